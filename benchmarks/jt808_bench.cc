@@ -0,0 +1,1139 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_bench.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 16:42:18
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "jt808/area_tracker.h"
+#include "jt808/bcd.h"
+#include "jt808/driving_alarm.h"
+#include "jt808/fleet_geofence.h"
+#include "jt808/geofence.h"
+#include "jt808/location_archive.h"
+#include "jt808/location_report.h"
+#include "jt808/packager.h"
+#include "jt808/parser.h"
+#include "jt808/protocol_parameter.h"
+#include "jt808/route_index.h"
+#include "jt808/util.h"
+
+#ifndef JT808_VERSION
+#define JT808_VERSION "unknown"
+#endif
+
+
+//
+// 统计堆内存分配次数, 测试程序为单线程, 无需原子操作.
+//
+namespace {
+
+uint64_t alloc_count = 0;
+
+}  // namespace
+
+// 替换的new/delete都基于malloc/free, 内联后GCC误报free()与operator new不配对.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+  ++alloc_count;
+  void* ptr = malloc(size ? size : 1);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  ++alloc_count;
+  void* ptr = malloc(size ? size : 1);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept {
+  ++alloc_count;
+  return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept {
+  ++alloc_count;
+  return malloc(size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::nothrow_t const&) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept {
+  free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+using libjt808::ProtocolParameter;
+
+// 阻止编译器优化掉测试代码的计算结果.
+template <typename T>
+inline void DoNotOptimize(T const& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile char const* sink;
+  sink = reinterpret_cast<char const*>(&value);
+#endif
+}
+
+// 测试项.
+struct Benchmark {
+  std::string name;
+  size_t bytes;  // 每次操作处理的字节数.
+  std::function<void (uint64_t)> run;  // 执行指定次数的操作.
+};
+
+// 测试结果.
+struct Result {
+  std::string name;
+  uint64_t iterations;
+  double ns_per_op;
+  size_t bytes_per_op;
+  double bytes_per_second;
+  double allocs_per_op;
+};
+
+// 测试样本, 每个消息ID一个.
+struct Sample {
+  uint16_t msg_id;
+  std::string name;
+  ProtocolParameter para;  // 用于封装的协议参数.
+  std::vector<uint8_t> frame;  // 封装后的完整消息.
+};
+
+std::string MsgIdName(uint16_t const& msg_id, char const* name) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "0x%04X", msg_id);
+  return std::string(buf) + "_" + name;
+}
+
+// 典型的位置基本信息.
+void FillLocationInfo(libjt808::LocationBasicInformation* info) {
+  info->alarm.value = 0;
+  info->status.value = 0;
+  info->status.bit.acc = 1;
+  info->status.bit.positioning = 1;
+  info->latitude = 22570336;
+  info->longitude = 113937577;
+  info->altitude = 52;
+  info->speed = 653;
+  info->bearing = 127;
+  info->time = "261018164218";
+}
+
+// 车载终端常见的位置附加信息项.
+void FillLocationExtensions(libjt808::LocationExtensions* ext) {
+  ext->clear();
+  (*ext)[libjt808::kMileage] = {0x00, 0x01, 0x86, 0xA0};
+  (*ext)[libjt808::kOilMass] = {0x01, 0xF4};
+  (*ext)[libjt808::kTachographSpeed] = {0x02, 0x8D};
+  (*ext)[libjt808::kVehicleSignalStatus] = {0x00, 0x00, 0x00, 0x03};
+  (*ext)[libjt808::kIoStatus] = {0x00, 0x00};
+  (*ext)[libjt808::kAnalogQuantity] = {0x00, 0x00, 0x00, 0x00};
+  (*ext)[libjt808::kNetworkQuantity] = {0x1F};
+  (*ext)[libjt808::kGnssSatellites] = {0x0C};
+  std::vector<uint8_t> item;
+  libjt808::SetAccessAreaAlarmBody(libjt808::kAccessAreaAlarmPolygonArea, 7,
+                                   libjt808::kAccessAreaAlarmInArea, &item);
+  (*ext)[libjt808::kAccessAreaAlarm] = item;
+}
+
+// 生成各消息ID的测试样本.
+// 消息内容按车载终端的典型取值填充, 随机数据使用固定种子, 保证结果可复现.
+void BuildSamples(libjt808::Packager const& packager,
+                  libjt808::Parser const& parser,
+                  std::vector<Sample>* samples) {
+  std::mt19937 rng(20201018);
+  ProtocolParameter base {};
+  base.msg_head.msgbody_attr.u16val = 0;
+  base.msg_head.phone_num = "13523339527";
+  base.msg_head.msg_flow_num = 0x1234;
+  base.parse.msg_head.msg_id = libjt808::kLocationReport;
+  base.parse.msg_head.msg_flow_num = 0x4321;
+  base.respone_result = libjt808::kSuccess;
+  base.register_info.province_id = 0x002c;
+  base.register_info.city_id = 0x012c;
+  base.register_info.manufacturer_id = {'S', 'K', 'O', 'E', 'M'};
+  base.register_info.terminal_model = {'S', 'K', '9', '1', '5', '1'};
+  base.register_info.terminal_id = {'0', '0', '0', '0', '0', '1'};
+  base.register_info.car_plate_color = libjt808::VehiclePlateColor::kBlue;
+  base.register_info.car_plate_num = "粤B99999";
+  base.authentication_code = {'1', '9', '6', '2', '5', '4', '7', '8', '3'};
+  base.parse.authentication_code = base.authentication_code;
+  FillLocationInfo(&base.location_info);
+  FillLocationExtensions(&base.location_extension);
+
+  struct Spec {
+    uint16_t msg_id;
+    char const* name;
+    std::function<void (ProtocolParameter*)> setup;
+  };
+  std::vector<Spec> const specs = {
+    {libjt808::kTerminalGeneralResponse, "terminal_general_response", nullptr},
+    {libjt808::kPlatformGeneralResponse, "platform_general_response", nullptr},
+    {libjt808::kTerminalHeartBeat, "heartbeat", nullptr},
+    {libjt808::kTerminalRegister, "register", nullptr},
+    {libjt808::kTerminalRegisterResponse, "register_response", nullptr},
+    {libjt808::kTerminalLogOut, "logout", nullptr},
+    {libjt808::kTerminalAuthentication, "authentication", nullptr},
+    {libjt808::kSetTerminalParameters, "set_terminal_parameters",
+     [] (ProtocolParameter* para) {
+       auto& items = para->terminal_parameters;
+       items[0x0001] = {0x00, 0x00, 0x00, 0x3C};
+       items[0x0013] = {'j', 't', '8', '0', '8', '.', 'e', 'x', 'a', 'm',
+                        'p', 'l', 'e', '.', 'c', 'o', 'm'};
+       items[0x0018] = {0x00, 0x00, 0x22, 0xB8};
+       items[0x0029] = {0x00, 0x00, 0x00, 0x1E};
+       items[0x0055] = {0x00, 0x00, 0x00, 0x78};
+       items[0x0056] = {0x00, 0x00, 0x00, 0x0A};
+     }},
+    {libjt808::kGetTerminalParameters, "get_terminal_parameters", nullptr},
+    {libjt808::kGetSpecificTerminalParameters,
+     "get_specific_terminal_parameters",
+     [] (ProtocolParameter* para) {
+       para->terminal_parameter_ids = {0x0001, 0x0013, 0x0029, 0x0055};
+     }},
+    {libjt808::kGetTerminalParametersResponse,
+     "get_terminal_parameters_response",
+     [] (ProtocolParameter* para) {
+       auto& items = para->terminal_parameters;
+       items[0x0001] = {0x00, 0x00, 0x00, 0x3C};
+       items[0x0013] = {'j', 't', '8', '0', '8', '.', 'e', 'x', 'a', 'm',
+                        'p', 'l', 'e', '.', 'c', 'o', 'm'};
+       items[0x0029] = {0x00, 0x00, 0x00, 0x1E};
+       items[0x0055] = {0x00, 0x00, 0x00, 0x78};
+     }},
+    {libjt808::kTerminalUpgrade, "terminal_upgrade",
+     [&rng] (ProtocolParameter* para) {
+       auto& info = para->upgrade_info;
+       info.upgrade_type = 0;
+       info.manufacturer_id = {'S', 'K', 'O', 'E', 'M'};
+       info.version_id = "1.0.1";
+       info.upgrade_data.resize(900);
+       for (auto& uch : info.upgrade_data) uch = rng() & 0xFF;
+       info.upgrade_data_total_len = 65536;
+     }},
+    {libjt808::kTerminalUpgradeResultReport, "terminal_upgrade_result",
+     [] (ProtocolParameter* para) {
+       para->upgrade_info.upgrade_type = 0;
+       para->upgrade_info.upgrade_result = 0;
+     }},
+    {libjt808::kLocationReport, "location_report", nullptr},
+    {libjt808::kGetLocationInformation, "get_location", nullptr},
+    {libjt808::kGetLocationInformationResponse, "get_location_response",
+     nullptr},
+    {libjt808::kLocationBatchUpload, "location_batch_upload",
+     [] (ProtocolParameter* para) {
+       auto& batch = para->location_batch;
+       batch.type = libjt808::kLocationBatchBlindArea;
+       batch.items.clear();
+       for (int i = 0; i < 10; ++i) {
+         std::vector<uint8_t> body;
+         para->location_info.latitude += 100;
+         libjt808::PackageLocationReportBody(para->location_info,
+                                             para->location_extension, &body);
+         batch.items.push_back(body);
+       }
+     }},
+    {libjt808::kLocationTrackingControl, "location_tracking_control",
+     [] (ProtocolParameter* para) {
+       para->location_tracking_control.interval = 5;
+       para->location_tracking_control.tracking_time = 3600;
+     }},
+    {libjt808::kSetPolygonArea, "set_polygon_area",
+     [] (ProtocolParameter* para) {
+       auto& area = para->polygon_area;
+       area.area_id = 7;
+       area.area_attribute.value = 0;
+       area.area_attribute.bit.in_alarm_to_server = 1;
+       area.area_attribute.bit.out_alarm_to_server = 1;
+       area.max_speed = 0;
+       area.overspeed_time = 0;
+       area.vertices.clear();
+       for (int i = 0; i < 16; ++i) {
+         libjt808::LocationPoint point;
+         point.latitude = 22.57 + 0.01*i;
+         point.longitude = 113.93 + ((i % 2) ? 0.02 : -0.02);
+         point.altitude = 0;
+         area.vertices.push_back(point);
+       }
+     }},
+    {libjt808::kDeletePolygonArea, "delete_polygon_area",
+     [] (ProtocolParameter* para) {
+       para->polygon_area_id = {1, 2, 3, 7};
+     }},
+    {libjt808::kSetCircularArea, "set_circular_area",
+     [] (ProtocolParameter* para) {
+       auto& setting = para->circular_area_setting;
+       setting.setting_type = libjt808::kAreaSettingAppend;
+       setting.areas.clear();
+       for (uint32_t id = 1; id <= 8; ++id) {
+         libjt808::CircularArea area {};
+         area.area_id = id;
+         area.area_attribute.bit.speed_limit = 1;
+         area.center.latitude = 22.57 + 0.01*id;
+         area.center.longitude = 113.93;
+         area.radius = 500;
+         area.max_speed = 60;
+         area.overspeed_time = 10;
+         setting.areas[id] = area;
+       }
+     }},
+    {libjt808::kSetRectangleArea, "set_rectangle_area",
+     [] (ProtocolParameter* para) {
+       auto& setting = para->rectangle_area_setting;
+       setting.setting_type = libjt808::kAreaSettingAppend;
+       setting.areas.clear();
+       for (uint32_t id = 1; id <= 8; ++id) {
+         libjt808::RectangleArea area {};
+         area.area_id = id;
+         area.area_attribute.bit.in_alarm_to_server = 1;
+         area.upper_left.latitude = 22.58 + 0.01*id;
+         area.upper_left.longitude = 113.92;
+         area.lower_right.latitude = 22.57 + 0.01*id;
+         area.lower_right.longitude = 113.94;
+         setting.areas[id] = area;
+       }
+     }},
+    {libjt808::kSetRoute, "set_route",
+     [] (ProtocolParameter* para) {
+       auto& route = para->route;
+       route.route_id = 7;
+       route.route_attribute.value = 0;
+       route.route_attribute.bit.out_alarm_to_server = 1;
+       route.points.clear();
+       for (uint32_t i = 0; i < 32; ++i) {
+         libjt808::RouteInflectionPoint point {};
+         point.point_id = i;
+         point.segment_id = i;
+         point.point.latitude = 22.57 + 0.001*i;
+         point.point.longitude = 113.93 + ((i % 2) ? 0.001 : 0.0);
+         point.width = 50;
+         point.segment_attribute.bit.speed_limit = 1;
+         point.max_speed = 80;
+         point.overspeed_time = 5;
+         route.points.push_back(point);
+       }
+     }},
+    {libjt808::kFillPacketRequest, "fill_packet_request",
+     [] (ProtocolParameter* para) {
+       para->fill_packet.first_packet_msg_flow_num = 0x0100;
+       para->fill_packet.packet_id = {3, 7, 12};
+     }},
+    {libjt808::kMultimediaDataUpload, "multimedia_upload",
+     [&rng] (ProtocolParameter* para) {
+       auto& upload = para->multimedia_upload;
+       upload.media_id = 1;
+       upload.media_type = 0;
+       upload.media_format = 0;
+       upload.media_event = 1;
+       upload.channel_id = 1;
+       upload.loaction_report_body.clear();
+       libjt808::PackageLocationReportBody(para->location_info, {},
+                                           &upload.loaction_report_body);
+       // 图像数据中包含需要转义的0x7E和0x7D.
+       upload.media_data.resize(900);
+       for (auto& uch : upload.media_data) uch = rng() & 0xFF;
+     }},
+    {libjt808::kMultimediaDataUploadResponse, "multimedia_upload_response",
+     [] (ProtocolParameter* para) {
+       para->multimedia_upload_response.media_id = 1;
+       para->multimedia_upload_response.reload_packet_ids = {2, 5};
+     }},
+  };
+
+  for (auto const& spec : specs) {
+    Sample sample;
+    sample.msg_id = spec.msg_id;
+    sample.name = MsgIdName(spec.msg_id, spec.name);
+    sample.para = base;
+    sample.para.msg_head.msg_id = spec.msg_id;
+    if (spec.setup) spec.setup(&sample.para);
+    if (libjt808::JT808FramePackage(packager, sample.para, &sample.frame) != 0) {
+      fprintf(stderr, "Skip %s: package failed\n", sample.name.c_str());
+      continue;
+    }
+    ProtocolParameter check {};
+    if (libjt808::JT808FrameParse(parser, sample.frame, &check) != 0) {
+      fprintf(stderr, "Skip %s: parse failed\n", sample.name.c_str());
+      continue;
+    }
+    samples->push_back(sample);
+  }
+}
+
+// 生成所有测试项.
+void BuildBenchmarks(std::vector<Sample> const& samples,
+                     libjt808::Packager const& packager,
+                     libjt808::Parser const& parser,
+                     std::vector<Benchmark>* benchmarks) {
+  // 消息封装与解析.
+  for (auto const& sample : samples) {
+    Sample const* s = &sample;
+    benchmarks->push_back({"parse/" + s->name, s->frame.size(),
+        [s, &parser] (uint64_t n) {
+          ProtocolParameter para {};
+          for (uint64_t i = 0; i < n; ++i) {
+            int ret = libjt808::JT808FrameParse(parser, s->frame, &para);
+            DoNotOptimize(ret);
+          }
+        }});
+  }
+  for (auto const& sample : samples) {
+    Sample const* s = &sample;
+    benchmarks->push_back({"package/" + s->name, s->frame.size(),
+        [s, &packager] (uint64_t n) {
+          std::vector<uint8_t> out;
+          for (uint64_t i = 0; i < n; ++i) {
+            int ret = libjt808::JT808FramePackage(packager, s->para, &out);
+            DoNotOptimize(ret);
+            DoNotOptimize(out.data());
+          }
+        }});
+  }
+
+  // 转义, 逆转义和校验, 分别使用典型位置信息汇报和含较多转义字符的多媒体数据.
+  for (auto const& sample : samples) {
+    if (sample.msg_id != libjt808::kLocationReport &&
+        sample.msg_id != libjt808::kMultimediaDataUpload) {
+      continue;
+    }
+    std::vector<uint8_t> raw;
+    libjt808::ReverseEscape(sample.frame, &raw);
+    // 去掉首尾标识位.
+    auto const content = std::make_shared<std::vector<uint8_t>>(
+        raw.begin()+1, raw.end()-1);
+    auto const escaped = std::make_shared<std::vector<uint8_t>>();
+    libjt808::Escape(*content, escaped.get());
+    benchmarks->push_back({"escape/" + sample.name, content->size(),
+        [content] (uint64_t n) {
+          std::vector<uint8_t> out;
+          for (uint64_t i = 0; i < n; ++i) {
+            libjt808::Escape(*content, &out);
+            DoNotOptimize(out.data());
+          }
+        }});
+    benchmarks->push_back({"reverse_escape/" + sample.name, escaped->size(),
+        [escaped] (uint64_t n) {
+          std::vector<uint8_t> out;
+          for (uint64_t i = 0; i < n; ++i) {
+            libjt808::ReverseEscape(*escaped, &out);
+            DoNotOptimize(out.data());
+          }
+        }});
+    benchmarks->push_back({"bcc_checksum/" + sample.name, content->size(),
+        [content] (uint64_t n) {
+          for (uint64_t i = 0; i < n; ++i) {
+            uint8_t sum = libjt808::BccCheckSum(content->data(),
+                                                content->size());
+            DoNotOptimize(sum);
+          }
+        }});
+  }
+
+  // BCD编码转换, 手机号(6字节)和时间(6字节).
+  benchmarks->push_back({"bcd/string_to_bcd_phone", 12,
+      [] (uint64_t n) {
+        std::string const phone("013523339527");
+        std::vector<uint8_t> out;
+        for (uint64_t i = 0; i < n; ++i) {
+          out.clear();
+          libjt808::StringToBcd(phone, &out);
+          DoNotOptimize(out.data());
+        }
+      }});
+  benchmarks->push_back({"bcd/bcd_to_string_phone", 6,
+      [] (uint64_t n) {
+        std::vector<uint8_t> const bcd = {0x01, 0x35, 0x23, 0x33, 0x95, 0x27};
+        std::string out;
+        for (uint64_t i = 0; i < n; ++i) {
+          out.clear();
+          libjt808::BcdToString(bcd, &out);
+          DoNotOptimize(out.data());
+        }
+      }});
+  benchmarks->push_back({"bcd/bcd_to_string_time", 6,
+      [] (uint64_t n) {
+        std::vector<uint8_t> const bcd = {0x26, 0x10, 0x18, 0x16, 0x42, 0x18};
+        std::string out;
+        for (uint64_t i = 0; i < n; ++i) {
+          out.clear();
+          libjt808::BcdToStringFillZero(bcd, &out);
+          DoNotOptimize(out.data());
+        }
+      }});
+  benchmarks->push_back({"bcd/hex_to_bcd", 1,
+      [] (uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+          uint8_t bcd = libjt808::HexToBcd(static_cast<uint8_t>(i % 100));
+          DoNotOptimize(bcd);
+        }
+      }});
+
+  // 位置信息汇报消息体及附加信息项解析.
+  libjt808::LocationBasicInformation info;
+  FillLocationInfo(&info);
+  libjt808::LocationExtensions ext;
+  FillLocationExtensions(&ext);
+  auto const basic = std::make_shared<std::vector<uint8_t>>();
+  libjt808::PackageLocationReportBody(info, {}, basic.get());
+  auto const full = std::make_shared<std::vector<uint8_t>>();
+  libjt808::PackageLocationReportBody(info, ext, full.get());
+  benchmarks->push_back({"location/parse_basic", basic->size(),
+      [basic] (uint64_t n) {
+        libjt808::LocationBasicInformation out_info;
+        libjt808::LocationExtensions out_ext;
+        for (uint64_t i = 0; i < n; ++i) {
+          out_ext.clear();
+          int ret = libjt808::ParseLocationReportBody(
+              basic->data(), basic->size(), &out_info, &out_ext);
+          DoNotOptimize(ret);
+        }
+      }});
+  benchmarks->push_back({"location/parse_basic_timestamp", basic->size(),
+      [basic] (uint64_t n) {
+        libjt808::LocationBasicInformation out_info;
+        for (uint64_t i = 0; i < n; ++i) {
+          int ret = libjt808::ParseLocationBasicInformation(
+              basic->data(), basic->size(), &out_info, false);
+          DoNotOptimize(ret);
+          DoNotOptimize(out_info.timestamp);
+        }
+      }});
+  benchmarks->push_back({"location/parse_extensions", full->size(),
+      [full] (uint64_t n) {
+        libjt808::LocationBasicInformation out_info;
+        libjt808::LocationExtensions out_ext;
+        for (uint64_t i = 0; i < n; ++i) {
+          out_ext.clear();
+          int ret = libjt808::ParseLocationReportBody(
+              full->data(), full->size(), &out_info, &out_ext);
+          DoNotOptimize(ret);
+        }
+      }});
+  benchmarks->push_back({"location/extension_view", full->size(),
+      [full] (uint64_t n) {
+        libjt808::LocationBasicInformation out_info;
+        libjt808::LocationExtensionView view;
+        uint32_t mileage = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          libjt808::ParseLocationBasicInformation(
+              full->data(), full->size(), &out_info, false);
+          view.Init(full->data(), full->size());
+          view.GetMileage(&mileage);
+          DoNotOptimize(mileage);
+        }
+      }});
+  benchmarks->push_back({"location/package_extensions", full->size(),
+      [info, ext] (uint64_t n) {
+        std::vector<uint8_t> out;
+        for (uint64_t i = 0; i < n; ++i) {
+          out.clear();
+          int ret = libjt808::PackageLocationReportBody(info, ext, &out);
+          DoNotOptimize(ret);
+        }
+      }});
+  benchmarks->push_back({"location/get_access_area_alarm",
+      ext[libjt808::kAccessAreaAlarm].size(),
+      [ext] (uint64_t n) {
+        auto const& item = ext.at(libjt808::kAccessAreaAlarm);
+        uint8_t type = 0;
+        uint32_t id = 0;
+        uint8_t direction = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          libjt808::GetAccessAreaAlarmBody(item, &type, &id, &direction);
+          DoNotOptimize(id);
+        }
+      }});
+
+  // 驾驶行为报警, 10万个终端轮流上报, 终端状态预先建立.
+  auto const driving_alarm = std::make_shared<libjt808::FleetDrivingAlarm>();
+  auto const driving_records =
+      std::make_shared<std::vector<libjt808::LocationRecord>>(100000);
+  libjt808::DrivingAlarmConfig driving_config {};
+  driving_config.max_speed = 80;
+  driving_config.overspeed_duration = 10;
+  driving_config.continuous_driving_time = 4*3600;
+  driving_config.daily_driving_time = 8*3600;
+  driving_config.min_rest_time = 20*60;
+  driving_config.max_parking_time = 3600;
+  driving_alarm->set_config(driving_config);
+  for (size_t i = 0; i < driving_records->size(); ++i) {
+    auto& record = (*driving_records)[i];
+    memset(&record, 0, sizeof(record));
+    snprintf(record.phone_num, sizeof(record.phone_num), "1%011llu",
+             static_cast<unsigned long long>(i % 100000000000ULL));
+    record.timestamp = 1700000000;
+    record.speed = static_cast<uint16_t>((i%10)*100);
+    record.status = 1;
+  }
+  {
+    std::vector<libjt808::DrivingAlarmEvent> events;
+    driving_alarm->Evaluate(driving_records->data(), driving_records->size(),
+                            &events);
+  }
+  benchmarks->push_back({"location/driving_alarm_100k_terminals", 0,
+      [driving_alarm, driving_records] (uint64_t n) {
+        std::vector<libjt808::DrivingAlarmEvent> events;
+        events.reserve(1024);
+        auto& records = *driving_records;
+        uint64_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          auto& record = records[i%records.size()];
+          ++record.timestamp;
+          events.clear();
+          driving_alarm->Evaluate(&record, 1, &events);
+          num += events.size();
+        }
+        DoNotOptimize(num);
+      }});
+
+  // 位置历史归档, 1000个终端各3600条1Hz行驶记录.
+  // 读取端映射后即删除文件, 映射内存在进程退出前有效.
+  std::mt19937 archive_rng(3600);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<libjt808::LocationRecord> archive_records;
+  archive_records.reserve(1000*3600);
+  for (uint32_t t = 0; t < 1000; ++t) {
+    double lon = 113.5 + unit(archive_rng);
+    double lat = 22.0 + unit(archive_rng);
+    double heading = unit(archive_rng)*6.28;
+    for (uint32_t s = 0; s < 3600; ++s) {
+      libjt808::LocationRecord record;
+      memset(&record, 0, sizeof(record));
+      snprintf(record.phone_num, sizeof(record.phone_num), "1%011u", t);
+      record.timestamp = 1700000000 + s;
+      heading += (unit(archive_rng)-0.5)*0.1;
+      lon += 0.00012*cos(heading);
+      lat += 0.00012*sin(heading);
+      record.longitude = static_cast<uint32_t>(lon*1e6);
+      record.latitude = static_cast<uint32_t>(lat*1e6);
+      record.altitude = 20;
+      record.speed = static_cast<uint16_t>(450 + unit(archive_rng)*20);
+      record.bearing = static_cast<uint16_t>(
+          fmod(heading*57.3+3600.0, 360.0));
+      record.status = 0x3;
+      archive_records.push_back(record);
+    }
+  }
+  std::string const archive_path = "jt808_bench_location.archive";
+  remove(archive_path.c_str());
+  {
+    libjt808::LocationArchiveWriter writer;
+    writer.Open(archive_path);
+    writer.Append(archive_records.data(), archive_records.size());
+  }
+  auto const archive = std::make_shared<libjt808::LocationArchiveReader>();
+  archive->Open(archive_path);
+  remove(archive_path.c_str());
+  benchmarks->push_back({"location/archive_scan_3.6m_records",
+      archive->record_num()*sizeof(libjt808::LocationRecord),
+      [archive] (uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+          uint64_t speed = 0;
+          archive->Scan("", 0, INT64_MAX,
+              [&speed] (libjt808::LocationRecord const* records,
+                        size_t const& num) {
+                speed += records[num-1].speed;
+              });
+          DoNotOptimize(speed);
+        }
+      }});
+  benchmarks->push_back({"location/archive_track_1h", 3600*sizeof(
+      libjt808::LocationRecord), [archive] (uint64_t n) {
+        std::vector<libjt808::LocationRecord> track;
+        track.reserve(3600);
+        for (uint64_t i = 0; i < n; ++i) {
+          archive->Read("100000000007", 1700000000, 1700003599, &track);
+          DoNotOptimize(track.size());
+        }
+      }});
+
+  // 区域判断, 1000个八边形区域随机分布在1°x1°范围内.
+  auto const areas = std::make_shared<libjt808::PolygonAreaSet>();
+  auto const points = std::make_shared<std::vector<libjt808::LocationPoint>>();
+  std::mt19937 rng(808);
+  std::uniform_real_distribution<double> position(0.0, 1.0);
+  std::uniform_real_distribution<double> radius(0.002, 0.02);
+  for (uint32_t id = 1; id <= 1000; ++id) {
+    libjt808::PolygonArea area {};
+    area.area_id = id;
+    double const center_lon = 113.5 + position(rng);
+    double const center_lat = 22.0 + position(rng);
+    double const r = radius(rng);
+    for (int i = 0; i < 8; ++i) {
+      double const angle = i*3.1415926535897931/4;
+      area.vertices.push_back({center_lon + r*cos(angle),
+                               center_lat + r*sin(angle), 0.0f});
+    }
+    (*areas)[id] = area;
+  }
+  for (int i = 0; i < 1024; ++i) {
+    points->push_back({113.5 + position(rng), 22.0 + position(rng), 0.0f});
+  }
+  auto const index = std::make_shared<libjt808::GeofenceIndex>();
+  index->Build(*areas);
+  benchmarks->push_back({"geofence/query_1000_areas", 0,
+      [index, points] (uint64_t n) {
+        std::vector<uint32_t> ids;
+        ids.reserve(16);
+        for (uint64_t i = 0; i < n; ++i) {
+          index->Query((*points)[i & 1023], &ids);
+          DoNotOptimize(ids.size());
+        }
+      }});
+  benchmarks->push_back({"geofence/linear_scan_1000_areas", 0,
+      [areas, points] (uint64_t n) {
+        size_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          for (auto const& item : *areas) {
+            num += libjt808::IsPointInsidePolygon((*points)[i & 1023],
+                                                  item.second.vertices);
+          }
+          DoNotOptimize(num);
+        }
+      }});
+  benchmarks->push_back({"geofence/update_area", 0,
+      [index, areas] (uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+          index->Insert(areas->at(static_cast<uint32_t>(i%1000)+1));
+        }
+      }});
+
+  // 复杂多边形, 1000个顶点的星形区域, 对比逐次射线法和预处理后的判断.
+  auto const complex = std::make_shared<std::vector<libjt808::LocationPoint>>();
+  for (int i = 0; i < 1000; ++i) {
+    double const angle = i*2*3.1415926535897931/1000;
+    double const r = (i%2 == 0) ? 0.5 : 0.3;
+    complex->push_back({114.0 + r*cos(angle), 22.5 + r*sin(angle), 0.0f});
+  }
+  auto const prepared = std::make_shared<libjt808::PreparedPolygon>(*complex);
+  auto const complex_fixed = std::make_shared<std::vector<libjt808::GeoPoint>>();
+  libjt808::ToGeoPoints(*complex, complex_fixed.get());
+  auto const points_fixed = std::make_shared<std::vector<libjt808::GeoPoint>>();
+  libjt808::ToGeoPoints(*points, points_fixed.get());
+  benchmarks->push_back({"geofence/ray_cast_1000_vertices", 0,
+      [complex, points] (uint64_t n) {
+        size_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          num += libjt808::IsPointInsidePolygon((*points)[i & 1023], *complex);
+        }
+        DoNotOptimize(num);
+      }});
+  benchmarks->push_back({"geofence/ray_cast_fixed_1000_vertices", 0,
+      [complex_fixed, points_fixed] (uint64_t n) {
+        size_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          num += libjt808::IsPointInsidePolygon((*points_fixed)[i & 1023],
+                                                *complex_fixed);
+        }
+        DoNotOptimize(num);
+      }});
+  benchmarks->push_back({"geofence/prepared_1000_vertices", 0,
+      [prepared, points_fixed] (uint64_t n) {
+        size_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          num += prepared->Contains((*points_fixed)[i & 1023]);
+        }
+        DoNotOptimize(num);
+      }});
+  benchmarks->push_back({"geofence/approximate_distance", 0,
+      [points_fixed] (uint64_t n) {
+        uint64_t meters = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          meters += libjt808::ApproximateDistance((*points_fixed)[i & 1023],
+              (*points_fixed)[(i+1) & 1023]);
+        }
+        DoNotOptimize(meters);
+      }});
+  // 历史轨迹回放, 每次批量判断1024个点.
+  benchmarks->push_back({"geofence/prepared_batch_1024_points", 0,
+      [prepared, points_fixed] (uint64_t n) {
+        std::vector<uint8_t> results(points_fixed->size());
+        for (uint64_t i = 0; i < n; ++i) {
+          prepared->ContainsBatch(points_fixed->data(), points_fixed->size(),
+                                  results.data());
+          DoNotOptimize(results[0]);
+        }
+      }});
+
+  // 平台侧区域判断, 10000个区域分布在10°x10°范围内, 100000个终端,
+  // 每个终端在某个区域中心附近的两个位置之间来回移动.
+  libjt808::PolygonAreaSet fleet_areas;
+  std::vector<std::pair<double, double>> centers;
+  for (uint32_t id = 1; id <= 10000; ++id) {
+    libjt808::PolygonArea area {};
+    area.area_id = id;
+    double const center_lon = 110.0 + 10*position(rng);
+    double const center_lat = 20.0 + 10*position(rng);
+    double const r = radius(rng);
+    for (int i = 0; i < 8; ++i) {
+      double const angle = i*3.1415926535897931/4;
+      area.vertices.push_back({center_lon + r*cos(angle),
+                               center_lat + r*sin(angle), 0.0f});
+    }
+    fleet_areas[id] = area;
+    centers.push_back(std::make_pair(center_lon, center_lat));
+  }
+  auto const fleet = std::make_shared<libjt808::FleetGeofence>();
+  fleet->SetAreas(fleet_areas);
+  constexpr size_t kTerminalNum = 100000;
+  auto const records =
+      std::make_shared<std::vector<libjt808::LocationRecord>>(2*kTerminalNum);
+  std::uniform_real_distribution<double> offset(-0.03, 0.03);
+  for (size_t i = 0; i < kTerminalNum; ++i) {
+    auto const& center = centers[i%centers.size()];
+    for (size_t j = 0; j < 2; ++j) {
+      auto& record = (*records)[j*kTerminalNum+i];
+      memset(&record, 0, sizeof(record));
+      snprintf(record.phone_num, sizeof(record.phone_num), "1%011llu",
+               static_cast<unsigned long long>(i % 100000000000ULL));
+      record.session = i;
+      record.longitude =
+          static_cast<uint32_t>((center.first + offset(rng))*1e6);
+      record.latitude =
+          static_cast<uint32_t>((center.second + offset(rng))*1e6);
+    }
+  }
+  benchmarks->push_back({"geofence/fleet_evaluate_10k_areas", 0,
+      [fleet, records] (uint64_t n) {
+        std::vector<libjt808::GeofenceEvent> events;
+        events.reserve(64);
+        uint64_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          events.clear();
+          fleet->Evaluate(&(*records)[i%records->size()], 1, &events);
+          num += events.size();
+        }
+        DoNotOptimize(num);
+      }});
+
+  // 圆形和矩形区域, 各500个随机分布在1°x1°范围内.
+  auto const shapes = std::make_shared<libjt808::GeofenceIndex>();
+  for (uint32_t id = 1; id <= 500; ++id) {
+    libjt808::CircularArea circle {};
+    circle.area_id = id;
+    circle.center = {113.5 + position(rng), 22.0 + position(rng), 0.0f};
+    circle.radius = static_cast<uint32_t>(radius(rng)*1e5);
+    shapes->Insert(circle);
+    libjt808::RectangleArea rectangle {};
+    rectangle.area_id = id;
+    double const lon = 113.5 + position(rng);
+    double const lat = 22.0 + position(rng);
+    rectangle.upper_left = {lon, lat + radius(rng), 0.0f};
+    rectangle.lower_right = {lon + radius(rng), lat, 0.0f};
+    shapes->Insert(rectangle);
+  }
+  benchmarks->push_back({"geofence/query_circle_rectangle_1000_areas", 0,
+      [shapes, points_fixed] (uint64_t n) {
+        std::vector<libjt808::AreaRef> refs;
+        refs.reserve(16);
+        for (uint64_t i = 0; i < n; ++i) {
+          shapes->Query((*points_fixed)[i & 1023], &refs);
+          DoNotOptimize(refs.size());
+        }
+      }});
+
+  // 路线偏离判断, 5000个拐点约100m间隔的路线, 检查点在路线附近随机偏移,
+  // 对比路段空间索引和逐个路段计算距离.
+  auto const route = std::make_shared<libjt808::Route>();
+  route->route_id = 1;
+  double route_lon = 113.5;
+  double route_lat = 22.0;
+  std::uniform_real_distribution<double> step(-0.0007, 0.0007);
+  for (uint32_t i = 0; i < 5000; ++i) {
+    libjt808::RouteInflectionPoint point {};
+    point.point_id = i;
+    point.segment_id = i;
+    point.point = {route_lon, route_lat, 0.0f};
+    point.width = 60;
+    route->points.push_back(point);
+    route_lon += 0.0007 + step(rng);
+    route_lat += step(rng);
+  }
+  auto const route_index = std::make_shared<libjt808::RouteIndex>();
+  route_index->Insert(*route);
+  auto const route_points = std::make_shared<std::vector<libjt808::GeoPoint>>();
+  std::uniform_real_distribution<double> deviation(-0.0005, 0.0005);
+  for (int i = 0; i < 1024; ++i) {
+    auto const& point = route->points[rng() % route->points.size()].point;
+    route_points->push_back(libjt808::ToGeoPoint(
+        {point.longitude + deviation(rng), point.latitude + deviation(rng),
+         0.0f}));
+  }
+  benchmarks->push_back({"geofence/route_match_5000_points", 0,
+      [route_index, route_points] (uint64_t n) {
+        libjt808::RouteMatch match;
+        size_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          num += route_index->Match(1, (*route_points)[i & 1023], &match);
+        }
+        DoNotOptimize(num);
+      }});
+  benchmarks->push_back({"geofence/route_linear_5000_points", 0,
+      [route, route_points] (uint64_t n) {
+        std::vector<libjt808::GeoPoint> vertices;
+        for (auto const& point : route->points) {
+          vertices.push_back(libjt808::ToGeoPoint(point.point));
+        }
+        size_t num = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          auto const& point = (*route_points)[i & 1023];
+          for (size_t k = 0; k+1 < vertices.size(); ++k) {
+            uint32_t const distance = libjt808::ApproximateSegmentDistance(
+                point, vertices[k], vertices[k+1]);
+            if (distance*2 <= route->points[k].width) {
+              ++num;
+              break;
+            }
+          }
+        }
+        DoNotOptimize(num);
+      }});
+
+  // 区域状态跟踪, 1Hz定位约60km/h行驶的轨迹, 对比缓存安全范围的跟踪器和
+  // 每个定位点查询区域空间索引.
+  auto const trajectory = std::make_shared<std::vector<libjt808::GeoPoint>>();
+  double track_lon = 114.0;
+  double track_lat = 22.5;
+  double heading = 0.0;
+  std::uniform_real_distribution<double> turn(-0.1, 0.1);
+  for (size_t i = 0; i < 4096; ++i) {
+    heading += turn(rng);
+    track_lon += 0.00015*cos(heading);
+    track_lat += 0.00015*sin(heading);
+    if (track_lon < 113.5 || track_lon > 114.5) heading = M_PI-heading;
+    if (track_lat < 22.0 || track_lat > 23.0) heading = -heading;
+    trajectory->push_back(libjt808::ToGeoPoint(
+        libjt808::LocationPoint {track_lon, track_lat, 0.0}));
+  }
+  benchmarks->push_back({"geofence/tracker_1hz_trajectory", 0,
+      [shapes, trajectory] (uint64_t n) {
+        libjt808::AreaTracker tracker;
+        std::vector<libjt808::AreaEvent> events;
+        events.reserve(16);
+        for (uint64_t i = 0; i < n; ++i) {
+          events.clear();
+          tracker.Update(*shapes, (*trajectory)[i & 4095],
+                         static_cast<int64_t>(i), 600, &events);
+          DoNotOptimize(events.size());
+        }
+      }});
+  benchmarks->push_back({"geofence/query_1hz_trajectory", 0,
+      [shapes, trajectory] (uint64_t n) {
+        std::vector<libjt808::AreaRef> refs;
+        refs.reserve(16);
+        for (uint64_t i = 0; i < n; ++i) {
+          shapes->Query((*trajectory)[i & 4095], &refs);
+          DoNotOptimize(refs.size());
+        }
+      }});
+}
+
+// 执行测试项, 逐步增加执行次数直到耗时不少于min_time秒.
+Result Measure(Benchmark const& benchmark, double const& min_time) {
+  benchmark.run(1);  // 预热.
+  uint64_t n = 1;
+  while (true) {
+    uint64_t const allocs = alloc_count;
+    auto const start = std::chrono::steady_clock::now();
+    benchmark.run(n);
+    double const elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    uint64_t const allocated = alloc_count - allocs;
+    if (elapsed >= min_time || n >= 1000000000ULL) {
+      Result result;
+      result.name = benchmark.name;
+      result.iterations = n;
+      result.ns_per_op = elapsed*1e9/n;
+      result.bytes_per_op = benchmark.bytes;
+      result.bytes_per_second = benchmark.bytes*n/elapsed;
+      // 测试函数内的一次性分配(如输出缓冲)不计入.
+      result.allocs_per_op = static_cast<double>(allocated)/n;
+      return result;
+    }
+    // 按本次耗时估算下次执行次数, 每次最多增加100倍.
+    double multiplier = (elapsed > 0) ? min_time*1.4/elapsed : 100.0;
+    if (multiplier > 100.0) multiplier = 100.0;
+    if (multiplier < 2.0) multiplier = 2.0;
+    n = static_cast<uint64_t>(n*multiplier);
+  }
+}
+
+void Usage(char const* name) {
+  printf("Usage: %s [options]\n", name);
+  printf("  --filter=SUBSTR    only run benchmarks whose name contains SUBSTR\n");
+  printf("  --min-time=SEC     minimum time per benchmark, default 0.5\n");
+  printf("  --format=FORMAT    output format: text, json or csv, default text\n");
+  printf("  --list             list benchmark names and exit\n");
+}
+
+void PrintTextHeader(void) {
+  printf("%-58s %12s %12s %12s %10s\n", "Benchmark", "Iterations",
+         "ns/op", "MB/s", "allocs/op");
+}
+
+void PrintTextRow(Result const& r) {
+  printf("%-58s %12lu %12.1f %12.2f %10.2f\n", r.name.c_str(),
+         static_cast<unsigned long>(r.iterations), r.ns_per_op,
+         r.bytes_per_second/1e6, r.allocs_per_op);
+}
+
+void PrintCsv(std::vector<Result> const& results) {
+  printf("name,iterations,ns_per_op,bytes_per_op,bytes_per_second,"
+         "allocs_per_op\n");
+  for (auto const& r : results) {
+    printf("%s,%lu,%.3f,%lu,%.0f,%.3f\n", r.name.c_str(),
+           static_cast<unsigned long>(r.iterations), r.ns_per_op,
+           static_cast<unsigned long>(r.bytes_per_op), r.bytes_per_second,
+           r.allocs_per_op);
+  }
+}
+
+void PrintJson(std::vector<Result> const& results, double const& min_time) {
+  char date[32];
+  time_t const now = time(nullptr);
+  struct tm tm_now;
+#if defined(_WIN32)
+  gmtime_s(&tm_now, &now);
+#else
+  gmtime_r(&now, &tm_now);
+#endif
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &tm_now);
+  printf("{\n");
+  printf("  \"context\": {\n");
+  printf("    \"date\": \"%s\",\n", date);
+  printf("    \"library_version\": \"%s\",\n", JT808_VERSION);
+#if defined(__VERSION__)
+  printf("    \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+#if defined(__OPTIMIZE__)
+  printf("    \"optimized\": true,\n");
+#else
+  printf("    \"optimized\": false,\n");
+#endif
+  printf("    \"min_time\": %.3f\n", min_time);
+  printf("  },\n");
+  printf("  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto const& r = results[i];
+    printf("    {\"name\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.3f, "
+           "\"bytes_per_op\": %lu, \"bytes_per_second\": %.0f, "
+           "\"allocs_per_op\": %.3f}%s\n", r.name.c_str(),
+           static_cast<unsigned long>(r.iterations), r.ns_per_op,
+           static_cast<unsigned long>(r.bytes_per_op), r.bytes_per_second,
+           r.allocs_per_op, (i+1 < results.size()) ? "," : "");
+  }
+  printf("  ]\n");
+  printf("}\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string filter;
+  std::string format("text");
+  double min_time = 0.5;
+  bool list = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg(argv[i]);
+    if (arg.compare(0, 9, "--filter=") == 0) {
+      filter = arg.substr(9);
+    } else if (arg.compare(0, 11, "--min-time=") == 0) {
+      min_time = atof(arg.c_str()+11);
+    } else if (arg.compare(0, 9, "--format=") == 0) {
+      format = arg.substr(9);
+    } else if (arg == "--list") {
+      list = true;
+    } else {
+      Usage(argv[0]);
+      return (arg == "-h" || arg == "--help") ? 0 : -1;
+    }
+  }
+  if (format != "text" && format != "json" && format != "csv") {
+    Usage(argv[0]);
+    return -1;
+  }
+  libjt808::Packager packager;
+  libjt808::JT808FramePackagerInit(&packager);
+  libjt808::Parser parser;
+  libjt808::JT808FrameParserInit(&parser);
+  std::vector<Sample> samples;
+  BuildSamples(packager, parser, &samples);
+  std::vector<Benchmark> benchmarks;
+  BuildBenchmarks(samples, packager, parser, &benchmarks);
+
+  std::vector<Result> results;
+  for (auto const& benchmark : benchmarks) {
+    if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    if (list) {
+      printf("%s\n", benchmark.name.c_str());
+      continue;
+    }
+    results.push_back(Measure(benchmark, min_time));
+    if (format == "text") {
+      // 逐项输出, 便于观察进度.
+      if (results.size() == 1) PrintTextHeader();
+      PrintTextRow(results.back());
+      fflush(stdout);
+    }
+  }
+  if (format == "json") {
+    PrintJson(results, min_time);
+  } else if (format == "csv") {
+    PrintCsv(results);
+  }
+  return 0;
+}
@@ -0,0 +1,229 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_load_generator.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 15:20:06
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "jt808/server.h"
+#include "terminal_emulator.h"
+
+
+namespace {
+
+void Usage(char const* name) {
+  printf("Usage: %s [options]\n", name);
+  printf("  --server IP:PORT           server address, default 127.0.0.1:8888\n");
+  printf("  --bind-ips IP[,IP...]      local addresses, used round-robin\n");
+  printf("  --terminals N              number of terminals, default 1000\n");
+  printf("  --threads N                number of event loop threads, default 4\n");
+  printf("  --duration S               test duration in seconds, default 30\n");
+  printf("  --connect-rate N           new connections per second, default 2000\n");
+  printf("  --report-interval MS       location report interval, default 1000\n");
+  printf("  --heartbeat-interval MS    heartbeat interval, default 30000\n");
+  printf("  --reconnect-delay MS       max reconnect delay, default 1000\n");
+  printf("  --storm-interval MS        reconnect storm period, default 0(off)\n");
+  printf("  --storm-fraction F         fraction of terminals per storm, default 0.1\n");
+  printf("  --alarm-interval MS        alarm burst period, default 0(off)\n");
+  printf("  --alarm-fraction F         fraction of terminals per burst, default 0.01\n");
+  printf("  --alarm-burst N            alarm reports per terminal, default 5\n");
+  printf("  --seed N                   random seed, default 1\n");
+  printf("  --embedded-server          run a JT808Server in this process\n");
+}
+
+// 拆分以逗号分隔的地址列表.
+void SplitIps(char const* str, std::vector<std::string>* ips) {
+  std::string item;
+  for (char const* p = str; ; ++p) {
+    if (*p == ',' || *p == '\0') {
+      if (!item.empty()) ips->push_back(item);
+      item.clear();
+      if (*p == '\0') break;
+    } else {
+      item.push_back(*p);
+    }
+  }
+}
+
+// 提高进程可打开的文件描述符数上限.
+void RaiseFileLimit(int const& need) {
+#if defined(__linux__)
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+  if (limit.rlim_cur < static_cast<rlim_t>(need)) {
+    limit.rlim_cur = (limit.rlim_max < static_cast<rlim_t>(need)) ?
+                     limit.rlim_max : static_cast<rlim_t>(need);
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  getrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur < static_cast<rlim_t>(need)) {
+    printf("Warning: open file limit %lu is less than %d\n",
+           static_cast<unsigned long>(limit.rlim_cur), need);
+  }
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  libjt808::EmulatorOptions options;
+  int duration = 30;
+  bool embedded_server = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg(argv[i]);
+    if (arg == "--embedded-server") {
+      embedded_server = true;
+      continue;
+    }
+    if (arg == "-h" || arg == "--help" || i+1 >= argc) {
+      Usage(argv[0]);
+      return (arg == "-h" || arg == "--help") ? 0 : -1;
+    }
+    char const* value = argv[++i];
+    if (arg == "--server") {
+      char const* colon = strchr(value, ':');
+      if (colon == nullptr) {
+        options.server_ip = value;
+      } else {
+        options.server_ip.assign(value, colon);
+        options.server_port = atoi(colon+1);
+      }
+    } else if (arg == "--bind-ips") {
+      SplitIps(value, &options.bind_ips);
+    } else if (arg == "--terminals") {
+      options.terminal_num = atoi(value);
+    } else if (arg == "--threads") {
+      options.thread_num = atoi(value);
+    } else if (arg == "--duration") {
+      duration = atoi(value);
+    } else if (arg == "--connect-rate") {
+      options.connect_rate = atoi(value);
+    } else if (arg == "--report-interval") {
+      options.report_interval_ms = atoi(value);
+    } else if (arg == "--heartbeat-interval") {
+      options.heartbeat_interval_ms = atoi(value);
+    } else if (arg == "--reconnect-delay") {
+      options.reconnect_delay_ms = atoi(value);
+    } else if (arg == "--storm-interval") {
+      options.storm_interval_ms = atoi(value);
+    } else if (arg == "--storm-fraction") {
+      options.storm_fraction = atof(value);
+    } else if (arg == "--alarm-interval") {
+      options.alarm_interval_ms = atoi(value);
+    } else if (arg == "--alarm-fraction") {
+      options.alarm_fraction = atof(value);
+    } else if (arg == "--alarm-burst") {
+      options.alarm_burst = atoi(value);
+    } else if (arg == "--seed") {
+      options.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+    } else {
+      Usage(argv[0]);
+      return -1;
+    }
+  }
+  // 内嵌服务端时, 服务端和模拟终端各占用一个文件描述符.
+  RaiseFileLimit(options.terminal_num*(embedded_server ? 2 : 1) + 1024);
+
+  libjt808::JT808Server server;
+  if (embedded_server) {
+    server.Init();
+    server.SetServerAccessPoint(options.server_ip, options.server_port);
+    server.set_max_connection_num(4096);
+    server.set_message_dump(false);
+    if (server.InitServer() != 0) {
+      printf("Init server failed\n");
+      return -1;
+    }
+    server.Run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  libjt808::TerminalEmulator emulator(options);
+  if (emulator.Start() != 0) {
+    printf("Start terminal emulator failed\n");
+    return -1;
+  }
+  printf("Terminals: %d, threads: %d, server: %s:%d, duration: %ds\n",
+         options.terminal_num, options.thread_num, options.server_ip.c_str(),
+         options.server_port, duration);
+  auto const start = std::chrono::steady_clock::now();
+  libjt808::EmulatorStats last = emulator.stats();
+  for (int sec = 1; sec <= duration; ++sec) {
+    std::this_thread::sleep_for(start + std::chrono::seconds(sec) -
+                                std::chrono::steady_clock::now());
+    auto const now = emulator.stats();
+    printf("[%4ds] online: %lu, sent: %lu msg/s, acks: %lu/s, "
+           "connects: %lu, disconnects: %lu\n", sec,
+           static_cast<unsigned long>(now.online),
+           static_cast<unsigned long>(now.msgs_sent - last.msgs_sent),
+           static_cast<unsigned long>(now.acks - last.acks),
+           static_cast<unsigned long>(now.connect_attempts -
+                                      last.connect_attempts),
+           static_cast<unsigned long>(now.disconnects - last.disconnects));
+    fflush(stdout);
+    last = now;
+  }
+  emulator.Stop();
+  double const elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  if (embedded_server) server.Stop();
+
+  auto const stats = emulator.stats();
+  auto const hist = emulator.ack_latency();
+  printf("\nSummary:\n");
+  printf("  connect attempts: %lu, failures: %lu\n",
+         static_cast<unsigned long>(stats.connect_attempts),
+         static_cast<unsigned long>(stats.connect_failures));
+  printf("  handshakes: %lu, failures: %lu, disconnects: %lu\n",
+         static_cast<unsigned long>(stats.handshakes),
+         static_cast<unsigned long>(stats.handshake_failures),
+         static_cast<unsigned long>(stats.disconnects));
+  printf("  messages sent: %lu (%.0f msg/s, %.2f MB/s), alarms: %lu\n",
+         static_cast<unsigned long>(stats.msgs_sent),
+         stats.msgs_sent/elapsed, stats.bytes_sent/elapsed/1e6,
+         static_cast<unsigned long>(stats.alarms_sent));
+  printf("  messages received: %lu, acks: %lu (%.0f ack/s)\n",
+         static_cast<unsigned long>(stats.msgs_received),
+         static_cast<unsigned long>(stats.acks), stats.acks/elapsed);
+  printf("  ack latency(us): mean %.0f, p50 %lu, p90 %lu, p99 %lu, "
+         "p999 %lu, max %lu\n", hist.mean(),
+         static_cast<unsigned long>(hist.Percentile(50.0)),
+         static_cast<unsigned long>(hist.Percentile(90.0)),
+         static_cast<unsigned long>(hist.Percentile(99.0)),
+         static_cast<unsigned long>(hist.Percentile(99.9)),
+         static_cast<unsigned long>(hist.max()));
+  return 0;
+}
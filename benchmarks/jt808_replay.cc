@@ -0,0 +1,180 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_replay.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 05:31:46
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "jt808/server.h"
+
+#ifndef JT808_VERSION
+#define JT808_VERSION "unknown"
+#endif
+
+
+namespace {
+
+// 回放配置.
+struct ReplayOptions {
+  std::string path;  // 抓包文件.
+  double speed = 0;  // 回放速度倍数, 0为尽快回放.
+  int repeat = 1;  // 回放次数.
+  bool dump = false;  // 显示接收到的消息内容.
+  bool json = false;
+};
+
+void Usage(char const* name) {
+  printf("Usage: %s [options] CAPTURE\n", name);
+  printf("  --speed X              replay speed, 1 = original timing, "
+         "default 0 = as fast as possible\n");
+  printf("  --repeat N             replay the capture N times, default 1\n");
+  printf("  --dump                 print decoded messages\n");
+  printf("  --format=json          machine-readable output\n");
+}
+
+int ParseOptions(int argc, char** argv, ReplayOptions* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg(argv[i]);
+    if (arg == "--format=json") {
+      options->json = true;
+      continue;
+    }
+    if (arg == "--format=text") {
+      options->json = false;
+      continue;
+    }
+    if (arg == "--dump") {
+      options->dump = true;
+      continue;
+    }
+    if (arg.compare(0, 2, "--") != 0) {
+      options->path = arg;
+      continue;
+    }
+    if (i+1 >= argc) return -1;
+    char const* value = argv[++i];
+    if (arg == "--speed") {
+      options->speed = atof(value);
+    } else if (arg == "--repeat") {
+      options->repeat = atoi(value);
+    } else {
+      return -1;
+    }
+  }
+  if (options->path.empty() || options->repeat <= 0) return -1;
+  return 0;
+}
+
+}  // namespace
+
+// 抓包回放: 抓包文件中的原始数据依次经过帧切分、解析和分发, 不使用socket,
+// 用于解析和分发的性能测试以及现场问题复现.
+// 抓包文件由JT808Server::StartFrameCapture()或
+// jt808_server_bench --capture生成.
+int main(int argc, char** argv) {
+  ReplayOptions options;
+  if (ParseOptions(argc, argv, &options) != 0) {
+    Usage(argv[0]);
+    return -1;
+  }
+  libjt808::JT808Server server;
+  server.Init();
+  server.set_message_dump(options.dump);
+  std::atomic<uint64_t> location_records(0);
+  server.OnLocationReported(
+      [&location_records] (libjt808::LocationRecord const*,
+                           size_t const& num) {
+        location_records.fetch_add(num, std::memory_order_relaxed);
+      });
+  server.OnMultimediaDataUploaded(
+      [] (libjt808::MultiMediaDataUpload const&) {});
+
+  int64_t frames = 0;
+  auto const begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < options.repeat; ++i) {
+    int64_t const ret = server.ReplayCapture(options.path, options.speed);
+    if (ret < 0) {
+      fprintf(stderr, "Replay %s failed\n", options.path.c_str());
+      return -1;
+    }
+    frames += ret;
+  }
+  double const elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  libjt808::MetricsSnapshot snapshot;
+  server.metrics().Snapshot(&snapshot);
+  uint64_t parse_failures = 0;
+  for (auto const& failures : snapshot.parse_failures) {
+    parse_failures += failures;
+  }
+  auto const& hist = snapshot.dispatch_latency_us;
+  double const bytes = static_cast<double>(snapshot.bytes_in);
+  if (options.json) {
+    printf("{\n");
+    printf("  \"context\": {\"library_version\": \"%s\", \"capture\": \"%s\", "
+           "\"speed\": %g, \"repeat\": %d},\n", JT808_VERSION,
+           options.path.c_str(), options.speed, options.repeat);
+    printf("  \"frames\": %ld,\n", static_cast<long>(frames));
+    printf("  \"bytes\": %.0f,\n", bytes);
+    printf("  \"parse_failures\": %lu,\n",
+           static_cast<unsigned long>(parse_failures));
+    printf("  \"location_records\": %lu,\n",
+           static_cast<unsigned long>(location_records.load()));
+    printf("  \"elapsed_seconds\": %.3f,\n", elapsed);
+    printf("  \"frames_per_second\": %.1f,\n", frames/elapsed);
+    printf("  \"megabytes_per_second\": %.2f,\n", bytes/elapsed/1e6);
+    printf("  \"dispatch_latency_us\": {\"count\": %lu, \"mean\": %.1f, "
+           "\"p50\": %lu, \"p99\": %lu, \"max\": %lu}\n",
+           static_cast<unsigned long>(hist.count()), hist.mean(),
+           static_cast<unsigned long>(hist.Percentile(50.0)),
+           static_cast<unsigned long>(hist.Percentile(99.0)),
+           static_cast<unsigned long>(hist.max()));
+    printf("}\n");
+  } else {
+    printf("Capture: %s, speed: %g, repeat: %d\n", options.path.c_str(),
+           options.speed, options.repeat);
+    printf("  frames:            %ld (%lu parse failures)\n",
+           static_cast<long>(frames),
+           static_cast<unsigned long>(parse_failures));
+    printf("  location records:  %lu\n",
+           static_cast<unsigned long>(location_records.load()));
+    printf("  elapsed:           %.3fs\n", elapsed);
+    printf("  throughput:        %.1f frames/s, %.2f MB/s\n",
+           frames/elapsed, bytes/elapsed/1e6);
+    printf("  dispatch(us):      p50 %lu, p99 %lu, max %lu\n",
+           static_cast<unsigned long>(hist.Percentile(50.0)),
+           static_cast<unsigned long>(hist.Percentile(99.0)),
+           static_cast<unsigned long>(hist.max()));
+  }
+  return 0;
+}
@@ -0,0 +1,419 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_server_bench.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 17:35:42
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "jt808/server.h"
+#include "terminal_emulator.h"
+
+#ifndef JT808_VERSION
+#define JT808_VERSION "unknown"
+#endif
+
+
+namespace {
+
+// 测试配置.
+struct BenchOptions {
+  int port = 18808;
+  int terminal_num = 1000;
+  int thread_num = 2;
+  int warmup = 5;  // 预热时间, 单位秒(s), 所有终端上线后开始计时.
+  int duration = 20;  // 测试时间, 单位秒(s).
+  int report_interval_ms = 1000;
+  // 消息类型权重, 位置信息汇报:心跳:多媒体数据上传.
+  int location_weight = 8;
+  int heartbeat_weight = 1;
+  int multimedia_weight = 1;
+  int multimedia_size = 512;
+  uint32_t seed = 1;
+  bool json = false;
+  std::string capture;  // 服务端抓包文件, 为空时不抓包.
+};
+
+// 进程资源占用.
+struct ProcessUsage {
+  double cpu_sec;  // 用户态和内核态CPU时间之和, 单位秒(s).
+  uint64_t rss_kb;  // 常驻内存, 单位KB.
+};
+
+void Usage(char const* name) {
+  printf("Usage: %s [options]\n", name);
+  printf("  --port N               loopback server port, default 18808\n");
+  printf("  --terminals N          number of terminals, default 1000\n");
+  printf("  --threads N            emulator event loop threads, default 2\n");
+  printf("  --warmup S             warmup seconds after all online, default 5\n");
+  printf("  --duration S           measured seconds, default 20\n");
+  printf("  --report-interval MS   per terminal message interval, default 1000\n");
+  printf("  --mix L:H:M            weights of 0x0200:0x0002:0x0801, default 8:1:1\n");
+  printf("  --multimedia-size N    0x0801 media data bytes, default 512\n");
+  printf("  --seed N               workload random seed, default 1\n");
+  printf("  --capture PATH         write server inbound capture for jt808_replay\n");
+  printf("  --format=json          machine-readable output\n");
+}
+
+int ParseOptions(int argc, char** argv, BenchOptions* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg(argv[i]);
+    if (arg == "--format=json") {
+      options->json = true;
+      continue;
+    }
+    if (arg == "--format=text") {
+      options->json = false;
+      continue;
+    }
+    if (i+1 >= argc) return -1;
+    char const* value = argv[++i];
+    if (arg == "--port") {
+      options->port = atoi(value);
+    } else if (arg == "--terminals") {
+      options->terminal_num = atoi(value);
+    } else if (arg == "--threads") {
+      options->thread_num = atoi(value);
+    } else if (arg == "--warmup") {
+      options->warmup = atoi(value);
+    } else if (arg == "--duration") {
+      options->duration = atoi(value);
+    } else if (arg == "--report-interval") {
+      options->report_interval_ms = atoi(value);
+    } else if (arg == "--mix") {
+      if (sscanf(value, "%d:%d:%d", &options->location_weight,
+                 &options->heartbeat_weight,
+                 &options->multimedia_weight) != 3) {
+        return -1;
+      }
+    } else if (arg == "--multimedia-size") {
+      options->multimedia_size = atoi(value);
+    } else if (arg == "--seed") {
+      options->seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+    } else if (arg == "--capture") {
+      options->capture = value;
+    } else {
+      return -1;
+    }
+  }
+  if (options->terminal_num <= 0 || options->duration <= 0) return -1;
+  return 0;
+}
+
+#if defined(__linux__)
+
+// 提高进程可打开的文件描述符数上限.
+void RaiseFileLimit(int const& need) {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+  if (limit.rlim_cur < static_cast<rlim_t>(need)) {
+    limit.rlim_cur = (limit.rlim_max < static_cast<rlim_t>(need)) ?
+                     limit.rlim_max : static_cast<rlim_t>(need);
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+
+// 读取进程CPU时间和常驻内存.
+int ReadProcessUsage(pid_t const& pid, ProcessUsage* usage) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+  FILE* fp = fopen(path, "r");
+  if (fp == nullptr) return -1;
+  char buf[1024];
+  size_t const len = fread(buf, 1, sizeof(buf)-1, fp);
+  fclose(fp);
+  buf[len] = '\0';
+  // 进程名可能包含空格, 从最后一个')'之后开始解析, 第14, 15项为utime, stime.
+  char const* pos = strrchr(buf, ')');
+  if (pos == nullptr) return -1;
+  unsigned long utime = 0;
+  unsigned long stime = 0;
+  if (sscanf(pos+2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+             &utime, &stime) != 2) {
+    return -1;
+  }
+  usage->cpu_sec = static_cast<double>(utime + stime)/sysconf(_SC_CLK_TCK);
+  snprintf(path, sizeof(path), "/proc/%d/status", static_cast<int>(pid));
+  fp = fopen(path, "r");
+  if (fp == nullptr) return -1;
+  usage->rss_kb = 0;
+  while (fgets(buf, sizeof(buf), fp) != nullptr) {
+    if (strncmp(buf, "VmRSS:", 6) == 0) {
+      usage->rss_kb = strtoull(buf+6, nullptr, 10);
+      break;
+    }
+  }
+  fclose(fp);
+  return 0;
+}
+
+// 在子进程中运行服务端, 以便单独统计服务端的CPU和内存占用.
+// 子进程在stop_fd关闭(父进程退出或测试结束)后退出.
+pid_t StartServer(int const& port, std::string const& capture,
+                  int* stop_fd) {
+  int ready_pipe[2];
+  int stop_pipe[2];
+  if (pipe(ready_pipe) != 0) return -1;
+  if (pipe(stop_pipe) != 0) {
+    close(ready_pipe[0]);
+    close(ready_pipe[1]);
+    return -1;
+  }
+  pid_t const pid = fork();
+  if (pid == 0) {
+    close(ready_pipe[0]);
+    close(stop_pipe[1]);
+    // 屏蔽服务端输出, 避免混入测试结果.
+    int const null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) dup2(null_fd, STDOUT_FILENO);
+    libjt808::JT808Server server;
+    server.Init();
+    server.SetServerAccessPoint("127.0.0.1", port);
+    server.set_max_connection_num(4096);
+    server.set_message_dump(false);
+    server.OnMultimediaDataUploaded(
+        [] (libjt808::MultiMediaDataUpload const&) {});
+    char const ok = (server.InitServer() == 0 &&
+                     (capture.empty() ||
+                      server.StartFrameCapture(capture) == 0)) ? 1 : 0;
+    if (ok) server.Run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (write(ready_pipe[1], &ok, 1) != 1 || !ok) _exit(1);
+    char ch;
+    while (read(stop_pipe[0], &ch, 1) > 0) {}
+    server.StopFrameCapture();
+    _exit(0);
+  }
+  close(ready_pipe[1]);
+  close(stop_pipe[0]);
+  if (pid < 0) {
+    close(ready_pipe[0]);
+    close(stop_pipe[1]);
+    return -1;
+  }
+  struct pollfd pfd;
+  pfd.fd = ready_pipe[0];
+  pfd.events = POLLIN;
+  char ok = 0;
+  if (poll(&pfd, 1, 5000) != 1 || read(ready_pipe[0], &ok, 1) != 1 || !ok) {
+    close(ready_pipe[0]);
+    close(stop_pipe[1]);
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    return -1;
+  }
+  close(ready_pipe[0]);
+  *stop_fd = stop_pipe[1];
+  return pid;
+}
+
+void StopServer(pid_t const& pid, int const& stop_fd) {
+  close(stop_fd);
+  int status = 0;
+  for (int i = 0; i < 50; ++i) {
+    if (waitpid(pid, &status, WNOHANG) == pid) return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, &status, 0);
+}
+
+double SelfCpuSec(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec/1e6 +
+         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec/1e6;
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  if (ParseOptions(argc, argv, &options) != 0) {
+    Usage(argv[0]);
+    return -1;
+  }
+#if defined(__linux__)
+  RaiseFileLimit(options.terminal_num + 1024);
+  int stop_fd = -1;
+  pid_t const server_pid = StartServer(options.port, options.capture,
+                                       &stop_fd);
+  if (server_pid < 0) {
+    fprintf(stderr, "Start server failed\n");
+    return -1;
+  }
+  ProcessUsage idle;
+  ReadProcessUsage(server_pid, &idle);
+
+  libjt808::EmulatorOptions emulator_options;
+  emulator_options.server_port = options.port;
+  emulator_options.terminal_num = options.terminal_num;
+  emulator_options.thread_num = options.thread_num;
+  emulator_options.report_interval_ms = options.report_interval_ms;
+  emulator_options.location_weight = options.location_weight;
+  emulator_options.heartbeat_weight = options.heartbeat_weight;
+  emulator_options.multimedia_weight = options.multimedia_weight;
+  emulator_options.multimedia_size = options.multimedia_size;
+  emulator_options.seed = options.seed;
+  libjt808::TerminalEmulator emulator(emulator_options);
+  if (emulator.Start() != 0) {
+    fprintf(stderr, "Start terminal emulator failed\n");
+    StopServer(server_pid, stop_fd);
+    return -1;
+  }
+
+  // 等待所有终端上线, 然后预热.
+  auto const connect_start = std::chrono::steady_clock::now();
+  while (emulator.stats().online < static_cast<uint64_t>(options.terminal_num)) {
+    if (std::chrono::steady_clock::now() - connect_start >
+        std::chrono::seconds(120)) {
+      fprintf(stderr, "Only %lu of %d terminals online\n",
+              static_cast<unsigned long>(emulator.stats().online),
+              options.terminal_num);
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  double const connect_sec = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - connect_start).count();
+  fprintf(stderr, "%lu terminals online in %.1fs, warming up %ds\n",
+          static_cast<unsigned long>(emulator.stats().online), connect_sec,
+          options.warmup);
+  std::this_thread::sleep_for(std::chrono::seconds(options.warmup));
+
+  // 测量.
+  emulator.ClearAckLatency();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  auto const begin_stats = emulator.stats();
+  ProcessUsage begin_usage;
+  ReadProcessUsage(server_pid, &begin_usage);
+  double const begin_self_cpu = SelfCpuSec();
+  auto const begin = std::chrono::steady_clock::now();
+  fprintf(stderr, "Measuring %ds\n", options.duration);
+  std::this_thread::sleep_for(std::chrono::seconds(options.duration));
+  auto const end_stats = emulator.stats();
+  ProcessUsage end_usage;
+  ReadProcessUsage(server_pid, &end_usage);
+  double const end_self_cpu = SelfCpuSec();
+  double const elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+  emulator.Stop();
+  StopServer(server_pid, stop_fd);
+
+  auto const hist = emulator.ack_latency();
+  auto const delta = [&] (uint64_t libjt808::EmulatorStats::*field) {
+    return static_cast<double>(end_stats.*field - begin_stats.*field);
+  };
+  double const sent = delta(&libjt808::EmulatorStats::msgs_sent);
+  double const acks = delta(&libjt808::EmulatorStats::acks);
+  double const received = delta(&libjt808::EmulatorStats::msgs_received);
+  double const server_cpu = end_usage.cpu_sec - begin_usage.cpu_sec;
+  double const client_cpu = end_self_cpu - begin_self_cpu;
+  double const online = static_cast<double>(end_stats.online);
+  double const rss_per_conn = (online > 0 && end_usage.rss_kb > idle.rss_kb) ?
+      (end_usage.rss_kb - idle.rss_kb)*1024.0/online : 0.0;
+  double const server_cpu_per_1k = (sent > 0) ? server_cpu*1e3/sent*1e3 : 0.0;
+  double const client_cpu_per_1k = (sent > 0) ? client_cpu*1e3/sent*1e3 : 0.0;
+
+  if (options.json) {
+    printf("{\n");
+    printf("  \"context\": {\"library_version\": \"%s\", \"terminals\": %d, "
+           "\"threads\": %d, \"report_interval_ms\": %d, \"mix\": \"%d:%d:%d\", "
+           "\"multimedia_size\": %d, \"seed\": %u, \"duration\": %d},\n",
+           JT808_VERSION, options.terminal_num, options.thread_num,
+           options.report_interval_ms, options.location_weight,
+           options.heartbeat_weight, options.multimedia_weight,
+           options.multimedia_size, options.seed, options.duration);
+    printf("  \"online\": %.0f,\n", online);
+    printf("  \"frames_sent_per_second\": %.1f,\n", sent/elapsed);
+    printf("  \"frames_received_per_second\": %.1f,\n", received/elapsed);
+    printf("  \"acks_per_second\": %.1f,\n", acks/elapsed);
+    printf("  \"locations_sent\": %.0f,\n",
+           delta(&libjt808::EmulatorStats::locations_sent));
+    printf("  \"heartbeats_sent\": %.0f,\n",
+           delta(&libjt808::EmulatorStats::heartbeats_sent));
+    printf("  \"multimedia_sent\": %.0f,\n",
+           delta(&libjt808::EmulatorStats::multimedia_sent));
+    printf("  \"disconnects\": %.0f,\n",
+           delta(&libjt808::EmulatorStats::disconnects));
+    printf("  \"ack_latency_us\": {\"count\": %lu, \"mean\": %.1f, "
+           "\"p50\": %lu, \"p99\": %lu, \"p999\": %lu, \"max\": %lu},\n",
+           static_cast<unsigned long>(hist.count()), hist.mean(),
+           static_cast<unsigned long>(hist.Percentile(50.0)),
+           static_cast<unsigned long>(hist.Percentile(99.0)),
+           static_cast<unsigned long>(hist.Percentile(99.9)),
+           static_cast<unsigned long>(hist.max()));
+    printf("  \"server_cpu_ms_per_1k_msgs\": %.3f,\n", server_cpu_per_1k);
+    printf("  \"server_cpu_percent\": %.1f,\n", server_cpu/elapsed*100);
+    printf("  \"emulator_cpu_ms_per_1k_msgs\": %.3f,\n", client_cpu_per_1k);
+    printf("  \"server_rss_kb\": %lu,\n",
+           static_cast<unsigned long>(end_usage.rss_kb));
+    printf("  \"server_rss_bytes_per_connection\": %.0f\n", rss_per_conn);
+    printf("}\n");
+  } else {
+    printf("Terminals: %d, threads: %d, interval: %dms, mix(0x0200:0x0002:"
+           "0x0801): %d:%d:%d, seed: %u\n", options.terminal_num,
+           options.thread_num, options.report_interval_ms,
+           options.location_weight, options.heartbeat_weight,
+           options.multimedia_weight, options.seed);
+    printf("  online:            %.0f (disconnects %.0f)\n", online,
+           delta(&libjt808::EmulatorStats::disconnects));
+    printf("  frames sent:       %.1f/s\n", sent/elapsed);
+    printf("  frames received:   %.1f/s\n", received/elapsed);
+    printf("  acks:              %.1f/s\n", acks/elapsed);
+    printf("  ack latency(us):   p50 %lu, p99 %lu, p999 %lu, max %lu\n",
+           static_cast<unsigned long>(hist.Percentile(50.0)),
+           static_cast<unsigned long>(hist.Percentile(99.0)),
+           static_cast<unsigned long>(hist.Percentile(99.9)),
+           static_cast<unsigned long>(hist.max()));
+    printf("  server cpu:        %.3f ms/1k msgs (%.1f%%)\n",
+           server_cpu_per_1k, server_cpu/elapsed*100);
+    printf("  emulator cpu:      %.3f ms/1k msgs\n", client_cpu_per_1k);
+    printf("  server rss:        %lu KB, %.0f bytes/connection\n",
+           static_cast<unsigned long>(end_usage.rss_kb), rss_per_conn);
+  }
+  return 0;
+#else
+  fprintf(stderr, "Only Linux is supported\n");
+  return -1;
+#endif
+}
@@ -0,0 +1,740 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  terminal_emulator.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 15:20:06
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "terminal_emulator.h"
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <random>
+
+#include "jt808/codec_registry.h"
+#include "jt808/frame_assembler.h"
+#include "jt808/packager.h"
+#include "jt808/parser.h"
+#include "jt808/protocol_parameter.h"
+
+
+namespace libjt808 {
+
+namespace {
+
+// 单个终端最多记录的待应答消息数, 超出时丢弃最旧的记录.
+constexpr size_t kMaxPendingAcks = 64;
+
+int64_t NowUsec(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 模拟终端状态.
+enum TerminalState {
+  kDisconnected = 0,
+  kConnecting,
+  kRegistering,
+  kAuthenticating,
+  kOnline,
+};
+
+// 定时任务类型.
+enum TimerType {
+  kTimerConnect = 0,
+  kTimerHandshake,
+  kTimerReport,
+  kTimerHeartbeat,
+};
+
+// 定时任务, generation与终端当前值不一致时说明任务已过期.
+struct Timer {
+  int64_t due;
+  uint32_t terminal;
+  uint32_t generation;
+  uint8_t type;
+  bool operator>(Timer const& other) const { return due > other.due; }
+};
+
+// 等待平台通用应答的消息.
+struct PendingAck {
+  uint16_t flow_num;
+  int64_t send_us;
+};
+
+// 模拟终端.
+struct Terminal {
+  int fd;
+  uint8_t state;
+  bool want_write;
+  uint16_t flow_num;
+  uint32_t generation;
+  int64_t last_send_us;
+  std::string phone;
+  std::vector<uint8_t> auth_code;
+  FrameAssembler assembler;
+  std::vector<uint8_t> out;
+  size_t out_offset;
+  std::vector<PendingAck> pending;
+};
+
+}  // namespace
+
+#if defined(__linux__)
+
+// 事件循环线程, 负责一部分模拟终端.
+class TerminalEmulator::Worker {
+ public:
+  Worker(EmulatorOptions const& options, int const& index,
+         std::atomic_bool const* running,
+         std::atomic<uint32_t> const* latency_epoch)
+      : options_(options), index_(index), running_(running),
+        latency_epoch_(latency_epoch), epoll_fd_(-1),
+        rng_(options.seed + index), tokens_(0), last_refill_us_(0) {
+    memset(&counters_, 0, sizeof(counters_));
+  }
+  ~Worker() {
+    for (auto& t : terminals_) {
+      if (t.fd >= 0) close(t.fd);
+    }
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+  }
+
+  int Init(void) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) return -1;
+    parser_ = DefaultParser();
+    packager_ = DefaultPackager();
+    // 所有终端使用相同的注册信息.
+    para_.register_info.province_id = 0x002c;
+    para_.register_info.city_id = 0x012c;
+    para_.register_info.manufacturer_id = {'S', 'K', 'O', 'E', 'M'};
+    para_.register_info.terminal_model = {'E', 'M', 'U'};
+    para_.register_info.terminal_id = {'0', '0', '0', '0', '0', '1'};
+    para_.register_info.car_plate_color = 0;
+    para_.msg_head.msgbody_attr.u16val = 0;
+    para_.location_info.status.bit.positioning = 1;
+    // 多媒体数据使用固定种子生成, 不同线程的数据相同.
+    auto& upload = para_.multimedia_upload;
+    upload.media_id = 1;
+    upload.media_type = 0;
+    upload.media_format = 0;
+    upload.media_event = 1;
+    upload.channel_id = 1;
+    int const media_size = (options_.multimedia_size < 0) ? 0 :
+                           (options_.multimedia_size > 987) ? 987 :
+                           options_.multimedia_size;
+    std::mt19937 media_rng(options_.seed);
+    upload.media_data.resize(media_size);
+    for (auto& uch : upload.media_data) uch = media_rng() & 0xFF;
+    int const weights[] = {options_.location_weight,
+                           options_.heartbeat_weight,
+                           options_.multimedia_weight};
+    for (int weight : weights) {
+      weight_sum_ += (weight > 0) ? weight : 0;
+      weights_.push_back(weight_sum_);
+    }
+    // 第i个终端由第(i % thread_num)个线程负责.
+    for (int id = index_; id < options_.terminal_num;
+         id += options_.thread_num) {
+      terminals_.emplace_back();
+      auto& t = terminals_.back();
+      t.fd = -1;
+      t.state = kDisconnected;
+      t.want_write = false;
+      t.flow_num = 0;
+      t.generation = 0;
+      t.last_send_us = 0;
+      t.phone = std::to_string(options_.phone_base + id);
+      t.out_offset = 0;
+      ids_.push_back(id);
+    }
+    return 0;
+  }
+
+  void Run(void) {
+    int64_t const start_us = NowUsec();
+    last_refill_us_ = start_us;
+    // 初始连接在各终端之间均匀错开.
+    double const rate = ConnectRatePerWorker();
+    for (size_t i = 0; i < terminals_.size(); ++i) {
+      int64_t const delay = (rate > 0) ? static_cast<int64_t>(i*1e6/rate) : 0;
+      Schedule(i, kTimerConnect, start_us + delay);
+    }
+    int64_t next_storm_us = start_us + options_.storm_interval_ms*1000LL;
+    int64_t next_alarm_us = start_us + options_.alarm_interval_ms*1000LL;
+    struct epoll_event events[256];
+    uint32_t latency_epoch = latency_epoch_->load();
+    while (running_->load()) {
+      if (latency_epoch != latency_epoch_->load()) {
+        latency_epoch = latency_epoch_->load();
+        ack_latency_.Reset();
+      }
+      int64_t now = NowUsec();
+      UpdateTimestamp();
+      RunTimers(now);
+      if (options_.storm_interval_ms > 0 && now >= next_storm_us) {
+        ReconnectStorm();
+        next_storm_us += options_.storm_interval_ms*1000LL;
+      }
+      if (options_.alarm_interval_ms > 0 && now >= next_alarm_us) {
+        AlarmBurst();
+        next_alarm_us += options_.alarm_interval_ms*1000LL;
+      }
+      // 最长等待100ms, 以便及时响应停止请求.
+      int timeout_ms = 100;
+      if (!timers_.empty()) {
+        int64_t const wait = (timers_.top().due - NowUsec() + 999)/1000;
+        if (wait < timeout_ms) timeout_ms = (wait > 0) ? wait : 0;
+      }
+      int const cnt = epoll_wait(epoll_fd_, events,
+                                 sizeof(events)/sizeof(events[0]),
+                                 timeout_ms);
+      for (int i = 0; i < cnt; ++i) {
+        HandleEvent(events[i].data.u32, events[i].events);
+      }
+    }
+    for (size_t i = 0; i < terminals_.size(); ++i) {
+      if (terminals_[i].fd >= 0) Disconnect(i, false);
+    }
+  }
+
+  void Snapshot(EmulatorStats* stats) const {
+    stats->connect_attempts += Load(counters_.connect_attempts);
+    stats->connect_failures += Load(counters_.connect_failures);
+    stats->handshakes += Load(counters_.handshakes);
+    stats->handshake_failures += Load(counters_.handshake_failures);
+    stats->disconnects += Load(counters_.disconnects);
+    stats->online += Load(counters_.online);
+    stats->msgs_sent += Load(counters_.msgs_sent);
+    stats->bytes_sent += Load(counters_.bytes_sent);
+    stats->msgs_received += Load(counters_.msgs_received);
+    stats->acks += Load(counters_.acks);
+    stats->alarms_sent += Load(counters_.alarms_sent);
+    stats->locations_sent += Load(counters_.locations_sent);
+    stats->heartbeats_sent += Load(counters_.heartbeats_sent);
+    stats->multimedia_sent += Load(counters_.multimedia_sent);
+  }
+
+  LatencyHistogram const& ack_latency(void) const { return ack_latency_; }
+
+ private:
+  // 各统计项由本线程写入, 其它线程只读.
+  struct Counters {
+    uint64_t connect_attempts;
+    uint64_t connect_failures;
+    uint64_t handshakes;
+    uint64_t handshake_failures;
+    uint64_t disconnects;
+    uint64_t online;
+    uint64_t msgs_sent;
+    uint64_t bytes_sent;
+    uint64_t msgs_received;
+    uint64_t acks;
+    uint64_t alarms_sent;
+    uint64_t locations_sent;
+    uint64_t heartbeats_sent;
+    uint64_t multimedia_sent;
+  };
+
+  static uint64_t Load(uint64_t const& counter) {
+    return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+  }
+  static void Add(uint64_t* counter, int64_t const& value) {
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+  }
+
+  double ConnectRatePerWorker(void) const {
+    if (options_.connect_rate <= 0) return 0;
+    return static_cast<double>(options_.connect_rate)/options_.thread_num;
+  }
+
+  // 每秒更新一次位置信息汇报中的时间, 封装时由时间戳直接生成BCD时间.
+  void UpdateTimestamp(void) {
+    time_t const now = time(nullptr);
+    if (now == timestamp_sec_) return;
+    timestamp_sec_ = now;
+    para_.location_info.time.clear();
+    para_.location_info.timestamp = now;
+  }
+
+  void Schedule(size_t const& idx, uint8_t const& type, int64_t const& due) {
+    timers_.push(Timer{due, static_cast<uint32_t>(idx),
+                       terminals_[idx].generation, type});
+  }
+
+  int64_t RandomDelayUsec(int const& max_ms) {
+    if (max_ms <= 0) return 0;
+    return std::uniform_int_distribution<int64_t>(0, max_ms*1000LL-1)(rng_);
+  }
+
+  void RunTimers(int64_t const& now) {
+    while (!timers_.empty() && timers_.top().due <= now) {
+      Timer const timer = timers_.top();
+      timers_.pop();
+      auto& t = terminals_[timer.terminal];
+      if (timer.generation != t.generation) continue;  // 已过期.
+      switch (timer.type) {
+        case kTimerConnect:
+          if (t.state == kDisconnected) Connect(timer.terminal, now);
+          break;
+        case kTimerHandshake:
+          if (t.state != kDisconnected && t.state != kOnline) {
+            Add(&counters_.handshake_failures, 1);
+            Disconnect(timer.terminal, true);
+          }
+          break;
+        case kTimerReport:
+          if (t.state == kOnline) {
+            SendPeriodicMessage(timer.terminal);
+            Schedule(timer.terminal, kTimerReport,
+                     timer.due + options_.report_interval_ms*1000LL);
+          }
+          break;
+        case kTimerHeartbeat:
+          if (t.state == kOnline) {
+            int64_t const interval = options_.heartbeat_interval_ms*1000LL;
+            if (now - t.last_send_us >= interval) {
+              Add(&counters_.heartbeats_sent, 1);
+              Send(timer.terminal, kTerminalHeartBeat, true);
+            }
+            Schedule(timer.terminal, kTimerHeartbeat, t.last_send_us + interval);
+          }
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  // 发起非阻塞连接, 超过连接速率限制时延后.
+  void Connect(size_t const& idx, int64_t const& now) {
+    double const rate = ConnectRatePerWorker();
+    if (rate > 0) {
+      tokens_ += (now - last_refill_us_)*rate/1e6;
+      last_refill_us_ = now;
+      if (tokens_ > rate) tokens_ = rate;  // 最多积累1秒的令牌.
+      if (tokens_ < 1.0) {
+        Schedule(idx, kTimerConnect,
+                 now + static_cast<int64_t>((1.0-tokens_)*1e6/rate) + 1);
+        return;
+      }
+      tokens_ -= 1.0;
+    }
+    auto& t = terminals_[idx];
+    Add(&counters_.connect_attempts, 1);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      ConnectFailed(idx);
+      return;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (!options_.bind_ips.empty()) {
+      auto const& ip = options_.bind_ips[ids_[idx] % options_.bind_ips.size()];
+      struct sockaddr_in local;
+      memset(&local, 0, sizeof(local));
+      local.sin_family = AF_INET;
+      local.sin_addr.s_addr = inet_addr(ip.c_str());
+      if (bind(fd, reinterpret_cast<struct sockaddr*>(&local),
+               sizeof(local)) != 0) {
+        close(fd);
+        ConnectFailed(idx);
+        return;
+      }
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(options_.server_port));
+    addr.sin_addr.s_addr = inet_addr(options_.server_ip.c_str());
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                sizeof(addr)) != 0 && errno != EINPROGRESS) {
+      close(fd);
+      ConnectFailed(idx);
+      return;
+    }
+    t.fd = fd;
+    t.state = kConnecting;
+    t.want_write = true;
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.u32 = static_cast<uint32_t>(idx);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    Schedule(idx, kTimerHandshake,
+             now + options_.handshake_timeout_ms*1000LL);
+  }
+
+  void ConnectFailed(size_t const& idx) {
+    Add(&counters_.connect_failures, 1);
+    auto& t = terminals_[idx];
+    ++t.generation;
+    Schedule(idx, kTimerConnect,
+             NowUsec() + RandomDelayUsec(options_.reconnect_delay_ms) + 1000);
+  }
+
+  // 断开连接, reconnect为true时在随机延迟后重新连接.
+  void Disconnect(size_t const& idx, bool const& reconnect) {
+    auto& t = terminals_[idx];
+    if (t.state == kOnline) {
+      Add(&counters_.online, -1);
+      if (reconnect) Add(&counters_.disconnects, 1);  // 不统计停止时的断开.
+    }
+    if (t.fd >= 0) close(t.fd);
+    t.fd = -1;
+    t.state = kDisconnected;
+    t.want_write = false;
+    ++t.generation;
+    t.assembler.Reset();
+    t.out.clear();
+    t.out.shrink_to_fit();
+    t.out_offset = 0;
+    t.pending.clear();
+    if (reconnect) {
+      Schedule(idx, kTimerConnect,
+               NowUsec() + RandomDelayUsec(options_.reconnect_delay_ms));
+    }
+  }
+
+  void HandleEvent(uint32_t const& idx, uint32_t const& events) {
+    if (idx >= terminals_.size()) return;
+    auto& t = terminals_[idx];
+    if (t.fd < 0) return;
+    if (t.state == kConnecting) {
+      int err = 0;
+      socklen_t len = sizeof(err);
+      getsockopt(t.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+      if (err != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+        Disconnect(idx, false);
+        ConnectFailed(idx);
+        return;
+      }
+      if (!(events & EPOLLOUT)) return;
+      t.state = kRegistering;
+      para_.msg_head.phone_num = t.phone;
+      Send(idx, kTerminalRegister, false);
+      return;
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+      if (Receive(idx) < 0) {
+        Disconnect(idx, true);
+        return;
+      }
+    }
+    if (t.fd >= 0 && (events & EPOLLOUT)) {
+      if (Flush(idx) < 0) Disconnect(idx, true);
+    }
+  }
+
+  int Receive(size_t const& idx) {
+    auto& t = terminals_[idx];
+    uint8_t buffer[4096];
+    while (t.fd >= 0) {
+      ssize_t const ret = recv(t.fd, buffer, sizeof(buffer), 0);
+      if (ret > 0) {
+        t.assembler.Append(buffer, static_cast<size_t>(ret));
+        while (t.fd >= 0 && t.assembler.Next(&frame_)) {
+          Add(&counters_.msgs_received, 1);
+          if (HandleFrame(idx) < 0) return -1;
+        }
+        if (ret < static_cast<ssize_t>(sizeof(buffer))) return 0;
+      } else if (ret == 0) {
+        return -1;
+      } else if (errno == EINTR) {
+        continue;
+      } else {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+      }
+    }
+    return 0;
+  }
+
+  int HandleFrame(size_t const& idx) {
+    auto& t = terminals_[idx];
+    if (JT808FrameParse(*parser_, frame_, &para_) != 0) return 0;
+    auto const& msg_id = para_.parse.msg_head.msg_id;
+    if (t.state == kRegistering) {
+      if (msg_id != kTerminalRegisterResponse) return 0;
+      if (para_.parse.respone_result != kRegisterSuccess) return -1;
+      t.auth_code = para_.parse.authentication_code;
+      t.state = kAuthenticating;
+      Send(idx, kTerminalAuthentication, false);
+      return 0;
+    }
+    if (msg_id != kPlatformGeneralResponse) return 0;
+    if (t.state == kAuthenticating) {
+      if (para_.parse.respone_msg_id != kTerminalAuthentication) return 0;
+      if (para_.parse.respone_result != kSuccess) return -1;
+      t.state = kOnline;
+      ++t.generation;  // 使注册鉴权超时任务失效.
+      Add(&counters_.handshakes, 1);
+      Add(&counters_.online, 1);
+      int64_t const now = NowUsec();
+      // 首次位置上报在一个周期内随机错开, 避免所有终端同时上报.
+      Schedule(idx, kTimerReport,
+               now + RandomDelayUsec(options_.report_interval_ms));
+      Schedule(idx, kTimerHeartbeat,
+               now + options_.heartbeat_interval_ms*1000LL);
+      return 0;
+    }
+    // 匹配应答流水号, 统计应答延时.
+    Add(&counters_.acks, 1);
+    auto const& flow_num = para_.parse.respone_flow_num;
+    for (auto it = t.pending.begin(); it != t.pending.end(); ++it) {
+      if (it->flow_num == flow_num) {
+        ack_latency_.Record(NowUsec() - it->send_us);
+        t.pending.erase(it);
+        break;
+      }
+    }
+    return 0;
+  }
+
+  // 按权重随机选择一种消息发送.
+  void SendPeriodicMessage(size_t const& idx) {
+    int const value = (weight_sum_ > 0) ?
+        std::uniform_int_distribution<int>(0, weight_sum_-1)(rng_) : 0;
+    if (weight_sum_ <= 0 || value < weights_[0]) {
+      SendLocationReport(idx, false);
+    } else if (value < weights_[1]) {
+      Add(&counters_.heartbeats_sent, 1);
+      Send(idx, kTerminalHeartBeat, true);
+    } else {
+      auto& upload = para_.multimedia_upload;
+      upload.loaction_report_body.clear();
+      SetLocation(idx);
+      PackageLocationReportBody(para_.location_info, LocationExtensions(),
+                                &upload.loaction_report_body);
+      Add(&counters_.multimedia_sent, 1);
+      Send(idx, kMultimediaDataUpload, true);
+    }
+  }
+
+  void SetLocation(size_t const& idx) {
+    auto const id = ids_[idx];
+    auto& info = para_.location_info;
+    info.alarm.value = 0;
+    info.latitude = 22570336 + (id % 1000)*100;
+    info.longitude = 113937577 + (id / 1000 % 1000)*100;
+    info.altitude = 50;
+    info.speed = 600;
+    info.bearing = static_cast<uint16_t>(id % 360);
+  }
+
+  void SendLocationReport(size_t const& idx, bool const& alarm) {
+    SetLocation(idx);
+    para_.location_info.alarm.bit.sos = alarm ? 1 : 0;
+    if (alarm) Add(&counters_.alarms_sent, 1);
+    Add(&counters_.locations_sent, 1);
+    Send(idx, kLocationReport, true);
+  }
+
+  // 封装并发送一条消息, need_ack为true时统计应答延时.
+  void Send(size_t const& idx, uint16_t const& msg_id, bool const& need_ack) {
+    auto& t = terminals_[idx];
+    para_.msg_head.msg_id = msg_id;
+    para_.msg_head.phone_num = t.phone;
+    para_.msg_head.msg_flow_num = t.flow_num;
+    para_.parse.authentication_code = t.auth_code;
+    if (JT808FramePackage(*packager_, para_, &msg_) < 0) return;
+    int64_t const now = NowUsec();
+    if (need_ack) {
+      if (t.pending.size() >= kMaxPendingAcks) t.pending.erase(t.pending.begin());
+      t.pending.push_back(PendingAck{t.flow_num, now});
+    }
+    ++t.flow_num;
+    t.last_send_us = now;
+    Add(&counters_.msgs_sent, 1);
+    Add(&counters_.bytes_sent, msg_.size());
+    t.out.insert(t.out.end(), msg_.begin(), msg_.end());
+    if (Flush(idx) < 0) Disconnect(idx, true);
+  }
+
+  // 发送缓存中的数据, 未发送完时监听可写事件.
+  int Flush(size_t const& idx) {
+    auto& t = terminals_[idx];
+    while (t.out_offset < t.out.size()) {
+      ssize_t const ret = send(t.fd, t.out.data()+t.out_offset,
+                               t.out.size()-t.out_offset, MSG_NOSIGNAL);
+      if (ret > 0) {
+        t.out_offset += static_cast<size_t>(ret);
+      } else if (ret < 0 && errno == EINTR) {
+        continue;
+      } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      } else {
+        return -1;
+      }
+    }
+    if (t.out_offset >= t.out.size()) {
+      t.out.clear();
+      t.out_offset = 0;
+    }
+    bool const want_write = !t.out.empty();
+    if (want_write != t.want_write) {
+      t.want_write = want_write;
+      struct epoll_event ev;
+      ev.events = EPOLLIN | (want_write ? EPOLLOUT : 0);
+      ev.data.u32 = static_cast<uint32_t>(idx);
+      epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, t.fd, &ev);
+    }
+    return 0;
+  }
+
+  // 随机选择部分在线终端同时断开, 并在随机延迟后重连.
+  void ReconnectStorm(void) {
+    std::bernoulli_distribution pick(options_.storm_fraction);
+    for (size_t i = 0; i < terminals_.size(); ++i) {
+      if (terminals_[i].state == kOnline && pick(rng_)) Disconnect(i, true);
+    }
+  }
+
+  // 随机选择部分在线终端连续发送报警位置信息汇报.
+  void AlarmBurst(void) {
+    std::bernoulli_distribution pick(options_.alarm_fraction);
+    for (size_t i = 0; i < terminals_.size(); ++i) {
+      if (terminals_[i].state != kOnline || !pick(rng_)) continue;
+      for (int n = 0; n < options_.alarm_burst; ++n) {
+        if (terminals_[i].state != kOnline) break;
+        SendLocationReport(i, true);
+      }
+    }
+  }
+
+  EmulatorOptions const& options_;
+  int index_;
+  std::atomic_bool const* running_;
+  std::atomic<uint32_t> const* latency_epoch_;
+  int epoll_fd_;
+  std::mt19937 rng_;
+  double tokens_;  // 连接速率限制令牌数.
+  int64_t last_refill_us_;
+  time_t timestamp_sec_ = 0;
+  int weight_sum_ = 0;
+  std::vector<int> weights_;  // 各消息类型的累计权重.
+  std::vector<Terminal> terminals_;
+  std::vector<int> ids_;  // 各终端的全局编号.
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+  std::shared_ptr<Parser const> parser_;
+  std::shared_ptr<Packager const> packager_;
+  ProtocolParameter para_;
+  std::vector<uint8_t> frame_;
+  std::vector<uint8_t> msg_;
+  Counters counters_;
+  LatencyHistogram ack_latency_;
+};
+
+TerminalEmulator::TerminalEmulator(EmulatorOptions const& options)
+    : options_(options) {
+  running_.store(false);
+  latency_epoch_.store(0);
+  if (options_.thread_num <= 0) options_.thread_num = 1;
+}
+
+TerminalEmulator::~TerminalEmulator() {
+  Stop();
+}
+
+int TerminalEmulator::Start(void) {
+  if (running_.load()) return -1;
+  workers_.clear();
+  for (int i = 0; i < options_.thread_num; ++i) {
+    workers_.emplace_back(new Worker(options_, i, &running_,
+                                     &latency_epoch_));
+    if (workers_.back()->Init() != 0) {
+      workers_.clear();
+      return -1;
+    }
+  }
+  running_.store(true);
+  for (auto& worker : workers_) {
+    threads_.emplace_back(&Worker::Run, worker.get());
+  }
+  return 0;
+}
+
+void TerminalEmulator::Stop(void) {
+  running_.store(false);
+  for (auto& thread : threads_) {
+    if (thread.joinable()) thread.join();
+  }
+  threads_.clear();
+}
+
+EmulatorStats TerminalEmulator::stats(void) const {
+  EmulatorStats stats;
+  memset(&stats, 0, sizeof(stats));
+  for (auto const& worker : workers_) worker->Snapshot(&stats);
+  return stats;
+}
+
+LatencyHistogram TerminalEmulator::ack_latency(void) const {
+  LatencyHistogram hist;
+  for (auto const& worker : workers_) hist.Merge(worker->ack_latency());
+  return hist;
+}
+
+#else
+
+// 其它平台暂不支持.
+class TerminalEmulator::Worker {};
+
+TerminalEmulator::TerminalEmulator(EmulatorOptions const& options)
+    : options_(options) {
+  running_.store(false);
+  latency_epoch_.store(0);
+}
+
+TerminalEmulator::~TerminalEmulator() {}
+
+int TerminalEmulator::Start(void) { return -1; }
+
+void TerminalEmulator::Stop(void) {}
+
+EmulatorStats TerminalEmulator::stats(void) const {
+  EmulatorStats stats = {};
+  return stats;
+}
+
+LatencyHistogram TerminalEmulator::ack_latency(void) const {
+  return LatencyHistogram();
+}
+
+#endif
+
+}  // namespace libjt808
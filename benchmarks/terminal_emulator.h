@@ -0,0 +1,157 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  terminal_emulator.h
+// @Version :  1.0
+// @Time    :  2026/10/18 15:20:06
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_BENCHMARKS_TERMINAL_EMULATOR_H_
+#define JT808_BENCHMARKS_TERMINAL_EMULATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/latency_histogram.h"
+
+
+namespace libjt808 {
+
+// 终端模拟器配置.
+struct EmulatorOptions {
+  // 服务端地址.
+  std::string server_ip = "127.0.0.1";
+  int server_port = 8888;
+  // 本地绑定地址, 轮流分配给各终端.
+  // 单个本地地址到同一服务端端口最多约28000个连接, 需要更多终端时
+  // 可指定多个回环地址, 如127.0.0.2, 127.0.0.3.
+  std::vector<std::string> bind_ips;
+  // 模拟终端数.
+  int terminal_num = 1000;
+  // 事件循环线程数.
+  int thread_num = 4;
+  // 每秒最多发起的新连接数, 0表示不限制.
+  int connect_rate = 2000;
+  // 位置信息汇报时间间隔, 单位毫秒(ms).
+  int report_interval_ms = 1000;
+  // 心跳时间间隔, 单位毫秒(ms), 该时间内无其它消息发送时发送心跳.
+  int heartbeat_interval_ms = 30000;
+  // 注册鉴权超时时间, 单位毫秒(ms).
+  int handshake_timeout_ms = 10000;
+  // 断线后重连延迟上限, 单位毫秒(ms), 实际延迟在[0, 上限)内随机.
+  int reconnect_delay_ms = 1000;
+  // 重连风暴周期, 单位毫秒(ms), 0表示关闭.
+  // 每个周期内随机选择storm_fraction比例的在线终端同时断开并重连.
+  int storm_interval_ms = 0;
+  double storm_fraction = 0.1;
+  // 报警突发周期, 单位毫秒(ms), 0表示关闭.
+  // 每个周期内随机选择alarm_fraction比例的在线终端,
+  // 连续发送alarm_burst条带报警标志的位置信息汇报.
+  int alarm_interval_ms = 0;
+  double alarm_fraction = 0.01;
+  int alarm_burst = 5;
+  // 周期上报的消息类型权重, 每个上报周期按权重随机选择一种消息发送:
+  // 位置信息汇报(0x0200), 心跳(0x0002), 多媒体数据上传(0x0801).
+  int location_weight = 1;
+  int heartbeat_weight = 0;
+  int multimedia_weight = 0;
+  // 多媒体数据上传(0x0801)消息中的多媒体数据长度, 不超过987字节.
+  int multimedia_size = 512;
+  // 终端手机号起始值, 第i个终端的手机号为phone_base+i.
+  uint64_t phone_base = 13800000000ULL;
+  // 随机数种子, 相同种子下各终端的行为序列相同.
+  uint32_t seed = 1;
+};
+
+// 终端模拟器统计数据.
+struct EmulatorStats {
+  uint64_t connect_attempts;  // 发起连接次数.
+  uint64_t connect_failures;  // 连接失败次数.
+  uint64_t handshakes;  // 注册鉴权成功次数.
+  uint64_t handshake_failures;  // 注册鉴权失败或超时次数.
+  uint64_t disconnects;  // 在线后断开连接次数.
+  uint64_t online;  // 当前在线终端数.
+  uint64_t msgs_sent;  // 发送的消息数.
+  uint64_t bytes_sent;  // 发送的字节数.
+  uint64_t msgs_received;  // 接收的消息数.
+  uint64_t acks;  // 收到的平台通用应答数.
+  uint64_t alarms_sent;  // 发送的报警位置信息汇报数.
+  uint64_t locations_sent;  // 发送的位置信息汇报数.
+  uint64_t heartbeats_sent;  // 发送的心跳数.
+  uint64_t multimedia_sent;  // 发送的多媒体数据上传数.
+};
+
+// 多终端模拟器.
+// 少量事件循环线程(epoll)驱动大量模拟终端, 每个终端独立完成连接, 注册,
+// 鉴权, 按周期发送位置信息汇报和心跳, 并统计消息从发送到收到平台通用应答
+// 的延时. 仅支持Linux.
+//
+// Example:
+//     EmulatorOptions options;
+//     options.terminal_num = 10000;
+//     TerminalEmulator emulator(options);
+//     emulator.Start();
+//     std::this_thread::sleep_for(std::chrono::seconds(60));
+//     emulator.Stop();
+//     auto const stats = emulator.stats();
+//     auto const hist = emulator.ack_latency();
+class TerminalEmulator {
+ public:
+  explicit TerminalEmulator(EmulatorOptions const& options);
+  ~TerminalEmulator();
+  TerminalEmulator(TerminalEmulator const&) = delete;
+  TerminalEmulator& operator=(TerminalEmulator const&) = delete;
+
+  // 启动所有事件循环线程.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Start(void);
+  // 停止所有事件循环线程并断开所有连接.
+  void Stop(void);
+  // 获取统计数据, 可在运行期间调用.
+  EmulatorStats stats(void) const;
+  // 获取应答延时直方图(单位微秒), 仅在Stop()之后调用.
+  LatencyHistogram ack_latency(void) const;
+  // 清空应答延时直方图, 用于跳过预热阶段, 各线程在下一次循环时生效.
+  void ClearAckLatency(void) { latency_epoch_.fetch_add(1); }
+
+ private:
+  class Worker;
+
+  EmulatorOptions options_;
+  std::atomic_bool running_;
+  std::atomic<uint32_t> latency_epoch_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_BENCHMARKS_TERMINAL_EMULATOR_H_
@@ -0,0 +1,145 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_area_setting.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 09:12:40
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "jt808/geofence.h"
+#include "jt808/packager.h"
+#include "jt808/parser.h"
+
+
+namespace {
+
+// 2026-10-19 08:00:00和18:00:00(GMT+8)的UTC时间戳.
+constexpr int64_t kStartTimestamp = 1792368000;
+constexpr int64_t kStopTimestamp = 1792404000;
+
+void SetPolygonArea(libjt808::PolygonArea* area) {
+  area->area_id = 0x0001;
+  area->area_attribute.value = 0;
+  area->area_attribute.bit.by_time = 1;
+  area->area_attribute.bit.speed_limit = 1;
+  area->area_attribute.bit.in_alarm_to_server = 1;
+  area->start_time = "261019080000";
+  area->stop_time = "261019180000";
+  area->max_speed = 60;
+  area->overspeed_time = 10;
+  area->vertices = {{114.099323, 22.543608, 0.0}, {114.099323, 22.543606, 0.0},
+                    {114.099321, 22.543606, 0.0}, {114.099321, 22.543608, 0.0}};
+}
+
+// 下发的多边形区域经封装和解析后, 生成的区域规则按起止时间生效.
+int PolygonAreaTimeRangeTest(void) {
+  libjt808::Packager packager;
+  libjt808::JT808FramePackagerInit(&packager);
+  libjt808::Parser parser;
+  libjt808::JT808FrameParserInit(&parser);
+  libjt808::ProtocolParameter svr_para {};
+  libjt808::ProtocolParameter cli_para {};
+  svr_para.msg_head.phone_num = "13523339527";
+  svr_para.msg_head.msg_id = libjt808::kSetPolygonArea;
+  SetPolygonArea(&svr_para.polygon_area);
+  std::vector<uint8_t> out;
+  if (libjt808::JT808FramePackage(packager, svr_para, &out) < 0 ||
+      libjt808::JT808FrameParse(parser, out, &cli_para) != 0) {
+    printf("polygon area: package or parse failed\n");
+    return -1;
+  }
+  auto const& area = cli_para.parse.polygon_area;
+  printf("polygon area: id=%u, time=%s-%s, max_speed=%u, vertices=%zu\n",
+         area.area_id, area.start_time.c_str(), area.stop_time.c_str(),
+         area.max_speed, area.vertices.size());
+  if (area.start_time != "261019080000" || area.stop_time != "261019180000" ||
+      area.max_speed != 60 || area.overspeed_time != 10 ||
+      area.vertices.size() != 4) {
+    printf("polygon area: parsed fields mismatch\n");
+    return -1;
+  }
+  libjt808::AreaRule rule;
+  libjt808::MakeAreaRule(area.area_attribute, area.start_time,
+                         area.stop_time, area.max_speed,
+                         area.overspeed_time, &rule);
+  if (!rule.attribute.bit.by_time || rule.daily ||
+      rule.start_time != kStartTimestamp || rule.stop_time != kStopTimestamp ||
+      libjt808::IsAreaActive(rule, kStartTimestamp-1) ||
+      !libjt808::IsAreaActive(rule, kStartTimestamp) ||
+      !libjt808::IsAreaActive(rule, kStopTimestamp) ||
+      libjt808::IsAreaActive(rule, kStopTimestamp+1)) {
+    printf("polygon area: time range rule mismatch\n");
+    return -1;
+  }
+  return 0;
+}
+
+// 消息体长度不足以包含起止时间、限速或顶点时解析失败.
+int PolygonAreaTruncatedTest(void) {
+  libjt808::Packager packager;
+  libjt808::JT808FramePackagerInit(&packager);
+  libjt808::Parser parser;
+  libjt808::JT808FrameParserInit(&parser);
+  libjt808::ProtocolParameter svr_para {};
+  svr_para.msg_head.phone_num = "13523339527";
+  svr_para.msg_head.msg_id = libjt808::kSetPolygonArea;
+  SetPolygonArea(&svr_para.polygon_area);
+  svr_para.polygon_area.vertices.clear();
+  std::vector<uint8_t> body;
+  // 消息体: 区域ID和属性6字节, 起止时间12字节, 限速3字节, 顶点数2字节.
+  if (packager[libjt808::kSetPolygonArea](svr_para, &body) != 23) {
+    printf("polygon area: package failed\n");
+    return -1;
+  }
+  std::vector<uint8_t> out;
+  for (size_t body_len = 0; body_len < body.size(); ++body_len) {
+    libjt808::JT808FramePackagerOverride(&packager, libjt808::kSetPolygonArea,
+        [&body, body_len] (libjt808::ProtocolParameter const&,
+                           std::vector<uint8_t>* out) -> int {
+          out->insert(out->end(), body.begin(), body.begin()+body_len);
+          return static_cast<int>(body_len);
+        });
+    libjt808::ProtocolParameter cli_para {};
+    if (libjt808::JT808FramePackage(packager, svr_para, &out) < 0) continue;
+    if (libjt808::JT808FrameParse(parser, out, &cli_para) == 0) {
+      printf("polygon area: truncated body(%zu bytes) accepted\n", body_len);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int ret = 0;
+  if (PolygonAreaTimeRangeTest() != 0) ret = -1;
+  if (PolygonAreaTruncatedTest() != 0) ret = -1;
+  printf("%s\n", ret == 0 ? "PASS" : "FAIL");
+  return ret;
+}
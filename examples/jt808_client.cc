@@ -35,7 +35,7 @@
 #include "jt808/client.h"
 
 
-using LocationExtensions = std::map<uint8_t, std::vector<uint8_t>>;
+using libjt808::LocationExtensions;
 
 namespace {
 
@@ -38,6 +38,9 @@
 #include <vector>
 
 #include "nmea_parser.h"
+#include "jt808/area_tracker.h"
+#include "jt808/bcd.h"
+#include "jt808/geofence.h"
 #include "jt808/packager.h"
 #include "jt808/parser.h"
 
@@ -77,69 +80,6 @@ int SetPolygonArea(uint32_t const& area_id,
   return 0;
 }
 
-// 地球半径, 取赤道半径取值, 单位为千米(Km).
-constexpr double kEarthRadius = 6378.137;
-//  同一经度下1°纬度差的直线距离, 单位为千米(Km).
-constexpr double kDistanceStep = 111.31949079327372;
-constexpr double kPI = 3.1415926535897931;
-
-constexpr double DegreeToRadian(double const& degree) {
-  return (degree * kPI / 180.0);
-}
-constexpr double LonLatMax(double const& lval, double const& rval) {
-  return (lval > rval ? lval:rval);
-}
-
-constexpr double LonLatMin(double const& lval, double const& rval) {
-  return (lval < rval ? lval:rval);
-}
-
-bool LonLatEqual(double const& lval, double const& rval) {
-  return (fabs(lval-rval) < 1e-7);
-}
-
-// double DistanceInMap(double const& longitudel, double const& latitudel,
-//                      double const& longituder, double const& latituder) {
-//   auto rad_lat1 = DegreeToRadian(latitudel);
-//   auto rad_lat2 = DegreeToRadian(latituder);
-//   auto d_lat = rad_lat1 - rad_lat2;
-//   auto d_lon = (DegreeToRadian(longitudel)- DegreeToRadian(longituder));
-//   auto distance = 2*asin(sqrt(pow(sin(d_lat/2), 2)+
-//                               cos(rad_lat1)*
-//                               cos(rad_lat2)*
-//                               pow(sin(d_lon/2), 2)));
-//   distance *= kEarthRadius;
-//   return distance;  // 单位为Km
-// }
-
-bool IsPointInsidePolygon(LocationPoint const& check_point,
-                          std::vector<LocationPoint> const& points) {
-  int corss_cnt = 0;
-  auto count = points.size();
-  for (size_t i = 0; i < count; ++i) {
-    auto const& point1 = points[i];
-    auto const& point2 = points[(i+1)%count];
-    if (check_point.latitude > LonLatMax(point1.latitude, point2.latitude) ||
-        check_point.latitude < LonLatMin(point1.latitude, point2.latitude) ||
-        check_point.longitude >
-            LonLatMax(point1.longitude, point2.longitude) ||
-        LonLatEqual(check_point.latitude,
-            LonLatMax(point1.latitude, point2.latitude)) ||
-        LonLatEqual(check_point.latitude,
-            LonLatMin(point1.latitude, point2.latitude))) {
-      continue;
-    }
-    double longitude = point1.longitude-
-        (point1.longitude-point2.longitude)*
-        (point1.latitude-check_point.latitude)/
-        (point1.latitude-point2.latitude);
-    if (longitude > check_point.longitude) {
-      ++corss_cnt;
-    }
-  }
-  return (corss_cnt%2 == 1);
-}
-
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -238,6 +178,9 @@ int main(int argc, char **argv) {
       ++i;
     }
   }
+  // 区域空间索引.
+  libjt808::GeofenceIndex geofence;
+  geofence.Build(polygon_area_set);
   //
   // NMEA解析.
   //
@@ -247,8 +190,9 @@ int main(int argc, char **argv) {
   nmea_parser.OnNmeaCallback([](const char *line) {
     printf("NMEA: %s\r\n", line);
   });
-  uint32_t in_out_area_flag = 0;
-  uint32_t last_in_out_area_id = 0;
+  // 区域状态跟踪, 定位点离开安全范围时才查询区域空间索引.
+  libjt808::AreaTracker area_tracker;
+  std::vector<libjt808::AreaEvent> area_events;
   // 解析回调函数.
   nmea_parser.OnLocationCallback(
     [&](const libnmeaparser::GPSLocation &location) {
@@ -262,42 +206,46 @@ int main(int argc, char **argv) {
              location.altitude, location.satellites_used,
              location.speed, location.bearing);
       LocationPoint point {location.longitude, location.latitude, 0.0};
+      int64_t timestamp = 0;
+      libjt808::TimeStringToTimestamp(
+          std::string(location.utc_time, location.utc_time+12), &timestamp);
       cli_para.location_info.alarm.bit.in_out_area = 0;
-      for (auto const& area: polygon_area_set) {
-        // 判断是否进入区域.
-        if ((IsPointInsidePolygon(point, area.second.vertices)) &&
-            area.second.area_attribute.bit.in_alarm_to_server) {
-          if (in_out_area_flag%2 == 1) break;  // 未离开区域.
-          cli_para.location_info.alarm.bit.in_out_area = 1;
-          last_in_out_area_id = area.first;
-          std::vector<uint8_t> item_value;
-          if (libjt808::SetAccessAreaAlarmBody(
-            libjt808::kAccessAreaAlarmPolygonArea, area.first,
-            libjt808::kAccessAreaAlarmInArea, &item_value) == 0) {
+      area_events.clear();
+      area_tracker.Update(geofence, libjt808::ToGeoPoint(point), timestamp,
+                          static_cast<uint16_t>(location.speed/10),
+                          &area_events);
+      for (auto const& event : area_events) {
+        auto const& it = polygon_area_set.find(event.area.area_id);
+        if (it == polygon_area_set.end()) continue;
+        auto const& attribute = it->second.area_attribute.bit;
+        std::vector<uint8_t> item_value;
+        if (event.type == libjt808::kAreaEventOverspeed) {
+          // 区域内超速.
+          cli_para.location_info.alarm.bit.overspeed = 1;
+          if (libjt808::SetOverSpeedAlarmBody(
+            libjt808::kOverSpeedAlarmPolygonArea, event.area.area_id,
+            &item_value) == 0) {
             cli_para.location_extension.insert(
-                std::make_pair(libjt808::kAccessAreaAlarm, item_value));
+                std::make_pair(libjt808::kOverSpeedAlarm, item_value));
           }
-          ++in_out_area_flag;
-          break;
+          continue;
         }
-      }
-      // 判断是否离开区域.
-      if ((cli_para.location_info.alarm.bit.in_out_area == 0) &&
-          (in_out_area_flag%2 == 1)) {
-        auto const& it = polygon_area_set.find(last_in_out_area_id);
-        if ((it != polygon_area_set.end()) &&
-            it->second.area_attribute.bit.out_alarm_to_server) {
-          cli_para.location_info.alarm.bit.in_out_area = 1;
-          std::vector<uint8_t> item_value;
-          if (libjt808::SetAccessAreaAlarmBody(
-            libjt808::kAccessAreaAlarmPolygonArea, last_in_out_area_id,
-            libjt808::kAccessAreaAlarmOutArea, &item_value) == 0) {
-            cli_para.location_extension.insert(
-                std::make_pair(libjt808::kAccessAreaAlarm, item_value));
-          }
+        // 判断是否进入或离开区域.
+        bool const in = (event.type == libjt808::kAreaEventEnter);
+        if ((!in && event.type != libjt808::kAreaEventExit) ||
+            (in && !attribute.in_alarm_to_server) ||
+            (!in && !attribute.out_alarm_to_server)) {
+          continue;
+        }
+        cli_para.location_info.alarm.bit.in_out_area = 1;
+        if (libjt808::SetAccessAreaAlarmBody(
+          libjt808::kAccessAreaAlarmPolygonArea, event.area.area_id,
+          in ? libjt808::kAccessAreaAlarmInArea :
+               libjt808::kAccessAreaAlarmOutArea,
+          &item_value) == 0) {
+          cli_para.location_extension.insert(
+              std::make_pair(libjt808::kAccessAreaAlarm, item_value));
         }
-        ++in_out_area_flag;
-        last_in_out_area_id = 0;
       }
 
       auto& status = cli_para.location_info.status;
@@ -410,6 +358,7 @@ int main(int argc, char **argv) {
       if (iter != polygon_area_set.end()) {
         iter->second.vertices.clear();
         polygon_area_set.erase(iter);
+        geofence.Remove(id);
       }
     }
     cli_para.parse.polygon_area_id.clear();
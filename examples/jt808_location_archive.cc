@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_location_archive.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 10:05:17
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "jt808/location_archive.h"
+
+
+namespace {
+
+constexpr char kArchivePath[] = "./jt808_location_archive.archive";
+
+void MakeRecord(char const* phone_num, int64_t const& timestamp,
+                libjt808::LocationRecord* record) {
+  memset(record, 0, sizeof(*record));
+  snprintf(record->phone_num, sizeof(record->phone_num), "%s", phone_num);
+  record->timestamp = timestamp;
+  record->longitude = 113937577;
+  record->latitude = 22570336;
+  record->speed = 600;
+}
+
+// 数据块未满但缓存时间超过最大块时长时写入文件, 不需要Flush()或Close().
+int BlockAgeTest(void) {
+  remove(kArchivePath);
+  libjt808::LocationArchiveWriter writer;
+  if (writer.Open(kArchivePath, 1024, 200) != 0) {
+    printf("archive: open failed\n");
+    return -1;
+  }
+  libjt808::LocationRecord record;
+  for (int i = 0; i < 5; ++i) {
+    MakeRecord("13395279527", 1792368000+i, &record);
+    writer.Append(&record, 1);
+  }
+  if (writer.block_num() != 0) {
+    printf("archive: block written before the age limit\n");
+    return -1;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  // 其他终端的记录触发块时长检查.
+  MakeRecord("13395279528", 1792368005, &record);
+  writer.Append(&record, 1);
+  if (writer.block_num() != 1) {
+    printf("archive: aged block not written, blocks=%lu\n",
+           static_cast<unsigned long>(writer.block_num()));
+    return -1;
+  }
+  // 写入方未关闭时即可读取已写出的数据块.
+  libjt808::LocationArchiveReader reader;
+  std::vector<libjt808::LocationRecord> track;
+  if (reader.Open(kArchivePath) != 0 ||
+      reader.Read("13395279527", 0, INT64_MAX, &track) != 0) {
+    printf("archive: read failed\n");
+    return -1;
+  }
+  printf("archive: blocks=%zu, records=%lu, track=%zu\n", reader.block_num(),
+         static_cast<unsigned long>(reader.record_num()), track.size());
+  if (reader.block_num() != 1 || track.size() != 5 ||
+      track.front().timestamp != 1792368000 ||
+      track.back().timestamp != 1792368004) {
+    printf("archive: aged block content mismatch\n");
+    return -1;
+  }
+  reader.Close();
+  writer.Close();
+  remove(kArchivePath);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int ret = 0;
+  if (BlockAgeTest() != 0) ret = -1;
+  printf("%s\n", ret == 0 ? "PASS" : "FAIL");
+  return ret;
+}
@@ -45,6 +45,7 @@ int main(int argc, char **argv) {
   libjt808::JT808Server server;
   server.Init();
   server.SetServerAccessPoint("127.0.0.1", 8888);
+  server.set_message_dump(true);
   if (server.InitServer() == 0) {
     server.Run();
     std::string cmd;
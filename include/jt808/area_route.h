@@ -98,6 +98,155 @@ struct PolygonArea {
 // 多边形区域集, map<区域ID, 区域信息>.
 using PolygonAreaSet = std::map<uint32_t, PolygonArea>;
 
+// 设置区域(0x8600/0x8602)的设置属性.
+enum AreaSettingType {
+  // 更新区域, 删除终端已有的全部同类区域后再添加.
+  kAreaSettingUpdate = 0x0,
+  // 追加区域, 区域ID已存在时替换.
+  kAreaSettingAppend = 0x1,
+  // 修改区域, 只修改终端已有的同ID区域.
+  kAreaSettingModify = 0x2,
+};
+
+// 圆形区域.
+struct CircularArea {
+  // 区域ID.
+  uint32_t area_id;
+  // 区域属性.
+  AreaAttribute area_attribute;
+  // 中心点, 只使用经纬度.
+  LocationPoint center;
+  // 半径, 单位为米(m).
+  uint32_t radius;
+  // 格式为"YYMMDDhhmmss", 若区域属性 0 位为 0 则没有该字段.
+  std::string start_time;
+  // 格式为"YYMMDDhhmmss", 若区域属性 0 位为 0 则没有该字段.
+  std::string stop_time;
+  // 单位为公里每小时(km/h), 若区域属性 1 位为 0 则没有该字段.
+  uint16_t max_speed;
+  // 超速持续时间, 单位为秒(s), 若区域属性 1 位为 0 则没有该字段.
+  uint8_t overspeed_time;
+};
+
+// 圆形区域集, map<区域ID, 区域信息>.
+using CircularAreaSet = std::map<uint32_t, CircularArea>;
+
+// 设置圆形区域.
+struct CircularAreaSetting {
+  // 设置属性, 见AreaSettingType.
+  uint8_t setting_type;
+  // 区域项.
+  CircularAreaSet areas;
+};
+
+// 矩形区域.
+struct RectangleArea {
+  // 区域ID.
+  uint32_t area_id;
+  // 区域属性.
+  AreaAttribute area_attribute;
+  // 左上点, 只使用经纬度.
+  LocationPoint upper_left;
+  // 右下点, 只使用经纬度.
+  LocationPoint lower_right;
+  // 格式为"YYMMDDhhmmss", 若区域属性 0 位为 0 则没有该字段.
+  std::string start_time;
+  // 格式为"YYMMDDhhmmss", 若区域属性 0 位为 0 则没有该字段.
+  std::string stop_time;
+  // 单位为公里每小时(km/h), 若区域属性 1 位为 0 则没有该字段.
+  uint16_t max_speed;
+  // 超速持续时间, 单位为秒(s), 若区域属性 1 位为 0 则没有该字段.
+  uint8_t overspeed_time;
+};
+
+// 矩形区域集, map<区域ID, 区域信息>.
+using RectangleAreaSet = std::map<uint32_t, RectangleArea>;
+
+// 设置矩形区域.
+struct RectangleAreaSetting {
+  // 设置属性, 见AreaSettingType.
+  uint8_t setting_type;
+  // 区域项.
+  RectangleAreaSet areas;
+};
+
+// 路线属性.
+union RouteAttribute {
+  struct {
+    // 1: 根据时间.
+    uint16_t by_time:1;
+    // 保留.
+    uint16_t retain1:1;
+    // 1: 进路线报警给驾驶员.
+    uint16_t in_alarm_to_dirver:1;
+    // 1: 进路线报警给平台.
+    uint16_t in_alarm_to_server:1;
+    // 1: 出路线报警给驾驶员.
+    uint16_t out_alarm_to_dirver:1;
+    // 1: 出路线报警给平台.
+    uint16_t out_alarm_to_server:1;
+    // 保留10位.
+    uint16_t retain2:10;
+  }bit;
+  uint16_t value;
+};
+
+// 路段属性.
+union RouteSegmentAttribute {
+  struct {
+    // 1: 行驶时间.
+    uint8_t driving_time:1;
+    // 1: 限速.
+    uint8_t speed_limit:1;
+    // 0: 北纬:1; 1: 南纬.
+    uint8_t sn_latitude:1;
+    // 0: 东经:1; 1: 西经.
+    uint8_t ew_longitude:1;
+    // 保留4位.
+    uint8_t retain:4;
+  }bit;
+  uint8_t value;
+};
+
+// 路线拐点, 拐点到下一拐点为一个路段, 路段参数保存在起始拐点中.
+struct RouteInflectionPoint {
+  // 拐点ID.
+  uint32_t point_id;
+  // 路段ID.
+  uint32_t segment_id;
+  // 拐点位置, 只使用经纬度.
+  LocationPoint point;
+  // 路段宽度, 单位为米(m).
+  uint8_t width;
+  // 路段属性.
+  RouteSegmentAttribute segment_attribute;
+  // 路段行驶过长阈值, 单位为秒(s), 若路段属性 0 位为 0 则没有该字段.
+  uint16_t max_driving_time;
+  // 路段行驶不足阈值, 单位为秒(s), 若路段属性 0 位为 0 则没有该字段.
+  uint16_t min_driving_time;
+  // 路段最高速度, 单位为公里每小时(km/h), 若路段属性 1 位为 0 则没有该字段.
+  uint16_t max_speed;
+  // 路段超速持续时间, 单位为秒(s), 若路段属性 1 位为 0 则没有该字段.
+  uint8_t overspeed_time;
+};
+
+// 路线.
+struct Route {
+  // 路线ID.
+  uint32_t route_id;
+  // 路线属性.
+  RouteAttribute route_attribute;
+  // 格式为"YYMMDDhhmmss", 若路线属性 0 位为 0 则没有该字段.
+  std::string start_time;
+  // 格式为"YYMMDDhhmmss", 若路线属性 0 位为 0 则没有该字段.
+  std::string stop_time;
+  // 路线拐点项.
+  std::vector<RouteInflectionPoint> points;
+};
+
+// 路线集, map<路线ID, 路线信息>.
+using RouteSet = std::map<uint32_t, Route>;
+
 }  // namespace libjt808
 
 #endif  // JT808_AREA_ROUTE_H_
@@ -0,0 +1,139 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  area_tracker.h
+// @Version :  1.0
+// @Time    :  2026/10/19 03:02:37
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_AREA_TRACKER_H_
+#define JT808_AREA_TRACKER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "jt808/geofence.h"
+#include "jt808/geometry.h"
+
+
+namespace libjt808 {
+
+// 区域状态变化事件类型.
+enum AreaEventType {
+  // 进区域.
+  kAreaEventEnter = 0x0,
+  // 出区域.
+  kAreaEventExit,
+  // 区域内超速, 速度超过最高速度并持续达到超速持续时间.
+  kAreaEventOverspeed,
+  // 区域内超速结束, 速度不再超过最高速度或离开区域.
+  kAreaEventOverspeedEnd,
+};
+
+// 区域状态变化事件.
+struct AreaEvent {
+  // 区域.
+  AreaRef area;
+  // 事件类型, 见AreaEventType.
+  uint8_t type;
+};
+
+// 单个终端的区域状态跟踪.
+// 车辆的相邻两次定位通常相距很近, 所在区域很少变化. 跟踪器缓存一个包含
+// 上次定位点的安全范围: 从定位点所在的网格开始, 切除不包含该点的候选区域
+// 外接矩形, 安全范围内只需判断外接矩形包含该点的少数候选区域.
+// 定位点仍在安全范围内时不查询空间索引, 离开安全范围或区域被修改后才重新查询.
+// 根据时间的区域只在时段内生效, 限速区域内速度超过最高速度并持续达到
+// 超速持续时间时产生超速事件. 区域被删除时不产生出区域事件.
+// 非线程安全, 每个终端使用一个跟踪器.
+//
+// Example:
+//     AreaTracker tracker;
+//     std::vector<AreaEvent> events;
+//     tracker.Update(index, MakeGeoPoint(info.longitude, info.latitude),
+//                    info.timestamp, info.speed, &events);
+class AreaTracker {
+ public:
+  AreaTracker();
+
+  // 以一次定位更新区域状态.
+  // 同一跟踪器可更换索引, 索引修改或更换后自动重新查询.
+  // Args:
+  //     index:  区域空间索引.
+  //     point:  定位点.
+  //     timestamp:  定位时间, UTC时间戳, 单位秒.
+  //     speed:  速度, 单位为1/10km/h, 与位置基本信息相同.
+  //     events:  追加产生的事件, 先出区域事件, 再按区域顺序产生
+  //              进区域和超速事件.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Update(GeofenceIndex const& index, GeoPoint const& point,
+             int64_t const& timestamp, uint16_t const& speed,
+             std::vector<AreaEvent>* events);
+  // 当前所在的生效区域, 按类型和区域ID升序排列.
+  void GetAreas(std::vector<AreaRef>* areas) const;
+  // 当前所在的生效区域个数.
+  size_t area_num(void) const { return inside_.size(); }
+  // 当前是否在某个区域内超速.
+  bool overspeed(void) const;
+  // 清除状态, 下次定位位于区域内时重新产生进区域事件.
+  void Reset(void);
+  // 查询空间索引的次数.
+  uint64_t refresh_num(void) const { return refresh_num_; }
+
+ private:
+  // 外接矩形包含缓存时定位点的候选区域.
+  struct Candidate {
+    uint32_t slot;
+    GeoBox box;
+  };
+  // 所在的区域及其超速状态.
+  struct InsideArea {
+    AreaRef area;
+    uint32_t slot;
+    int64_t overspeed_since;  // 开始超过最高速度的时间, 未超速时为-1.
+    bool overspeed;  // 已产生超速事件.
+  };
+
+  // 查询空间索引, 重新生成安全范围和候选区域.
+  void Refresh(GeofenceIndex const& index, GeoPoint const& point);
+  // 更新区域内的超速状态.
+  static void CheckSpeed(AreaRule const& rule, int64_t const& timestamp,
+                         uint16_t const& speed, InsideArea* state,
+                         std::vector<AreaEvent>* events);
+
+  bool valid_;
+  uint64_t version_;  // 缓存时索引的修改版本.
+  GeoBox region_;  // 安全范围.
+  std::vector<Candidate> candidates_;
+  std::vector<InsideArea> inside_;  // 按区域升序排列.
+  std::vector<InsideArea> current_;
+  uint64_t refresh_num_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_AREA_TRACKER_H_
@@ -46,6 +46,14 @@ uint8_t* BcdToStringCompressFillingZero(const uint8_t *src,
 int StringToBcd(std::string const& in, std::vector<uint8_t>* out);
 int BcdToString(std::vector<uint8_t> const& in, std::string* out);
 int BcdToStringFillZero(std::vector<uint8_t> const& in, std::string* out);
+
+// 6字节BCD时间"YYMMDDhhmmss"(GMT+8, 2000~2099年)与UTC时间戳(秒)互相转换.
+// 时间非法或超出范围时返回-1, 成功返回0.
+int BcdTimeToTimestamp(uint8_t const* bcd, int64_t* timestamp);
+int TimestampToBcdTime(int64_t const& timestamp, uint8_t* bcd);
+// "YYMMDDhhmmss"格式的时间字符串与UTC时间戳(秒)互相转换.
+int TimeStringToTimestamp(std::string const& time, int64_t* timestamp);
+int TimestampToTimeString(int64_t const& timestamp, std::string* time);
 }  // namespace libjt808
 
 #endif  // JT808_BCD_H_
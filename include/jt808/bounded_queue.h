@@ -0,0 +1,153 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  bounded_queue.h
+// @Version :  1.0
+// @Time    :  2026/10/18 09:12:40
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_BOUNDED_QUEUE_H_
+#define JT808_BOUNDED_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+
+namespace libjt808 {
+
+// 有界无锁队列, 支持多生产者多消费者.
+// 每个存储单元带有一个序号, 生产者和消费者通过CAS竞争读写位置,
+// 序号用于判断单元当前是否可写或可读, 全程无互斥锁.
+// 容量会向上取整为2的幂.
+//
+// Example:
+//     BoundedQueue<std::vector<uint8_t>> queue(1024);
+//     queue.TryPush(std::move(msg));
+//     std::vector<uint8_t> out;
+//     while (queue.TryPop(&out)) { ... }
+template<typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t const& capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    mask_ = size-1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+  BoundedQueue(BoundedQueue const&) = delete;
+  BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+  // 入队, 队列已满时返回false, 此时value不会被移动.
+  bool TryPush(T&& value) {
+    Cell* cell = nullptr;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (1) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(
+                pos, pos+1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // 队列已满.
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::move(value);
+    cell->sequence.store(pos+1, std::memory_order_release);
+    return true;
+  }
+  bool TryPush(T const& value) {
+    T copy(value);
+    return TryPush(std::move(copy));
+  }
+
+  // 出队, 队列为空时返回false.
+  bool TryPop(T* value) {
+    if (value == nullptr) return false;
+    Cell* cell = nullptr;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (1) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) -
+                      static_cast<intptr_t>(pos+1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(
+                pos, pos+1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // 队列为空.
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    *value = std::move(cell->data);
+    cell->sequence.store(pos+mask_+1, std::memory_order_release);
+    return true;
+  }
+
+  // 队列容量.
+  size_t capacity(void) const { return mask_+1; }
+  // 当前元素个数的近似值, 仅用于统计.
+  size_t size_approx(void) const {
+    size_t enq = enqueue_pos_.load(std::memory_order_relaxed);
+    size_t deq = dequeue_pos_.load(std::memory_order_relaxed);
+    return (enq > deq) ? (enq-deq) : 0;
+  }
+  // 队列是否为空的近似判断.
+  bool empty_approx(void) const { return size_approx() == 0; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  // 读写位置分别位于不同缓存行, 避免生产者与消费者伪共享.
+  char pad0_[64];
+  std::atomic<size_t> enqueue_pos_;
+  char pad1_[64];
+  std::atomic<size_t> dequeue_pos_;
+  char pad2_[64];
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_BOUNDED_QUEUE_H_
@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  box_grid.h
+// @Version :  1.0
+// @Time    :  2026/10/19 02:14:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_BOX_GRID_H_
+#define JT808_BOX_GRID_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "jt808/geometry.h"
+
+
+namespace libjt808 {
+
+// 外接矩形的网格索引.
+// 以固定大小的经纬度网格划分平面, 每个网格记录与其相交的外接矩形所属的对象编号,
+// 查询时只返回检查点所在网格中的候选对象, 由调用方做精确判断.
+// 跨越网格过多的外接矩形单独存放, 每次查询都作为候选对象返回.
+// 同一对象可以多个外接矩形加入, 查询时可能重复返回.
+// 非线程安全, 多线程访问时由调用方加锁.
+class BoxGrid {
+ public:
+  // Args:
+  //     cell_size:  网格边长, 单位为百万分之一度, 不大于0时使用0.05度.
+  explicit BoxGrid(int32_t const& cell_size);
+
+  // 网格边长, 单位为百万分之一度.
+  int32_t cell_size(void) const { return cell_size_; }
+
+  // 加入对象的一个外接矩形.
+  void Insert(uint32_t const& slot, GeoBox const& box);
+  // 移除对象的一个外接矩形, box需与加入时相同.
+  void Remove(uint32_t const& slot, GeoBox const& box);
+  // 移除所有对象.
+  void Clear(void);
+
+  // 检查点所在网格的范围(含边界).
+  GeoBox CellBox(GeoPoint const& point) const;
+
+  // 依次访问检查点所在网格中的对象和大范围对象.
+  template<typename Visitor>
+  void ForEach(GeoPoint const& point, Visitor&& visitor) const {
+    auto const& cell = cells_.find(CellKey(CellIndex(point.longitude),
+                                           CellIndex(point.latitude)));
+    if (cell != cells_.end()) {
+      for (auto const& slot : cell->second) visitor(slot);
+    }
+    for (auto const& slot : large_slots_) visitor(slot);
+  }
+
+ private:
+  // 单个外接矩形最多放入的网格数, 超过时单独存放.
+  static constexpr int64_t kMaxCellsPerBox = 1024;
+
+  // 向下取整的网格序号.
+  int32_t CellIndex(int32_t const& value) const {
+    return (value >= 0) ? value/cell_size_ :
+                          -((cell_size_-1-value)/cell_size_);
+  }
+  static uint64_t CellKey(int32_t const& x, int32_t const& y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+           static_cast<uint32_t>(y);
+  }
+  bool IsLarge(GeoBox const& box) const {
+    int64_t const cells =
+        (static_cast<int64_t>(CellIndex(box.max_longitude)) -
+         CellIndex(box.min_longitude)+1) *
+        (static_cast<int64_t>(CellIndex(box.max_latitude)) -
+         CellIndex(box.min_latitude)+1);
+    return cells > kMaxCellsPerBox;
+  }
+
+  int32_t cell_size_;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;  // 网格到对象.
+  std::vector<uint32_t> large_slots_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_BOX_GRID_H_
@@ -0,0 +1,152 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  callback_executor.h
+// @Version :  1.0
+// @Time    :  2026/10/18 19:52:30
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_CALLBACK_EXECUTOR_H_
+#define JT808_CALLBACK_EXECUTOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace libjt808 {
+
+class Metrics;
+
+// 回调队列已满时的处理策略.
+enum CallbackOverflowPolicy {
+  // 提交线程等待队列有空位, 把压力反馈给IO线程.
+  kCallbackOverflowBlock = 0,
+  // 丢弃新提交的回调.
+  kCallbackOverflowDrop,
+  // 在提交线程中直接执行回调.
+  kCallbackOverflowRunInline,
+};
+
+// 应用回调执行器.
+// 回调按会话(终端连接)排队, 同一会话的回调按提交顺序依次执行,
+// 不同会话的回调由多个工作线程并行执行, 单个慢回调只阻塞所属会话.
+// 工作线程数为0时在提交线程中直接执行.
+//
+// Example:
+//     CallbackExecutor executor;
+//     executor.Start(4);
+//     executor.Submit(socket, [media] (void) { SaveToDatabase(*media); });
+//     executor.Stop();
+class CallbackExecutor {
+ public:
+  using Task = std::function<void (void)>;
+
+  CallbackExecutor();
+  ~CallbackExecutor();
+  CallbackExecutor(CallbackExecutor const&) = delete;
+  CallbackExecutor& operator=(CallbackExecutor const&) = delete;
+
+  // 设置所有会话待执行回调总数的上限, 需在Start()之前调用.
+  void set_capacity(size_t const& capacity) { capacity_ = capacity; }
+  size_t capacity(void) const { return capacity_; }
+  // 设置队列已满时的处理策略, 需在Start()之前调用.
+  void set_overflow_policy(CallbackOverflowPolicy const& policy) {
+    overflow_policy_ = policy;
+  }
+  // 设置记录排队时间的运行指标, 需在Start()之前调用.
+  void set_metrics(Metrics* metrics) { metrics_ = metrics; }
+
+  // 启动工作线程.
+  // Args:
+  //     thread_num:  工作线程数.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Start(int const& thread_num);
+  // 执行完已提交的回调后停止工作线程.
+  void Stop(void);
+
+  // 提交回调.
+  // Args:
+  //     session:  会话标识, 同一会话的回调按提交顺序执行.
+  //     task:  回调.
+  // Returns:
+  //     成功返回0, 队列已满被丢弃返回-1.
+  int Submit(uint64_t const& session, Task const& task);
+  // 不受容量限制地提交回调, 不阻塞提交线程, 也不在提交线程中执行.
+  // 用于提交线程持有其他锁或不能等待的场合.
+  // Returns:
+  //     成功返回0, 未启动或没有工作线程返回-1, 由调用方处理回调.
+  int Post(uint64_t const& session, Task const& task);
+
+  // 当前线程是否是本执行器的工作线程.
+  bool InWorkerThread(void) const;
+
+  // 当前待执行的回调数.
+  size_t pending(void) const;
+  // 因队列已满被丢弃的回调数.
+  uint64_t dropped(void) const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Item {
+    Task task;
+    std::chrono::steady_clock::time_point submit_time;
+  };
+  // 单个会话的待执行回调, scheduled表示会话已在就绪队列中或正被执行.
+  struct Session {
+    std::deque<Item> items;
+    bool scheduled;
+  };
+
+  // 工作线程处理函数.
+  void WorkerHandler(void);
+
+  size_t capacity_;
+  CallbackOverflowPolicy overflow_policy_;
+  Metrics* metrics_;
+  mutable std::mutex mutex_;
+  std::condition_variable ready_cond_;  // 有会话就绪或停止.
+  std::condition_variable space_cond_;  // 队列有空位.
+  std::map<uint64_t, Session> sessions_;
+  std::deque<uint64_t> ready_;  // 有待执行回调且未被执行的会话.
+  size_t pending_;
+  bool running_;
+  std::vector<std::thread> workers_;
+  std::atomic<uint64_t> dropped_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_CALLBACK_EXECUTOR_H_
@@ -40,15 +40,27 @@
 #endif
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <string>
 #include <thread>
-#include <list>
 #include <mutex>
+#include <vector>
 
+#include "jt808/area_tracker.h"
+#include "jt808/codec_registry.h"
+#include "jt808/driving_alarm.h"
+#include "jt808/frame_assembler.h"
+#include "jt808/geofence.h"
+#include "jt808/location_journal.h"
 #include "jt808/packager.h"
 #include "jt808/parser.h"
 #include "jt808/protocol_parameter.h"
+#include "jt808/route_index.h"
+#include "jt808/send_queue.h"
 #include "jt808/terminal_parameter.h"
 
 
@@ -143,6 +155,7 @@ class JT808Client {
   // 停止服务线程.
   void Stop(void);
   // 等待所有缓存消息发送完成或等待超时后再停止服务线程.
+  // 由服务线程发送和清除缓存消息, 服务线程退出后返回.
   void WattingStop(int const& timeout_msec);
   // 获取当前服务线程运行状态.
   bool service_is_running(void) const {
@@ -151,33 +164,56 @@ class JT808Client {
 
   //
   //  外部获取和设置当前的通用消息体解析和封装函数, 用于重写或新增命令支持.
-  //  必须在调用Init()成员函数后才可以使用.
+  //  可以在Init()之前或之后使用; Init()只补全缺少的默认命令,
+  //  不会覆盖Init()之前已经重写或新增的命令.
+  //  默认与进程内所有实例共享同一份只读的解析器和封装器,
+  //  通过非const接口修改时才复制出本实例的私有副本(写时复制).
   //
   // 获取通用JT808协议封装器.
-  Packager& packager(void) { return packager_; }
-  Packager const& packager(void) const { return packager_; }
+  Packager& packager(void) { return packager_.mutable_get(); }
+  Packager const& packager(void) const { return packager_.get(); }
   void packager(Packager* packager) const {
     if (packager == nullptr) return;
-    *packager = packager_;
+    *packager = packager_.get();
+  }
+  // 获取可与其他实例共享的只读封装器.
+  std::shared_ptr<Packager const> shared_packager(void) const {
+    return packager_.shared();
   }
   // 设置通用JT808协议封装器.
-  void set_packager(Packager const& packager) { packager_ = packager; }
+  void set_packager(Packager const& packager) { packager_.reset(packager); }
+  void set_packager(std::shared_ptr<Packager const> const& packager) {
+    packager_.reset(packager);
+  }
   // 获取通用JT808协议解析器.
-  Parser& parser(void) { return parser_; }
-  Parser const& parser(void) const {  return parser_; }
+  Parser& parser(void) { return parser_.mutable_get(); }
+  Parser const& parser(void) const {  return parser_.get(); }
   void parser(Parser* parser) const {
     if (parser == nullptr) return;
-    *parser = parser_;
+    *parser = parser_.get();
+  }
+  // 获取可与其他实例共享的只读解析器.
+  std::shared_ptr<Parser const> shared_parser(void) const {
+    return parser_.shared();
   }
   // 设置通用JT808协议解析器.
-  void set_parser(Parser const& parser) { parser_ = parser; }
+  void set_parser(Parser const& parser) { parser_.reset(parser); }
+  void set_parser(std::shared_ptr<Parser const> const& parser) {
+    parser_.reset(parser);
+  }
 
   //
   // 位置上报相关.
   //
   // 设置报警标识位.
+  // 有新的报警位置位时, 立即生成一条报警位置信息汇报, 并优先发送.
   void SetAlarmBit(uint32_t const& alarm) {
+    auto const raised = alarm & ~parameter_.location_info.alarm.value;
     parameter_.location_info.alarm.value = alarm;
+    if (raised != 0) {
+      location_report_immediately_flag_ |= kAlarmOccurred;
+      WakeUp();
+    }
   }
   // 获取报警标识位.
   uint32_t const& alarm_bit(void) const {
@@ -191,6 +227,7 @@ class JT808Client {
   void SetInOutAreaAlarmBit(uint8_t const& in) {
     parameter_.location_info.alarm.bit.in_out_area = in;
     location_report_immediately_flag_ |= kAlarmOccurred;
+    WakeUp();
   }
   // 设置进出区域报警位置信息附加项.
   // Args:
@@ -210,6 +247,7 @@ class JT808Client {
   void SetStatusBit(uint32_t const& status) {
     parameter_.location_info.status.value = status;
     location_report_immediately_flag_ |= kStateChanged;
+    WakeUp();
   }
   // 获取状态位.
   uint32_t const& status_bit(void) const {
@@ -243,6 +281,12 @@ class JT808Client {
     parameter_.location_info.bearing = static_cast<uint16_t>(bearing);
     parameter_.location_info.time.assign(timestamp.begin(), timestamp.end());
   }
+  // 根据当前位置基本信息和终端参数(0x0055~0x005C)判断超速、疲劳驾驶、
+  // 当天累计驾驶超时和超时停车, 更新对应的报警位和超速报警附加项.
+  // 已设置路线时按路段行驶时间阈值判断路段行驶时间不足/过长, 报警位和
+  // 附加项(0x13)只在驶离路段后的一次上报中保留.
+  // 在每次UpdateLocation()之后调用, 有新的报警位置位时立即上报.
+  void EvaluateDrivingAlarm(void);
   // 获取位置信息附加项.
   int GetLocationExtension(LocationExtensions* items) {
     if (items == nullptr) return -1;
@@ -276,7 +320,27 @@ class JT808Client {
   };
   // 立刻生成一条位置上报消息.
   // 仅在外部控制位置上报时调用.
+  // 报警触发的位置上报消息进入报警优先级队列, 先于应答和常规上报发送.
   void GenerateLocationReportMsgNow(void);
+  // 获取待发送消息队列.
+  PrioritySendQueue const& send_queue(void) const { return send_queue_; }
+  // 开启位置信息汇报持久化存储.
+  // 服务线程未运行期间生成的位置信息汇报, 以及连接断开时未发送的位置信息汇报
+  // 写入日志文件, 重新连接后通过定位数据批量上传(0x0704)进行盲区补报,
+  // 收到平台应答后才从日志中删除.
+  // Args:
+  //     path:  日志文件路径.
+  //     capacity:  最多保存的位置信息汇报条数, 超出时覆盖最旧的记录.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int EnableLocationJournal(std::string const& path,
+                            uint32_t const& capacity = 10000) {
+    return location_journal_.Open(path, capacity);
+  }
+  // 获取日志中待补报的位置信息汇报条数.
+  size_t journaled_location_report_num(void) const {
+    return location_journal_.size();
+  }
 
   //
   // 终端参数相关.
@@ -366,7 +430,9 @@ class JT808Client {
   //     区域ID已存在返回-1, 否则返回0.
   int AddPolygonArea(PolygonArea const& area) {
     auto const& id = area.area_id;
-    return (polygon_areas_.insert(std::make_pair(id, area)).second - 1);
+    if (!polygon_areas_.insert(std::make_pair(id, area)).second) return -1;
+    area_index_.Insert(area);
+    return 0;
   }
   // 新增一个多边形区域.
   // Args:
@@ -387,7 +453,7 @@ class JT808Client {
                      std::vector<LocationPoint> const& vertices) {
     PolygonArea area = {id, AreaAttribute {attr}, begin_time, end_time,
                         max_speed, overspeed_time, vertices};
-    return (polygon_areas_.insert(std::make_pair(id, area)).second - 1);
+    return AddPolygonArea(area);
   }
   // 更新一个多边形区域信息.
   // 若区域ID不存在, 直接插入, 否则更新原有区域信息.
@@ -409,7 +475,7 @@ class JT808Client {
                          std::vector<LocationPoint> const& vertices) {
     PolygonArea area = {id, AreaAttribute {attr}, begin_time, end_time,
                         max_speed, overspeed_time, vertices};
-    polygon_areas_[id] = area;
+    UpdatePolygonAreaByArea(area);
   }
   // 更新指定的多边形区域.
   // Args:
@@ -418,6 +484,7 @@ class JT808Client {
   //     None.
   void UpdatePolygonAreaByArea(PolygonArea const& area) {
     polygon_areas_[area.area_id] = area;
+    area_index_.Insert(area);
   }
   // 更新指定的多边形区域.
   // Args:
@@ -427,6 +494,7 @@ class JT808Client {
   void UpdatePolygonAreaByAreas(PolygonAreaSet const& areas) {
     for (auto const& item : areas) {
       polygon_areas_[item.first] = item.second;
+      area_index_.Insert(item.second);
     }
   }
   // 删除指定ID多边形区域.
@@ -437,6 +505,7 @@ class JT808Client {
   void DeletePolygonAreaByID(uint32_t const& id) {
     auto const& it = polygon_areas_.find(id);
     if (it != polygon_areas_.end()) polygon_areas_.erase(it);
+    area_index_.Remove(id);
   }
   // 删除指定ID多边形区域.
   // 区域ID集为空时, 删除所有多边形区域信息.
@@ -460,6 +529,23 @@ class JT808Client {
   //     None.
   void DeleteAllPolygonArea(void) {
     polygon_areas_.clear();
+    area_index_.Clear(kAccessAreaAlarmPolygonArea);
+  }
+  // 查询包含指定位置点的多边形区域.
+  // 由区域空间索引完成, 耗时与区域总数无关.
+  // Args:
+  //     point:  位置点.
+  //     area_ids:  包含该位置点的区域ID, 按升序排列.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int GetPolygonAreasContaining(LocationPoint const& point,
+                                std::vector<uint32_t>* area_ids) const {
+    return area_index_.Query(point, area_ids);
+  }
+  // 指定ID的多边形区域是否包含位置点, 区域不存在时返回false.
+  bool IsInsidePolygonArea(uint32_t const& id,
+                           LocationPoint const& point) const {
+    return area_index_.Contains(id, point);
   }
   // 多边形区域回调函数.
   using PolygonAreaCallback = std::function<void (void/* 参数待定. */)>;
@@ -467,6 +553,102 @@ class JT808Client {
   void OnPolygonAreaUpdated(PolygonAreaCallback const& callback) {
     polygon_area_callback_ = callback;
   }
+  // 获取当前圆形区域信息集.
+  CircularAreaSet const& circular_areas(void) const {
+    return circular_areas_;
+  }
+  // 按设置属性(见AreaSettingType)更新圆形区域.
+  // Args:
+  //     setting:  设置圆形区域.
+  // Returns:
+  //     None.
+  void UpdateCircularAreas(CircularAreaSetting const& setting);
+  // 删除指定ID圆形区域.
+  // 区域ID集为空时, 删除所有圆形区域信息.
+  // Args:
+  //     ids:  区域ID集.
+  // Returns:
+  //     None.
+  void DeleteCircularAreaByIDs(std::vector<uint32_t> const& ids);
+  // 获取当前矩形区域信息集.
+  RectangleAreaSet const& rectangle_areas(void) const {
+    return rectangle_areas_;
+  }
+  // 按设置属性(见AreaSettingType)更新矩形区域.
+  // Args:
+  //     setting:  设置矩形区域.
+  // Returns:
+  //     None.
+  void UpdateRectangleAreas(RectangleAreaSetting const& setting);
+  // 删除指定ID矩形区域.
+  // 区域ID集为空时, 删除所有矩形区域信息.
+  // Args:
+  //     ids:  区域ID集.
+  // Returns:
+  //     None.
+  void DeleteRectangleAreaByIDs(std::vector<uint32_t> const& ids);
+  // 获取当前路线信息集.
+  RouteSet const& routes(void) const {
+    return routes_;
+  }
+  // 新增或更新一条路线.
+  // Args:
+  //     route:  路线.
+  // Returns:
+  //     None.
+  void UpdateRoute(Route const& route) {
+    routes_[route.route_id] = route;
+    route_index_.Insert(route);
+  }
+  // 删除指定ID路线.
+  // 路线ID集为空时, 删除所有路线信息.
+  // Args:
+  //     ids:  路线ID集.
+  // Returns:
+  //     None.
+  void DeleteRouteByIDs(std::vector<uint32_t> const& ids);
+  // 查询包含指定位置点的圆形、矩形和多边形区域.
+  // 由区域空间索引完成, 耗时与区域总数无关.
+  // Args:
+  //     point:  位置点.
+  //     areas:  包含该位置点的区域, 按区域类型和区域ID升序排列.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int GetAreasContaining(LocationPoint const& point,
+                         std::vector<AreaRef>* areas) const {
+    return area_index_.Query(ToGeoPoint(point), areas);
+  }
+  // 位置点是否在指定路线上, 不在时即为偏离路线.
+  // 由路段空间索引完成, 耗时与路线拐点数无关.
+  // Args:
+  //     id:  路线ID.
+  //     point:  位置点.
+  //     match:  在路线上时填充距离最近的路段, 可为nullptr.
+  // Returns:
+  //     在路线上返回true, 偏离路线或路线不存在返回false.
+  bool IsOnRoute(uint32_t const& id, LocationPoint const& point,
+                 RouteMatch* match) const {
+    return route_index_.Match(id, ToGeoPoint(point), match);
+  }
+  // 以本终端的位置基本信息更新所在区域状态, 产生进出区域和区域内超速事件.
+  // 定位点离开缓存的安全范围或区域被修改时才查询区域空间索引.
+  // Args:
+  //     info:  位置基本信息, 使用经纬度、速度和时间戳.
+  //     events:  追加产生的事件.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int TrackAreas(LocationBasicInformation const& info,
+                 std::vector<AreaEvent>* events) {
+    return area_tracker_.Update(area_index_,
+                                MakeGeoPoint(info.longitude, info.latitude),
+                                info.timestamp, info.speed, events);
+  }
+  // 圆形、矩形区域和路线回调函数, 参数为平台下发的消息ID.
+  using AreaRouteCallback = std::function<void (uint16_t const& msg_id)>;
+  // 设置平台配置修改圆形、矩形区域或路线时的回调函数.
+  void OnAreaRouteUpdated(AreaRouteCallback const& callback) {
+    area_route_callback_ = callback;
+  }
   //
   // 多媒体数据上传.
   //
@@ -496,19 +678,72 @@ class JT808Client {
 
  private:
   // 生成一条消息.
-  int PackagingMessage(uint32_t const& msg_id, std::vector<uint8_t>* out);
+  int PackagingMessage(uint32_t const& msg_id, std::vector<uint8_t>* out,
+                       uint16_t* flow_num = nullptr);
   // 生成一条消息, 存放在通用消息列表.
   int PackagingGeneralMessage(uint32_t const& msg_id);
-  // 发送一条消息.
-  int SendMessage(std::vector<uint8_t> const& msg);
+  // 按优先级发送队列中的消息, 直到队列为空或socket不可写.
+  // Args:
+  //     current_only:  只发送完正在发送的消息, 不从队列中取新消息.
+  // Returns:
+  //     队列已发送完成返回0, socket暂不可写返回1, 发送失败返回-1.
+  int FlushSendQueue(bool const& current_only = false);
+  // 是否有消息只发送了一部分.
+  bool SendingPartialFrame(void) const {
+    return sending_offset_ > 0 && sending_offset_ < sending_msg_.size();
+  }
+  // 唤醒事件循环.
+  void WakeUp(void);
+  // 设置手动收发标志, 进入手动收发时等待事件循环停止读写socket.
+  void SetManualDeal(bool const& manual);
+  // 事件循环更新手动收发状态, manual表示已停止读写socket.
+  void UpdateManualDealAck(bool const& manual);
+  // 等待停止时距退出事件循环的时间.
+  // Returns:
+  //     缓存消息已发送完成或已超时返回0, 否则返回剩余的毫秒数,
+  //     未等待停止返回-1.
+  int64_t WaitingStopRemainMsec(void) const;
   // 主线程处理函数.
   void ThreadHandler(void);
-  // 发送消息到服务端线程处理函数.
-  void SendHandler(std::atomic_bool *const running);
-  // 接收服务端消息线程处理函数.
-  void ReceiveHandler(std::atomic_bool *const running);
+  // 事件循环, socket读写和定时任务均在此处理.
+  void EventLoop(void);
+  // 获取心跳包时间间隔, 单位毫秒(ms).
+  int64_t HeartbeatIntervalMsec(void) const;
+  // 发送队列中的消息.
+  int SendPending(void);
+  // 位置上报定时处理.
+  void OnReportTimeout(void);
+  // 检查是否需要立即进行位置上报.
+  void CheckImmediateReport(void);
+  // 心跳定时处理, 返回距下一次检查的时间.
+  int64_t OnHeartbeatTimeout(int64_t const& heartbeat_intv);
+  // 接收socket中所有可读数据并处理.
+  int ReceiveAvailable(void);
+  // 处理一条完整的平台消息.
+  void HandleMessage(std::vector<uint8_t> const& msg);
+  // 将发送队列中未发送的位置信息汇报转存到日志中.
+  void SpillLocationReportsToJournal(void);
+  // 从日志中读取位置信息汇报, 生成定位数据批量上传消息.
+  void SendJournalBatches(void);
+  // 收到定位数据批量上传的平台应答.
+  void OnJournalBatchResponse(uint16_t const& flow_num);
+
+  // 已发送未应答的定位数据批量上传消息.
+  struct JournalBatch {
+    uint16_t flow_num;  // 消息流水号.
+    size_t num;  // 包含的日志记录条数.
+    bool acked;  // 是否已收到平台应答.
+  };
 
-  std::atomic_bool manual_deal_;  // 手动处理标志.
+  std::atomic_bool manual_deal_;  // 手动处理标志, 由loop_mutex_保护写入.
+  // 事件循环已进入手动处理状态, 由loop_mutex_保护写入.
+  std::atomic_bool manual_deal_ack_;
+  std::mutex loop_mutex_;
+  std::condition_variable loop_cond_;  // 进入手动处理状态或事件循环退出.
+  bool service_thread_alive_;  // 服务线程尚未退出, 由loop_mutex_保护.
+  std::atomic_bool waiting_stop_;  // 发送完缓存消息后停止服务线程.
+  std::atomic<int64_t> waiting_stop_deadline_ms_;  // 等待停止的截止时刻.
+  int wakeup_fd_;  // 事件循环唤醒描述符(eventfd).
   std::mutex msg_generate_mutex_;  // 消息生成互斥锁, 保证消息流水号唯一性.
   decltype(socket(0, 0, 0)) client_;  // 通用TCP连接socket.
   std::atomic_bool is_connected_;  // 与服务端TCP连接状态.
@@ -516,7 +751,7 @@ class JT808Client {
   std::string ip_;  // 服务端IP地址.
   int port_;  // 服务端端口.
   uint8_t location_report_inteval_;  // 位置信息上报时间间隔.
-  uint16_t location_report_immediately_flag_;  // 立即进行位置上报标志.
+  std::atomic<uint16_t> location_report_immediately_flag_;  // 立即进行位置上报标志.
   std::atomic_bool location_report_msg_generate_outside_;  // 外部控制生成位置上报信息.
   std::thread service_thread_;  // 服务线程.
   std::atomic_bool service_is_running_;  // 服务线程运行标志.
@@ -525,12 +760,31 @@ class JT808Client {
   TerminalParameterCallback terminal_parameter_callback_;  // 修改终端参数回调函数.
   UpgradeCallback upgrade_callback_;  // 下发终端升级包回调函数.
   PolygonAreaCallback polygon_area_callback_;  // 修改多边形区域回调函数.
-  Packager packager_;  // 通用JT808协议封装器.
-  Parser parser_;  // 通用JT808协议解析器.
-  std::list<std::vector<uint8_t>> location_report_msg_;  // 位置上报消息列表.
-  std::list<std::vector<uint8_t>> general_msg_;  // 除位置上报消息外的消息列表.
+  AreaRouteCallback area_route_callback_;  // 修改圆形、矩形区域和路线回调函数.
+  SharedPackager packager_;  // 通用JT808协议封装器.
+  SharedParser parser_;  // 通用JT808协议解析器.
+  PrioritySendQueue send_queue_;  // 按优先级排列的待发送消息队列.
+  std::vector<uint8_t> sending_msg_;  // 正在发送的消息.
+  size_t sending_offset_;  // 正在发送的消息已发送的字节数.
+  FrameAssembler frame_assembler_;  // 接收数据的消息帧切分.
+  std::vector<uint8_t> receive_msg_;  // 接收到的一帧消息.
+  bool first_report_;  // 是否尚未进行首次位置上报.
+  std::chrono::steady_clock::time_point last_send_tp_;  // 最后发送消息时刻.
+  std::unique_ptr<char[]> upgrade_buffer_;  // 升级包分包数据缓存.
+  int upgrade_total_size_;  // 已接收的升级包数据大小.
+  int upgrade_packet_max_size_;  // 升级包子包最大的数据长度.
   PolygonAreaSet polygon_areas_;  // 多边形区域信息集.
+  CircularAreaSet circular_areas_;  // 圆形区域信息集.
+  RectangleAreaSet rectangle_areas_;  // 矩形区域信息集.
+  RouteSet routes_;  // 路线信息集.
+  GeofenceIndex area_index_;  // 圆形、矩形和多边形区域空间索引.
+  RouteIndex route_index_;  // 路线路段空间索引.
+  AreaTracker area_tracker_;  // 本终端的区域状态跟踪.
+  DrivingAlarmTracker driving_alarm_tracker_;  // 本终端的驾驶行为报警判断.
   ProtocolParameter parameter_;  // JT808协议参数.
+  LocationJournal location_journal_;  // 位置信息汇报持久化日志.
+  std::deque<JournalBatch> journal_batches_;  // 等待应答的批量上传消息.
+  size_t journal_inflight_num_;  // 已发送未应答的日志记录条数.
 };
 
 }  // namespace libjt808
@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  codec_registry.h
+// @Version :  1.0
+// @Time    :  2026/10/19 10:12:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_CODEC_REGISTRY_H_
+#define JT808_CODEC_REGISTRY_H_
+
+#include <memory>
+
+#include "jt808/packager.h"
+#include "jt808/parser.h"
+
+
+namespace libjt808 {
+
+// 进程内共享的默认解析器, 首次调用时由JT808FrameParserInit()初始化,
+// 之后只读, 可被任意线程同时使用.
+std::shared_ptr<Parser const> DefaultParser(void);
+// 进程内共享的默认封装器, 首次调用时由JT808FramePackagerInit()初始化,
+// 之后只读, 可被任意线程同时使用.
+std::shared_ptr<Packager const> DefaultPackager(void);
+
+// 写时复制的共享对象.
+// 多个实例通过引用计数共享同一份只读对象, 拷贝和构造只增加引用计数;
+// 需要修改时(mutable_get())若仍与其他实例共享, 先复制一份私有副本再修改,
+// 不影响其他实例. 修改操作需在对象被多个线程使用之前完成.
+//
+// Example:
+//     CopyOnWrite<Parser> parser(DefaultParser());
+//     JT808FrameParse(parser.get(), frame, &para);
+//     JT808FrameParserOverride(&parser.mutable_get(), 0x0200, handler);
+template<typename T>
+class CopyOnWrite {
+ public:
+  // 未设置对象时视为空对象, 不申请内存.
+  CopyOnWrite() = default;
+  explicit CopyOnWrite(std::shared_ptr<T const> const& ptr)
+      : ptr_(std::const_pointer_cast<T>(ptr)) {}
+  explicit CopyOnWrite(T const& value) : ptr_(std::make_shared<T>(value)) {}
+
+  T const& get(void) const { return ptr_ ? *ptr_ : Empty(); }
+  T& mutable_get(void) {
+    if (!ptr_) {
+      ptr_ = std::make_shared<T>();
+    } else if (ptr_.use_count() > 1) {
+      ptr_ = std::make_shared<T>(*ptr_);
+    }
+    return *ptr_;
+  }
+  // 取得共享的只读对象, 可用于构造其他实例.
+  std::shared_ptr<T const> shared(void) const { return ptr_; }
+
+  void reset(std::shared_ptr<T const> const& ptr) {
+    ptr_ = std::const_pointer_cast<T>(ptr);
+  }
+  void reset(T const& value) { ptr_ = std::make_shared<T>(value); }
+  // 用默认对象补全当前对象中缺少的项, 已有的项(外部重写)保持不变.
+  // 当前对象为空时直接共享默认对象, 无缺少项时不复制.
+  void merge(std::shared_ptr<T const> const& defaults) {
+    if (!ptr_ || ptr_->empty()) {
+      reset(defaults);
+      return;
+    }
+    if (ptr_ == defaults) return;
+    bool missing = false;
+    for (auto const& item : *defaults) {
+      if (ptr_->find(item.first) == ptr_->end()) {
+        missing = true;
+        break;
+      }
+    }
+    if (!missing) return;
+    auto& value = mutable_get();
+    for (auto const& item : *defaults) value.insert(item);
+  }
+
+ private:
+  static T const& Empty(void) {
+    static T const empty;
+    return empty;
+  }
+
+  // 共享时只通过get()只读访问, 写入前保证引用计数为1.
+  std::shared_ptr<T> ptr_;
+};
+
+using SharedParser = CopyOnWrite<Parser>;
+using SharedPackager = CopyOnWrite<Packager>;
+
+}  // namespace libjt808
+
+#endif  // JT808_CODEC_REGISTRY_H_
@@ -0,0 +1,249 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  driving_alarm.h
+// @Version :  1.0
+// @Time    :  2026/10/19 03:41:18
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_DRIVING_ALARM_H_
+#define JT808_DRIVING_ALARM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jt808/area_route.h"
+#include "jt808/location_report.h"
+#include "jt808/location_stream.h"
+#include "jt808/route_index.h"
+#include "jt808/terminal_parameter.h"
+
+
+namespace libjt808 {
+
+// 驾驶行为报警门限, 对应终端参数0x0055~0x005C, 门限为0时不判断对应报警.
+struct DrivingAlarmConfig {
+  // 最高速度, 单位km/h.
+  uint32_t max_speed;
+  // 超速持续时间, 单位秒.
+  uint32_t overspeed_duration;
+  // 连续驾驶时间门限, 单位秒.
+  uint32_t continuous_driving_time;
+  // 当天累计驾驶时间门限, 单位秒.
+  uint32_t daily_driving_time;
+  // 最小休息时间, 单位秒, 停车达到该时间后连续驾驶时间清零,
+  // 为0时停车即清零.
+  uint32_t min_rest_time;
+  // 最长停车时间, 单位秒, ACC开且停车超过该时间时超时停车报警.
+  uint32_t max_parking_time;
+  // 超速报警预警差值, 单位1/10km/h.
+  uint16_t overspeed_warning_diff;
+  // 疲劳驾驶预警差值, 单位秒.
+  uint16_t fatigue_warning_diff;
+  // 行驶判定速度, 单位1/10km/h, 速度不小于该值视为行驶, 为0时使用5km/h.
+  uint16_t moving_speed;
+};
+
+// 从终端参数读取驾驶行为报警门限, 未设置的参数为0.
+// Returns:
+//     成功返回0, 失败返回-1.
+int GetDrivingAlarmConfig(TerminalParameters const& items,
+                          DrivingAlarmConfig* config);
+
+// 由驾驶行为判断负责的报警标志位: 超速、疲劳驾驶、预警、
+// 当天累计驾驶超时和超时停车.
+constexpr uint32_t kDrivingAlarmMask = 0x0000000EU | (1U << 18) | (1U << 19);
+
+// 把驾驶行为报警写入位置信息: 替换alarm中kDrivingAlarmMask对应的位,
+// 超速报警且没有超速附加项时追加无特定位置的超速报警附加项, 超速结束时移除.
+// Args:
+//     driving_alarm:  驾驶行为报警标志, 见DrivingAlarmTracker::alarm().
+//     alarm:  位置信息的报警标志.
+//     items:  位置信息附加项, 可为nullptr.
+void SetDrivingAlarmItems(uint32_t const& driving_alarm, AlarmBit* alarm,
+                          LocationExtensions* items);
+
+// 路段行驶时间判断结果, 即路段行驶时间报警附加信息(0x13)的结果字段.
+enum SectionDrivingTimeResult {
+  kSectionDrivingTimeShort = 0,  // 不足.
+  kSectionDrivingTimeLong = 1,  // 过长.
+};
+
+// 路段行驶时间不足/过长报警.
+struct SectionDrivingTimeAlarm {
+  uint32_t segment_id;  // 路段ID.
+  uint16_t driving_time;  // 路段行驶时间, 单位秒.
+  uint8_t result;  // 见SectionDrivingTimeResult.
+};
+
+// 把路段行驶时间报警写入位置信息: section_alarm不为nullptr时置位路段行驶
+// 时间报警位并设置附加项(0x13), 为nullptr时清除.
+// Args:
+//     section_alarm:  路段行驶时间报警, 见DrivingAlarmTracker::UpdateSection().
+//     alarm:  位置信息的报警标志.
+//     items:  位置信息附加项, 可为nullptr.
+void SetSectionDrivingTimeItems(SectionDrivingTimeAlarm const* section_alarm,
+                                AlarmBit* alarm, LocationExtensions* items);
+
+// 单个终端的驾驶行为报警判断.
+// 状态为固定大小, 每条定位只做常数次计算. 相邻两条定位之间的时间按前一条
+// 定位的行驶状态计入驾驶或停车时间, 间隔超过kMaxRecordGap秒时视为停车.
+// 当天按GMT+8时间划分. 时间早于上一条定位的记录(如补传)不参与判断.
+// 非线程安全, 每个终端使用一个跟踪器.
+//
+// Example:
+//     DrivingAlarmTracker tracker;
+//     tracker.Update(config, info.timestamp, info.speed, info.status.value);
+//     SetDrivingAlarmItems(tracker.alarm(), &info.alarm, &extensions);
+class DrivingAlarmTracker {
+ public:
+  // 视为连续上报的最大定位间隔, 单位秒.
+  static constexpr int64_t kMaxRecordGap = 300;
+
+  DrivingAlarmTracker() { Reset(); }
+
+  // 以一次定位更新驾驶行为状态.
+  // Args:
+  //     config:  报警门限.
+  //     timestamp:  定位时间, UTC时间戳, 单位秒.
+  //     speed:  速度, 单位1/10km/h.
+  //     status:  状态位, 用于判断ACC开关.
+  // Returns:
+  //     报警标志变化的位, 记录被忽略时为0.
+  uint32_t Update(DrivingAlarmConfig const& config, int64_t const& timestamp,
+                  uint16_t const& speed, uint32_t const& status);
+  // 以一次定位所在的路段更新路段行驶时间.
+  // 驶离路段(驶入同一路线的其他路段或驶离路线)时, 按该路段起始拐点的
+  // 行驶时间阈值判断在该路段的行驶时间; 换到其他路线时重新计时, 不判断.
+  // Args:
+  //     timestamp:  定位时间, UTC时间戳, 单位秒.
+  //     match:  定位所在的路段, 不在路线上时为nullptr.
+  //     point:  所在路段的起始拐点, 提供路段属性和行驶时间阈值,
+  //             为nullptr时该路段不判断行驶时间.
+  //     section_alarm:  行驶时间不足或过长时填充.
+  // Returns:
+  //     产生路段行驶时间报警返回true, 否则返回false.
+  bool UpdateSection(int64_t const& timestamp, RouteMatch const* match,
+                     RouteInflectionPoint const* point,
+                     SectionDrivingTimeAlarm* section_alarm);
+  // 清除状态.
+  void Reset(void);
+
+  // 当前的驾驶行为报警标志, 只包含kDrivingAlarmMask中的位.
+  uint32_t alarm(void) const { return alarm_; }
+  // 本次连续驾驶时间, 单位秒.
+  uint32_t continuous_driving_time(void) const { return continuous_time_; }
+  // 当天累计驾驶时间, 单位秒.
+  uint32_t daily_driving_time(void) const { return daily_time_; }
+  // 本次停车时间, 单位秒.
+  uint32_t parking_time(void) const { return parking_time_; }
+  // 是否在路段上计时.
+  bool in_section(void) const { return section_since_ >= 0; }
+  // 正在计时的路段所在的路线ID.
+  uint32_t section_route_id(void) const { return section_route_id_; }
+
+ private:
+  int64_t last_time_;  // 上一条定位时间, 没有时为-1.
+  int64_t overspeed_since_;  // 开始超过最高速度的时间, 未超速时为-1.
+  int32_t day_;  // 上一条定位所在的天(GMT+8).
+  uint32_t continuous_time_;
+  uint32_t daily_time_;
+  uint32_t parking_time_;
+  uint32_t alarm_;
+  bool moving_;  // 上一条定位是否在行驶.
+  int64_t section_since_;  // 驶入当前路段的时间, 不在路段上时为-1.
+  int64_t section_last_time_;  // 当前路段上一条定位的时间.
+  uint32_t section_route_id_;
+  uint32_t section_segment_id_;
+  uint32_t section_point_index_;
+  // 当前路段的行驶时间阈值, 单位秒, 为0时不判断.
+  uint16_t section_max_time_;
+  uint16_t section_min_time_;
+};
+
+// 终端驾驶行为报警事件, 报警标志变化时产生.
+struct DrivingAlarmEvent {
+  uint64_t session;  // 会话标识(客户端的socket).
+  int64_t timestamp;  // 定位时间, UTC时间戳, 单位秒.
+  char phone_num[20];  // 终端手机号, 不足部分补0.
+  uint32_t alarm;  // 当前的驾驶行为报警标志.
+  uint32_t changed;  // 变化的报警位.
+  uint32_t continuous_driving_time;  // 本次连续驾驶时间, 单位秒.
+  uint32_t daily_driving_time;  // 当天累计驾驶时间, 单位秒.
+  uint16_t speed;  // 速度, 单位1/10km/h.
+};
+
+// 平台侧的车队驾驶行为报警判断.
+// 对每个终端上报的位置记录判断超速、疲劳驾驶、当天累计驾驶超时和超时停车,
+// 报警标志变化时产生事件, 用于不上报这些报警的终端或平台统一门限.
+// 每个终端只保存一个定长的跟踪器, 单线程即可处理整个车队的位置记录.
+//
+// Example:
+//     FleetDrivingAlarm evaluator;
+//     evaluator.set_config(config);
+//     std::vector<DrivingAlarmEvent> events;
+//     evaluator.Evaluate(records, num, &events);
+class FleetDrivingAlarm {
+ public:
+  FleetDrivingAlarm();
+  FleetDrivingAlarm(FleetDrivingAlarm const&) = delete;
+  FleetDrivingAlarm& operator=(FleetDrivingAlarm const&) = delete;
+
+  // 设置报警门限, 可在任意线程调用, 下一批记录开始生效.
+  void set_config(DrivingAlarmConfig const& config);
+  DrivingAlarmConfig config(void) const;
+
+  // 清除指定终端的状态.
+  void RemoveTerminal(std::string const& phone_num);
+  // 清除所有终端的状态.
+  void ClearTerminals(void);
+  // 当前保存了状态的终端数.
+  size_t terminal_num(void) const;
+
+  // 判断位置记录的驾驶行为, 追加产生的报警事件.
+  // 同一终端的位置记录需按时间顺序判断.
+  // Args:
+  //     records:  位置记录.
+  //     num:  位置记录数.
+  //     events:  追加产生的事件.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Evaluate(LocationRecord const* records, size_t const& num,
+               std::vector<DrivingAlarmEvent>* events);
+
+ private:
+  mutable std::mutex mutex_;
+  DrivingAlarmConfig config_;
+  std::unordered_map<std::string, DrivingAlarmTracker> terminals_;
+  std::string phone_num_;  // 复用的查找键.
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_DRIVING_ALARM_H_
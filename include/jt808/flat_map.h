@@ -0,0 +1,193 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  flat_map.h
+// @Version :  1.0
+// @Time    :  2026/10/18 21:40:16
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_FLAT_MAP_H_
+#define JT808_FLAT_MAP_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace libjt808 {
+
+// 按键有序的扁平映射表.
+// 键值对按键升序连续存放在std::vector中, 查找为二分查找,
+// 遍历和序列化是顺序内存访问, 接口与std::map保持一致.
+// 插入和删除会移动后面的元素, 适合元素个数较少(几十到几百)的场景;
+// 插入、删除后之前取得的迭代器和引用失效.
+//
+// Example:
+//     FlatMap<uint8_t, SmallVector<uint8_t, 16>> items;
+//     items.insert(std::make_pair(0x01, std::vector<uint8_t>{0, 0, 0, 1}));
+//     auto it = items.find(0x01);
+//     for (auto const& item : items) { ... }
+template<typename Key, typename T>
+class FlatMap {
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using size_type = size_t;
+  using container_type = std::vector<value_type>;
+  using iterator = typename container_type::iterator;
+  using const_iterator = typename container_type::const_iterator;
+
+  FlatMap() = default;
+  FlatMap(std::initializer_list<value_type> values) {
+    insert(values.begin(), values.end());
+  }
+  template<typename InputIt>
+  FlatMap(InputIt first, InputIt last) {
+    insert(first, last);
+  }
+
+  iterator begin(void) { return items_.begin(); }
+  iterator end(void) { return items_.end(); }
+  const_iterator begin(void) const { return items_.begin(); }
+  const_iterator end(void) const { return items_.end(); }
+  const_iterator cbegin(void) const { return items_.cbegin(); }
+  const_iterator cend(void) const { return items_.cend(); }
+
+  size_t size(void) const { return items_.size(); }
+  bool empty(void) const { return items_.empty(); }
+  void reserve(size_t const& num) { items_.reserve(num); }
+  // 清空元素, 保留已申请的存储空间以便复用.
+  void clear(void) { items_.clear(); }
+  void swap(FlatMap& other) { items_.swap(other.items_); }
+
+  iterator lower_bound(Key const& key) {
+    return std::lower_bound(items_.begin(), items_.end(), key, KeyLess());
+  }
+  const_iterator lower_bound(Key const& key) const {
+    return std::lower_bound(items_.begin(), items_.end(), key, KeyLess());
+  }
+
+  iterator find(Key const& key) {
+    auto it = lower_bound(key);
+    return (it != items_.end() && it->first == key) ? it : items_.end();
+  }
+  const_iterator find(Key const& key) const {
+    auto it = lower_bound(key);
+    return (it != items_.end() && it->first == key) ? it : items_.end();
+  }
+  size_t count(Key const& key) const { return find(key) != end() ? 1 : 0; }
+
+  T& at(Key const& key) {
+    auto it = find(key);
+    if (it == items_.end()) throw std::out_of_range("FlatMap::at");
+    return it->second;
+  }
+  T const& at(Key const& key) const {
+    auto it = find(key);
+    if (it == items_.end()) throw std::out_of_range("FlatMap::at");
+    return it->second;
+  }
+
+  T& operator[](Key const& key) {
+    auto it = lower_bound(key);
+    if (it == items_.end() || it->first != key) {
+      it = items_.insert(it, value_type(key, T()));
+    }
+    return it->second;
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return emplace(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return emplace(value.first, std::move(value.second));
+  }
+  // 兼容std::make_pair生成的键值类型不同的键值对.
+  template<typename K, typename V>
+  std::pair<iterator, bool> insert(std::pair<K, V> const& value) {
+    return emplace(static_cast<Key>(value.first), value.second);
+  }
+  template<typename K, typename V>
+  std::pair<iterator, bool> insert(std::pair<K, V>&& value) {
+    return emplace(static_cast<Key>(value.first), std::move(value.second));
+  }
+  // 已存在的键不会被覆盖. 按键升序插入时只追加到末尾.
+  template<typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      if (items_.empty() || items_.back().first < first->first) {
+        items_.push_back(value_type(first->first, first->second));
+      } else {
+        insert(*first);
+      }
+    }
+  }
+
+  template<typename V>
+  std::pair<iterator, bool> emplace(Key const& key, V&& value) {
+    if (items_.empty() || items_.back().first < key) {
+      items_.push_back(value_type(key, std::forward<V>(value)));
+      return std::make_pair(items_.end()-1, true);
+    }
+    auto it = lower_bound(key);
+    if (it != items_.end() && it->first == key) {
+      return std::make_pair(it, false);
+    }
+    it = items_.insert(it, value_type(key, std::forward<V>(value)));
+    return std::make_pair(it, true);
+  }
+
+  iterator erase(const_iterator pos) { return items_.erase(pos); }
+  size_t erase(Key const& key) {
+    auto it = find(key);
+    if (it == items_.end()) return 0;
+    items_.erase(it);
+    return 1;
+  }
+
+  friend bool operator==(FlatMap const& lhs, FlatMap const& rhs) {
+    return lhs.items_ == rhs.items_;
+  }
+  friend bool operator!=(FlatMap const& lhs, FlatMap const& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  struct KeyLess {
+    bool operator()(value_type const& item, Key const& key) const {
+      return item.first < key;
+    }
+  };
+
+  container_type items_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_FLAT_MAP_H_
@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  fleet_geofence.h
+// @Version :  1.0
+// @Time    :  2026/10/19 00:41:27
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_FLEET_GEOFENCE_H_
+#define JT808_FLEET_GEOFENCE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jt808/area_route.h"
+#include "jt808/geofence.h"
+#include "jt808/location_stream.h"
+#include "jt808/small_vector.h"
+
+
+namespace libjt808 {
+
+// 终端进出区域事件.
+struct GeofenceEvent {
+  uint64_t session;  // 会话标识(客户端的socket).
+  int64_t timestamp;  // 定位时间, UTC时间戳, 单位秒.
+  char phone_num[20];  // 终端手机号, 不足部分补0.
+  uint32_t area_id;  // 区域ID.
+  uint32_t latitude;  // 纬度, 单位百万分之一度.
+  uint32_t longitude;  // 经度, 单位百万分之一度.
+  uint8_t direction;  // kAccessAreaAlarmInArea或kAccessAreaAlarmOutArea.
+};
+
+// 平台侧的车队区域判断.
+// 平台统一定义多边形区域, 对每个终端上报的位置记录判断所在区域,
+// 与该终端上一次所在区域比较后产生进区域和出区域事件,
+// 用于不支持设置多边形区域(0x8604)的终端.
+// 所有终端共享同一份只读的区域空间索引, 修改区域时复制一份新的索引后整体替换,
+// 判断过程不需要等待区域修改; 终端的区域状态按手机号分片加锁,
+// 可在多个线程中同时调用Evaluate().
+//
+// Example:
+//     FleetGeofence fence;
+//     fence.SetAreas(polygon_areas);
+//     std::vector<GeofenceEvent> events;
+//     fence.Evaluate(records, num, &events);
+class FleetGeofence {
+ public:
+  // Args:
+  //     cell_size:  区域空间索引的网格边长, 单位为度.
+  explicit FleetGeofence(double const& cell_size = 0.05);
+  FleetGeofence(FleetGeofence const&) = delete;
+  FleetGeofence& operator=(FleetGeofence const&) = delete;
+
+  //
+  // 区域管理, 可在任意线程调用.
+  //
+  // 替换全部区域.
+  void SetAreas(PolygonAreaSet const& areas);
+  // 新增或更新区域.
+  void UpdateAreas(PolygonAreaSet const& areas);
+  // 删除指定ID的区域, 终端不会因区域被删除而产生出区域事件.
+  void RemoveAreas(std::vector<uint32_t> const& area_ids);
+  // 当前区域个数.
+  size_t area_num(void) const;
+
+  //
+  // 终端状态管理.
+  //
+  // 清除指定终端的区域状态, 下次上报时位于区域内将重新产生进区域事件.
+  void RemoveTerminal(std::string const& phone_num);
+  // 清除所有终端的区域状态.
+  void ClearTerminals(void);
+  // 当前保存了区域状态(曾进入过区域)的终端数.
+  size_t terminal_num(void) const;
+
+  // 判断位置记录所在区域, 追加产生的进出区域事件.
+  // 同一终端的位置记录需按时间顺序判断.
+  // Args:
+  //     records:  位置记录.
+  //     num:  位置记录数.
+  //     events:  追加产生的事件, 同一记录先出区域后进区域, 按区域ID升序.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Evaluate(LocationRecord const* records, size_t const& num,
+               std::vector<GeofenceEvent>* events);
+
+ private:
+  // 终端当前所在的区域ID, 按升序排列.
+  using AreaIds = SmallVector<uint32_t, 4>;
+  // 按手机号分片的终端区域状态, 减少多线程判断时的锁竞争.
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, AreaIds> terminals;
+  };
+  static constexpr size_t kShardNum = 64;
+
+  std::shared_ptr<GeofenceIndex const> index(void) const {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    return index_;
+  }
+  // 复制当前索引, 修改后替换.
+  template<typename Modifier>
+  void ModifyIndex(Modifier const& modifier);
+  // 比较终端前后所在区域, 产生事件并更新状态.
+  void Transition(GeofenceIndex const& index, LocationRecord const& record,
+                  std::vector<uint32_t> const& inside, AreaIds* state,
+                  std::vector<GeofenceEvent>* events) const;
+
+  double cell_size_;
+  std::mutex update_mutex_;  // 串行化区域修改.
+  mutable std::mutex index_mutex_;  // 保护index_指针本身.
+  std::shared_ptr<GeofenceIndex const> index_;
+  Shard shards_[kShardNum];
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_FLEET_GEOFENCE_H_
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  frame_assembler.h
+// @Version :  1.0
+// @Time    :  2026/10/18 11:05:21
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_FRAME_ASSEMBLER_H_
+#define JT808_FRAME_ASSEMBLER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+
+namespace libjt808 {
+
+// TCP字节流消息帧组装器.
+// 处理TCP粘包和拆包, 从连续的字节流中切分出以0x7E开始并以0x7E结束的
+// 完整JT808消息帧(未逆转义). 标识位之前的无效数据会被丢弃.
+//
+// Example:
+//     FrameAssembler assembler;
+//     assembler.Append(buffer, len);
+//     std::vector<uint8_t> frame;
+//     while (assembler.Next(&frame)) {
+//       JT808FrameParse(parser, frame, &para);
+//     }
+class FrameAssembler {
+ public:
+  // Args:
+  //     max_frame_size:  单帧最大长度, 超过时丢弃该帧数据并重新同步.
+  explicit FrameAssembler(size_t const& max_frame_size = 4096)
+      : max_frame_size_(max_frame_size), read_pos_(0) {}
+
+  // 追加接收到的数据.
+  void Append(uint8_t const* data, size_t const& len);
+  // 取出下一个完整的消息帧.
+  // Returns:
+  //     有完整消息帧返回true, 否则返回false.
+  bool Next(std::vector<uint8_t>* frame);
+  // 清除所有缓存数据.
+  void Reset(void) {
+    buffer_.clear();
+    read_pos_ = 0;
+  }
+  // 当前缓存的未处理数据长度.
+  size_t pending(void) const { return buffer_.size() - read_pos_; }
+
+ private:
+  size_t max_frame_size_;
+  size_t read_pos_;
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_FRAME_ASSEMBLER_H_
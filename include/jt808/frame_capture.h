@@ -0,0 +1,177 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  frame_capture.h
+// @Version :  1.0
+// @Time    :  2026/10/19 05:08:31
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_FRAME_CAPTURE_H_
+#define JT808_FRAME_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace libjt808 {
+
+// 抓包记录类型.
+enum FrameCaptureType {
+  // 服务端接受新连接, 回放时清除该会话之前的状态.
+  kFrameCaptureAccept = 0,
+  // 从连接接收到的原始数据.
+  kFrameCaptureData = 1,
+};
+
+// 单条接收数据的最大长度.
+constexpr size_t kMaxFrameCaptureData = 65536;
+
+// 抓包记录.
+struct FrameCaptureRecord {
+  int64_t time_us;  // 接收时间, 系统时间, 单位微秒(us).
+  uint64_t session;  // 会话标识(客户端的socket).
+  uint8_t type;  // 记录类型, 见FrameCaptureType.
+  std::vector<uint8_t> data;  // 接收到的原始数据, 可能包含多帧或不完整的帧.
+};
+
+// 原始数据抓包文件写入.
+// 文件由16字节的文件头和依次追加的记录组成, 每条记录为:
+//     类型(1字节), 与上一条记录的时间差(zigzag+varint, 微秒),
+//     会话标识(varint), 数据长度(varint)和数据.
+// 调用线程只把记录编码到内存缓存, 后台线程批量写入文件, 不阻塞IO线程.
+// 缓存超过上限(磁盘写入跟不上)时丢弃新记录并计数.
+// 可在多个线程中调用.
+//
+// Example:
+//     FrameCaptureWriter capture;
+//     capture.Open("./jt808.capture");
+//     capture.WriteData(socket, buffer, len);
+//     capture.Close();
+class FrameCaptureWriter {
+ public:
+  explicit FrameCaptureWriter(size_t const& max_buffer_bytes = 16 << 20);
+  ~FrameCaptureWriter();
+  FrameCaptureWriter(FrameCaptureWriter const&) = delete;
+  FrameCaptureWriter& operator=(FrameCaptureWriter const&) = delete;
+
+  // 创建抓包文件并启动后台写入线程, 文件已存在时覆盖.
+  // Returns:
+  //     成功返回0, 已打开或创建文件失败返回-1.
+  int Open(std::string const& path);
+  // 写出缓存中的记录并关闭文件.
+  void Close(void);
+  bool is_open(void) const {
+    return open_.load(std::memory_order_relaxed);
+  }
+
+  // 记录接受新连接.
+  void WriteAccept(uint64_t const& session);
+  // 记录接收到的原始数据.
+  void WriteData(uint64_t const& session, uint8_t const* data,
+                 size_t const& len);
+
+  // 已写入缓存的记录数.
+  uint64_t records(void) const {
+    return records_.load(std::memory_order_relaxed);
+  }
+  // 因缓存已满或数据过长被丢弃的记录数.
+  uint64_t dropped(void) const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // 编码一条记录写入缓存.
+  void Append(uint8_t const& type, uint64_t const& session,
+              uint8_t const* data, size_t const& len);
+  // 后台写入线程处理函数.
+  void WriterHandler(void);
+
+  size_t const max_buffer_bytes_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::vector<uint8_t> buffer_;  // 待写入的记录, 由mutex_保护.
+  int64_t last_time_us_;  // 上一条记录的时间, 由mutex_保护.
+  bool stopping_;  // 由mutex_保护.
+  FILE* file_;  // 只在后台写入线程中使用.
+  std::thread writer_thread_;
+  std::atomic_bool open_;
+  std::atomic<uint64_t> records_;
+  std::atomic<uint64_t> dropped_;
+};
+
+// 原始数据抓包文件读取, 按写入顺序逐条读取记录.
+// 文件末尾不完整的记录(进程异常退出时写入)视为文件结束.
+//
+// Example:
+//     FrameCaptureReader reader;
+//     reader.Open("./jt808.capture");
+//     FrameCaptureRecord record;
+//     while (reader.Next(&record) == 1) { ... }
+class FrameCaptureReader {
+ public:
+  FrameCaptureReader();
+  ~FrameCaptureReader();
+  FrameCaptureReader(FrameCaptureReader const&) = delete;
+  FrameCaptureReader& operator=(FrameCaptureReader const&) = delete;
+
+  // 打开抓包文件.
+  // Returns:
+  //     成功返回0, 失败或文件不是抓包文件返回-1.
+  int Open(std::string const& path);
+  void Close(void);
+  bool is_open(void) const { return file_ != nullptr; }
+
+  // 读取下一条记录.
+  // Returns:
+  //     读取到记录返回1, 文件结束返回0, 文件损坏返回-1.
+  int Next(FrameCaptureRecord* record);
+
+  // 开始抓包的时间, 系统时间, 单位微秒(us).
+  int64_t start_time_us(void) const { return start_time_us_; }
+
+ private:
+  // 保证缓存中至少有need字节未读数据, 文件剩余不足时读取到文件末尾.
+  // Returns:
+  //     缓存中未读数据的字节数.
+  size_t Fill(size_t const& need);
+
+  FILE* file_;
+  std::vector<uint8_t> buffer_;
+  size_t pos_;  // 缓存中未读数据的起始位置.
+  size_t end_;  // 缓存中未读数据的结束位置.
+  int64_t start_time_us_;
+  int64_t time_us_;  // 上一条记录的时间.
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_FRAME_CAPTURE_H_
@@ -0,0 +1,288 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  geofence.h
+// @Version :  1.0
+// @Time    :  2026/10/19 00:15:06
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_GEOFENCE_H_
+#define JT808_GEOFENCE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jt808/area_route.h"
+#include "jt808/box_grid.h"
+#include "jt808/geometry.h"
+#include "jt808/location_report.h"
+
+
+namespace libjt808 {
+
+// 射线法判断点是否在多边形内.
+// 经纬度先四舍五入为百万分之一度, 再按定点坐标精确判断,
+// 结果与IsPointInsidePolygon(GeoPoint const&, ...)相同.
+// Args:
+//     point:  检查点.
+//     vertices:  多边形顶点, 按顺序依次存储, 首尾自动闭合.
+// Returns:
+//     在多边形内返回true, 否则返回false, 顶点数小于3时总是返回false.
+bool IsPointInsidePolygon(LocationPoint const& point,
+                          std::vector<LocationPoint> const& vertices);
+
+// 预处理后的多边形, 用于同一多边形的大量判断.
+// 预先计算每条边的纬度范围、下端点和端点差, 判断时只需一次整数叉积;
+// 水平边不会与射线相交, 预处理时直接去掉. 坐标为百万分之一度的定点数,
+// 边数据按4条一组, 组内各字段连续存放(SoA), 编译时启用AVX2(-mavx2)
+// 则每条指令同时判断4条边, 否则使用结果相同的标量实现.
+// 判断结果与IsPointInsidePolygon()一致.
+//
+// Example:
+//     PreparedPolygon polygon(area.vertices);
+//     bool inside = polygon.Contains(MakeGeoPoint(info.longitude,
+//                                                 info.latitude));
+//     polygon.ContainsBatch(track.data(), track.size(), results.data());
+class PreparedPolygon {
+ public:
+  PreparedPolygon() : edge_num_(0), box_() {}
+  explicit PreparedPolygon(std::vector<GeoPoint> const& vertices) {
+    Reset(vertices);
+  }
+  explicit PreparedPolygon(std::vector<LocationPoint> const& vertices) {
+    Reset(vertices);
+  }
+
+  // 以新的顶点集重新预处理, 顶点数小于3时为空多边形.
+  void Reset(std::vector<GeoPoint> const& vertices);
+  void Reset(std::vector<LocationPoint> const& vertices);
+  // 参与判断的边数(不含水平边).
+  size_t edge_num(void) const { return edge_num_; }
+  // 外接矩形, 空多边形时全为0.
+  GeoBox const& box(void) const { return box_; }
+
+  // 判断点是否在多边形内.
+  bool Contains(GeoPoint const& point) const;
+  bool Contains(LocationPoint const& point) const {
+    return Contains(ToGeoPoint(point));
+  }
+  // 批量判断, 用于历史轨迹回放等场景.
+  // Args:
+  //     points:  检查点.
+  //     num:  检查点个数.
+  //     results:  判断结果, 在多边形内为1, 否则为0, 长度不小于num.
+  void ContainsBatch(GeoPoint const* points, size_t const& num,
+                     uint8_t* results) const;
+  void ContainsBatch(LocationPoint const* points, size_t const& num,
+                     uint8_t* results) const;
+
+ private:
+  // 每组边数, 与AVX2一次处理的64位整数个数相同.
+  static constexpr size_t kGroupSize = 4;
+  // 每组边的字段数: 最小纬度, 最大纬度, 下端点经度, 下端点纬度,
+  // 上下端点经度差, 上下端点纬度差.
+  static constexpr size_t kFieldNum = 6;
+
+  // 统计射线与边的交点个数.
+  int CountCrossings(GeoPoint const& point) const;
+
+  size_t edge_num_;
+  GeoBox box_;
+  std::vector<int32_t> edges_;  // 按组存放的边数据, 不足一组的部分为空边.
+};
+
+// 区域引用, 不同类型的区域ID相互独立.
+struct AreaRef {
+  // 区域类型, 见kAccessAreaAlarmLocationType.
+  uint8_t type;
+  // 区域ID.
+  uint32_t area_id;
+};
+
+inline bool operator==(AreaRef const& lhs, AreaRef const& rhs) {
+  return lhs.type == rhs.type && lhs.area_id == rhs.area_id;
+}
+inline bool operator<(AreaRef const& lhs, AreaRef const& rhs) {
+  return lhs.type < rhs.type ||
+         (lhs.type == rhs.type && lhs.area_id < rhs.area_id);
+}
+
+// 区域的时段和限速规则, 由区域属性及起止时间、限速字段生成.
+struct AreaRule {
+  // 区域属性.
+  AreaAttribute attribute;
+  // 根据时间时的起止时间, UTC时间戳, 单位秒;
+  // daily为true时为每天的时段, 取GMT+8当天的秒数.
+  int64_t start_time;
+  int64_t stop_time;
+  // 起止时间的年月日均为0时按每天的时段判断.
+  bool daily;
+  // 最高速度, 单位为公里每小时(km/h).
+  uint16_t max_speed;
+  // 超速持续时间, 单位为秒(s).
+  uint8_t overspeed_time;
+};
+
+// 由区域属性及起止时间、限速字段生成区域规则.
+// 起止时间格式错误时不按时间限制.
+void MakeAreaRule(AreaAttribute const& attribute,
+                  std::string const& start_time,
+                  std::string const& stop_time,
+                  uint16_t const& max_speed,
+                  uint8_t const& overspeed_time,
+                  AreaRule* rule);
+
+// 区域在指定时间是否生效, 不根据时间的区域总是生效.
+// 每天的时段起始时间大于结束时间时表示跨越零点.
+bool IsAreaActive(AreaRule const& rule, int64_t const& timestamp);
+
+class AreaTracker;
+
+// 圆形、矩形和多边形区域的空间索引.
+// 以固定大小的经纬度网格划分平面, 每个网格记录与其相交的区域外接矩形,
+// 查询时只需对检查点所在网格中的区域做外接矩形过滤和精确判断,
+// 与区域总数无关. 外接矩形跨越网格过多的大区域单独存放, 查询时逐个检查.
+// 区域的新增、更新和删除只修改其覆盖的网格, 无需重建整个索引.
+// 圆形区域按近似距离判断(见IsWithinDistance), 矩形区域和多边形区域含边界.
+// 只接受区域ID参数的接口仅针对多边形区域.
+// 非线程安全, 多线程访问时由调用方加锁.
+//
+// Example:
+//     GeofenceIndex index;
+//     index.Build(polygon_areas);
+//     index.Insert(circular_area);
+//     std::vector<AreaRef> areas;
+//     index.Query(point, &areas);
+class GeofenceIndex {
+ public:
+  // Args:
+  //     cell_size:  网格边长, 单位为度, 应接近常见区域的尺寸.
+  explicit GeofenceIndex(double const& cell_size = 0.05);
+
+  // 网格边长, 单位为度.
+  double cell_size(void) const { return grid_.cell_size()*1e-6; }
+  // 区域个数.
+  size_t size(void) const { return slots_.size(); }
+  bool empty(void) const { return slots_.empty(); }
+  // 区域修改版本, 每次修改后变化, 不同索引的修改版本也不相同,
+  // 复制得到的索引与原索引的版本相同.
+  uint64_t version(void) const { return version_; }
+  // 是否包含指定的区域.
+  bool HasArea(uint8_t const& type, uint32_t const& area_id) const {
+    return slots_.find(AreaKey(type, area_id)) != slots_.end();
+  }
+  bool HasArea(uint32_t const& area_id) const {
+    return HasArea(kAccessAreaAlarmPolygonArea, area_id);
+  }
+
+  // 清空后以多边形区域信息集重建索引.
+  void Build(PolygonAreaSet const& areas);
+  // 新增区域, 同类型的区域ID已存在时替换原有区域.
+  // Returns:
+  //     成功返回0, 多边形顶点数小于3返回-1.
+  int Insert(PolygonArea const& area);
+  int Insert(CircularArea const& area);
+  int Insert(RectangleArea const& area);
+  // 删除指定的区域, 区域不存在时不做处理.
+  void Remove(uint8_t const& type, uint32_t const& area_id);
+  void Remove(uint32_t const& area_id) {
+    Remove(kAccessAreaAlarmPolygonArea, area_id);
+  }
+  // 删除指定类型的所有区域.
+  void Clear(uint8_t const& type);
+  // 删除所有区域.
+  void Clear(void);
+
+  // 查询包含指定点的所有区域.
+  // Args:
+  //     point:  检查点.
+  //     areas:  包含检查点的区域, 按类型和区域ID升序排列.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Query(GeoPoint const& point, std::vector<AreaRef>* areas) const;
+  // 查询包含指定点的所有多边形区域.
+  // Args:
+  //     point:  检查点.
+  //     area_ids:  包含检查点的多边形区域ID, 按升序排列.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Query(GeoPoint const& point, std::vector<uint32_t>* area_ids) const;
+  int Query(LocationPoint const& point,
+            std::vector<uint32_t>* area_ids) const {
+    return Query(ToGeoPoint(point), area_ids);
+  }
+  // 获取指定区域的规则.
+  // Returns:
+  //     成功返回0, 区域不存在返回-1.
+  int GetRule(uint8_t const& type, uint32_t const& area_id,
+              AreaRule* rule) const;
+  // 指定的区域是否包含检查点, 区域不存在时返回false.
+  bool Contains(uint8_t const& type, uint32_t const& area_id,
+                GeoPoint const& point) const;
+  bool Contains(uint32_t const& area_id, GeoPoint const& point) const {
+    return Contains(kAccessAreaAlarmPolygonArea, area_id, point);
+  }
+  bool Contains(uint32_t const& area_id, LocationPoint const& point) const {
+    return Contains(area_id, ToGeoPoint(point));
+  }
+
+ private:
+  // 已索引的区域.
+  struct Entry {
+    uint8_t type;
+    uint32_t area_id;
+    GeoBox box;  // 放入网格的外接矩形, 矩形区域即为区域本身.
+    GeoPoint center;  // 圆形区域的中心点.
+    uint32_t radius;  // 圆形区域的半径.
+    PreparedPolygon polygon;  // 多边形区域.
+    AreaRule rule;
+  };
+  // AreaTracker直接缓存存储槽和网格候选区域.
+  friend class AreaTracker;
+
+  static uint64_t AreaKey(uint8_t const& type, uint32_t const& area_id) {
+    return (static_cast<uint64_t>(type) << 32) | area_id;
+  }
+  // 取得区域的存储槽, 区域已存在时先从网格中移除.
+  Entry* Acquire(uint8_t const& type, uint32_t const& area_id);
+  // 判断区域是否包含检查点.
+  static bool EntryContains(Entry const& entry, GeoPoint const& point);
+
+  // 修改后更新版本.
+  void Modified(void);
+
+  uint64_t version_;
+  BoxGrid grid_;
+  std::vector<Entry> entries_;  // 区域存储槽, 删除后的槽位复用.
+  std::vector<uint32_t> free_slots_;
+  std::unordered_map<uint64_t, uint32_t> slots_;  // 区域类型和ID到存储槽.
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_GEOFENCE_H_
@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  geometry.h
+// @Version :  1.0
+// @Time    :  2026/10/19 01:26:43
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_GEOMETRY_H_
+#define JT808_GEOMETRY_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "jt808/area_route.h"
+
+
+namespace libjt808 {
+
+// 定点经纬度坐标, 单位为百万分之一度, 与协议中的经纬度单位相同.
+// 位置信息汇报中的经纬度可直接使用, 无需转换为浮点数;
+// 相比LocationPoint, 每个顶点只占8字节.
+struct GeoPoint {
+  int32_t longitude;
+  int32_t latitude;
+};
+
+inline bool operator==(GeoPoint const& lhs, GeoPoint const& rhs) {
+  return lhs.longitude == rhs.longitude && lhs.latitude == rhs.latitude;
+}
+inline bool operator!=(GeoPoint const& lhs, GeoPoint const& rhs) {
+  return !(lhs == rhs);
+}
+
+// 定点经纬度外接矩形.
+struct GeoBox {
+  int32_t min_longitude;
+  int32_t min_latitude;
+  int32_t max_longitude;
+  int32_t max_latitude;
+};
+
+// 由协议中的经纬度(百万分之一度)构造定点坐标.
+inline GeoPoint MakeGeoPoint(uint32_t const& longitude,
+                             uint32_t const& latitude) {
+  return GeoPoint {static_cast<int32_t>(longitude),
+                   static_cast<int32_t>(latitude)};
+}
+
+// 浮点经纬度(度)转换为定点数, 四舍五入到百万分之一度.
+inline int32_t DegreeToMicroDegree(double const& degree) {
+  return static_cast<int32_t>(degree*1e6 + (degree < 0 ? -0.5 : 0.5));
+}
+
+// 浮点经纬度转换为定点坐标.
+inline GeoPoint ToGeoPoint(LocationPoint const& point) {
+  return GeoPoint {DegreeToMicroDegree(point.longitude),
+                   DegreeToMicroDegree(point.latitude)};
+}
+
+// 浮点顶点集转换为定点顶点集.
+void ToGeoPoints(std::vector<LocationPoint> const& points,
+                 std::vector<GeoPoint>* out);
+
+// 计算顶点集的外接矩形.
+// Returns:
+//     成功返回0, 顶点集为空返回-1.
+int GetBoundingBox(std::vector<GeoPoint> const& vertices, GeoBox* box);
+
+// 外接矩形是否包含指定点(含边界).
+inline bool IsPointInsideBox(GeoPoint const& point, GeoBox const& box) {
+  return point.longitude >= box.min_longitude &&
+         point.longitude <= box.max_longitude &&
+         point.latitude >= box.min_latitude &&
+         point.latitude <= box.max_latitude;
+}
+
+// 向量OA与OB的叉积, 以64位整数精确计算.
+// 大于0表示B在OA的左侧(逆时针方向), 小于0在右侧, 等于0三点共线.
+inline int64_t Cross(GeoPoint const& o, GeoPoint const& a, GeoPoint const& b) {
+  return static_cast<int64_t>(a.longitude-o.longitude)*
+             (b.latitude-o.latitude) -
+         static_cast<int64_t>(a.latitude-o.latitude)*
+             (b.longitude-o.longitude);
+}
+
+// 射线法判断点是否在多边形内, 全部为整数运算, 结果确定.
+// 从检查点向东作水平射线, 交点是否在检查点东侧由叉积的符号判断, 无需除法.
+// 边的一个端点纬度等于检查点纬度时按在其上方处理, 点恰好在边上时视为不相交.
+// Args:
+//     point:  检查点.
+//     vertices:  多边形顶点, 按顺序依次存储, 首尾自动闭合.
+// Returns:
+//     在多边形内返回true, 否则返回false, 顶点数小于3时总是返回false.
+bool IsPointInsidePolygon(GeoPoint const& point,
+                          std::vector<GeoPoint> const& vertices);
+
+//
+// 距离近似计算.
+// 在两点附近把地球表面近似为平面(等距圆柱投影), 经度差按纬度的余弦缩放,
+// 余弦值按0.1°查表得到, 几十公里内误差约0.5%以内, 用于区域和路线判断.
+//
+// 赤道上1百万分之一度对应的距离, 单位为米(m).
+constexpr double kMetersPerMicroDegree = 0.11131949079327372;
+
+// 两点间的近似距离, 单位为米(m).
+uint32_t ApproximateDistance(GeoPoint const& from, GeoPoint const& to);
+// 两点间的近似距离是否不超过指定值, 比较距离的平方, 不开方.
+bool IsWithinDistance(GeoPoint const& from, GeoPoint const& to,
+                      uint32_t const& meters);
+// 点到线段的近似距离, 单位为米(m).
+uint32_t ApproximateSegmentDistance(GeoPoint const& point,
+                                    GeoPoint const& start,
+                                    GeoPoint const& end);
+// 外接矩形向四周扩展指定距离, 单位为米(m).
+// 经度方向按扩展后纬度绝对值最大处的余弦放大, 与原矩形内任一点的近似距离
+// 不超过该距离的点都在扩展后的矩形内.
+GeoBox ExpandBox(GeoBox const& box, uint32_t const& meters);
+
+}  // namespace libjt808
+
+#endif  // JT808_GEOMETRY_H_
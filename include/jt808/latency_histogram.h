@@ -0,0 +1,152 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  latency_histogram.h
+// @Version :  1.0
+// @Time    :  2026/10/18 15:20:06
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LATENCY_HISTOGRAM_H_
+#define JT808_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+
+namespace libjt808 {
+
+// 对数-线性分段的延时直方图.
+// 小于64的值逐个计数, 之后每个2的幂区间再均分为32段, 相对误差约3%.
+// 记录操作只有一次数组自增, 适合在事件循环中统计每条消息的应答延时.
+//
+// Example:
+//     LatencyHistogram hist;
+//     hist.Record(latency_us);
+//     printf("p99: %lu\n", hist.Percentile(99.0));
+class LatencyHistogram {
+ public:
+  LatencyHistogram() : counts_(kBucketNum, 0), count_(0), sum_(0), max_(0) {}
+
+  // 记录一个值.
+  void Record(uint64_t const& value) {
+    ++counts_[BucketIndex(value)];
+    ++count_;
+    sum_ += value;
+    if (value > max_) max_ = value;
+  }
+  // 合并另一个直方图.
+  void Merge(LatencyHistogram const& other) {
+    for (size_t i = 0; i < kBucketNum; ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (other.max_ > max_) max_ = other.max_;
+  }
+  // 清空.
+  void Reset(void) {
+    counts_.assign(kBucketNum, 0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+  }
+  // 获取百分位数.
+  // Args:
+  //     percentile:  百分位, 取值范围[0, 100].
+  // Returns:
+  //     该百分位所在分段的上限值, 无数据时返回0.
+  uint64_t Percentile(double const& percentile) const {
+    if (count_ == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(percentile/100.0*count_ + 0.5);
+    if (target == 0) target = 1;
+    if (target > count_) target = count_;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketNum; ++i) {
+      seen += counts_[i];
+      if (seen >= target) {
+        uint64_t const upper = (i+1 < kBucketNum) ? Value(i+1)-1 : max_;
+        return (upper < max_) ? upper : max_;
+      }
+    }
+    return max_;
+  }
+  // 按分段累加计数, 用于合并以其它形式(如原子计数)保存的直方图数据.
+  void AddBucket(size_t const& bucket, uint64_t const& count) {
+    if (bucket >= kBucketNum || count == 0) return;
+    counts_[bucket] += count;
+    count_ += count;
+  }
+  // 累加总和并更新最大值, 与AddBucket()配合使用.
+  void AddSummary(uint64_t const& sum, uint64_t const& max) {
+    sum_ += sum;
+    if (max > max_) max_ = max;
+  }
+  uint64_t count(void) const { return count_; }
+  uint64_t max(void) const { return max_; }
+  double mean(void) const {
+    return (count_ == 0) ? 0.0 : static_cast<double>(sum_)/count_;
+  }
+  uint64_t sum(void) const { return sum_; }
+
+  // 分段数.
+  static constexpr size_t kBucketNum = 64 + (63-5)*32;
+
+  // 值所在的分段.
+  static size_t BucketIndex(uint64_t const& value) {
+    if (value < kLinearNum) return static_cast<size_t>(value);
+#if defined(__GNUC__)
+    int const msb = 63 - __builtin_clzll(value);
+#else
+    int msb = 0;
+    for (uint64_t v = value; v > 1; v >>= 1) ++msb;
+#endif
+    int const shift = msb - kSubBits;
+    return kLinearNum + (shift-1)*kSubNum +
+           static_cast<size_t>((value >> shift) - kSubNum);
+  }
+
+ private:
+  static constexpr int kSubBits = 5;
+  static constexpr size_t kSubNum = 1 << kSubBits;
+  static constexpr size_t kLinearNum = kSubNum*2;
+  static_assert(kBucketNum == kLinearNum + (63-kSubBits)*kSubNum,
+                "bucket number mismatch");
+
+  // 分段的下限值.
+  static uint64_t Value(size_t const& index) {
+    if (index < kLinearNum) return index;
+    size_t const idx = index - kLinearNum;
+    int const shift = static_cast<int>(idx/kSubNum) + 1;
+    return static_cast<uint64_t>(idx%kSubNum + kSubNum) << shift;
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,216 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_archive.h
+// @Version :  1.0
+// @Time    :  2026/10/19 04:26:53
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOCATION_ARCHIVE_H_
+#define JT808_LOCATION_ARCHIVE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jt808/location_report.h"
+#include "jt808/location_stream.h"
+
+
+namespace libjt808 {
+
+// 位置历史归档文件.
+// 文件由64字节的文件头和依次追加的数据块组成, 每个数据块只包含一个终端的
+// 位置记录, 按列存放:
+//     时间、经度、纬度、高程、速度、方向: 与前一条记录的差值, zigzag+varint编码;
+//     报警标志、状态: 1位变化标记位图, 之后依次存放发生变化的值.
+// 1Hz上报的车辆每条记录约8字节. 块头记录终端手机号和时间范围,
+// 按时间范围查询时跳过不相交的块.
+//
+// 写入:
+//     LocationArchiveWriter writer;
+//     writer.Open("./location.archive");
+//     writer.Append(records, num);
+//     writer.Close();
+// 读取:
+//     LocationArchiveReader reader;
+//     reader.Open("./location.archive");
+//     std::vector<LocationRecord> track;
+//     reader.Read("13395279527", start_time, stop_time, &track);
+
+// 位置历史归档写入.
+// 每个终端在内存中缓存一个正在编码的数据块, 达到最大记录条数或缓存时间
+// 超过最大块时长时写入文件, Flush()和Close()写出所有未满的数据块.
+// 块时长在Append()中检查, 没有新记录时未满的数据块保留到下一次Append().
+// 写入文件只追加完整的数据块, 打开已有文件时截断末尾不完整的数据块后继续追加.
+// 可在多个线程中调用.
+class LocationArchiveWriter {
+ public:
+  LocationArchiveWriter();
+  ~LocationArchiveWriter();
+  LocationArchiveWriter(LocationArchiveWriter const&) = delete;
+  LocationArchiveWriter& operator=(LocationArchiveWriter const&) = delete;
+
+  // 打开归档文件, 文件不存在时创建.
+  // Args:
+  //     path:  归档文件路径.
+  //     block_records:  每个数据块的最大记录条数.
+  //     max_block_age_ms:  数据块从第一条记录起在内存中缓存的最长时间,
+  //                        单位毫秒(ms), 限制进程异常退出时丢失的记录.
+  // Returns:
+  //     成功返回0, 失败或文件不是归档文件返回-1.
+  int Open(std::string const& path, uint32_t const& block_records = 1024,
+           int const& max_block_age_ms = 60000);
+  // 写出所有数据块并关闭文件.
+  void Close(void);
+  bool is_open(void) const;
+
+  // 追加位置记录, 使用手机号、时间和位置基本信息, 不保存会话标识.
+  // Returns:
+  //     成功返回0, 未打开或写文件失败返回-1.
+  int Append(LocationRecord const* records, size_t const& num);
+  // 追加一条位置基本信息.
+  int Append(std::string const& phone_num,
+             LocationBasicInformation const& info);
+  // 写出所有未满的数据块.
+  int Flush(void);
+
+  // 已写入文件的数据块个数和字节数.
+  uint64_t block_num(void) const;
+  uint64_t bytes_written(void) const;
+
+ private:
+  struct Block;
+
+  // 按开始缓存的时间排列的数据块.
+  struct AgingBlock {
+    std::chrono::steady_clock::time_point since;
+    Block* block;
+  };
+
+  // 编码并写出数据块, 调用方已加锁.
+  int WriteBlock(Block* block);
+  // 写出缓存时间超过最大块时长的数据块, 调用方已加锁.
+  int WriteAgedBlocks(std::chrono::steady_clock::time_point const& now);
+
+  mutable std::mutex mutex_;
+  FILE* file_;
+  uint32_t block_records_;
+  std::chrono::milliseconds max_block_age_;
+  // 终端正在编码的数据块.
+  std::unordered_map<std::string, std::unique_ptr<Block>> blocks_;
+  // 未写出的数据块, 同一数据块写出后再次开始缓存时重新加入.
+  std::deque<AgingBlock> aging_blocks_;
+  std::string phone_num_;  // 复用的查找键.
+  std::vector<uint8_t> buffer_;  // 复用的数据块编码缓存.
+  uint64_t block_num_;
+  uint64_t bytes_written_;
+};
+
+// 位置历史归档读取.
+// 归档文件通过mmap只读映射到内存, 打开时建立数据块索引, 之后写入的数据块
+// 需重新打开才能读取. 打开后为只读状态, 可在多个线程中同时查询.
+class LocationArchiveReader {
+ public:
+  // 数据块查询回调, records仅在回调期间有效.
+  using Visitor =
+      std::function<void (LocationRecord const* records, size_t const& num)>;
+
+  LocationArchiveReader();
+  ~LocationArchiveReader();
+  LocationArchiveReader(LocationArchiveReader const&) = delete;
+  LocationArchiveReader& operator=(LocationArchiveReader const&) = delete;
+
+  // 打开归档文件并建立数据块索引, 末尾不完整的数据块被忽略.
+  // Returns:
+  //     成功返回0, 失败或文件不是归档文件返回-1.
+  int Open(std::string const& path);
+  void Close(void);
+  bool is_open(void) const { return data_ != nullptr; }
+
+  // 数据块个数.
+  size_t block_num(void) const { return blocks_.size(); }
+  // 记录条数.
+  uint64_t record_num(void) const { return record_num_; }
+  // 终端个数.
+  size_t terminal_num(void) const { return terminals_.size(); }
+
+  // 按时间范围查询位置记录, 逐个数据块回调.
+  // 同一终端的记录按写入顺序返回.
+  // Args:
+  //     phone_num:  终端手机号, 为空时查询所有终端.
+  //     start_time:  起始时间(含), UTC时间戳, 单位秒.
+  //     stop_time:  结束时间(含), UTC时间戳, 单位秒.
+  //     visitor:  回调函数.
+  // Returns:
+  //     成功返回查询到的记录条数, 数据块损坏返回-1.
+  int64_t Scan(std::string const& phone_num, int64_t const& start_time,
+               int64_t const& stop_time, Visitor const& visitor) const;
+  // 按时间范围读取终端的位置记录, 用于轨迹回放.
+  // Returns:
+  //     成功返回0, 数据块损坏返回-1.
+  int Read(std::string const& phone_num, int64_t const& start_time,
+           int64_t const& stop_time,
+           std::vector<LocationRecord>* records) const;
+
+ private:
+  struct BlockInfo {
+    size_t offset;  // 数据块在文件中的偏移.
+    uint32_t num;
+    int64_t start_time;
+    int64_t stop_time;
+  };
+
+  // 解码数据块中时间范围内的记录.
+  // Returns:
+  //     成功返回记录条数, 数据块损坏返回-1.
+  int64_t DecodeBlock(BlockInfo const& block, int64_t const& start_time,
+                      int64_t const& stop_time,
+                      std::vector<LocationRecord>* records) const;
+
+  uint8_t const* data_;  // 映射内存起始位置.
+  size_t map_size_;
+  std::vector<BlockInfo> blocks_;
+  std::unordered_map<std::string, std::vector<uint32_t>> terminals_;
+  uint64_t record_num_;
+#if defined(__linux__)
+  int fd_;
+#elif defined(_WIN32)
+  void* file_;
+  void* mapping_;
+#endif
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_LOCATION_ARCHIVE_H_
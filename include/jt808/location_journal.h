@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_journal.h
+// @Version :  1.0
+// @Time    :  2026/10/18 14:05:27
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOCATION_JOURNAL_H_
+#define JT808_LOCATION_JOURNAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace libjt808 {
+
+// 位置信息汇报持久化环形日志.
+// 日志文件通过mmap映射到内存, 由固定大小的文件头和capacity个固定大小的
+// 记录槽组成, 每个记录槽存放一条位置信息汇报(0x0200)消息体.
+// 写入和删除只修改文件头中的读写序号, 进程重启后可以继续读取未上传的记录.
+// 日志已满时覆盖最旧的记录.
+//
+// Example:
+//     LocationJournal journal;
+//     journal.Open("./location.journal", 10000);
+//     journal.Append(body);
+//     std::vector<std::vector<uint8_t>> items;
+//     journal.Peek(0, 100, 1020, &items);
+//     journal.Pop(items.size());
+class LocationJournal {
+ public:
+  LocationJournal();
+  ~LocationJournal();
+  LocationJournal(LocationJournal const&) = delete;
+  LocationJournal& operator=(LocationJournal const&) = delete;
+
+  // 打开日志文件, 文件不存在或格式不匹配时重新创建.
+  // Args:
+  //     path:  日志文件路径.
+  //     capacity:  最多保存的记录条数.
+  //     slot_size:  单条记录最大字节数, 超出的记录无法写入.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Open(std::string const& path, uint32_t const& capacity,
+           uint32_t const& slot_size = 256);
+  // 同步并关闭日志文件.
+  void Close(void);
+  // 日志文件是否已打开.
+  bool is_open(void) const;
+
+  // 追加一条记录, 日志已满时覆盖最旧的记录.
+  // Returns:
+  //     成功返回0, 未打开或记录过长返回-1.
+  int Append(std::vector<uint8_t> const& record);
+  // 读取记录但不删除.
+  // Args:
+  //     offset:  跳过最旧的offset条记录.
+  //     max_num:  最多读取的记录条数.
+  //     max_bytes:  读取记录的总字节数上限, 每条记录额外计2字节长度.
+  //     records:  读取到的记录, 损坏的记录以空记录返回.
+  // Returns:
+  //     读取到的记录条数.
+  size_t Peek(size_t const& offset, size_t const& max_num,
+              size_t const& max_bytes,
+              std::vector<std::vector<uint8_t>>* records) const;
+  // 删除最旧的num条记录.
+  void Pop(size_t const& num);
+  // 将日志内容异步刷入磁盘.
+  int Sync(void);
+
+  // 当前记录条数.
+  size_t size(void) const;
+  // 最多保存的记录条数.
+  size_t capacity(void) const;
+  // 因日志已满被覆盖的记录条数.
+  uint64_t overwritten(void) const;
+
+ private:
+  struct Header;
+
+  // 第seq条记录所在的记录槽.
+  uint8_t* Slot(uint64_t const& seq) const;
+
+  mutable std::mutex mutex_;
+  Header* header_;  // 文件头, 指向映射内存起始位置.
+  uint8_t* slots_;  // 记录槽起始位置.
+  size_t map_size_;  // 映射内存大小.
+  uint64_t overwritten_;  // 被覆盖的记录条数.
+#if defined(__linux__)
+  int fd_;
+#elif defined(_WIN32)
+  void* file_;
+  void* mapping_;
+#endif
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_LOCATION_JOURNAL_H_
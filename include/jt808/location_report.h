@@ -31,11 +31,15 @@
 #define JT808_LOCATION_REPORT_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include <map>
 #include <string>
 #include <vector>
 
+#include "jt808/flat_map.h"
+#include "jt808/small_vector.h"
+
 
 namespace libjt808 {
 
@@ -164,7 +168,10 @@ struct LocationBasicInformation {
   // 方向 0-359,正北为0, 顺时针
   uint16_t bearing;
   // 时间, "YYMMDDhhmmss"(GMT+8时间, 本标准之后涉及的时间均采用此时区).
+  // 解析时可选择不生成, 封装时为空则使用timestamp.
   std::string time;
+  // 时间对应的UTC时间戳, 单位秒. 解析时由BCD时间直接换算, 时间非法时为0.
+  int64_t timestamp;
 };
 
 // 扩展车辆信号状态位
@@ -238,8 +245,11 @@ enum LocationExtensionId {
   kPositioningStatus = 0xEE
 };
 
+// 位置信息附加项的值, 不超过16字节时无需堆分配.
+using LocationExtensionValue = SmallVector<uint8_t, 16>;
 // 位置信息附加项存储定义: key: itemid, value: itemvalue.
-using LocationExtensions = std::map<uint8_t, std::vector<uint8_t>>;
+// 按附加信息ID升序连续存放, 封装时按ID顺序写出.
+using LocationExtensions = FlatMap<uint8_t, LocationExtensionValue>;
 
 //  超速报警附加信息位置类型, BYTE.
 enum kOverSpeedAlarmLocationType {
@@ -296,13 +306,160 @@ struct LocationTrackingControl {
   uint32_t tracking_time;
 };
 
+// 定位数据批量上传类型.
+enum kLocationBatchType {
+  // 正常位置批量汇报.
+  kLocationBatchNormal = 0x0,
+  // 盲区补报.
+  kLocationBatchBlindArea,
+};
+
+// 定位数据批量上传信息.
+struct LocationBatch {
+  // 位置数据类型.
+  uint8_t type;
+  // 位置汇报数据项, 每项为一条完整的位置信息汇报(0x0200)消息体.
+  std::vector<std::vector<uint8_t>> items;
+};
+
+// 封装位置信息汇报消息体, 结果追加到out末尾.
+// Returns:
+//     成功返回消息体长度, 失败返回-1.
+int PackageLocationReportBody(LocationBasicInformation const& basic_info,
+                              LocationExtensions const& extension_info,
+                              std::vector<uint8_t>* out);
+
+// 解析位置信息汇报消息体, 解析出的附加信息项合并到extension_info中.
+// Args:
+//     time_string:  是否生成basic_info->time, 为false时只生成timestamp.
+// Returns:
+//     成功返回0, 失败返回-1.
+int ParseLocationReportBody(uint8_t const* in, size_t const& len,
+                            LocationBasicInformation* basic_info,
+                            LocationExtensions* extension_info,
+                            bool const& time_string = true);
+
+// 只解析位置信息汇报消息体中的位置基本信息(前28字节), 不解析附加信息项.
+// Args:
+//     time_string:  是否生成basic_info->time, 为false时只生成timestamp.
+// Returns:
+//     成功返回0, 失败返回-1.
+int ParseLocationBasicInformation(uint8_t const* in, size_t const& len,
+                                  LocationBasicInformation* basic_info,
+                                  bool const& time_string = true);
+
+// 位置附加信息视图.
+// 只记录位置信息汇报消息体中各附加信息项的偏移, 不复制数据也不分配内存,
+// 读取时才按类型解析. 视图引用的消息体在使用期间必须保持有效.
+// 同一ID出现多次时以最后一项为准.
+//
+// Example:
+//     LocationExtensionView view;
+//     if (view.Init(body.data(), body.size()) == 0) {
+//       uint32_t mileage;
+//       if (view.GetMileage(&mileage)) { ... }
+//     }
+class LocationExtensionView {
+ public:
+  LocationExtensionView() { Reset(); }
+
+  // 由完整的位置信息汇报消息体(含28字节位置基本信息)建立视图.
+  // Returns:
+  //     成功返回0, 附加信息项长度超出范围返回-1.
+  int Init(uint8_t const* body, size_t const& len);
+  int Init(std::vector<uint8_t> const& body) {
+    return Init(body.data(), body.size());
+  }
+  // 清空视图.
+  void Reset(void);
+
+  // 附加信息项数量.
+  size_t size(void) const { return num_; }
+  bool empty(void) const { return num_ == 0; }
+  // 是否包含指定附加信息项.
+  bool Has(uint8_t const& id) const { return offsets_[id] != 0; }
+  // 获取附加信息项的原始数据.
+  // Returns:
+  //     存在返回true.
+  bool Find(uint8_t const& id, uint8_t const** data, size_t* len) const;
+  // 按出现顺序遍历附加信息项.
+  // func: void (uint8_t const& id, uint8_t const* data, size_t const& len).
+  template<typename Func>
+  void ForEach(Func const& func) const {
+    for (size_t pos = 28; pos+2 <= len_; pos += 2+body_[pos+1]) {
+      func(body_[pos], body_+pos+2, static_cast<size_t>(body_[pos+1]));
+    }
+  }
+  // 转换为LocationExtensions, 合并到extensions中.
+  void ToExtensions(LocationExtensions* extensions) const;
+
+  //
+  // 按类型读取, 附加信息项不存在或长度不符时返回false.
+  //
+  bool GetU8(uint8_t const& id, uint8_t* value) const;
+  bool GetU16(uint8_t const& id, uint16_t* value) const;
+  bool GetU32(uint8_t const& id, uint32_t* value) const;
+  // 里程, 1/10km.
+  bool GetMileage(uint32_t* mileage) const {
+    return GetU32(kMileage, mileage);
+  }
+  // 油量, 1/10L.
+  bool GetOilMass(uint16_t* oil_mass) const {
+    return GetU16(kOilMass, oil_mass);
+  }
+  // 行驶记录功能获取的速度, 1/10km/h.
+  bool GetTachographSpeed(uint16_t* speed) const {
+    return GetU16(kTachographSpeed, speed);
+  }
+  // 扩展车辆信号状态位.
+  bool GetVehicleSignalStatus(uint32_t* status) const {
+    return GetU32(kVehicleSignalStatus, status);
+  }
+  // IO状态位.
+  bool GetIoStatus(uint16_t* status) const {
+    return GetU16(kIoStatus, status);
+  }
+  // 模拟量.
+  bool GetAnalogQuantity(uint32_t* analog) const {
+    return GetU32(kAnalogQuantity, analog);
+  }
+  // 无线通信网络信号强度.
+  bool GetNetworkQuality(uint8_t* quality) const {
+    return GetU8(kNetworkQuantity, quality);
+  }
+  // GNSS定位卫星数.
+  bool GetGnssSatellites(uint8_t* satellites) const {
+    return GetU8(kGnssSatellites, satellites);
+  }
+  // 超速报警附加信息, 位置类型为无特定位置时area_route_id为0.
+  bool GetOverSpeedAlarm(uint8_t* location_type,
+                         uint32_t* area_route_id) const;
+  // 进出区域/路线报警附加信息.
+  bool GetAccessAreaAlarm(uint8_t* location_type, uint32_t* area_route_id,
+                          uint8_t* direction) const;
+  // 路段行驶时间不足/过长报警附加信息.
+  // Args:
+  //     route_id:  路段ID.
+  //     driving_time:  路段行驶时间, 单位秒(s).
+  //     result:  结果, 0:不足; 1:过长.
+  bool GetDrivingTimeAlarm(uint32_t* route_id, uint16_t* driving_time,
+                           uint8_t* result) const;
+
+ private:
+  uint8_t const* body_;
+  size_t len_;
+  size_t num_;
+  // 各ID的附加信息项在消息体中的偏移, 0表示不存在.
+  uint16_t offsets_[256];
+};
+
 // 设置超速报警附加信息消息体.
 int SetOverSpeedAlarmBody(uint8_t const& location_type,
                           uint32_t const& area_route_id,
                           std::vector<uint8_t>* out);
 
 // 获得超速报警报警附加信息消息体.
-int GetOverSpeedAlarmBody(std::vector<uint8_t> const& out,
+int GetOverSpeedAlarmBody(LocationExtensionValue const& out,
                           uint8_t* location_type,
                           uint32_t* area_route_id);
 
@@ -313,11 +470,23 @@ int SetAccessAreaAlarmBody(uint8_t const& location_type,
                            std::vector<uint8_t>* out);
 
 // 获得进出区域/路线报警附加信息消息体.
-int GetAccessAreaAlarmBody(std::vector<uint8_t> const& out,
+int GetAccessAreaAlarmBody(LocationExtensionValue const& out,
                            uint8_t* location_type,
                            uint32_t* area_route_id,
                            uint8_t* direction);
 
+// 设置路段行驶时间不足/过长报警附加信息消息体.
+int SetDrivingTimeAlarmBody(uint32_t const& segment_id,
+                            uint16_t const& driving_time,
+                            uint8_t const& result,
+                            std::vector<uint8_t>* out);
+
+// 获得路段行驶时间不足/过长报警附加信息消息体.
+int GetDrivingTimeAlarmBody(LocationExtensionValue const& out,
+                            uint32_t* segment_id,
+                            uint16_t* driving_time,
+                            uint8_t* result);
+
 }  // namespace libjt808
 
 #endif  // JT808_LOCATION_REPORT_H_
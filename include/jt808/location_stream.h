@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_stream.h
+// @Version :  1.0
+// @Time    :  2026/10/18 20:31:08
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOCATION_STREAM_H_
+#define JT808_LOCATION_STREAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/bounded_queue.h"
+#include "jt808/location_report.h"
+
+
+namespace libjt808 {
+
+// 定长的位置记录, 由位置信息汇报(0x0200)或定位数据批量上传(0x0704)解码得到.
+struct LocationRecord {
+  int64_t receive_time_us;  // 服务端接收时间, 系统时间, 单位微秒(us).
+  uint64_t session;  // 会话标识(客户端的socket).
+  int64_t timestamp;  // 定位时间, UTC时间戳, 单位秒, 时间非法时为0.
+  char phone_num[20];  // 终端手机号, 不足部分补0.
+  uint32_t alarm;  // 报警标志.
+  uint32_t status;  // 状态.
+  uint32_t latitude;  // 纬度, 单位百万分之一度.
+  uint32_t longitude;  // 经度, 单位百万分之一度.
+  uint16_t altitude;  // 海拔高度, 单位米(m).
+  uint16_t speed;  // 速度, 单位1/10km/h.
+  uint16_t bearing;  // 方向.
+  uint8_t batch;  // 来自定位数据批量上传时为1.
+  uint8_t reserved;
+};
+
+// 由位置基本信息填充位置记录.
+void FillLocationRecord(LocationBasicInformation const& info,
+                        std::string const& phone_num,
+                        LocationRecord* record);
+
+// 位置记录事件流.
+// IO线程通过Push()把位置记录写入有界无锁队列, 消费线程批量取出后回调,
+// 每批最多max_records条, 首条记录入队后最多等待max_delay_ms毫秒即回调,
+// 便于下游数据库或消息总线批量写入. 队列满时丢弃新记录并计数.
+//
+// Example:
+//     LocationStream stream;
+//     stream.set_batch(512, 50);
+//     stream.Start([] (LocationRecord const* records, size_t const& num) {
+//       BulkInsert(records, num);
+//     });
+//     stream.Push(record);
+//     stream.Stop();
+class LocationStream {
+ public:
+  // 批量回调, 在消费线程中执行, records仅在回调期间有效.
+  using BatchCallback =
+      std::function<void (LocationRecord const* records, size_t const& num)>;
+
+  explicit LocationStream(size_t const& capacity = 65536);
+  ~LocationStream();
+  LocationStream(LocationStream const&) = delete;
+  LocationStream& operator=(LocationStream const&) = delete;
+
+  // 设置每批的最大记录数和最大等待时间, 需在Start()之前调用.
+  void set_batch(size_t const& max_records, int const& max_delay_ms) {
+    max_records_ = (max_records > 0) ? max_records : 1;
+    max_delay_ms_ = (max_delay_ms > 0) ? max_delay_ms : 0;
+  }
+
+  // 启动消费线程.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Start(BatchCallback const& callback);
+  // 回调完队列中剩余的记录后停止消费线程.
+  void Stop(void);
+  bool is_running(void) const { return running_.load(); }
+
+  // 写入一条位置记录, 可在任意线程调用.
+  // Returns:
+  //     成功返回true, 队列已满或未启动返回false.
+  bool Push(LocationRecord const& record);
+
+  // 因队列已满被丢弃的记录数.
+  uint64_t dropped(void) const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // 消费线程处理函数.
+  void ConsumerHandler(void);
+
+  BoundedQueue<LocationRecord> queue_;
+  size_t max_records_;
+  int max_delay_ms_;
+  BatchCallback callback_;
+  std::atomic_bool running_;
+  std::atomic_bool waiting_;  // 消费线程等待新记录.
+  std::atomic<uint64_t> dropped_;
+  std::mutex wait_mutex_;
+  std::condition_variable wait_cond_;
+  std::thread consumer_thread_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_LOCATION_STREAM_H_
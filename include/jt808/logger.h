@@ -0,0 +1,208 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  logger.h
+// @Version :  1.0
+// @Time    :  2026/10/18 19:05:12
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOGGER_H_
+#define JT808_LOGGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "jt808/bounded_queue.h"
+
+
+namespace libjt808 {
+
+// 日志级别.
+enum LogLevel {
+  kLogDebug = 0,
+  kLogInfo,
+  kLogWarning,
+  kLogError,
+  kLogOff,  // 关闭所有日志.
+};
+
+// 日志输出目标, 在后台输出线程中调用.
+// Args:
+//     level:  日志级别.
+//     line:  已添加时间和级别前缀的一行日志, 不含结尾换行符.
+//     len:  日志长度.
+using LogSink = std::function<void (LogLevel const& level,
+                                    char const* line, size_t const& len)>;
+
+// 异步日志.
+// 调用线程只把日志写入有界无锁队列, 添加时间前缀和输出均在后台线程中进行,
+// 调用线程不会因为标准输出的锁或IO阻塞. 队列满时丢弃日志并计数.
+// 后台线程在首次写入日志时启动.
+//
+// Example:
+//     Logger::Instance().set_level(kLogWarning);
+//     Logger::Instance().SetSink([] (LogLevel const& level,
+//                                    char const* line, size_t const& len) {
+//       fwrite(line, 1, len, stderr);
+//       fputc('\n', stderr);
+//     });
+//     JT808_LOG_ERROR("%s[%d]: Send message failed !!!", __FUNCTION__,
+//                     __LINE__);
+class Logger {
+ public:
+  // 单条日志的最大长度, 超出部分被截断.
+  static constexpr size_t kMaxLineLength = 256;
+
+  explicit Logger(size_t const& capacity = 4096);
+  ~Logger();
+  Logger(Logger const&) = delete;
+  Logger& operator=(Logger const&) = delete;
+
+  // 全局日志, 库内部的日志均写到此处.
+  static Logger& Instance(void);
+
+  // 设置输出级别, 低于此级别的日志直接丢弃, 默认kLogInfo.
+  void set_level(LogLevel const& level) {
+    level_.store(level, std::memory_order_relaxed);
+  }
+  LogLevel level(void) const {
+    return static_cast<LogLevel>(level_.load(std::memory_order_relaxed));
+  }
+  bool IsEnabled(LogLevel const& level) const {
+    return level >= level_.load(std::memory_order_relaxed);
+  }
+  // 设置输出目标, 为空时输出到标准输出.
+  void SetSink(LogSink const& sink);
+
+  // 按printf格式写入一条日志.
+  void Log(LogLevel const& level, char const* fmt, ...)
+#if defined(__GNUC__)
+      __attribute__((format(printf, 3, 4)))
+#endif
+      ;
+  // 写入已格式化的文本, 多行文本按行拆分为多条日志.
+  void Write(LogLevel const& level, std::string const& text);
+
+  // 等待队列中的日志全部输出.
+  void Flush(void);
+  // 因队列已满而丢弃的日志数.
+  uint64_t dropped(void) const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Record {
+    LogLevel level;
+    int64_t time_us;  // 系统时间, 单位微秒(us).
+    uint16_t len;
+    char text[kMaxLineLength];
+  };
+
+  void Push(Record* record);
+  // 后台输出线程处理函数.
+  void OutputHandler(void);
+  void Output(Record const& record);
+
+  BoundedQueue<Record> queue_;
+  std::atomic<int> level_;
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> pushed_;  // 已入队的日志数.
+  std::atomic<uint64_t> written_;  // 已输出的日志数.
+  std::mutex sink_mutex_;
+  LogSink sink_;
+  // 后台输出线程.
+  std::once_flag start_flag_;
+  std::thread output_thread_;
+  std::atomic_bool output_is_running_;
+  std::atomic_bool output_is_waiting_;  // 输出线程等待新日志.
+  std::mutex wait_mutex_;
+  std::condition_variable wait_cond_;
+};
+
+// 按printf格式格式化后追加到字符串末尾, 用于拼接多行日志.
+void StringAppendF(std::string* out, char const* fmt, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+// 日志限频, 用于可能在热路径上大量重复出现的错误日志.
+// 每个间隔内只允许输出一次, 其余的计入抑制次数.
+class LogRateLimiter {
+ public:
+  explicit LogRateLimiter(int const& interval_ms);
+
+  // 是否允许输出.
+  // Args:
+  //     suppressed:  允许输出时, 返回上次输出以来被抑制的次数.
+  // Returns:
+  //     允许输出返回true.
+  bool Allow(uint64_t* suppressed);
+
+ private:
+  int64_t const interval_us_;
+  std::atomic<int64_t> next_us_;
+  std::atomic<uint64_t> suppressed_;
+};
+
+}  // namespace libjt808
+
+// 按级别写日志, 级别未开启时不计算参数.
+#define JT808_LOG(level, ...)                                         \
+  do {                                                                \
+    if (::libjt808::Logger::Instance().IsEnabled(level)) {            \
+      ::libjt808::Logger::Instance().Log(level, __VA_ARGS__);         \
+    }                                                                 \
+  } while (0)
+#define JT808_LOG_DEBUG(...) JT808_LOG(::libjt808::kLogDebug, __VA_ARGS__)
+#define JT808_LOG_INFO(...) JT808_LOG(::libjt808::kLogInfo, __VA_ARGS__)
+#define JT808_LOG_WARNING(...) JT808_LOG(::libjt808::kLogWarning, __VA_ARGS__)
+#define JT808_LOG_ERROR(...) JT808_LOG(::libjt808::kLogError, __VA_ARGS__)
+
+// 限频的错误日志, 每个调用位置在interval_ms内最多输出一次.
+#define JT808_LOG_ERROR_EVERY_MS(interval_ms, ...)                     \
+  do {                                                                \
+    static ::libjt808::LogRateLimiter jt808_log_limiter(interval_ms); \
+    uint64_t jt808_log_suppressed = 0;                                \
+    if (::libjt808::Logger::Instance().IsEnabled(                     \
+            ::libjt808::kLogError) &&                                 \
+        jt808_log_limiter.Allow(&jt808_log_suppressed)) {             \
+      ::libjt808::Logger::Instance().Log(::libjt808::kLogError,       \
+                                         __VA_ARGS__);                \
+      if (jt808_log_suppressed > 0) {                                 \
+        ::libjt808::Logger::Instance().Log(::libjt808::kLogError,     \
+            "  (%lu similar messages suppressed)",                    \
+            static_cast<unsigned long>(jt808_log_suppressed));        \
+      }                                                               \
+    }                                                                 \
+  } while (0)
+
+#endif  // JT808_LOGGER_H_
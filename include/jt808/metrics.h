@@ -0,0 +1,163 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  metrics.h
+// @Version :  1.0
+// @Time    :  2026/10/18 18:26:51
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_METRICS_H_
+#define JT808_METRICS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/latency_histogram.h"
+
+
+namespace libjt808 {
+
+// 消息解析失败原因.
+enum MetricsParseFailure {
+  // 校验码错误.
+  kMetricsParseChecksum = 0,
+  // 不支持的消息ID.
+  kMetricsParseUnknownId,
+  // 消息长度不足.
+  kMetricsParseShortFrame,
+  // 消息头或消息体格式错误.
+  kMetricsParseOther,
+  kMetricsParseFailureNum,
+};
+
+// 运行指标快照.
+struct MetricsSnapshot {
+  // 按消息ID统计的接收和发送消息数, 只包含非0项.
+  std::map<uint16_t, uint64_t> frames_in;
+  std::map<uint16_t, uint64_t> frames_out;
+  // 消息ID不在0x0000-0x0FFF和0x8000-0x8FFF范围内的接收和发送消息数.
+  uint64_t frames_in_other;
+  uint64_t frames_out_other;
+  // 按原因统计的解析失败数.
+  uint64_t parse_failures[kMetricsParseFailureNum];
+  // 接收和发送的字节数.
+  uint64_t bytes_in;
+  uint64_t bytes_out;
+  // 因工作线程队列已满被丢弃的应用回调数.
+  uint64_t callbacks_dropped;
+  // 当前已鉴权的连接数.
+  int64_t active_sessions;
+  // 从接受连接到鉴权成功的时间, 单位微秒(us).
+  LatencyHistogram handshake_duration_us;
+  // 从接收数据到消息处理完成(含发送应答)的时间, 单位微秒(us).
+  LatencyHistogram dispatch_latency_us;
+  // 平台下发消息到收到终端通用应答的时间, 单位微秒(us).
+  LatencyHistogram ack_latency_us;
+  // 应用回调在工作线程队列中的等待时间, 单位微秒(us).
+  LatencyHistogram callback_queue_wait_us;
+};
+
+// 运行指标注册表.
+// 每个更新线程首次更新时分配一个独立的分片, 之后只写本线程分片中的计数,
+// 不加锁也不使用原子读-改-写指令, 单次更新仅需几纳秒.
+// 读取时合并所有分片, 线程退出后其分片中的计数仍然保留.
+//
+// Example:
+//     Metrics metrics;
+//     metrics.AddFrameIn(kLocationReport);
+//     metrics.RecordDispatchLatency(35);
+//     MetricsSnapshot snapshot;
+//     metrics.Snapshot(&snapshot);
+//     // 通过本地套接字输出Prometheus文本格式的指标:
+//     //   socat - UNIX-CONNECT:/tmp/jt808_metrics.sock
+//     metrics.StartExporter("/tmp/jt808_metrics.sock");
+class Metrics {
+ public:
+  Metrics();
+  ~Metrics();
+  Metrics(Metrics const&) = delete;
+  Metrics& operator=(Metrics const&) = delete;
+
+  //
+  // 更新接口, 可在任意线程调用.
+  //
+  void AddFrameIn(uint16_t const& msg_id);
+  void AddFrameOut(uint16_t const& msg_id);
+  void AddBytesIn(size_t const& bytes);
+  void AddBytesOut(size_t const& bytes);
+  // 记录一次解析失败.
+  // Args:
+  //     error:  JT808FrameParse()的返回值.
+  void AddParseFailure(int const& error);
+  void SetActiveSessions(int64_t const& num);
+  void RecordHandshakeDuration(uint64_t const& us);
+  void RecordDispatchLatency(uint64_t const& us);
+  void RecordAckLatency(uint64_t const& us);
+  void AddCallbackDropped(void);
+  void RecordCallbackQueueWait(uint64_t const& us);
+
+  //
+  // 读取接口.
+  //
+  // 合并所有分片得到当前指标.
+  void Snapshot(MetricsSnapshot* snapshot) const;
+  // Prometheus文本格式的指标, 延时直方图以summary形式输出.
+  std::string PrometheusText(void) const;
+
+  // 在本地套接字(Unix domain socket)上输出Prometheus文本格式的指标,
+  // 每个连接输出一次当前指标后关闭. 仅支持Linux.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int StartExporter(std::string const& path);
+  void StopExporter(void);
+
+ private:
+  struct Shard;
+
+  // 获取当前线程的分片, 首次调用时分配.
+  Shard* LocalShard(void);
+  Shard* AttachShard(void);
+  void ExporterHandler(int const& listen_fd);
+
+  uint64_t const id_;  // 注册表编号, 用于区分线程局部缓存所属的注册表.
+  mutable std::mutex mutex_;
+  std::map<std::thread::id, std::unique_ptr<Shard>> shards_;
+  std::atomic<int64_t> active_sessions_;
+  // 指标输出.
+  std::atomic_bool exporter_running_;
+  std::thread exporter_thread_;
+  std::string exporter_path_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_METRICS_H_
@@ -67,7 +67,19 @@ bool JT808FrameParserOverride(Parser* parser,
                               uint16_t const& msg_id,
                               ParseHandler const& handler);
 
+// JT808FrameParse()解析失败原因, 其它失败返回-1.
+enum ParseErrorCode {
+  // 消息长度不足.
+  kParseErrorShortFrame = -2,
+  // 校验码错误.
+  kParseErrorChecksum = -3,
+  // 不支持的消息ID.
+  kParseErrorUnknownId = -4,
+};
+
 // 解析命令.
+// Returns:
+//     成功返回0, 失败返回-1或ParseErrorCode.
 int JT808FrameParse(Parser const& parser,
                     std::vector<uint8_t> const& in,
                     ProtocolParameter* para);
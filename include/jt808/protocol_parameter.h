@@ -61,8 +61,15 @@ enum SupportedCommands {
   kGetLocationInformation = 0x8201,  // 位置信息查询.
   kGetLocationInformationResponse = 0x0201,  // 位置信息查询应答.
   kLocationTrackingControl = 0x8202,  // 临时位置跟踪控制.
+  kLocationBatchUpload = 0x0704,  // 定位数据批量上传.
+  kSetCircularArea = 0x8600,  // 设置圆形区域.
+  kDeleteCircularArea = 0x8601,  // 删除圆形区域.
+  kSetRectangleArea = 0x8602,  // 设置矩形区域.
+  kDeleteRectangleArea = 0x8603,  // 删除矩形区域.
   kSetPolygonArea = 0x8604,  // 设置多边形区域.
   kDeletePolygonArea = 0x8605,  // 删除多边形区域.
+  kSetRoute = 0x8606,  // 设置路线.
+  kDeleteRoute = 0x8607,  // 删除路线.
   kMultimediaDataUpload = 0x0801,  // 多媒体数据上传.
   kMultimediaDataUploadResponse = 0x8800,  // 多媒体数据上传应答.
 };
@@ -250,14 +257,35 @@ struct ProtocolParameter {
   LocationBasicInformation location_info;
   // 位置上报时填充位置附加信息, 可选项.
   LocationExtensions location_extension;
+  // 解析位置信息汇报(应答)时不生成parse.location_extension,
+  // 只保存消息体原始数据到parse.location_report_body,
+  // 需要时通过LocationExtensionView按需读取附加信息.
+  bool lazy_location_extension;
+  // 解析位置信息汇报(应答)时只生成parse.location_info.timestamp,
+  // 不生成parse.location_info.time字符串.
+  bool numeric_location_time;
   // 临时位置跟踪控制信息.
   LocationTrackingControl location_tracking_control;
+  // 定位数据批量上传信息.
+  LocationBatch location_batch;
   // 多边形区域集.
   // PolygonAreaSet polygon_area_set;
   // 多边形区域.
   PolygonArea polygon_area;
   // 删除多边形区域ID集.
   std::vector<uint32_t> polygon_area_id;
+  // 设置圆形区域.
+  CircularAreaSetting circular_area_setting;
+  // 删除圆形区域ID集, 为空时删除所有圆形区域.
+  std::vector<uint32_t> circular_area_id;
+  // 设置矩形区域.
+  RectangleAreaSetting rectangle_area_setting;
+  // 删除矩形区域ID集, 为空时删除所有矩形区域.
+  std::vector<uint32_t> rectangle_area_id;
+  // 路线.
+  Route route;
+  // 删除路线ID集, 为空时删除所有路线.
+  std::vector<uint32_t> route_id;
   // 升级信息.
   UpgradeInfo upgrade_info;
   // 补传分包信息.
@@ -287,14 +315,30 @@ struct ProtocolParameter {
     LocationBasicInformation location_info;
     // 解析出的位置附加信息.
     LocationExtensions location_extension;
+    // 位置信息汇报消息体原始数据, 仅lazy_location_extension为true时填充.
+    std::vector<uint8_t> location_report_body;
     // 解析出的临时位置跟踪控制信息.
     LocationTrackingControl location_tracking_control;
+    // 解析出的定位数据批量上传信息.
+    LocationBatch location_batch;
     // 解析出的多边形区域集.
     // PolygonAreaSet polygon_area_set;
     // 解析出的多边形区域.
     PolygonArea polygon_area;
     // 解析出的删除多边形区域ID集.
     std::vector<uint32_t> polygon_area_id;
+    // 解析出的设置圆形区域.
+    CircularAreaSetting circular_area_setting;
+    // 解析出的删除圆形区域ID集.
+    std::vector<uint32_t> circular_area_id;
+    // 解析出的设置矩形区域.
+    RectangleAreaSetting rectangle_area_setting;
+    // 解析出的删除矩形区域ID集.
+    std::vector<uint32_t> rectangle_area_id;
+    // 解析出的路线.
+    Route route;
+    // 解析出的删除路线ID集.
+    std::vector<uint32_t> route_id;
     // 解析出的升级信息.
     UpgradeInfo upgrade_info;
     // 解析出的补传分包信息.
@@ -0,0 +1,150 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  route_index.h
+// @Version :  1.0
+// @Time    :  2026/10/19 02:14:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_ROUTE_INDEX_H_
+#define JT808_ROUTE_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "jt808/area_route.h"
+#include "jt808/box_grid.h"
+#include "jt808/geometry.h"
+
+
+namespace libjt808 {
+
+// 检查点所在的路段.
+struct RouteMatch {
+  // 路线ID.
+  uint32_t route_id;
+  // 路段ID.
+  uint32_t segment_id;
+  // 路段起始拐点在路线拐点项中的序号.
+  uint32_t point_index;
+  // 检查点到路段的近似距离, 单位为米(m).
+  uint32_t distance;
+};
+
+// 路线的路段空间索引, 用于判断车辆是否偏离路线.
+// 拐点到下一拐点为一个路段, 以路段为中心线、路段宽度为总宽度形成通道,
+// 检查点到路段的近似距离不超过路段宽度的一半即在该路段上.
+// 路段按网格边长切分后, 每一小段的外接矩形扩展半个路段宽度放入网格,
+// 查询时只计算检查点所在网格中的路段, 长路线的判断耗时与拐点总数无关.
+// 非线程安全, 多线程访问时由调用方加锁.
+//
+// Example:
+//     RouteIndex index;
+//     index.Insert(route);
+//     RouteMatch match;
+//     if (!index.Match(route.route_id, point, &match)) {
+//       // 偏离路线.
+//     }
+class RouteIndex {
+ public:
+  // Args:
+  //     cell_size:  网格边长, 单位为度, 应大于常见的路段宽度.
+  explicit RouteIndex(double const& cell_size = 0.01);
+
+  // 网格边长, 单位为度.
+  double cell_size(void) const { return grid_.cell_size()*1e-6; }
+  // 路线条数.
+  size_t size(void) const { return routes_.size(); }
+  bool empty(void) const { return routes_.empty(); }
+  // 路段总数.
+  size_t segment_num(void) const {
+    return segments_.size()-free_slots_.size();
+  }
+  // 是否包含指定ID的路线.
+  bool HasRoute(uint32_t const& route_id) const {
+    return routes_.find(route_id) != routes_.end();
+  }
+
+  // 清空后以路线信息集重建索引.
+  void Build(RouteSet const& routes);
+  // 新增路线, 路线ID已存在时替换原有路线.
+  // Returns:
+  //     成功返回0, 拐点数小于2返回-1.
+  int Insert(Route const& route);
+  // 删除指定ID的路线, 路线不存在时不做处理.
+  void Remove(uint32_t const& route_id);
+  // 删除所有路线.
+  void Clear(void);
+
+  // 查询检查点所在的所有路线, 每条路线取距离最近的路段.
+  // Args:
+  //     point:  检查点.
+  //     matches:  检查点所在的路段, 按路线ID升序排列.
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int Query(GeoPoint const& point, std::vector<RouteMatch>* matches) const;
+  // 检查点是否在指定路线上, 不在时即为偏离路线.
+  // Args:
+  //     route_id:  路线ID.
+  //     point:  检查点.
+  //     match:  在路线上时填充距离最近的路段, 可为nullptr.
+  // Returns:
+  //     在路线上返回true, 偏离路线或路线不存在返回false.
+  bool Match(uint32_t const& route_id, GeoPoint const& point,
+             RouteMatch* match) const;
+
+ private:
+  // 已索引的路段.
+  struct Segment {
+    uint32_t route_id;
+    uint32_t segment_id;
+    uint32_t point_index;
+    uint32_t width;  // 路段宽度, 单位为米(m).
+    GeoPoint start;
+    GeoPoint end;
+  };
+
+  // 依次生成路段切分后各小段扩展半个路段宽度的外接矩形.
+  template<typename Visitor>
+  void ForEachSegmentBox(Segment const& segment, Visitor&& visitor) const;
+  // 把路段加入或移出网格.
+  void LinkSegment(uint32_t const& slot);
+  void UnlinkSegment(uint32_t const& slot);
+  // 检查点在路段上时更新距离最近的路段.
+  void MatchSegment(Segment const& segment, GeoPoint const& point,
+                    RouteMatch* match) const;
+
+  BoxGrid grid_;
+  std::vector<Segment> segments_;  // 路段存储槽, 删除后的槽位复用.
+  std::vector<uint32_t> free_slots_;
+  // 路线ID到其路段的存储槽.
+  std::unordered_map<uint32_t, std::vector<uint32_t>> routes_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_ROUTE_INDEX_H_
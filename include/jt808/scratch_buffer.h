@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  scratch_buffer.h
+// @Version :  1.0
+// @Time    :  2026/10/19 09:26:41
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_SCRATCH_BUFFER_H_
+#define JT808_SCRATCH_BUFFER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+
+namespace libjt808 {
+
+// 线程私有的帧处理临时缓冲区.
+// 每个线程持有一组可复用的字节缓冲区, 按栈的方式借出和归还,
+// 归还时只清空内容并保留已申请的容量, 稳定运行后逐帧的逆转义、转义和
+// 封装不再申请内存, 也就不会在多线程间争用malloc.
+// 同一线程内嵌套借用时依次使用下一个缓冲区, 超过kMaxDepth层时临时申请.
+// 归还时容量超过kMaxRetainedCapacity的缓冲区会被释放, 避免偶发的大帧
+// (如升级包)长期占用内存.
+//
+// Example:
+//     ScratchBuffer scratch;
+//     ReverseEscape(in, scratch.get());
+//     Handle(*scratch);
+class ScratchBuffer {
+ public:
+  static constexpr size_t kMaxDepth = 4;
+  static constexpr size_t kMaxRetainedCapacity = 64*1024;
+
+  ScratchBuffer();
+  ~ScratchBuffer();
+  ScratchBuffer(ScratchBuffer const&) = delete;
+  ScratchBuffer& operator=(ScratchBuffer const&) = delete;
+
+  std::vector<uint8_t>* get(void) { return buffer_; }
+  std::vector<uint8_t>& operator*(void) { return *buffer_; }
+  std::vector<uint8_t>* operator->(void) { return buffer_; }
+
+ private:
+  std::vector<uint8_t>* buffer_;
+  std::vector<uint8_t> fallback_;  // 嵌套过深时使用.
+  bool borrowed_;  // buffer_借自线程私有缓冲区.
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_SCRATCH_BUFFER_H_
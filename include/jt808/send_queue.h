@@ -0,0 +1,104 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  send_queue.h
+// @Version :  1.0
+// @Time    :  2026/10/18 09:40:12
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_SEND_QUEUE_H_
+#define JT808_SEND_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <vector>
+
+#include "jt808/bounded_queue.h"
+
+
+namespace libjt808 {
+
+// 发送优先级, 数值越小越优先发送.
+enum SendPriority {
+  kSendPriorityAlarm = 0,  // 报警触发的位置信息汇报.
+  kSendPriorityResponse,  // 应答及其它通用消息.
+  kSendPriorityRoutine,  // 常规位置信息汇报.
+  kSendPriorityNum,
+};
+
+// 多优先级待发送消息队列.
+// 每个优先级对应一个有界无锁队列, 取出时总是先取高优先级的消息.
+// 队列满时丢弃该优先级中最旧的消息, 保证新消息可以入队.
+//
+// Example:
+//     PrioritySendQueue queue;
+//     queue.Push(kSendPriorityAlarm, std::move(msg));
+//     std::vector<uint8_t> out;
+//     while (queue.Pop(&out)) { ... }
+class PrioritySendQueue {
+ public:
+  // Args:
+  //     alarm_capacity:  报警消息队列容量.
+  //     response_capacity:  应答消息队列容量.
+  //     routine_capacity:  常规位置信息汇报队列容量.
+  PrioritySendQueue(size_t const& alarm_capacity = 1024,
+                    size_t const& response_capacity = 128,
+                    size_t const& routine_capacity = 16384);
+  PrioritySendQueue(PrioritySendQueue const&) = delete;
+  PrioritySendQueue& operator=(PrioritySendQueue const&) = delete;
+
+  // 添加一条待发送消息.
+  // Returns:
+  //     未发生丢弃返回true, 丢弃了旧消息返回false.
+  bool Push(SendPriority const& priority, std::vector<uint8_t>&& msg);
+  // 取出优先级最高的一条消息.
+  // Returns:
+  //     队列为空返回false.
+  bool Pop(std::vector<uint8_t>* msg);
+  // 取出指定优先级的一条消息.
+  bool Pop(SendPriority const& priority, std::vector<uint8_t>* msg);
+  // 清空所有消息.
+  void Clear(void);
+  // 所有队列是否为空.
+  bool empty(void) const;
+  // 指定优先级队列中的消息数.
+  size_t size(SendPriority const& priority) const;
+  // 因队列已满被丢弃的消息总数.
+  uint64_t dropped(void) const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  BoundedQueue<std::vector<uint8_t>> alarm_;
+  BoundedQueue<std::vector<uint8_t>> response_;
+  BoundedQueue<std::vector<uint8_t>> routine_;
+  BoundedQueue<std::vector<uint8_t>>* queues_[kSendPriorityNum];
+  std::atomic<uint64_t> dropped_;
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_SEND_QUEUE_H_
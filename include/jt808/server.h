@@ -39,13 +39,30 @@
 #include <windows.h>
 #endif
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <future>
+#include <memory>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 
+#include "callback_executor.h"
+#include "codec_registry.h"
+#include "driving_alarm.h"
+#include "fleet_geofence.h"
+#include "frame_assembler.h"
+#include "frame_capture.h"
+#include "location_archive.h"
+#include "location_stream.h"
+#include "metrics.h"
 #include "packager.h"
 #include "parser.h"
 #include "protocol_parameter.h"
@@ -54,6 +71,28 @@
 
 namespace libjt808 {
 
+// 下发命令失败的结果码, 非负的结果码为终端应答结果(kSuccess等).
+enum CommandStatus {
+  // 重传达到最大次数后仍未收到应答.
+  kCommandTimeout = -1,
+  // 终端未连接或等待应答期间连接断开.
+  kCommandDisconnected = -2,
+  // 消息封装失败.
+  kCommandPackageFailed = -3,
+};
+
+// 下发命令的结果.
+struct CommandResult {
+  // 终端通用应答(0x0001)的应答结果, 收到查询终端参数应答(0x0104)或
+  // 位置信息查询应答(0x0201)时为kSuccess, 失败时为CommandStatus.
+  int result;
+  uint16_t msg_id;  // 下发的消息ID.
+  uint16_t flow_num;  // 下发消息的流水号.
+  int retransmissions;  // 重传次数.
+  // 终端应答消息的解析结果, 未收到应答时为空.
+  std::shared_ptr<ProtocolParameter const> response;
+};
+
 // JT808平台.
 // 已实现了终端注册, 终端鉴权, 心跳包, 位置信息汇报功能.
 // 鉴权成功后对所有命令暂时以平台通用应答作为消息回应.
@@ -70,6 +109,9 @@ namespace libjt808 {
 //       }
 //       server.Stop();
 //     }
+//
+// 运行指标(收发消息数, 解析失败数, 处理延时等)通过metrics()获取,
+// 也可调用metrics().StartExporter()在本地套接字上输出.
 class JT808Server {
  public:
   JT808Server() {}
@@ -82,6 +124,28 @@ class JT808Server {
     ip_ = ip;
     port_ = port;
   }
+  // 设置等待连接队列的最大长度, 需在Run()之前调用.
+  void set_max_connection_num(int const& num) { max_connection_num_ = num; }
+  // 设置是否显示接收到的位置信息汇报和终端参数等内容, 默认不显示.
+  // 内容通过异步日志输出, 大量终端接入时仍应关闭, 避免格式化占用服务线程.
+  void set_message_dump(bool const& dump) { message_dump_ = dump; }
+  // 设置执行应用回调的工作线程数, 默认2, 为0时在服务线程中直接执行.
+  // 需在Run()之前调用.
+  void set_callback_thread_num(int const& num) { callback_thread_num_ = num; }
+  // 设置待执行应用回调数的上限和队列已满时的处理策略, 需在Run()之前调用.
+  void set_callback_queue(size_t const& capacity,
+                          CallbackOverflowPolicy const& policy) {
+    callback_executor_.set_capacity(capacity);
+    callback_executor_.set_overflow_policy(policy);
+  }
+  // 获取当前已鉴权的客户端连接数.
+  size_t client_num(void) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    return clients_.size();
+  }
+  // 获取运行指标.
+  Metrics& metrics(void) { return metrics_; }
+  Metrics const& metrics(void) const { return metrics_; }
   // 初始化服务端.
   int InitServer(void);
 
@@ -99,28 +163,49 @@ class JT808Server {
 
   //
   //  外部获取和设置当前的通用消息体解析和封装函数, 用于重写或新增命令支持.
-  //  必须在调用Init()成员函数后才可以使用.
+  //  可以在Init()之前或之后使用; Init()只补全缺少的默认命令,
+  //  不会覆盖Init()之前已经重写或新增的命令.
+  //  默认与进程内所有实例共享同一份只读的解析器和封装器,
+  //  通过非const接口修改时才复制出本实例的私有副本(写时复制).
   //
   // 获取通用JT808协议封装器.
-  Packager& packager(void) { return packager_; }
-  Packager const& packager(void) const { return packager_; }
+  Packager& packager(void) { return packager_.mutable_get(); }
+  Packager const& packager(void) const { return packager_.get(); }
   void packager(Packager* packager) const {
     if (packager == nullptr) return;
-    *packager = packager_;
+    *packager = packager_.get();
+  }
+  // 获取可与其他实例共享的只读封装器.
+  std::shared_ptr<Packager const> shared_packager(void) const {
+    return packager_.shared();
   }
   // 设置通用JT808协议封装器.
-  void set_packager(Packager const& packager) { packager_ = packager; }
+  void set_packager(Packager const& packager) { packager_.reset(packager); }
+  void set_packager(std::shared_ptr<Packager const> const& packager) {
+    packager_.reset(packager);
+  }
   // 获取通用JT808协议解析器.
-  Parser& parser(void) { return parser_; }
-  Parser const& parser(void) const {  return parser_; }
+  Parser& parser(void) { return parser_.mutable_get(); }
+  Parser const& parser(void) const {  return parser_.get(); }
   void parser(Parser* parser) const {
     if (parser == nullptr) return;
-    *parser = parser_;
+    *parser = parser_.get();
+  }
+  // 获取可与其他实例共享的只读解析器.
+  std::shared_ptr<Parser const> shared_parser(void) const {
+    return parser_.shared();
   }
   // 设置通用JT808协议解析器.
-  void set_parser(Parser const& parser) { parser_ = parser; }
+  void set_parser(Parser const& parser) { parser_.reset(parser); }
+  void set_parser(std::shared_ptr<Parser const> const& parser) {
+    parser_.reset(parser);
+  }
 
   // 升级请求.
+  // 升级包通过SendCommand()逐包下发, 每包收到终端通用应答后发送下一包,
+  // 调用线程阻塞到升级流程结束.
+  // 不能在应用回调或主服务线程中调用, 否则直接返回-1, 回调中请使用
+  // 异步的UpgradeRequestByPhoneNumber().
   // Args:
   //     socket:  客户端的socket.
   //     upgrade_type: 升级类型.
@@ -134,6 +219,7 @@ class JT808Server {
                      char const* path);
   
   // 升级请求.
+  // 调用线程阻塞到升级流程结束, 调用限制同UpgradeRequest().
   // Args:
   //     phone:  客户端的终端手机号.
   //     upgrade_type: 升级类型.
@@ -144,17 +230,10 @@ class JT808Server {
                                   int const& upgrade_type,
                                   std::vector<uint8_t> const& manufacturer_id,
                                   std::string const& version_id,
-                                  char const* path) {
-    for (auto const& item : clients_) {
-      if (item.second.msg_head.phone_num == phone) {
-        return UpgradeRequest(item.first, upgrade_type,
-                              manufacturer_id, version_id, path);
-      }
-    }
-    return -1;
-  }
+                                  char const* path);
   // 
   // 多媒体数据上传.
+  // 回调在工作线程中执行, 同一终端的回调按接收顺序执行.
   //
   using MultimediaDataUploadCallback =
       std::function<void (MultiMediaDataUpload const&)>;
@@ -162,6 +241,150 @@ class JT808Server {
     multimedia_data_upload_callback_ = callback;
   }
 
+  //
+  // 位置信息汇报事件流.
+  // 位置信息汇报(0x0200)和定位数据批量上传(0x0704)解码为定长的位置记录,
+  // 由独立的消费线程批量回调, 每批最多max_records条,
+  // 首条记录接收后最多等待max_delay_ms毫秒. 需在Run()之前调用.
+  //
+  using LocationBatchCallback = LocationStream::BatchCallback;
+  void OnLocationReported(LocationBatchCallback const& callback,
+                          size_t const& max_records = 256,
+                          int const& max_delay_ms = 100);
+  // 因事件流队列已满被丢弃的位置记录数.
+  uint64_t location_records_dropped(void) const {
+    return location_stream_.dropped();
+  }
+
+  //
+  // 平台侧区域判断.
+  // 位置记录在事件流消费线程中与平台定义的多边形区域比较,
+  // 终端进入或离开区域时批量回调进出区域事件, 在位置记录批量回调之前执行.
+  // 区域可在运行期间通过fleet_geofence()随时修改. 需在Run()之前设置回调.
+  //
+  using GeofenceEventCallback =
+      std::function<void (GeofenceEvent const* events, size_t const& num)>;
+  void OnGeofenceEvent(GeofenceEventCallback const& callback) {
+    geofence_event_callback_ = callback;
+  }
+  // 获取平台定义的区域和终端区域状态.
+  FleetGeofence& fleet_geofence(void) { return fleet_geofence_; }
+
+  //
+  // 平台侧驾驶行为报警判断.
+  // 位置记录在事件流消费线程中判断超速、疲劳驾驶、当天累计驾驶超时和超时停车,
+  // 终端报警标志变化时批量回调, 在位置记录批量回调之前执行.
+  // 报警门限可在运行期间通过driving_alarm()随时修改. 需在Run()之前设置回调.
+  //
+  using DrivingAlarmEventCallback =
+      std::function<void (DrivingAlarmEvent const* events, size_t const& num)>;
+  void OnDrivingAlarmEvent(DrivingAlarmEventCallback const& callback) {
+    driving_alarm_event_callback_ = callback;
+  }
+  // 获取驾驶行为报警门限和终端驾驶状态.
+  FleetDrivingAlarm& driving_alarm(void) { return driving_alarm_; }
+
+  //
+  // 位置历史归档.
+  // 位置记录在事件流消费线程中按终端写入列式归档文件, 每个终端满
+  // block_records条记录或缓存超过max_block_age_ms毫秒写出一个数据块,
+  // Stop()时写出所有未满的数据块.
+  // 归档文件由LocationArchiveReader读取. 需在Run()之前调用.
+  //
+  // Returns:
+  //     成功返回0, 失败返回-1.
+  int EnableLocationArchive(std::string const& path,
+                            uint32_t const& block_records = 1024,
+                            int const& max_block_age_ms = 60000) {
+    return location_archive_.Open(path, block_records, max_block_age_ms);
+  }
+  // 写出所有未满的数据块, 可在任意线程调用.
+  int FlushLocationArchive(void) { return location_archive_.Flush(); }
+
+  //
+  // 原始数据抓包与回放.
+  // 抓包开启后, 从终端连接接收到的原始数据连同接收时间和会话标识写入
+  // 抓包文件, IO线程只做内存编码, 由后台线程写文件. 可在运行期间随时开启
+  // 和关闭, Stop()时关闭.
+  //
+  // Returns:
+  //     成功返回0, 已开启或创建文件失败返回-1.
+  int StartFrameCapture(std::string const& path) {
+    return frame_capture_.Open(path);
+  }
+  void StopFrameCapture(void) { frame_capture_.Close(); }
+  // 因磁盘写入跟不上被丢弃的抓包记录数.
+  uint64_t frame_capture_dropped(void) const {
+    return frame_capture_.dropped();
+  }
+  // 回放抓包文件, 不使用socket.
+  // 抓包数据按会话依次经过帧切分、解析和分发, 处理与主服务线程相同,
+  // 应答消息只封装不发送, 位置记录事件流和应用回调照常执行, 返回前执行完毕.
+  // 注册和鉴权消息按普通消息处理, 不校验鉴权码.
+  // 需在Init()之后调用, 不能与Run()同时使用.
+  // Args:
+  //     path:  抓包文件路径.
+  //     speed:  回放速度倍数, 1为按原始时间间隔回放, 不大于0时尽快回放.
+  // Returns:
+  //     成功返回回放的帧数, 文件打开失败或损坏返回-1.
+  int64_t ReplayCapture(std::string const& path, double const& speed = 0);
+
+  //
+  // 异步下发命令.
+  // 命令由主服务线程封装和发送, 调用线程不阻塞, 也不与主服务线程竞争读取
+  // 终端连接. 主服务线程按应答流水号匹配终端通用应答(0x0001)和
+  // 查询终端参数应答(0x0104)、位置信息查询应答(0x0201), 超时未应答时按JT808
+  // 规定原样重传: 第n次重传后的超时时间为T×(n+1), 重传N次后仍未应答即超时.
+  // 超时时间从消息完整写入socket时开始计算, 终端接收缓慢时消息在连接的
+  // 发送缓存中排队, T×(N+1)内仍未写入也视为超时.
+  // 结果在应用回调工作线程中回调, 同一终端的结果按完成顺序回调.
+  // 应用回调工作线程数为0时在主服务线程中回调, 此时回调中不能等待
+  // 其他下发命令的结果.
+  //
+  using CommandCallback = std::function<void (CommandResult const& result)>;
+  // 设置应答超时时间T(毫秒)和最大重传次数N, 默认10秒和3次, 需在Run()之前调用.
+  void set_command_retransmission(int const& timeout_ms, int const& times) {
+    command_timeout_ms_ = (timeout_ms > 0) ? timeout_ms : 1;
+    command_retransmissions_ = (times > 0) ? times : 0;
+  }
+  // 下发命令, 可在任意线程调用.
+  // Args:
+  //     phone:  终端手机号.
+  //     msg_id:  消息ID.
+  //     para:  命令内容, 消息头只使用消息体属性和分包项,
+  //            手机号和流水号由终端连接提供.
+  //     callback:  结果回调, 可为空.
+  // Returns:
+  //     成功提交返回0, 此后回调必定执行一次; 服务未运行返回-1.
+  int SendCommand(std::string const& phone, uint16_t const& msg_id,
+                  ProtocolParameter const& para,
+                  CommandCallback const& callback);
+  // 下发命令, 通过future获取结果, 服务未运行时结果为kCommandDisconnected.
+  std::future<CommandResult> SendCommand(std::string const& phone,
+                                         uint16_t const& msg_id,
+                                         ProtocolParameter const& para);
+  // 异步升级请求, 可在任意线程调用.
+  // 每包的结果回调中发送下一包, 全部成功或某一包失败时回调一次,
+  // 结果为最后一次下发的升级包的结果.
+  // Args:
+  //     phone:  客户端的终端手机号.
+  //     upgrade_type: 升级类型.
+  //     path:  升级文件路径.
+  //     callback:  升级结束回调, 可为空.
+  // Returns:
+  //     成功开始升级返回0, 此后回调必定执行一次;
+  //     升级文件打开失败或服务未运行返回-1.
+  int UpgradeRequestByPhoneNumber(std::string const& phone,
+                                  int const& upgrade_type,
+                                  std::vector<uint8_t> const& manufacturer_id,
+                                  std::string const& version_id,
+                                  char const* path,
+                                  CommandCallback const& callback);
+  // 已提交但未完成的下发命令数.
+  size_t pending_command_num(void) const {
+    return pending_command_num_.load(std::memory_order_relaxed);
+  }
+
   // 通用消息封装和发送函数.
   // Args:
   //     socket:  客户端的socket.
@@ -173,41 +396,209 @@ class JT808Server {
                               uint32_t const& msg_id,
                               ProtocolParameter* para);
 
-  // 通用消息接收和解析函数.
+  // 通用消息接收和解析函数, 每次解析一帧消息.
+  // 接收的数据先经过帧切分, 同一次接收中后续的消息帧保留在assembler中,
+  // 下一次调用时直接解析, 不会丢弃.
   // 阻塞函数.
   // 鉴权通过的客户端禁止调用.
   // Args:
   //     client:  客户端的socket.
   //     timeout:  超时时间, 单位秒(s).
+  //     assembler:  该连接的消息帧切分器.
   //     para: 协议参数.
   // Returns:
   //     成功返回0, 失败返回-1.
   int ReceiveAndParseMessage(decltype(socket(0, 0, 0)) const& socket,
                              int const& timeout,
+                             FrameAssembler* assembler,
                              ProtocolParameter* para);
 
  private:
+  // 提交给主服务线程的下发命令.
+  struct CommandRequest {
+    std::string phone_num;
+    uint16_t msg_id;
+    std::unique_ptr<ProtocolParameter> para;
+    CommandCallback callback;
+  };
+  // 等待应答的下发命令.
+  struct PendingCommand {
+    std::vector<uint8_t> frame;  // 已封装的消息, 重传时原样发送.
+    uint16_t msg_id;
+    int retransmissions;
+    // 消息已完整发送时为本次等待应答的截止时间,
+    // 未发送完时为等待发送的截止时间.
+    std::chrono::steady_clock::time_point deadline;
+    bool sent;  // 本次发送的消息是否已完整写入socket.
+    CommandCallback callback;
+  };
+  // 待写入socket的消息帧.
+  struct OutboundFrame {
+    std::vector<uint8_t> data;
+    uint16_t msg_id;
+    uint16_t flow_num;
+    bool command;  // 是否是等待应答的下发命令.
+  };
+  // 等待终端通用应答的下发消息, 用于统计应答延时.
+  struct PendingAck {
+    bool valid;
+    uint16_t flow_num;
+    std::chrono::steady_clock::time_point send_tp;  // 完整写入的时间.
+  };
+  // 终端连接的发送状态, 只在主服务线程中访问.
+  // 待发送数据按顺序整帧写入, 不会被其他消息帧打断.
+  struct Outbound {
+    Outbound() : offset(0), bytes(0) {
+      for (auto& ack : acks) ack.valid = false;
+    }
+    std::deque<OutboundFrame> frames;
+    size_t offset;  // 首个消息帧已写入的字节数.
+    size_t bytes;  // 待写入的总字节数.
+    // 按消息流水号取模存放的等待应答记录.
+    std::array<PendingAck, 64> acks;
+  };
+  // 进行中的异步升级.
+  struct UpgradeState {
+    std::string phone_num;
+    ProtocolParameter para;  // 升级包公共的参数.
+    std::vector<uint8_t> data;  // 升级文件内容.
+    size_t max_content;  // 每包的最大升级数据长度.
+    uint16_t total_packet;
+    uint16_t packet_seq;  // 下一包的序号, 从1开始.
+    CommandCallback callback;
+  };
+  // 已结束等待回调的下发命令.
+  struct FinishedCommand {
+    uint64_t session;
+    CallbackExecutor::Task task;
+  };
+
   // 等待客户端连接线程处理函数.
   void WaitHandler(void);
   // 主服务线程处理函数.
   void ServiceHandler(void);
+  // 启动和停止应用回调工作线程、位置记录事件流消费线程.
+  void StartWorkers(void);
+  void StopWorkers(void);
+  // 解析并处理一帧消息, 主服务线程和回放共用.
+  // Returns:
+  //     成功或解析失败返回0, 发送应答失败(连接已断开)返回-1.
+  int DispatchFrame(decltype(socket(0, 0, 0)) const& socket,
+                    std::vector<uint8_t> const& frame,
+                    std::chrono::steady_clock::time_point const& recv_tp,
+                    ProtocolParameter* para);
+  // 关闭并移除客户端连接, 等待应答的下发命令以kCommandDisconnected结束.
+  // 调用方已持有clients_mutex_.
+  void RemoveClient(decltype(socket(0, 0, 0)) const& socket);
+  // 在主服务线程中发送已提交的下发命令, 并检查应答超时和重传.
+  // 调用方已持有clients_mutex_.
+  void ProcessCommands(void);
+  // 收到终端应答时, 结束对应的下发命令.
+  void MatchCommand(decltype(socket(0, 0, 0)) const& socket,
+                    ProtocolParameter const& para);
+  // 主服务线程退出时, 以kCommandDisconnected结束所有未完成的下发命令.
+  void AbortCommands(void);
+  // 结束下发命令, 结果暂存到finished_commands_, 由DeliverCommandResults()回调.
+  // 调用方已持有clients_mutex_.
+  void FinishCommand(decltype(socket(0, 0, 0)) const& socket,
+                     uint16_t const& flow_num, PendingCommand* command,
+                     int const& result,
+                     std::shared_ptr<ProtocolParameter const> const& response);
+  // 下发下一个升级包, 失败或全部完成时结束升级.
+  // Returns:
+  //     成功提交返回0, 服务未运行返回-1, 此时不回调.
+  int SendUpgradePacket(std::shared_ptr<UpgradeState> const& state);
+  // 在应用回调工作线程中回调已结束的下发命令.
+  // 调用方不能持有clients_mutex_, 回调可再次下发命令.
+  void DeliverCommandResults(std::vector<FinishedCommand>* commands);
+  // 把消息帧加入连接的待发送数据并尽量写入socket, 只在主服务线程中调用.
+  // 消息帧完整写入后才统计发送指标和开始等待应答.
+  // Returns:
+  //     成功返回0, 发送失败或待发送数据超过上限返回-1.
+  int QueueFrame(decltype(socket(0, 0, 0)) const& socket,
+                 std::vector<uint8_t> const& frame,
+                 uint16_t const& msg_id, uint16_t const& flow_num,
+                 bool const& command);
+  // 在socket可写时继续写入连接的待发送数据.
+  // Returns:
+  //     写入完成或socket暂不可写返回0, 发送失败返回-1.
+  int FlushOutbound(decltype(socket(0, 0, 0)) const& socket);
+  // 消息帧完整写入后的处理.
+  void OnFrameSent(decltype(socket(0, 0, 0)) const& socket,
+                   OutboundFrame const& frame, Outbound* outbound);
+  // 记录等待终端通用应答的下发消息, 用于统计应答延时.
+  // 记录保存在连接的发送状态中, 只在主服务线程中访问, 无需加锁.
+  void AddPendingAck(uint16_t const& msg_id, uint16_t const& flow_num,
+                     Outbound* outbound);
+  // 收到终端通用应答时, 匹配对应的下发消息并记录应答延时.
+  void MatchPendingAck(decltype(socket(0, 0, 0)) const& socket,
+                       ProtocolParameter const& para);
+  // 把位置信息解码为位置记录写入事件流.
+  void PushLocationRecords(decltype(socket(0, 0, 0)) const& socket,
+                           ProtocolParameter const& para);
+  // 把接收完成的多媒体数据交给回调工作线程.
+  void DispatchMultimediaData(decltype(socket(0, 0, 0)) const& socket,
+                              MultiMediaDataUpload* media);
 
   decltype(socket(0, 0, 0)) listen_;  // 监听的socket.
   std::atomic_bool is_ready_;  // 服务端socket状态.
   std::string ip_;  // 服务端IP地址.
   int port_;  // 服务端端口.
   int max_connection_num_;
+  bool message_dump_;  // 显示接收到的位置信息汇报.
   MultimediaDataUploadCallback multimedia_data_upload_callback_;
+  int callback_thread_num_;  // 应用回调工作线程数.
+  CallbackExecutor callback_executor_;  // 应用回调执行器.
+  LocationBatchCallback location_batch_callback_;  // 位置记录批量回调.
+  LocationStream location_stream_;  // 位置记录事件流.
+  GeofenceEventCallback geofence_event_callback_;  // 进出区域事件回调.
+  FleetGeofence fleet_geofence_;  // 平台定义的区域和终端区域状态.
+  DrivingAlarmEventCallback driving_alarm_event_callback_;  // 驾驶行为报警回调.
+  FleetDrivingAlarm driving_alarm_;  // 驾驶行为报警门限和终端驾驶状态.
+  LocationArchiveWriter location_archive_;  // 位置历史归档.
+  FrameCaptureWriter frame_capture_;  // 原始数据抓包.
+  bool replaying_;  // 正在回放抓包文件, 应答只封装不发送.
+  // 分包多媒体数据的接收缓存, 只在主服务线程或回放中使用.
+  std::unique_ptr<char[]> media_buffer_;
+  int media_total_size_;
+  int media_packet_max_size_;
   std::thread waiting_thread_;  // 等待客户端连接线程.
   std::atomic_bool waiting_is_running_;  // 等待客户端连接线程运行标志.
   std::thread service_thread_;  // 主服务线程.
   std::atomic_bool service_is_running_;  // 主服务线程运行标志.
-  Packager packager_;  // 通用JT808协议封装器.
-  Parser parser_;  // 通用JT808协议解析器.
+  SharedPackager packager_;  // 通用JT808协议封装器.
+  SharedParser parser_;  // 通用JT808协议解析器.
+  // 保护clients_和phone_clients_, 等待连接线程与主服务线程共用.
+  std::mutex clients_mutex_;
   // 客户端的socket(key)-客户端的协议参数(value).
   std::map<decltype(socket(0, 0, 0)), ProtocolParameter> clients_;
-  // 处于升级状态的客户端连接.
-  std::map<decltype(socket(0, 0, 0)), int> is_upgrading_clients_;
+  // 终端手机号(key)-最近一次鉴权的客户端socket(value).
+  std::unordered_map<std::string, decltype(socket(0, 0, 0))> phone_clients_;
+  // 客户端的socket(key)-消息帧切分器(value), 由clients_mutex_保护.
+  // 鉴权时使用的切分器随连接一起交给主服务线程.
+  std::map<decltype(socket(0, 0, 0)), FrameAssembler> assemblers_;
+  // 鉴权完成时切分器中仍有数据的连接, 由主服务线程处理, 由clients_mutex_保护.
+  std::vector<decltype(socket(0, 0, 0))> handshake_leftover_clients_;
+  // 客户端的socket(key)-待发送数据(value), 由clients_mutex_保护.
+  std::map<decltype(socket(0, 0, 0)), Outbound> outbounds_;
+  Metrics metrics_;  // 运行指标.
+  int command_timeout_ms_;  // 应答超时时间T, 单位毫秒(ms).
+  int command_retransmissions_;  // 最大重传次数N.
+  std::atomic<size_t> pending_command_num_;
+  std::mutex command_mutex_;
+  // 主服务线程是否接收新的下发命令, 由command_mutex_保护.
+  bool command_accepting_;
+  // 待主服务线程发送的下发命令, 由command_mutex_保护.
+  std::vector<CommandRequest> command_queue_;
+  // 以下只在主服务线程中使用.
+  std::vector<CommandRequest> command_batch_;  // 复用的命令取出缓存.
+  // 等待应答的下发命令, 客户端的socket和消息流水号(key)-命令(value).
+  std::map<std::pair<decltype(socket(0, 0, 0)), uint16_t>, PendingCommand>
+      pending_commands_;
+  // 下一次检查应答超时的时间.
+  std::chrono::steady_clock::time_point next_command_check_;
+  // 已结束等待回调的下发命令, 由clients_mutex_保护.
+  std::vector<FinishedCommand> finished_commands_;
 };
 
 }  // namespace libjt808
@@ -0,0 +1,246 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  small_vector.h
+// @Version :  1.0
+// @Time    :  2026/10/18 21:40:16
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_SMALL_VECTOR_H_
+#define JT808_SMALL_VECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+
+namespace libjt808 {
+
+// 带内联缓冲区的小容量数组, 仅用于可按字节拷贝的类型.
+// 元素个数不超过N时存放在对象内部, 超过时才申请堆内存.
+// 接口与std::vector保持一致, 并可与std::vector相互隐式转换,
+// 终端参数项和位置附加信息的值绝大多数只有1~8字节, 无需额外的堆分配.
+//
+// Example:
+//     SmallVector<uint8_t, 16> value{0x01, 0x02};
+//     value.push_back(0x03);
+//     std::vector<uint8_t> out = value;
+template<typename T, size_t N>
+class SmallVector {
+  static_assert(std::is_trivial<T>::value,
+                "SmallVector only supports trivial types");
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = T&;
+  using const_reference = T const&;
+  using pointer = T*;
+  using const_pointer = T const*;
+  using iterator = T*;
+  using const_iterator = T const*;
+
+  SmallVector() : data_(inline_), size_(0), capacity_(N) {}
+  explicit SmallVector(size_t const& num, T const& value = T())
+      : SmallVector() {
+    assign(num, value);
+  }
+  template<typename InputIt, typename = typename std::enable_if<
+               !std::is_integral<InputIt>::value>::type>
+  SmallVector(InputIt first, InputIt last) : SmallVector() {
+    assign(first, last);
+  }
+  SmallVector(std::initializer_list<T> values) : SmallVector() {
+    assign(values.begin(), values.end());
+  }
+  SmallVector(std::vector<T> const& values) : SmallVector() {  // NOLINT
+    assign(values.data(), values.data()+values.size());
+  }
+  SmallVector(SmallVector const& other) : SmallVector() {
+    assign(other.begin(), other.end());
+  }
+  SmallVector(SmallVector&& other) : SmallVector() {
+    MoveFrom(&other);
+  }
+  ~SmallVector() {
+    if (data_ != inline_) free(data_);
+  }
+
+  SmallVector& operator=(SmallVector const& other) {
+    if (this != &other) assign(other.begin(), other.end());
+    return *this;
+  }
+  SmallVector& operator=(SmallVector&& other) {
+    if (this != &other) {
+      if (data_ != inline_) free(data_);
+      data_ = inline_;
+      size_ = 0;
+      capacity_ = N;
+      MoveFrom(&other);
+    }
+    return *this;
+  }
+  SmallVector& operator=(std::vector<T> const& values) {
+    assign(values.data(), values.data()+values.size());
+    return *this;
+  }
+  SmallVector& operator=(std::initializer_list<T> values) {
+    assign(values.begin(), values.end());
+    return *this;
+  }
+
+  operator std::vector<T>() const {  // NOLINT
+    return std::vector<T>(begin(), end());
+  }
+
+  size_t size(void) const { return size_; }
+  size_t capacity(void) const { return capacity_; }
+  bool empty(void) const { return size_ == 0; }
+
+  T* data(void) { return data_; }
+  T const* data(void) const { return data_; }
+  iterator begin(void) { return data_; }
+  iterator end(void) { return data_+size_; }
+  const_iterator begin(void) const { return data_; }
+  const_iterator end(void) const { return data_+size_; }
+  const_iterator cbegin(void) const { return data_; }
+  const_iterator cend(void) const { return data_+size_; }
+
+  T& operator[](size_t const& pos) { return data_[pos]; }
+  T const& operator[](size_t const& pos) const { return data_[pos]; }
+  T& front(void) { return data_[0]; }
+  T const& front(void) const { return data_[0]; }
+  T& back(void) { return data_[size_-1]; }
+  T const& back(void) const { return data_[size_-1]; }
+
+  void clear(void) { size_ = 0; }
+
+  void reserve(size_t const& capacity) {
+    if (capacity <= capacity_) return;
+    size_t new_capacity = capacity_*2;
+    if (new_capacity < capacity) new_capacity = capacity;
+    T* new_data = static_cast<T*>(malloc(new_capacity*sizeof(T)));
+    memcpy(new_data, data_, size_*sizeof(T));
+    if (data_ != inline_) free(data_);
+    data_ = new_data;
+    capacity_ = static_cast<uint32_t>(new_capacity);
+  }
+
+  void resize(size_t const& num, T const& value = T()) {
+    reserve(num);
+    for (size_t i = size_; i < num; ++i) data_[i] = value;
+    size_ = static_cast<uint32_t>(num);
+  }
+
+  void push_back(T const& value) {
+    if (size_ == capacity_) reserve(size_+1);
+    data_[size_++] = value;
+  }
+
+  void pop_back(void) { --size_; }
+
+  void assign(size_t const& num, T const& value) {
+    size_ = 0;
+    resize(num, value);
+  }
+
+  // 随机访问迭代器先一次性预留空间, 其他迭代器逐个追加.
+  template<typename InputIt, typename = typename std::enable_if<
+               !std::is_integral<InputIt>::value>::type>
+  void assign(InputIt first, InputIt last) {
+    size_ = 0;
+    Append(first, last,
+           typename std::iterator_traits<InputIt>::iterator_category());
+  }
+
+  template<typename InputIt, typename = typename std::enable_if<
+               !std::is_integral<InputIt>::value>::type>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_t const offset = pos-data_;
+    size_t const old_size = size_;
+    Append(first, last,
+           typename std::iterator_traits<InputIt>::iterator_category());
+    // 先追加到末尾再旋转到插入位置.
+    if (offset < old_size) {
+      std::vector<T> tail(data_+offset, data_+old_size);
+      memmove(data_+offset, data_+old_size, (size_-old_size)*sizeof(T));
+      memcpy(data_+offset+(size_-old_size), tail.data(),
+             tail.size()*sizeof(T));
+    }
+    return data_+offset;
+  }
+
+  friend bool operator==(SmallVector const& lhs, SmallVector const& rhs) {
+    return lhs.size_ == rhs.size_ &&
+           memcmp(lhs.data_, rhs.data_, lhs.size_*sizeof(T)) == 0;
+  }
+  friend bool operator!=(SmallVector const& lhs, SmallVector const& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  template<typename InputIt>
+  void Append(InputIt first, InputIt last, std::random_access_iterator_tag) {
+    size_t const num = static_cast<size_t>(last-first);
+    reserve(size_+num);
+    for (size_t i = 0; i < num; ++i) data_[size_+i] = first[i];
+    size_ += static_cast<uint32_t>(num);
+  }
+
+  template<typename InputIt>
+  void Append(InputIt first, InputIt last, std::input_iterator_tag) {
+    for (; first != last; ++first) push_back(*first);
+  }
+
+  // 对方使用堆内存时直接接管, 否则拷贝内联数据.
+  void MoveFrom(SmallVector* other) {
+    if (other->data_ != other->inline_) {
+      data_ = other->data_;
+      capacity_ = other->capacity_;
+      size_ = other->size_;
+      other->data_ = other->inline_;
+      other->capacity_ = N;
+    } else {
+      memcpy(inline_, other->inline_, other->size_*sizeof(T));
+      size_ = other->size_;
+    }
+    other->size_ = 0;
+  }
+
+  T* data_;
+  uint32_t size_;
+  uint32_t capacity_;
+  T inline_[N];
+};
+
+}  // namespace libjt808
+
+#endif  // JT808_SMALL_VECTOR_H_
@@ -31,6 +31,7 @@
 #define JT808_SOCKET_UTIL_H_
 
 #if defined(__linux__)
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -155,6 +156,38 @@ inline int Close(SOCKET s) {
 }
 #endif
 
+// 等待socket可写.
+// Returns:
+//     可写返回1, 超时返回0, 出错返回-1.
+template<typename T>
+inline int WaitWritable(T s, int timeout_msec) {
+  return -1;
+}
+#if defined(__linux__)
+template<>
+inline int WaitWritable(int fd, int timeout_msec) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLOUT;
+  pfd.revents = 0;
+  int ret = poll(&pfd, 1, timeout_msec);
+  if (ret <= 0) return ret;
+  if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) return -1;
+  return 1;
+}
+#elif defined(_WIN32)
+template<>
+inline int WaitWritable(SOCKET s, int timeout_msec) {
+  fd_set wfds;
+  FD_ZERO(&wfds);
+  FD_SET(s, &wfds);
+  struct timeval tv = {timeout_msec/1000, (timeout_msec%1000)*1000};
+  int ret = select(0, nullptr, &wfds, nullptr, &tv);
+  if (ret == SOCKET_ERROR) return -1;
+  return ret > 0 ? 1 : 0;
+}
+#endif
+
 }  // namespace libjt808
 
 #endif  // JT808_SOCKET_UTIL_H_
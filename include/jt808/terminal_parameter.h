@@ -36,6 +36,8 @@
 #include <string>
 #include <vector>
 
+#include "jt808/flat_map.h"
+#include "jt808/small_vector.h"
 #include "jt808/util.h"
 
 
@@ -98,6 +100,20 @@ enum TerminalParameterID {
    kAlarmKeyFlag= 0x0054,
   // DWORD, 最高速度, km/h.
   kMaxSpeed = 0x0055,
+  // DWORD, 超速持续时间(s).
+  kOverspeedDuration = 0x0056,
+  // DWORD, 连续驾驶时间门限(s).
+  kContinuousDrivingTimeThreshold = 0x0057,
+  // DWORD, 当天累计驾驶时间门限(s).
+  kCumulativeDrivingTimeThreshold = 0x0058,
+  // DWORD, 最小休息时间(s).
+  kMinimumRestTime = 0x0059,
+  // DWORD, 最长停车时间(s).
+  kMaximumParkingTime = 0x005A,
+  // WORD,  超速报警预警差值, 单位为1/10km/h.
+  kOverspeedWarningDifference = 0x005B,
+  // WORD,  疲劳驾驶预警差值(s), >0.
+  kFatigueDrivingWarningDifference = 0x005C,
   // BYTE,  GNSS定位模式, 定义如下:
   //        bit0, 0: 禁用GPS定位, 1: 启用GPS定位;
   //        bit1, 0: 禁用北斗定位, 1: 启用北斗定位;
@@ -156,8 +172,11 @@ enum GNSSModelBaudeRate {
   kBDRT115200,
 };
 
+// 终端参数项的值, 不超过16字节时无需堆分配.
+using TerminalParameterValue = SmallVector<uint8_t, 16>;
 // 终端参数存储定义: key: itemid, value: itemvalue.
-using TerminalParameters = std::map<uint32_t, std::vector<uint8_t>>;
+// 按参数ID升序连续存放.
+using TerminalParameters = FlatMap<uint32_t, TerminalParameterValue>;
 
 //
 //  终端参数转换.
@@ -0,0 +1,199 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  area_tracker.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 03:02:37
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/area_tracker.h"
+
+#include <algorithm>
+
+
+namespace libjt808 {
+
+namespace {
+
+int64_t BoxArea(GeoBox const& box) {
+  return (static_cast<int64_t>(box.max_longitude)-box.min_longitude+1) *
+         (static_cast<int64_t>(box.max_latitude)-box.min_latitude+1);
+}
+
+// 缩小范围使其与外接矩形不相交且仍包含检查点, 选择剩余面积最大的切分方式.
+// 检查点不在外接矩形内, 至少有一种切分方式.
+void ExcludeBox(GeoPoint const& point, GeoBox const& box, GeoBox* region) {
+  if (box.max_longitude < region->min_longitude ||
+      box.min_longitude > region->max_longitude ||
+      box.max_latitude < region->min_latitude ||
+      box.min_latitude > region->max_latitude) {
+    return;
+  }
+  GeoBox best = *region;
+  int64_t best_area = -1;
+  auto const consider = [&best, &best_area] (GeoBox const& candidate) {
+    int64_t const area = BoxArea(candidate);
+    if (area > best_area) {
+      best = candidate;
+      best_area = area;
+    }
+  };
+  GeoBox candidate = *region;
+  if (point.longitude < box.min_longitude) {
+    candidate.max_longitude = box.min_longitude-1;
+    consider(candidate);
+    candidate = *region;
+  }
+  if (point.longitude > box.max_longitude) {
+    candidate.min_longitude = box.max_longitude+1;
+    consider(candidate);
+    candidate = *region;
+  }
+  if (point.latitude < box.min_latitude) {
+    candidate.max_latitude = box.min_latitude-1;
+    consider(candidate);
+    candidate = *region;
+  }
+  if (point.latitude > box.max_latitude) {
+    candidate.min_latitude = box.max_latitude+1;
+    consider(candidate);
+  }
+  *region = best;
+}
+
+}  // namespace
+
+AreaTracker::AreaTracker()
+    : valid_(false), version_(0), region_(), refresh_num_(0) {
+}
+
+void AreaTracker::Reset(void) {
+  valid_ = false;
+  candidates_.clear();
+  inside_.clear();
+}
+
+void AreaTracker::GetAreas(std::vector<AreaRef>* areas) const {
+  if (areas == nullptr) return;
+  areas->clear();
+  for (auto const& state : inside_) areas->push_back(state.area);
+}
+
+bool AreaTracker::overspeed(void) const {
+  for (auto const& state : inside_) {
+    if (state.overspeed) return true;
+  }
+  return false;
+}
+
+void AreaTracker::Refresh(GeofenceIndex const& index, GeoPoint const& point) {
+  ++refresh_num_;
+  valid_ = true;
+  version_ = index.version();
+  region_ = index.grid_.CellBox(point);
+  candidates_.clear();
+  index.grid_.ForEach(point, [this, &index, &point] (uint32_t const& slot) {
+    auto const& box = index.entries_[slot].box;
+    if (IsPointInsideBox(point, box)) {
+      candidates_.push_back(Candidate {slot, box});
+    } else {
+      ExcludeBox(point, box, &region_);
+    }
+  });
+}
+
+int AreaTracker::Update(GeofenceIndex const& index, GeoPoint const& point,
+                        int64_t const& timestamp, uint16_t const& speed,
+                        std::vector<AreaEvent>* events) {
+  if (events == nullptr) return -1;
+  if (!valid_ || version_ != index.version() ||
+      !IsPointInsideBox(point, region_)) {
+    Refresh(index, point);
+  }
+  current_.clear();
+  for (auto const& candidate : candidates_) {
+    if (!IsPointInsideBox(point, candidate.box)) continue;
+    auto const& entry = index.entries_[candidate.slot];
+    if (!IsAreaActive(entry.rule, timestamp) ||
+        !GeofenceIndex::EntryContains(entry, point)) {
+      continue;
+    }
+    current_.push_back(InsideArea {AreaRef {entry.type, entry.area_id},
+                                   candidate.slot, -1, false});
+  }
+  if (current_.size() > 1) {
+    std::sort(current_.begin(), current_.end(),
+              [] (InsideArea const& lhs, InsideArea const& rhs) {
+                return lhs.area < rhs.area;
+              });
+  }
+  // 之前在区域内而现在不在, 区域已被删除的不产生事件.
+  auto it = current_.begin();
+  for (auto const& state : inside_) {
+    while (it != current_.end() && it->area < state.area) ++it;
+    if (it != current_.end() && it->area == state.area) continue;
+    if (!index.HasArea(state.area.type, state.area.area_id)) continue;
+    if (state.overspeed) {
+      events->push_back(AreaEvent {state.area, kAreaEventOverspeedEnd});
+    }
+    events->push_back(AreaEvent {state.area, kAreaEventExit});
+  }
+  // 沿用仍在区域内的超速状态.
+  auto old = inside_.begin();
+  for (auto& state : current_) {
+    while (old != inside_.end() && old->area < state.area) ++old;
+    if (old != inside_.end() && old->area == state.area) {
+      state.overspeed_since = old->overspeed_since;
+      state.overspeed = old->overspeed;
+    } else {
+      events->push_back(AreaEvent {state.area, kAreaEventEnter});
+    }
+    CheckSpeed(index.entries_[state.slot].rule, timestamp, speed, &state,
+               events);
+  }
+  inside_.swap(current_);
+  return 0;
+}
+
+void AreaTracker::CheckSpeed(AreaRule const& rule, int64_t const& timestamp,
+                             uint16_t const& speed, InsideArea* state,
+                             std::vector<AreaEvent>* events) {
+  if (!rule.attribute.bit.speed_limit) return;
+  if (speed > static_cast<uint32_t>(rule.max_speed)*10) {
+    if (state->overspeed_since < 0) state->overspeed_since = timestamp;
+    if (!state->overspeed &&
+        timestamp-state->overspeed_since >= rule.overspeed_time) {
+      state->overspeed = true;
+      events->push_back(AreaEvent {state->area, kAreaEventOverspeed});
+    }
+    return;
+  }
+  state->overspeed_since = -1;
+  if (state->overspeed) {
+    state->overspeed = false;
+    events->push_back(AreaEvent {state->area, kAreaEventOverspeedEnd});
+  }
+}
+
+}  // namespace libjt808
@@ -32,6 +32,41 @@
 
 namespace libjt808 {
 
+namespace {
+
+// BCD字节到数值的查找表, 含非法半字节(>9)的字节为0xFF.
+struct BcdDecodeTable {
+  BcdDecodeTable() {
+    for (int i = 0; i < 256; ++i) {
+      value[i] = ((i >> 4) > 9 || (i & 0x0F) > 9) ?
+                 0xFF : static_cast<uint8_t>((i >> 4)*10 + (i & 0x0F));
+    }
+  }
+  uint8_t value[256];
+};
+
+BcdDecodeTable const kBcdDecodeTable;
+
+// 平年各月1日之前的累计天数, 下标为月份.
+constexpr int kDaysBeforeMonth[14] = {
+  0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365
+};
+// 1970-01-01到2000-01-01的天数.
+constexpr int64_t kDaysFrom1970To2000 = 10957;
+// 2000~2099年的4年周期天数, 周期首年为闰年.
+constexpr int64_t kDaysPer4Years = 1461;
+constexpr int64_t kSecondsPerDay = 86400;
+// GMT+8时区偏移.
+constexpr int64_t kTimeZoneOffset = 8*3600;
+
+// 2000~2099年中被4整除的都是闰年.
+inline int DaysInMonth(int const& year, int const& month) {
+  return kDaysBeforeMonth[month+1] - kDaysBeforeMonth[month] +
+         ((month == 2 && year%4 == 0) ? 1 : 0);
+}
+
+}  // namespace
+
 uint8_t HexToBcd(uint8_t const& src) {
   uint8_t temp;
   temp = ((src / 10) << 4) + (src % 10);
@@ -136,4 +171,81 @@ int BcdToStringFillZero(std::vector<uint8_t> const& in, std::string* out) {
   return 0;
 }
 
+// 查表解码各BCD字节后直接按累计天数换算, 不经过字符串和mktime.
+int BcdTimeToTimestamp(uint8_t const* bcd, int64_t* timestamp) {
+  if (bcd == nullptr || timestamp == nullptr) return -1;
+  uint8_t val[6];
+  for (int i = 0; i < 6; ++i) {
+    val[i] = kBcdDecodeTable.value[bcd[i]];
+    if (val[i] == 0xFF) return -1;
+  }
+  int const year = val[0];
+  int const month = val[1];
+  int const day = val[2];
+  if (month < 1 || month > 12 || day < 1 ||
+      day > DaysInMonth(year, month) ||
+      val[3] > 23 || val[4] > 59 || val[5] > 59) {
+    return -1;
+  }
+  int64_t const days = kDaysFrom1970To2000 + year*365 + (year+3)/4 +
+                       kDaysBeforeMonth[month] +
+                       ((month > 2 && year%4 == 0) ? 1 : 0) + day-1;
+  *timestamp = days*kSecondsPerDay + val[3]*3600 + val[4]*60 + val[5] -
+               kTimeZoneOffset;
+  return 0;
+}
+
+int TimestampToBcdTime(int64_t const& timestamp, uint8_t* bcd) {
+  if (bcd == nullptr) return -1;
+  int64_t const local = timestamp + kTimeZoneOffset;
+  int64_t days = local/kSecondsPerDay - kDaysFrom1970To2000;
+  if (local < 0 || days < 0 || days >= 25*kDaysPer4Years) return -1;
+  int const secs = static_cast<int>(local%kSecondsPerDay);
+  int year = static_cast<int>(days/kDaysPer4Years)*4;
+  days %= kDaysPer4Years;
+  if (days >= 366) {
+    days -= 366;
+    year += 1 + static_cast<int>(days/365);
+    days %= 365;
+  }
+  int month = 1;
+  while (month < 12 && days >= kDaysBeforeMonth[month+1] +
+                                ((month >= 2 && year%4 == 0) ? 1 : 0)) {
+    ++month;
+  }
+  int const day = static_cast<int>(days) - kDaysBeforeMonth[month] -
+                  ((month > 2 && year%4 == 0) ? 1 : 0) + 1;
+  bcd[0] = HexToBcd(year);
+  bcd[1] = HexToBcd(month);
+  bcd[2] = HexToBcd(day);
+  bcd[3] = HexToBcd(secs/3600);
+  bcd[4] = HexToBcd(secs/60%60);
+  bcd[5] = HexToBcd(secs%60);
+  return 0;
+}
+
+int TimeStringToTimestamp(std::string const& time, int64_t* timestamp) {
+  if (time.size() != 12) return -1;
+  uint8_t bcd[6];
+  for (int i = 0; i < 6; ++i) {
+    uint8_t const high = time[i*2]-'0';
+    uint8_t const low = time[i*2+1]-'0';
+    if (high > 9 || low > 9) return -1;
+    bcd[i] = (high << 4) | low;
+  }
+  return BcdTimeToTimestamp(bcd, timestamp);
+}
+
+int TimestampToTimeString(int64_t const& timestamp, std::string* time) {
+  if (time == nullptr) return -1;
+  uint8_t bcd[6];
+  if (TimestampToBcdTime(timestamp, bcd) != 0) return -1;
+  time->resize(12);
+  for (int i = 0; i < 6; ++i) {
+    (*time)[i*2] = (bcd[i] >> 4) + '0';
+    (*time)[i*2+1] = (bcd[i] & 0x0F) + '0';
+  }
+  return 0;
+}
+
 }  // namespace libjt808
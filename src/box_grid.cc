@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  box_grid.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 02:14:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/box_grid.h"
+
+#include <algorithm>
+
+
+namespace libjt808 {
+
+constexpr int64_t BoxGrid::kMaxCellsPerBox;
+
+BoxGrid::BoxGrid(int32_t const& cell_size) : cell_size_(cell_size) {
+  if (cell_size_ <= 0) cell_size_ = 50000;
+}
+
+void BoxGrid::Insert(uint32_t const& slot, GeoBox const& box) {
+  if (IsLarge(box)) {
+    large_slots_.push_back(slot);
+    return;
+  }
+  int32_t const max_x = CellIndex(box.max_longitude);
+  int32_t const max_y = CellIndex(box.max_latitude);
+  for (int32_t x = CellIndex(box.min_longitude); x <= max_x; ++x) {
+    for (int32_t y = CellIndex(box.min_latitude); y <= max_y; ++y) {
+      cells_[CellKey(x, y)].push_back(slot);
+    }
+  }
+}
+
+void BoxGrid::Remove(uint32_t const& slot, GeoBox const& box) {
+  if (IsLarge(box)) {
+    auto it = std::find(large_slots_.begin(), large_slots_.end(), slot);
+    if (it != large_slots_.end()) large_slots_.erase(it);
+    return;
+  }
+  int32_t const max_x = CellIndex(box.max_longitude);
+  int32_t const max_y = CellIndex(box.max_latitude);
+  for (int32_t x = CellIndex(box.min_longitude); x <= max_x; ++x) {
+    for (int32_t y = CellIndex(box.min_latitude); y <= max_y; ++y) {
+      auto const& cell = cells_.find(CellKey(x, y));
+      if (cell == cells_.end()) continue;
+      auto& cell_slots = cell->second;
+      auto it = std::find(cell_slots.begin(), cell_slots.end(), slot);
+      if (it != cell_slots.end()) {
+        *it = cell_slots.back();
+        cell_slots.pop_back();
+      }
+      if (cell_slots.empty()) cells_.erase(cell);
+    }
+  }
+}
+
+GeoBox BoxGrid::CellBox(GeoPoint const& point) const {
+  int64_t const min_longitude =
+      static_cast<int64_t>(CellIndex(point.longitude))*cell_size_;
+  int64_t const min_latitude =
+      static_cast<int64_t>(CellIndex(point.latitude))*cell_size_;
+  int64_t const max_longitude =
+      std::min<int64_t>(min_longitude+cell_size_-1, INT32_MAX);
+  int64_t const max_latitude =
+      std::min<int64_t>(min_latitude+cell_size_-1, INT32_MAX);
+  return GeoBox {static_cast<int32_t>(std::max<int64_t>(min_longitude,
+                                                        INT32_MIN)),
+                 static_cast<int32_t>(std::max<int64_t>(min_latitude,
+                                                        INT32_MIN)),
+                 static_cast<int32_t>(max_longitude),
+                 static_cast<int32_t>(max_latitude)};
+}
+
+void BoxGrid::Clear(void) {
+  cells_.clear();
+  large_slots_.clear();
+}
+
+}  // namespace libjt808
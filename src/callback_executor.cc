@@ -0,0 +1,179 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  callback_executor.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 19:52:30
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/callback_executor.h"
+
+#include "jt808/metrics.h"
+
+
+namespace libjt808 {
+
+namespace {
+
+// 当前线程所属的执行器, 非工作线程为空.
+thread_local CallbackExecutor const* current_executor = nullptr;
+
+}  // namespace
+
+CallbackExecutor::CallbackExecutor()
+    : capacity_(4096),
+      overflow_policy_(kCallbackOverflowBlock),
+      metrics_(nullptr),
+      pending_(0),
+      running_(false) {
+  dropped_.store(0);
+}
+
+CallbackExecutor::~CallbackExecutor() {
+  Stop();
+}
+
+int CallbackExecutor::Start(int const& thread_num) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_ || thread_num < 0) return -1;
+  running_ = true;
+  for (int i = 0; i < thread_num; ++i) {
+    workers_.push_back(std::thread(&CallbackExecutor::WorkerHandler, this));
+  }
+  return 0;
+}
+
+void CallbackExecutor::Stop(void) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!running_) return;
+  running_ = false;
+  lock.unlock();
+  ready_cond_.notify_all();
+  space_cond_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) worker.join();
+  }
+  workers_.clear();
+}
+
+int CallbackExecutor::Submit(uint64_t const& session, Task const& task) {
+  if (!task) return 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!running_ || workers_.empty()) {
+    lock.unlock();
+    task();
+    return 0;
+  }
+  if (pending_ >= capacity_) {
+    if (overflow_policy_ == kCallbackOverflowDrop) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      if (metrics_ != nullptr) metrics_->AddCallbackDropped();
+      return -1;
+    } else if (overflow_policy_ == kCallbackOverflowRunInline) {
+      lock.unlock();
+      task();
+      return 0;
+    }
+    space_cond_.wait(lock, [this] {
+      return pending_ < capacity_ || !running_;
+    });
+    if (!running_) {
+      lock.unlock();
+      task();
+      return 0;
+    }
+  }
+  auto& item = sessions_[session];
+  item.items.push_back(Item{task, std::chrono::steady_clock::now()});
+  ++pending_;
+  if (!item.scheduled) {
+    item.scheduled = true;
+    ready_.push_back(session);
+    lock.unlock();
+    ready_cond_.notify_one();
+  }
+  return 0;
+}
+
+int CallbackExecutor::Post(uint64_t const& session, Task const& task) {
+  if (!task) return 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!running_ || workers_.empty()) return -1;
+  auto& item = sessions_[session];
+  item.items.push_back(Item{task, std::chrono::steady_clock::now()});
+  ++pending_;
+  if (!item.scheduled) {
+    item.scheduled = true;
+    ready_.push_back(session);
+    lock.unlock();
+    ready_cond_.notify_one();
+  }
+  return 0;
+}
+
+bool CallbackExecutor::InWorkerThread(void) const {
+  return current_executor == this;
+}
+
+size_t CallbackExecutor::pending(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_;
+}
+
+// 每次从就绪队列取一个会话执行其最早的回调, 会话仍有回调时重新排到队尾,
+// 同一会话同时只会被一个工作线程执行, 保证会话内的顺序.
+// 停止时先执行完剩余的回调再退出.
+void CallbackExecutor::WorkerHandler(void) {
+  current_executor = this;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (1) {
+    ready_cond_.wait(lock, [this] { return !ready_.empty() || !running_; });
+    if (ready_.empty()) break;
+    auto const session = ready_.front();
+    ready_.pop_front();
+    auto it = sessions_.find(session);
+    Item item = std::move(it->second.items.front());
+    it->second.items.pop_front();
+    --pending_;
+    lock.unlock();
+    space_cond_.notify_one();
+    if (metrics_ != nullptr) {
+      metrics_->RecordCallbackQueueWait(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now()-item.submit_time).count());
+    }
+    item.task();
+    item.task = nullptr;
+    lock.lock();
+    it = sessions_.find(session);
+    if (it->second.items.empty()) {
+      sessions_.erase(it);
+    } else {
+      ready_.push_back(session);
+      ready_cond_.notify_one();
+    }
+  }
+}
+
+}  // namespace libjt808
@@ -30,17 +30,25 @@
 #include "jt808/client.h"
 
 #include <string.h>
+#include <errno.h>
 #include <math.h>
 #if defined(__linux__)
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #endif
 
 #include <chrono>
 #include <fstream>
 
+#include "jt808/bcd.h"
+#include "jt808/logger.h"
+#include "jt808/scratch_buffer.h"
 #include "jt808/socket_util.h"
+#include "jt808/util.h"
 
 
 namespace libjt808 {
@@ -58,19 +66,106 @@ const RegisterInfo kRegisterInfo = {
   "\xD4\xC1\x42\x31\x32\x33\x34\x35",  // "粤B12345".
 };
 
+// 定位数据批量上传消息体最大长度, 受消息体属性中10位长度字段限制.
+constexpr size_t kJournalBatchMaxBodyLength = 1023;
+// 同时等待平台应答的定位数据批量上传消息数.
+constexpr size_t kJournalBatchWindow = 4;
+
+// 从已封装的位置信息汇报(0x0200)消息中取出消息体.
+int ExtractLocationReportBody(std::vector<uint8_t> const& frame,
+                              std::vector<uint8_t>* body) {
+  ScratchBuffer scratch;
+  auto& out = *scratch;
+  if (ReverseEscape(frame, &out) < 0 || out.size() < 15) return -1;
+  if (out[1]*256 + out[2] != kLocationReport) return -1;
+  MsgBodyAttribute attr;
+  attr.u16val = out[3]*256 + out[4];
+  size_t pos = MSGBODY_NOPACKET_POS;
+  if (attr.bit.packet == 1) pos = MSGBODY_PACKET_POS;
+  if (pos+attr.bit.msglen+2 != out.size()) return -1;
+  body->assign(out.begin()+pos, out.begin()+pos+attr.bit.msglen);
+  return 0;
+}
+
+// 当前线程是否为事件循环线程, 事件循环线程内生成消息时无需唤醒自身.
+thread_local bool in_event_loop = false;
+
+#if defined(__linux__)
+// 设置定时器超时时间, interval_ms为0时为单次定时器.
+void SetTimer(int const& fd, int64_t const& value_ms,
+              int64_t const& interval_ms) {
+  struct itimerspec spec;
+  spec.it_value.tv_sec = value_ms/1000;
+  spec.it_value.tv_nsec = (value_ms%1000)*1000000;
+  // 超时时间为0会关闭定时器, 因此至少设置为1ns.
+  if (value_ms <= 0) spec.it_value.tv_nsec = 1;
+  spec.it_interval.tv_sec = interval_ms/1000;
+  spec.it_interval.tv_nsec = (interval_ms%1000)*1000000;
+  timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+// 读取并清除eventfd或timerfd的计数.
+void DrainFd(int const& fd) {
+  uint64_t count = 0;
+  while (read(fd, &count, sizeof(count)) > 0) {}
+}
+#endif
+
+// 按设置属性更新圆形或矩形区域, 同时维护区域空间索引.
+template<typename AreaSet>
+void ApplyAreaSetting(uint8_t const& type, uint8_t const& setting_type,
+                      AreaSet const& areas, AreaSet* current,
+                      GeofenceIndex* index) {
+  if (setting_type == kAreaSettingUpdate) {
+    current->clear();
+    index->Clear(type);
+  }
+  for (auto const& item : areas) {
+    if (setting_type == kAreaSettingModify &&
+        current->find(item.first) == current->end()) {
+      continue;
+    }
+    (*current)[item.first] = item.second;
+    index->Insert(item.second);
+  }
+}
+
+// 删除指定ID的圆形或矩形区域, 区域ID集为空时删除该类型的所有区域.
+template<typename AreaSet>
+void DeleteAreas(uint8_t const& type, std::vector<uint32_t> const& ids,
+                 AreaSet* current, GeofenceIndex* index) {
+  if (ids.empty()) {
+    current->clear();
+    index->Clear(type);
+    return;
+  }
+  for (auto const& id : ids) {
+    current->erase(id);
+    index->Remove(type, id);
+  }
+}
+
 }  // namespace
 
-JT808Client::JT808Client() {
+JT808Client::JT808Client()
+    : wakeup_fd_(-1), service_thread_alive_(false), client_(-1),
+      first_report_(true),
+      upgrade_total_size_(0), upgrade_packet_max_size_(0),
+      journal_inflight_num_(0) {
 }
 
 JT808Client::~JT808Client() {
+#if defined(__linux__)
+  if (wakeup_fd_ >= 0) close(wakeup_fd_);
+#endif
 }
 
 // 对一些必要的参数设定一个默认值, 防止协议命令生成不完整.
 void JT808Client::Init(void) {
-  // 初始化命令解析器和命令封装器.
-  JT808FrameParserInit(&parser_);
-  JT808FramePackagerInit(&packager_);
+  // 使用进程内共享的命令解析器和命令封装器,
+  // 保留Init()之前已经重写或新增的命令.
+  parser_.merge(DefaultParser());
+  packager_.merge(DefaultPackager());
   // 预设终端手机号.
   parameter_.msg_head.phone_num = std::move("13395279527");
   parameter_.msg_head.msgbody_attr.u16val = 0;  // 消息体属性.
@@ -81,12 +176,17 @@ void JT808Client::Init(void) {
   upgrade_callback_ = [] (uint8_t const& type,
       char const* data, int const& size) -> void { return; };
   polygon_area_callback_ = [] (void) -> void { return; };
+  area_route_callback_ = [] (uint16_t const& msg_id) -> void { return; };
   // 位置上报相关.
   location_report_inteval_ = 10;  // 10s位置上报时间间隔.
-  location_report_immediately_flag_ = 0;  // 立即上报标志清零.
+  location_report_immediately_flag_.store(0);  // 立即上报标志清零.
   parameter_.location_info.alarm.value = 0;
   parameter_.location_info.status.value = 0;
   parameter_.location_info.time = "700101000000"; // 1970-01-01-00-00-00.
+  // 待发送消息.
+  send_queue_.Clear();
+  sending_msg_.clear();
+  sending_offset_ = 0;
   // 通信流程控制.
   is_connected_.store(false);
   is_authenticated_.store(false);
@@ -94,6 +194,13 @@ void JT808Client::Init(void) {
   location_report_msg_generate_outside_.store(false);
   tcp_connection_handling_.store(false);
   jt808_connection_handling_.store(false);
+  SetManualDeal(false);
+  manual_deal_ack_.store(false);
+  waiting_stop_.store(false);
+  waiting_stop_deadline_ms_.store(0);
+#if defined(__linux__)
+  if (wakeup_fd_ < 0) wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
 }
 
 // 与远程服务器建立TCP连接, 并设置socket为非阻塞模式.
@@ -110,7 +217,7 @@ int JT808Client::ConnectRemote(void) {
   addr.sin_addr.s_addr = inet_addr(ip_.c_str());
   auto tcp_socket = socket(AF_INET, SOCK_STREAM, 0);
   if (tcp_socket == -1) {
-    printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Create socket failed!!!", __FUNCTION__, __LINE__);
     tcp_connection_handling_.store(false);
     return -1;
   }
@@ -125,7 +232,7 @@ int JT808Client::ConnectRemote(void) {
   }
   auto tcp_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
   if (tcp_socket == INVALID_SOCKET) {
-    printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Create socket failed!!!", __FUNCTION__, __LINE__);
     WSACleanup();
     tcp_connection_handling_.store(false);
     return -1;
@@ -134,7 +241,7 @@ int JT808Client::ConnectRemote(void) {
 #endif
   if (Connect(tcp_socket, reinterpret_cast<struct sockaddr *>(&addr),
               sizeof(addr)) == -1) {
-    printf("[%s:%d] Connect to remote server failed!!!\n",
+    JT808_LOG_ERROR("[%s:%d] Connect to remote server failed!!!",
         ip_.c_str(), port_);
     Close(tcp_socket);
 #if defined(_WIN32)
@@ -151,7 +258,8 @@ int JT808Client::ConnectRemote(void) {
 #elif defined(_WIN32)
   unsigned long ul = 1;
   if (ioctlsocket(tcp_socket, FIONBIO, (unsigned long *)&ul) == SOCKET_ERROR) {
-    printf("[%s:%d] Set socket nonblock failed!!!\n", ip_.c_str(), port_);
+    JT808_LOG_ERROR("[%s:%d] Set socket nonblock failed!!!",
+        ip_.c_str(), port_);
     Close(tcp_socket);
 #if defined(_WIN32)
     WSACleanup();
@@ -164,7 +272,7 @@ int JT808Client::ConnectRemote(void) {
   client_ = tcp_socket;
   is_connected_.store(true);
   tcp_connection_handling_.store(false);
-  printf("[%s:%d] TCP connected.\n", ip_.c_str(), port_);
+  JT808_LOG_INFO("[%s:%d] TCP connected.", ip_.c_str(), port_);
   return 0;
 }
 
@@ -254,13 +362,19 @@ int JT808Client::JT808ConnectionAuthentication(void) {
   }
   is_authenticated_.store(true);
   jt808_connection_handling_.store(false);
-  printf("[%s:%d]: JT808 connected.\n", ip_.c_str(), port_);
+  JT808_LOG_INFO("[%s:%d]: JT808 connected.", ip_.c_str(), port_);
   return 0;
 }
 
 // 在与JT808服务端成功进行连接和鉴权后启动服务线程.
 void JT808Client::Run(void) {
   if (!is_connected_ || !is_authenticated_) return;
+  service_is_running_.store(true);
+  {
+    std::lock_guard<std::mutex> lock(loop_mutex_);
+    service_thread_alive_ = true;
+    waiting_stop_.store(false);
+  }
   service_thread_ = std::thread(&JT808Client::ThreadHandler, this);
   service_thread_.detach();
 }
@@ -268,6 +382,7 @@ void JT808Client::Run(void) {
 // 停止服务线程并清除TCP连接.
 void JT808Client::Stop(void) {
   service_is_running_.store(false);
+  WakeUp();
   if (tcp_connection_handling_.load()) return;
   if (jt808_connection_handling_.load()) return;
   if (client_ > 0) {
@@ -281,40 +396,104 @@ void JT808Client::Stop(void) {
   is_connected_.store(false);
 }
 
+// 发送队列只在服务线程中访问, 由服务线程发送完或超时后清除并退出,
+// 服务线程退出后socket已从事件循环中移除, 再关闭连接.
 void JT808Client::WattingStop(int const& timeout_msec) {
-  if (client_ > 0) {
-    auto begin_tp = std::chrono::steady_clock::now();
-    auto end_tp = begin_tp;
-    while (std::chrono::duration_cast<std::chrono::milliseconds>(
-              end_tp-begin_tp).count() < timeout_msec) {
-      if (general_msg_.empty() && location_report_msg_.empty()) break;
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      end_tp = std::chrono::steady_clock::now();
-    }
-    general_msg_.clear();
-    location_report_msg_.clear();
-    service_is_running_.store(false);
-    Close(client_);
-    client_ = 0;
-#if defined(_WIN32)
-    WSACleanup();
-#endif
-    is_authenticated_.store(false);
-    is_connected_.store(false);
+  std::unique_lock<std::mutex> lock(loop_mutex_);
+  if (service_thread_alive_) {
+    waiting_stop_deadline_ms_.store(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count() +
+        timeout_msec);
+    waiting_stop_.store(true);
+    lock.unlock();
+    WakeUp();
+    // 在服务线程中调用时, 由服务线程退出时关闭连接.
+    if (in_event_loop) return;
+    lock.lock();
+    loop_cond_.wait(lock, [this] { return !service_thread_alive_; });
   }
+  lock.unlock();
+  Stop();
+}
+
+int64_t JT808Client::WaitingStopRemainMsec(void) const {
+  if (!waiting_stop_.load()) return -1;
+  if (sending_msg_.empty() && send_queue_.empty()) return 0;
+  int64_t const remain = waiting_stop_deadline_ms_.load() -
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+  return (remain > 0) ? remain : 0;
 }
 
+// 由报警触发的位置上报消息放入报警优先级队列, 其余放入常规上报队列.
 void JT808Client::GenerateLocationReportMsgNow(void) {
   // printf("timestamp: %s\n", parameter_.location_info.time.c_str());
   std::vector<uint8_t> msg;
+  // 服务线程未运行时直接写入日志, 等待重新连接后补报.
+  if (!service_is_running_.load() && location_journal_.is_open()) {
+    std::unique_lock<std::mutex> lock(msg_generate_mutex_);
+    PackageLocationReportBody(parameter_.location_info,
+                              parameter_.location_extension, &msg);
+    lock.unlock();
+    location_journal_.Append(msg);
+    location_report_immediately_flag_.fetch_and(
+        static_cast<uint16_t>(~kAlarmOccurred));
+    return;
+  }
   if (PackagingMessage(kLocationReport, &msg) < 0) {
-    printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Package message failed !!!",
+        __FUNCTION__, __LINE__);
     return;
   }
-  if (location_report_msg_.size() > 10000) {
-    location_report_msg_.pop_front();
+  auto const flag = location_report_immediately_flag_.fetch_and(
+      static_cast<uint16_t>(~kAlarmOccurred));
+  if ((flag & kAlarmOccurred) ||
+      (parameter_.location_info.alarm.bit.sos == 1)) {
+    send_queue_.Push(kSendPriorityAlarm, std::move(msg));
+  } else {
+    send_queue_.Push(kSendPriorityRoutine, std::move(msg));
+  }
+  if (!in_event_loop) WakeUp();
+}
+
+// 位置时间优先使用时间字符串, UpdateLocation()的浮点版本只更新时间字符串.
+void JT808Client::EvaluateDrivingAlarm(void) {
+  auto const& info = parameter_.location_info;
+  int64_t timestamp = info.timestamp;
+  if (!info.time.empty()) TimeStringToTimestamp(info.time, &timestamp);
+  DrivingAlarmConfig config;
+  GetDrivingAlarmConfig(parameter_.terminal_parameters, &config);
+  driving_alarm_tracker_.Update(config, timestamp, info.speed,
+                                info.status.value);
+  // 同时在多条路线上时, 优先沿正在计时的路线判断, 否则取ID最小的路线.
+  RouteMatch const* match = nullptr;
+  RouteInflectionPoint const* point = nullptr;
+  std::vector<RouteMatch> matches;
+  if (!route_index_.empty()) {
+    route_index_.Query(MakeGeoPoint(info.longitude, info.latitude), &matches);
+  }
+  for (auto const& item : matches) {
+    if (match == nullptr ||
+        item.route_id == driving_alarm_tracker_.section_route_id()) {
+      match = &item;
+    }
+  }
+  if (match != nullptr) {
+    auto const& it = routes_.find(match->route_id);
+    if (it != routes_.end() && match->point_index < it->second.points.size()) {
+      point = &it->second.points[match->point_index];
+    }
   }
-  location_report_msg_.push_back(std::move(msg));
+  SectionDrivingTimeAlarm section_alarm;
+  bool const section_alarmed = driving_alarm_tracker_.UpdateSection(
+      timestamp, match, point, &section_alarm);
+  AlarmBit alarm = info.alarm;
+  SetDrivingAlarmItems(driving_alarm_tracker_.alarm(), &alarm,
+                       &parameter_.location_extension);
+  SetSectionDrivingTimeItems(section_alarmed ? &section_alarm : nullptr,
+                             &alarm, &parameter_.location_extension);
+  SetAlarmBit(alarm.value);
 }
 
 int JT808Client::MultimediaUpload(char const* path,
@@ -322,7 +501,8 @@ int JT808Client::MultimediaUpload(char const* path,
   std::ifstream ifs;
   ifs.open(path, std::ios::in|std::ios::binary);
   if (!ifs.is_open()) {
-    printf("%s[%d]: Updrade file open failed !!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Updrade file open failed !!!",
+        __FUNCTION__, __LINE__);
     return -1;
   }
   ifs.seekg(0, std::ios::end);
@@ -344,7 +524,7 @@ int JT808Client::MultimediaUpload(char const* path,
     media.loaction_report_body.assign(
         location_basic.begin(), location_basic.end());
   }
-  manual_deal_.store(true);
+  SetManualDeal(true);
   uint16_t max_content = 1023-36;
   if (length > max_content) {  // 需要分包处理.
     parameter_.msg_head.msgbody_attr.bit.packet = 1;  // 进行分包.
@@ -357,17 +537,17 @@ int JT808Client::MultimediaUpload(char const* path,
       if (len > max_content) len = max_content;
       media.media_data.assign(buffer.get()+i, buffer.get()+i+len);
       if (PackagingAndSendMessage(kMultimediaDataUpload) < 0) {
-        manual_deal_.store(false);
+        SetManualDeal(false);
         return -1;
       }
       if (ReceiveAndParseMessage(3) < 0) {
-        manual_deal_.store(false);
+        SetManualDeal(false);
         return -1;
       }
       if (parameter_.parse.msg_head.msg_id != kPlatformGeneralResponse ||
           parameter_.parse.respone_msg_id != kMultimediaDataUpload ||
           parameter_.parse.respone_result != kSuccess) {
-        manual_deal_.store(false);
+        SetManualDeal(false);
         return -1;
       }
       ++parameter_.msg_head.packet_seq;
@@ -377,30 +557,30 @@ int JT808Client::MultimediaUpload(char const* path,
   } else {
     media.media_data.assign(buffer.get(), buffer.get()+length);
     if (PackagingAndSendMessage(kMultimediaDataUpload) < 0) {
-      manual_deal_.store(false);
+      SetManualDeal(false);
       return -1;
     }
     if (ReceiveAndParseMessage(3) < 0) {
-      manual_deal_.store(false);
+      SetManualDeal(false);
       return -1;
     }
     if (parameter_.parse.respone_msg_id != kMultimediaDataUpload ||
         parameter_.parse.respone_result != kSuccess) {
-      manual_deal_.store(false);
+      SetManualDeal(false);
       return -1;
     }
   }
   if (ReceiveAndParseMessage(5) == 0) {
     if (parameter_.parse.msg_head.msg_id == kMultimediaDataUploadResponse) {
       if (parameter_.parse.msg_head.msgbody_attr.bit.msglen == 4) {
-        printf("Completed.\n");
+        JT808_LOG_INFO("Completed.");
       } else {
         // TODO(mengyuming@hotmail.com): 需要重传.
       }
     }
   }
-  printf("Done.\n");
-  manual_deal_.store(false);
+  JT808_LOG_INFO("Done.");
+  SetManualDeal(false);
   return 0;
 }
 
@@ -408,16 +588,19 @@ int JT808Client::MultimediaUpload(char const* path,
 // 并通过socket发送到服务端.
 int JT808Client::PackagingAndSendMessage(uint32_t const& msg_id) {
   if (!is_connected_) {
-    printf("%s[%d]: Invalid connection !!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Invalid connection !!!", __FUNCTION__, __LINE__);
     return -1;
   }
-  std::vector<uint8_t> msg;
+  ScratchBuffer scratch;
+  auto& msg = *scratch;
   if (PackagingMessage(msg_id, &msg) < 0) {
-    printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Package message failed !!!",
+        __FUNCTION__, __LINE__);
     return -1;
   }
   if (Send(client_, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
-    printf("%s[%d]: Send message failed !!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Send message failed !!!",
+        __FUNCTION__, __LINE__);
     return -1;
   }
   return 0;
@@ -426,7 +609,7 @@ int JT808Client::PackagingAndSendMessage(uint32_t const& msg_id) {
 // 阻塞地从socket连接中接收一次数据, 然后按照JT808协议进行解析.
 int JT808Client::ReceiveAndParseMessage(int const& timeout) {
   if (!is_connected_) {
-    printf("%s[%d]: Invalid connection !!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Invalid connection !!!", __FUNCTION__, __LINE__);
     return -1;
   }
   std::vector<uint8_t> msg;
@@ -441,7 +624,8 @@ int JT808Client::ReceiveAndParseMessage(int const& timeout) {
       msg.assign(buffer.get(), buffer.get()+ret);
       break;
     } else if (ret == 0) {
-      printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
+      JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Disconnect !!!",
+          __FUNCTION__, __LINE__);
       is_connected_.store(false);
       return -1;
     } else {
@@ -459,22 +643,26 @@ int JT808Client::ReceiveAndParseMessage(int const& timeout) {
   // for (auto const& uch : msg) printf("%02X ", uch);
   // printf("\n");
   // 解析消息.
-  if (JT808FrameParse(parser_, msg, &parameter_) == -1) {
-    printf("%s[%d]: Parse message failed !!!\n", __FUNCTION__, __LINE__);
+  if (JT808FrameParse(parser_.get(), msg, &parameter_) < 0) {
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Parse message failed !!!",
+        __FUNCTION__, __LINE__);
     return -1;
   }
   return 0;
 }
 
 int JT808Client::PackagingMessage(uint32_t const& msg_id,
-                                  std::vector<uint8_t>* out) {
+                                  std::vector<uint8_t>* out,
+                                  uint16_t* flow_num) {
   if (out == nullptr) return -1;
   std::unique_lock<std::mutex> lock(msg_generate_mutex_);
   parameter_.msg_head.msg_id = msg_id;  // 设置消息ID.
-  if (JT808FramePackage(packager_, parameter_, out) < 0) {
-    printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+  if (JT808FramePackage(packager_.get(), parameter_, out) < 0) {
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Package message failed !!!",
+        __FUNCTION__, __LINE__);
     return -1;
   }
+  if (flow_num != nullptr) *flow_num = parameter_.msg_head.msg_flow_num;
   ++parameter_.msg_head.msg_flow_num;  // 每正确生成一条命令, 消息流水号增加1.
   lock.unlock();
   return 0;
@@ -485,289 +673,635 @@ int JT808Client::PackagingGeneralMessage(uint32_t const& msg_id) {
   if (PackagingMessage(msg_id, &msg) != 0) {
     return -1;
   }
-  if (general_msg_.size() > 100) {
-    general_msg_.pop_front();
-  }
-  general_msg_.push_back(std::move(msg));
+  send_queue_.Push(kSendPriorityResponse, std::move(msg));
+  if (!in_event_loop) WakeUp();
   return 0;
 }
 
+// 唤醒事件循环, 使其及时处理新的待发送消息或状态变化.
+void JT808Client::WakeUp(void) {
+#if defined(__linux__)
+  if (wakeup_fd_ < 0) return;
+  uint64_t one = 1;
+  if (write(wakeup_fd_, &one, sizeof(one)) < 0) {
+    // 计数溢出时事件循环必然处于待唤醒状态, 忽略即可.
+  }
+#endif
+}
+
+// 进入手动收发模式时, 等待事件循环发送完未完成的消息并停止读写socket,
+// 避免与手动收发竞争. 事件循环线程中调用时不等待.
+void JT808Client::SetManualDeal(bool const& manual) {
+  std::unique_lock<std::mutex> lock(loop_mutex_);
+  manual_deal_.store(manual);
+  manual_deal_ack_.store(false);
+  lock.unlock();
+  WakeUp();
+  if (!manual || in_event_loop) return;
+  lock.lock();
+  loop_cond_.wait(lock, [this] {
+    return manual_deal_ack_.load() || !service_is_running_.load();
+  });
+}
+
+void JT808Client::UpdateManualDealAck(bool const& manual) {
+  std::lock_guard<std::mutex> lock(loop_mutex_);
+  bool const ack = manual && manual_deal_.load();
+  manual_deal_ack_.store(ack);
+  if (ack) loop_cond_.notify_all();
+}
+
+// 正在发送的消息未发送完成时必须先将其发送完, 保证消息帧的完整性.
+int JT808Client::FlushSendQueue(bool const& current_only) {
+  int ret = -1;
+  while (1) {
+    if (sending_offset_ >= sending_msg_.size()) {
+      sending_msg_.clear();
+      sending_offset_ = 0;
+      if (current_only || !send_queue_.Pop(&sending_msg_)) return 0;
+      // printf("JT808 Send[%d]: ", static_cast<int>(sending_msg_.size()));
+      // for (auto const& uch : sending_msg_) printf("%02X ", uch);
+      // printf("\n");
+    }
+    ret = Send(client_,
+               reinterpret_cast<char*>(sending_msg_.data())+sending_offset_,
+               static_cast<int>(sending_msg_.size()-sending_offset_), 0);
+    if (ret > 0) {
+      sending_offset_ += ret;
+      continue;
+    }
+    if (ret < 0) {
+#if defined(__linux__)
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+#elif defined(_WIN32)
+      auto wsa_errno = WSAGetLastError();
+      if (wsa_errno == WSAEINTR) continue;
+      if (wsa_errno == WSAEWOULDBLOCK) return 1;
+#endif
+    }
+    return -1;
+  }
+}
+
 // 服务端通信线程, 解析接收到的命令, 同时自动进行位置信息上报和心跳包的发送.
 void JT808Client::ThreadHandler(void) {
   service_is_running_.store(true);
-  std::atomic_bool send_running;
-  std::atomic_bool recv_running;
-  send_running.store(false);
-  recv_running.store(false);
+  in_event_loop = true;
   std::string server_ip = ip_;
   int server_port = port_;
-  while (service_is_running_) {
-    if (!send_running.load()) {
-      std::thread(&JT808Client::SendHandler, this, &send_running).detach();
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-    if (!recv_running.load()) {
-      std::thread(&JT808Client::ReceiveHandler, this, &recv_running).detach();
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  // 上次连接中未发送完的消息已不完整, 直接丢弃.
+  if (sending_offset_ > 0) {
+    sending_msg_.clear();
+    sending_offset_ = 0;
   }
+  frame_assembler_.Reset();
+  upgrade_buffer_.reset();
+  manual_deal_ack_.store(false);
+  first_report_ = true;
+  last_send_tp_ = std::chrono::steady_clock::now();
+  // 未收到应答的批量上传消息重新发送.
+  journal_batches_.clear();
+  journal_inflight_num_ = 0;
+  SendJournalBatches();
+  EventLoop();
   // 线程终止.
-  send_running.store(false);
-  recv_running.store(false);
-  service_is_running_.store(false);
-  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  SpillLocationReportsToJournal();
+  if (waiting_stop_.load()) {
+    send_queue_.Clear();
+    sending_msg_.clear();
+    sending_offset_ = 0;
+  }
+  in_event_loop = false;
+  {
+    std::lock_guard<std::mutex> lock(loop_mutex_);
+    manual_deal_ack_.store(false);
+    service_is_running_.store(false);
+    loop_cond_.notify_all();
+  }
   Stop();
-  printf("[%s:%d] Main service done.\r\n", server_ip.c_str(), server_port);
+  {
+    std::lock_guard<std::mutex> lock(loop_mutex_);
+    service_thread_alive_ = false;
+    loop_cond_.notify_all();
+  }
+  JT808_LOG_INFO("[%s:%d] Main service done.", server_ip.c_str(), server_port);
 }
 
-void JT808Client::SendHandler(std::atomic_bool *const running) {
-  running->store(true);
-  int64_t report_intv = location_report_inteval_*1000;  // 时间间隔, ms.
-  std::unique_ptr<char[]> buffer(
-      new char[4096], std::default_delete<char[]>());
-  auto report_begin_tp = std::chrono::steady_clock::now();
-  auto heartbeat_begin_tp = std::chrono::steady_clock::now();
-  auto end_tp = std::chrono::steady_clock::now();
-  auto report_time_lag = std::chrono::duration_cast<
-        std::chrono::milliseconds>(end_tp - report_begin_tp).count();
-  auto heartbeat_time_lag = std::chrono::duration_cast<
-        std::chrono::milliseconds>(end_tp - heartbeat_begin_tp).count();
-  int64_t heartbeat_intv;
-  uint32_t temp;
-  // 从终端参数中获取心跳包时间间隔, 若未找到或值为0则使用默认60秒(s)心跳.
+// 心跳包时间间隔, 从终端参数中获取, 若未找到或值为0则使用默认60秒(s)心跳.
+int64_t JT808Client::HeartbeatIntervalMsec(void) const {
+  uint32_t temp = 0;
   if ((GetTerminalHeartbeatInterval(&temp) == 0) && (temp > 0)) {
-    heartbeat_intv = temp * 1000;
-  } else {
-    heartbeat_intv = 60000;  // 60s.
+    return static_cast<int64_t>(temp) * 1000;
   }
-  bool first_report = true;
-  manual_deal_.store(false);
-  std::string server_ip = ip_;
-  int server_port = port_;
-  while (running->load()) {
-    // if (manual_deal_.load()) {
-    //   std::this_thread::sleep_for(std::chrono::milliseconds(20));
-    //   continue;
-    // }
-    end_tp = std::chrono::steady_clock::now();
-    // 优先发送应答消息.
-    if (!general_msg_.empty()) {
-      if (!manual_deal_.load()) {
-        for (auto& msg : general_msg_) {
-          // printf("JT808 Send[%d]: ", static_cast<int>(msg.size()));
-          // for (auto const& uch : msg) printf("%02X ", uch);
-          // printf("\n");
-          if (Send(client_, reinterpret_cast<char*>(msg.data()),
-              msg.size(), 0) <= 0) {
-            printf("%s[%d]: Send message failed !!!\n",
-                __FUNCTION__, __LINE__);
-            service_is_running_.store(false);
-            return;
-          }
-          std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
-        general_msg_.clear();
+  return 60000;
+}
+
+// 发送待发送消息, 有消息发送时更新最后发送时间, 用于心跳检测.
+// 手动收发期间只发送完未完成的消息, 避免手动发送的消息插入其中.
+int JT808Client::SendPending(void) {
+  bool const manual = manual_deal_.load();
+  if (manual && !SendingPartialFrame()) return 0;
+  if (sending_msg_.empty() && send_queue_.empty()) return 0;
+  int ret = FlushSendQueue(manual);
+  if (ret >= 0) last_send_tp_ = std::chrono::steady_clock::now();
+  return ret;
+}
+
+// 到达位置上报时间间隔.
+// 首次上报需要等到成功定位后再进行, 在此期间由心跳包维持连接.
+void JT808Client::OnReportTimeout(void) {
+  if (location_report_msg_generate_outside_.load()) return;
+  if (first_report_ && parameter_.location_info.status.bit.positioning == 0) {
+    return;
+  }
+  first_report_ = false;
+  GenerateLocationReportMsgNow();
+  location_report_immediately_flag_.fetch_and(
+      static_cast<uint16_t>(~kStateChanged));
+}
+
+// 报警或状态变化时立即进行位置上报.
+void JT808Client::CheckImmediateReport(void) {
+  if (location_report_msg_generate_outside_.load()) return;
+  if (location_report_immediately_flag_.load() == 0) return;
+  if (first_report_ && parameter_.location_info.status.bit.positioning == 0) {
+    return;
+  }
+  first_report_ = false;
+  GenerateLocationReportMsgNow();
+  location_report_immediately_flag_.fetch_and(
+      static_cast<uint16_t>(~kStateChanged));
+}
+
+// 心跳定时器超时, 距上次发送消息已超过心跳时间间隔时发送心跳包.
+// Returns:
+//     距下一次检查心跳的时间, 单位毫秒(ms).
+int64_t JT808Client::OnHeartbeatTimeout(int64_t const& heartbeat_intv) {
+  auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - last_send_tp_).count();
+  if (elapsed >= heartbeat_intv) {
+    PackagingGeneralMessage(kTerminalHeartBeat);
+    last_send_tp_ = std::chrono::steady_clock::now();
+    return heartbeat_intv;
+  }
+  return heartbeat_intv - elapsed;
+}
+
+// 读取socket中所有已到达的数据, 切分出完整消息帧后逐帧处理.
+// Returns:
+//     成功返回0, 连接断开或出错返回-1.
+int JT808Client::ReceiveAvailable(void) {
+  char buffer[4096];
+  int ret = -1;
+  while (1) {
+    if ((ret = Recv(client_, buffer, sizeof(buffer), 0)) > 0) {
+      frame_assembler_.Append(reinterpret_cast<uint8_t*>(buffer), ret);
+      while (frame_assembler_.Next(&receive_msg_)) {
+        // printf("JT808 Recv[%d]: ", static_cast<int>(receive_msg_.size()));
+        // for (auto const& uch : receive_msg_) printf("%02X ", uch);
+        // printf("\n");
+        HandleMessage(receive_msg_);
       }
-      heartbeat_begin_tp = end_tp;  // 重置心跳检测时间.
-    }
-    // 到达时间间隔或有立即上报的标志时进行位置信息汇报.
-    // 外部生成上报消息, 交由内部进行上报.
-    if (!location_report_msg_.empty()) {
-      if (!manual_deal_.load()) {
-        for (auto& msg : location_report_msg_) {
-          // printf("JT808 Send[%d]: ", static_cast<int>(msg.size()));
-          // for (auto const& uch : msg) printf("%02X ", uch);
-          // printf("\n");
-          if (Send(client_, reinterpret_cast<char*>(msg.data()),
-                msg.size(), 0) <= 0) {
-            printf("[%s:%d] Send data failed !!!\n",
-                server_ip.c_str(), server_port);
-            service_is_running_.store(false);
-            return;
-          }
-          std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
-        location_report_msg_.clear();
-        // report_begin_tp = end_tp;
+      if (ret < static_cast<int>(sizeof(buffer))) return 0;
+      continue;
+    } else if (ret == 0) {
+      JT808_LOG_ERROR_EVERY_MS(1000, "[%s:%d] Disconnect !!!",
+          ip_.c_str(), port_);
+      return -1;
+    }
+#if defined(__linux__)
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+#elif defined(_WIN32)
+    auto wsa_errno = WSAGetLastError();
+    if (wsa_errno == WSAEINTR) continue;
+    if (wsa_errno == WSAEWOULDBLOCK) return 0;
+#endif
+    JT808_LOG_ERROR_EVERY_MS(1000, "[%s:%d] Remote socket error!!!",
+        ip_.c_str(), port_);
+    return -1;
+  }
+}
+
+void JT808Client::UpdateCircularAreas(CircularAreaSetting const& setting) {
+  ApplyAreaSetting(kAccessAreaAlarmCircularArea, setting.setting_type,
+                   setting.areas, &circular_areas_, &area_index_);
+}
+
+void JT808Client::DeleteCircularAreaByIDs(std::vector<uint32_t> const& ids) {
+  DeleteAreas(kAccessAreaAlarmCircularArea, ids, &circular_areas_,
+              &area_index_);
+}
+
+void JT808Client::UpdateRectangleAreas(RectangleAreaSetting const& setting) {
+  ApplyAreaSetting(kAccessAreaAlarmRectangleArea, setting.setting_type,
+                   setting.areas, &rectangle_areas_, &area_index_);
+}
+
+void JT808Client::DeleteRectangleAreaByIDs(
+    std::vector<uint32_t> const& ids) {
+  DeleteAreas(kAccessAreaAlarmRectangleArea, ids, &rectangle_areas_,
+              &area_index_);
+}
+
+void JT808Client::DeleteRouteByIDs(std::vector<uint32_t> const& ids) {
+  if (ids.empty()) {
+    routes_.clear();
+    route_index_.Clear();
+    return;
+  }
+  for (auto const& id : ids) {
+    routes_.erase(id);
+    route_index_.Remove(id);
+  }
+}
+
+// 处理一条平台下发的消息.
+void JT808Client::HandleMessage(std::vector<uint8_t> const& msg) {
+  if (JT808FrameParse(parser_.get(), msg, &parameter_) != 0) return;
+  auto const& msg_id = parameter_.parse.msg_head.msg_id;
+  if (msg_id == kSetTerminalParameters) {  // 设置终端参数.
+    // 更新终端参数.
+    for (auto const& it : parameter_.parse.terminal_parameters) {
+      if (parameter_.terminal_parameters.find(it.first) !=
+          parameter_.terminal_parameters.end()) {
+        parameter_.terminal_parameters[it.first] = it.second;
+      } else {
+        parameter_.terminal_parameters.insert(it);
       }
-      heartbeat_begin_tp = end_tp;  // 重置心跳检测时间.
-    }
-    // 上次发送位置上报消息到此时的时间差.
-    report_time_lag = std::chrono::duration_cast<
-        std::chrono::milliseconds>(end_tp - report_begin_tp).count();
-    // 上次发送心跳包到此时的时间差.
-    heartbeat_time_lag = std::chrono::duration_cast<
-        std::chrono::milliseconds>(end_tp - heartbeat_begin_tp).count();
-    // 到达时间间隔或有立即上报的标志时进行位置信息汇报.
-    // 外部生成上报消息, 交由内部进行上报.
-    if (!location_report_msg_generate_outside_ &&
-        (report_time_lag >= report_intv ||
-         location_report_immediately_flag_)) {
-      // 首次上报需要等到成功定位后再进行, 再此期间可以进行心跳包发送.
-      if (parameter_.location_info.status.bit.positioning == 0) {
-        if (first_report) {
-          if (heartbeat_time_lag >= heartbeat_intv) {
-            heartbeat_begin_tp = end_tp;
-            PackagingGeneralMessage(kTerminalHeartBeat);
-          }
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
-          continue;
-        }
+    }
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    terminal_parameter_callback_();
+  } else if (msg_id == kGetTerminalParameters ||
+             msg_id == kGetSpecificTerminalParameters) {  // 查询终端参数.
+    auto const& ids = parameter_.parse.terminal_parameter_ids;
+    if (ids.empty()) {  // 返回全部参数.
+      parameter_.terminal_parameter_ids.clear();
+    } else {  // 返回指定参数.
+      parameter_.terminal_parameter_ids.assign(ids.begin(), ids.end());
+    }
+    PackagingGeneralMessage(kGetTerminalParametersResponse);
+  } else if (msg_id == kSetPolygonArea) {  // 设置矩形区域.
+    UpdatePolygonAreaByArea(parameter_.parse.polygon_area);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    polygon_area_callback_();
+  } else if (msg_id == kDeletePolygonArea) {  // 删除矩形区域.
+    DeletePolygonAreaByIDs(parameter_.polygon_area_id);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    polygon_area_callback_();
+  } else if (msg_id == kSetCircularArea) {  // 设置圆形区域.
+    UpdateCircularAreas(parameter_.parse.circular_area_setting);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    area_route_callback_(msg_id);
+  } else if (msg_id == kDeleteCircularArea) {  // 删除圆形区域.
+    DeleteCircularAreaByIDs(parameter_.parse.circular_area_id);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    area_route_callback_(msg_id);
+  } else if (msg_id == kSetRectangleArea) {  // 设置矩形区域.
+    UpdateRectangleAreas(parameter_.parse.rectangle_area_setting);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    area_route_callback_(msg_id);
+  } else if (msg_id == kDeleteRectangleArea) {  // 删除矩形区域.
+    DeleteRectangleAreaByIDs(parameter_.parse.rectangle_area_id);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    area_route_callback_(msg_id);
+  } else if (msg_id == kSetRoute) {  // 设置路线.
+    UpdateRoute(parameter_.parse.route);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    area_route_callback_(msg_id);
+  } else if (msg_id == kDeleteRoute) {  // 删除路线.
+    DeleteRouteByIDs(parameter_.parse.route_id);
+    // 应答成功.
+    parameter_.respone_result = kSuccess;
+    PackagingGeneralMessage(kTerminalGeneralResponse);
+    // 调用回调函数.
+    area_route_callback_(msg_id);
+  } else if (msg_id == kTerminalUpgrade) {  // 下发终端升级包.
+    // TODO(mengyuming@hotmail.com): 未做分包完整性校验.
+    auto const& upgrade_info = parameter_.parse.upgrade_info;
+    auto const& msg_head =  parameter_.parse.msg_head;
+    auto const& packet_size = upgrade_info.upgrade_data.size();
+    // 检查分包.
+    if (msg_head.msgbody_attr.bit.packet == 1) {  // 分包.
+      // 分配空间.
+      if (msg_head.packet_seq == 1) {  // 第一包.
+        int max_len = msg_head.msgbody_attr.bit.msglen*
+                      msg_head.total_packet;
+        upgrade_buffer_.reset(new char[max_len]);
+        // 子包最大的数据长度.
+        upgrade_packet_max_size_ = packet_size;
+        upgrade_total_size_ = 0;
       }
-      if (first_report) first_report = false;
-      location_report_immediately_flag_ = 0;
-      report_begin_tp = end_tp;
-      heartbeat_begin_tp = end_tp;  // 进行位置汇报后重置心跳检测时间.
-      GenerateLocationReportMsgNow();
-    } else if (heartbeat_time_lag >= heartbeat_intv) {
-      heartbeat_begin_tp = end_tp;
-      PackagingGeneralMessage(kTerminalHeartBeat);
-    } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      if (!upgrade_buffer_) return;
+      memcpy(&(upgrade_buffer_[
+                 upgrade_packet_max_size_*(msg_head.packet_seq-1)]),
+             upgrade_info.upgrade_data.data(),
+             packet_size);
+      upgrade_total_size_ += packet_size;
+      parameter_.respone_result = kSuccess;
+      PackagingGeneralMessage(kTerminalGeneralResponse);
+      // 等待所有数据传输完成.
+      if (msg_head.packet_seq == msg_head.total_packet) {
+        upgrade_callback_(upgrade_info.upgrade_type,
+                          upgrade_buffer_.get(),
+                          upgrade_total_size_);
+        upgrade_buffer_.reset();
+        // 暂时直接返回升级结果.
+        parameter_.upgrade_info.upgrade_type = upgrade_info.upgrade_type;
+        parameter_.upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
+        PackagingGeneralMessage(kTerminalUpgradeResultReport);
+      }
+    } else {  // 未分包.
+      parameter_.respone_result = kSuccess;
+      PackagingGeneralMessage(kTerminalGeneralResponse);
+      upgrade_callback_(upgrade_info.upgrade_type,
+                        reinterpret_cast<char const*>(
+                            upgrade_info.upgrade_data.data()),
+                        static_cast<int>(
+                            upgrade_info.upgrade_data.size()));
+      // 暂时直接返回升级结果.
+      parameter_.upgrade_info.upgrade_type = upgrade_info.upgrade_type;
+      parameter_.upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
+      PackagingGeneralMessage(kTerminalUpgradeResultReport);
+    }
+  } else if (msg_id == kPlatformGeneralResponse) {
+    // 接收到平台应答后, 清除进出区域报警标志位.
+    if ((parameter_.parse.respone_msg_id == kLocationReport) &&
+        (parameter_.location_info.alarm.bit.in_out_area == 1)) {
+      parameter_.location_info.alarm.bit.in_out_area = 0;
+    } else if (parameter_.parse.respone_msg_id == kLocationBatchUpload) {
+      OnJournalBatchResponse(parameter_.parse.respone_flow_num);
     }
   }
-  running->store(false);
-  printf("[%s:%d] Send service done.\r\n", server_ip.c_str(), server_port);
 }
 
-void JT808Client::ReceiveHandler(std::atomic_bool *const running) {
-  running->store(true);
-  int ret = -1;
-  std::unique_ptr<char[]> buffer(
-      new char[4096], std::default_delete<char[]>());
+// 连接断开时, 队列中未发送的位置信息汇报转存到日志中, 避免丢失.
+void JT808Client::SpillLocationReportsToJournal(void) {
+  if (!location_journal_.is_open()) return;
   std::vector<uint8_t> msg;
-  std::unique_ptr<char[]> upgrade_buffer;
-  int total_size = 0;
-  int packet_max_size = 0;
-  manual_deal_.store(false);
-  std::string server_ip = ip_;
-  int server_port = port_;
-  while (running->load()) {
-    if (manual_deal_.load()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  std::vector<uint8_t> body;
+  for (auto const& priority : {kSendPriorityAlarm, kSendPriorityRoutine}) {
+    while (send_queue_.Pop(priority, &msg)) {
+      if (ExtractLocationReportBody(msg, &body) == 0) {
+        location_journal_.Append(body);
+      }
+    }
+  }
+  location_journal_.Sync();
+}
+
+// 从日志中依次读取位置信息汇报, 按消息体长度上限组成定位数据批量上传消息.
+// 最多同时有kJournalBatchWindow条消息等待应答.
+void JT808Client::SendJournalBatches(void) {
+  if (!location_journal_.is_open()) return;
+  std::vector<std::vector<uint8_t>> records;
+  while (journal_batches_.size() < kJournalBatchWindow) {
+    // 消息体由数据项个数(2)+位置数据类型(1)+若干数据项组成.
+    auto const num = location_journal_.Peek(journal_inflight_num_, 0xFFFF,
+                                            kJournalBatchMaxBodyLength-3,
+                                            &records);
+    if (num == 0) break;
+    auto& batch = parameter_.location_batch;
+    batch.type = kLocationBatchBlindArea;
+    batch.items.clear();
+    for (auto& record : records) {
+      if (!record.empty()) batch.items.push_back(std::move(record));
+    }
+    JournalBatch journal_batch = {0, num, batch.items.empty()};
+    if (!batch.items.empty()) {
+      std::vector<uint8_t> msg;
+      if (PackagingMessage(kLocationBatchUpload, &msg,
+                           &journal_batch.flow_num) < 0) {
+        break;
+      }
+      send_queue_.Push(kSendPriorityRoutine, std::move(msg));
+    }
+    // 全部为损坏记录时无需等待应答, 前面没有未应答的消息时直接删除.
+    if (journal_batch.acked && journal_batches_.empty()) {
+      location_journal_.Pop(num);
       continue;
     }
-    if ((ret = Recv(client_, buffer.get(), 4096, 0)) > 0) {
-      // TODO(mengyuming@hotmail.com): 需要处理TCP粘包.
-      msg.assign(buffer.get(), buffer.get()+ret);
-      // printf("JT808 Recv[%d]: ", static_cast<int>(msg.size()));
-      // for (auto const& uch : msg) printf("%02X ", uch);
-      // printf("\n");
-      if (JT808FrameParse(parser_, msg, &parameter_) == 0) {
-        auto const& msg_id = parameter_.parse.msg_head.msg_id;
-        if (msg_id == kSetTerminalParameters) {  // 设置终端参数.
-          // 更新终端参数.
-          for (auto const& it : parameter_.parse.terminal_parameters) {
-            if (parameter_.terminal_parameters.find(it.first) !=
-                parameter_.terminal_parameters.end()) {
-              parameter_.terminal_parameters[it.first] = it.second;
-            } else {
-              parameter_.terminal_parameters.insert(it);
-            }
-          }
-          // 应答成功.
-          parameter_.respone_result = kSuccess;
-          PackagingGeneralMessage(kTerminalGeneralResponse);
-          // 调用回调函数.
-          terminal_parameter_callback_();
-        } else if (msg_id == kGetTerminalParameters ||
-                   msg_id == kGetSpecificTerminalParameters) {  // 查询终端参数.
-          auto const& ids = parameter_.parse.terminal_parameter_ids;
-          if (ids.empty()) {  // 返回全部参数.
-            parameter_.terminal_parameter_ids.clear();
-          } else {  // 返回指定参数.
-            parameter_.terminal_parameter_ids.assign(ids.begin(), ids.end());
-          }
-          PackagingGeneralMessage(kGetTerminalParametersResponse);
-        } else if (msg_id == kSetPolygonArea) {  // 设置矩形区域.
-          UpdatePolygonAreaByArea(parameter_.parse.polygon_area);
-          // 应答成功.
-          parameter_.respone_result = kSuccess;
-          PackagingMessage(kTerminalGeneralResponse, &msg);
-          general_msg_.push_back(msg);
-          // 调用回调函数.
-          polygon_area_callback_();
-        } else if (msg_id == kDeletePolygonArea) {  // 删除矩形区域.
-          DeletePolygonAreaByIDs(parameter_.polygon_area_id);
-          // 应答成功.
-          parameter_.respone_result = kSuccess;
-          PackagingGeneralMessage(kTerminalGeneralResponse);
-          // 调用回调函数.
-          polygon_area_callback_();
-        } else if (msg_id == kTerminalUpgrade) {  // 下发终端升级包.
-          // TODO(mengyuming@hotmail.com): 未做分包完整性校验.
-          auto const& upgrade_info = parameter_.parse.upgrade_info;
-          auto const& msg_head =  parameter_.parse.msg_head;
-          auto const& packet_size = upgrade_info.upgrade_data.size();
-          // 检查分包.
-          if (msg_head.msgbody_attr.bit.packet == 1) {  // 分包.
-            // 分配空间.
-            if (msg_head.packet_seq == 1) {  // 第一包.
-              int max_len = msg_head.msgbody_attr.bit.msglen*
-                            msg_head.total_packet;
-                upgrade_buffer = std::move(std::unique_ptr<char[]>(
-                    new char[max_len], std::default_delete<char[]>()));
-              // 子包最大的数据长度.
-              packet_max_size = packet_size;
-              total_size = 0;
-            }
-            memcpy(&(upgrade_buffer[packet_max_size*(msg_head.packet_seq-1)]),
-                   upgrade_info.upgrade_data.data(),
-                   packet_size);
-            total_size += packet_size;
-            parameter_.respone_result = kSuccess;
-            PackagingGeneralMessage(kTerminalGeneralResponse);
-            // 等待所有数据传输完成.
-            if (msg_head.packet_seq == msg_head.total_packet) {
-              upgrade_callback_(upgrade_info.upgrade_type,
-                                upgrade_buffer.get(),
-                                total_size);
-              upgrade_buffer.reset();
-              // 暂时直接返回升级结果.
-              parameter_.upgrade_info.upgrade_type = upgrade_info.upgrade_type;
-              parameter_.upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
-              PackagingGeneralMessage(kTerminalUpgradeResultReport);
-            }
-          } else {  // 未分包.
-            parameter_.respone_result = kSuccess;
-            PackagingGeneralMessage(kTerminalGeneralResponse);
-            upgrade_callback_(upgrade_info.upgrade_type,
-                              reinterpret_cast<char const*>(
-                                  upgrade_info.upgrade_data.data()),
-                              static_cast<int>(
-                                  upgrade_info.upgrade_data.size()));
-            // 暂时直接返回升级结果.
-            parameter_.upgrade_info.upgrade_type = upgrade_info.upgrade_type;
-            parameter_.upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
-            PackagingGeneralMessage(kTerminalUpgradeResultReport);
-          }
-        } else if (msg_id == kPlatformGeneralResponse) {
-          // 接收到平台应答后, 清除进出区域报警标志位.
-          if ((parameter_.parse.respone_msg_id == kLocationReport) &&
-              (parameter_.location_info.alarm.bit.in_out_area == 1)) {
-            parameter_.location_info.alarm.bit.in_out_area = 0;
-          }
-        }
+    journal_batches_.push_back(journal_batch);
+    journal_inflight_num_ += num;
+  }
+}
+
+// 平台已应答的批量上传消息按顺序从日志中删除, 然后继续补报.
+// 无论应答结果如何均视为已处理, 避免平台无法处理的数据阻塞后续补报.
+void JT808Client::OnJournalBatchResponse(uint16_t const& flow_num) {
+  for (auto& batch : journal_batches_) {
+    if (!batch.acked && batch.flow_num == flow_num) {
+      batch.acked = true;
+      break;
+    }
+  }
+  size_t popped = 0;
+  while (!journal_batches_.empty() && journal_batches_.front().acked) {
+    popped += journal_batches_.front().num;
+    journal_inflight_num_ -= journal_batches_.front().num;
+    journal_batches_.pop_front();
+  }
+  if (popped == 0) return;
+  location_journal_.Pop(popped);
+  SendJournalBatches();
+}
+
+#if defined(__linux__)
+// 基于epoll的事件循环.
+// socket读写, eventfd唤醒, timerfd位置上报和心跳定时均由同一线程处理,
+// 空闲时阻塞在epoll_wait上, 不占用CPU.
+void JT808Client::EventLoop(void) {
+  int const epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  int const heartbeat_fd = timerfd_create(CLOCK_MONOTONIC,
+                                          TFD_NONBLOCK | TFD_CLOEXEC);
+  int const report_fd = timerfd_create(CLOCK_MONOTONIC,
+                                       TFD_NONBLOCK | TFD_CLOEXEC);
+  if (epoll_fd < 0 || heartbeat_fd < 0 || report_fd < 0 || wakeup_fd_ < 0) {
+    JT808_LOG_ERROR("%s[%d]: Create event loop failed!!!",
+        __FUNCTION__, __LINE__);
+    if (epoll_fd >= 0) close(epoll_fd);
+    if (heartbeat_fd >= 0) close(heartbeat_fd);
+    if (report_fd >= 0) close(report_fd);
+    return;
+  }
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = wakeup_fd_;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd_, &ev);
+  ev.data.fd = heartbeat_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, heartbeat_fd, &ev);
+  ev.data.fd = report_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, report_fd, &ev);
+  uint32_t socket_events = EPOLLIN;
+  ev.events = socket_events;
+  ev.data.fd = client_;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_, &ev);
+  // 心跳定时器为单次定时, 每次超时后根据最后发送时间重新设定.
+  int64_t const heartbeat_intv = HeartbeatIntervalMsec();
+  SetTimer(heartbeat_fd, heartbeat_intv, 0);
+  // 位置上报定时器为周期定时, 保证上报节拍不受处理耗时影响.
+  int64_t const report_intv =
+      static_cast<int64_t>(location_report_inteval_)*1000;
+  if (report_intv > 0) SetTimer(report_fd, report_intv, report_intv);
+  struct epoll_event events[8];
+  bool error = false;
+  bool socket_added = true;
+  while (service_is_running_.load() && !error) {
+    // 等待停止时发送完缓存消息或超时后退出.
+    int64_t const stop_remain = WaitingStopRemainMsec();
+    if (stop_remain == 0) break;
+    // 手动收发期间从epoll中移除socket, 结束后重新加入.
+    // EPOLLHUP和EPOLLERR无法屏蔽, 仅清除关注事件时对端关闭会使epoll_wait
+    // 持续返回.
+    // 请求手动收发时若有消息只发送了一部分, 先只等待可写将其发送完.
+    bool const manual_requested = manual_deal_.load();
+    bool const manual = manual_requested && !SendingPartialFrame();
+    if (manual) {
+      if (socket_added) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_, &ev);
+        socket_added = false;
       }
-    } else if (ret == 0) {
-      printf("[%s:%d] Disconnect !!!\n", server_ip.c_str(), server_port);
-      service_is_running_.store(false);
-      return;
     } else {
-      if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        continue;
-      } else {
-        printf("[%s:%d] Remote socket error!!!\n",
-            server_ip.c_str(), server_port);
-        service_is_running_.store(false);
-        return;
+      uint32_t wanted = EPOLLIN;
+      if (manual_requested) {
+        wanted = EPOLLOUT;
+      } else if (!sending_msg_.empty() || !send_queue_.empty()) {
+        wanted |= EPOLLOUT;
+      }
+      if (!socket_added || wanted != socket_events) {
+        socket_events = wanted;
+        ev.events = socket_events;
+        ev.data.fd = client_;
+        epoll_ctl(epoll_fd, socket_added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                  client_, &ev);
+        socket_added = true;
+      }
+    }
+    UpdateManualDealAck(manual);
+    int const cnt = epoll_wait(epoll_fd, events,
+                               sizeof(events)/sizeof(events[0]),
+                               static_cast<int>(stop_remain));
+    if (cnt < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    for (int i = 0; i < cnt && !error; ++i) {
+      int const fd = events[i].data.fd;
+      if (fd == wakeup_fd_) {
+        DrainFd(wakeup_fd_);
+      } else if (fd == heartbeat_fd) {
+        DrainFd(heartbeat_fd);
+        SetTimer(heartbeat_fd, OnHeartbeatTimeout(heartbeat_intv), 0);
+      } else if (fd == report_fd) {
+        DrainFd(report_fd);
+        OnReportTimeout();
+      } else if (fd == client_) {
+        if (manual_deal_.load()) continue;
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+          if (ReceiveAvailable() < 0) error = true;
+        }
+      }
+    }
+    if (error) break;
+    CheckImmediateReport();
+    if (SendPending() < 0) {
+      JT808_LOG_ERROR_EVERY_MS(1000, "[%s:%d] Send data failed !!!",
+          ip_.c_str(), port_);
+      break;
+    }
+  }
+  close(report_fd);
+  close(heartbeat_fd);
+  close(epoll_fd);
+}
+#elif defined(_WIN32)
+// 基于select的事件循环.
+// Windows下没有eventfd和timerfd, 根据最近的定时时刻计算select超时时间,
+// 其它线程产生的消息最迟在50ms内被发送.
+void JT808Client::EventLoop(void) {
+  using Clock = std::chrono::steady_clock;
+  int64_t const heartbeat_intv = HeartbeatIntervalMsec();
+  int64_t const report_intv =
+      static_cast<int64_t>(location_report_inteval_)*1000;
+  auto heartbeat_tp = Clock::now() + std::chrono::milliseconds(heartbeat_intv);
+  auto report_tp = Clock::now() + std::chrono::milliseconds(report_intv);
+  while (service_is_running_.load()) {
+    // 等待停止时发送完缓存消息或超时后退出.
+    if (WaitingStopRemainMsec() == 0) break;
+    // 请求手动收发时若有消息只发送了一部分, 先将其发送完.
+    bool const manual_requested = manual_deal_.load();
+    bool const manual = manual_requested && !SendingPartialFrame();
+    UpdateManualDealAck(manual);
+    auto now = Clock::now();
+    auto next_tp = heartbeat_tp;
+    if (report_intv > 0 && report_tp < next_tp) next_tp = report_tp;
+    int64_t timeout_ms = std::chrono::duration_cast<
+        std::chrono::milliseconds>(next_tp - now).count();
+    if (timeout_ms < 0) timeout_ms = 0;
+    if (timeout_ms > 50) timeout_ms = 50;
+    fd_set rfds;
+    fd_set wfds;
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
+    if (!manual) {
+      if (!manual_requested) FD_SET(client_, &rfds);
+      if (manual_requested || !sending_msg_.empty() || !send_queue_.empty()) {
+        FD_SET(client_, &wfds);
       }
     }
+    struct timeval tv = {static_cast<long>(timeout_ms/1000),
+                         static_cast<long>((timeout_ms%1000)*1000)};
+    if (manual) {
+      Sleep(static_cast<DWORD>(timeout_ms));
+    } else if (select(0, &rfds, &wfds, nullptr, &tv) == SOCKET_ERROR) {
+      break;
+    }
+    if (!manual_deal_.load() && FD_ISSET(client_, &rfds)) {
+      if (ReceiveAvailable() < 0) break;
+    }
+    now = Clock::now();
+    if (now >= heartbeat_tp) {
+      heartbeat_tp = now + std::chrono::milliseconds(
+          OnHeartbeatTimeout(heartbeat_intv));
+    }
+    if (report_intv > 0 && now >= report_tp) {
+      report_tp += std::chrono::milliseconds(report_intv);
+      OnReportTimeout();
+    }
+    CheckImmediateReport();
+    if (SendPending() < 0) {
+      JT808_LOG_ERROR_EVERY_MS(1000, "[%s:%d] Send data failed !!!",
+          ip_.c_str(), port_);
+      break;
+    }
   }
-  running->store(false);
-  printf("[%s:%d] Receive service done.\r\n", server_ip.c_str(), server_port);
 }
+#endif
 
 }  // namespace libjt808
@@ -0,0 +1,53 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  codec_registry.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 10:12:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/codec_registry.h"
+
+
+namespace libjt808 {
+
+std::shared_ptr<Parser const> DefaultParser(void) {
+  static std::shared_ptr<Parser const> const parser = [] {
+    auto parser = std::make_shared<Parser>();
+    JT808FrameParserInit(parser.get());
+    return parser;
+  }();
+  return parser;
+}
+
+std::shared_ptr<Packager const> DefaultPackager(void) {
+  static std::shared_ptr<Packager const> const packager = [] {
+    auto packager = std::make_shared<Packager>();
+    JT808FramePackagerInit(packager.get());
+    return packager;
+  }();
+  return packager;
+}
+
+}  // namespace libjt808
@@ -0,0 +1,306 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  driving_alarm.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 03:41:18
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/driving_alarm.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+
+namespace libjt808 {
+
+namespace {
+
+constexpr int64_t kSecondsPerDay = 24*3600;
+// 当天按GMT+8划分.
+constexpr int64_t kTimeZoneOffset = 8*3600;
+// 默认行驶判定速度, 单位1/10km/h.
+constexpr uint16_t kDefaultMovingSpeed = 50;
+
+// 累加秒数, 超过范围时取最大值.
+void AddSeconds(int64_t const& seconds, uint32_t* total) {
+  *total = static_cast<uint32_t>(
+      std::min<int64_t>(static_cast<int64_t>(*total)+seconds, UINT32_MAX));
+}
+
+}  // namespace
+
+int GetDrivingAlarmConfig(TerminalParameters const& items,
+                          DrivingAlarmConfig* config) {
+  if (config == nullptr) return -1;
+  memset(config, 0, sizeof(*config));
+  GetTerminalParameter(items, kMaxSpeed, &config->max_speed);
+  GetTerminalParameter(items, kOverspeedDuration,
+                       &config->overspeed_duration);
+  GetTerminalParameter(items, kContinuousDrivingTimeThreshold,
+                       &config->continuous_driving_time);
+  GetTerminalParameter(items, kCumulativeDrivingTimeThreshold,
+                       &config->daily_driving_time);
+  GetTerminalParameter(items, kMinimumRestTime, &config->min_rest_time);
+  GetTerminalParameter(items, kMaximumParkingTime, &config->max_parking_time);
+  GetTerminalParameter(items, kOverspeedWarningDifference,
+                       &config->overspeed_warning_diff);
+  GetTerminalParameter(items, kFatigueDrivingWarningDifference,
+                       &config->fatigue_warning_diff);
+  return 0;
+}
+
+void SetDrivingAlarmItems(uint32_t const& driving_alarm, AlarmBit* alarm,
+                          LocationExtensions* items) {
+  if (alarm == nullptr) return;
+  alarm->value = (alarm->value & ~kDrivingAlarmMask) |
+                 (driving_alarm & kDrivingAlarmMask);
+  if (items == nullptr) return;
+  auto const& it = items->find(kOverSpeedAlarm);
+  if (alarm->bit.overspeed) {
+    if (it != items->end()) return;  // 已有区域或路段超速附加项.
+    std::vector<uint8_t> value;
+    SetOverSpeedAlarmBody(kOverSpeedAlarmNoSpecificLocation, 0, &value);
+    items->insert(std::make_pair(kOverSpeedAlarm, value));
+  } else if (it != items->end() && it->second.size() == 1 &&
+             it->second[0] == kOverSpeedAlarmNoSpecificLocation) {
+    items->erase(it);
+  }
+}
+
+void SetSectionDrivingTimeItems(SectionDrivingTimeAlarm const* section_alarm,
+                                AlarmBit* alarm, LocationExtensions* items) {
+  if (alarm == nullptr) return;
+  alarm->bit.road_drive_time = (section_alarm != nullptr) ? 1 : 0;
+  if (items == nullptr) return;
+  if (section_alarm == nullptr) {
+    items->erase(kDrivingTimeAlarm);
+    return;
+  }
+  std::vector<uint8_t> value;
+  SetDrivingTimeAlarmBody(section_alarm->segment_id,
+                          section_alarm->driving_time,
+                          section_alarm->result, &value);
+  (*items)[kDrivingTimeAlarm] = value;
+}
+
+constexpr int64_t DrivingAlarmTracker::kMaxRecordGap;
+
+void DrivingAlarmTracker::Reset(void) {
+  last_time_ = -1;
+  overspeed_since_ = -1;
+  day_ = 0;
+  continuous_time_ = 0;
+  daily_time_ = 0;
+  parking_time_ = 0;
+  alarm_ = 0;
+  moving_ = false;
+  section_since_ = -1;
+  section_last_time_ = -1;
+  section_route_id_ = 0;
+  section_segment_id_ = 0;
+  section_point_index_ = 0;
+  section_max_time_ = 0;
+  section_min_time_ = 0;
+}
+
+uint32_t DrivingAlarmTracker::Update(DrivingAlarmConfig const& config,
+                                     int64_t const& timestamp,
+                                     uint16_t const& speed,
+                                     uint32_t const& status) {
+  if (timestamp <= 0 || timestamp < last_time_) return 0;
+  uint16_t const moving_speed =
+      (config.moving_speed > 0) ? config.moving_speed : kDefaultMovingSpeed;
+  bool const moving = (speed >= moving_speed);
+  int32_t const day =
+      static_cast<int32_t>((timestamp+kTimeZoneOffset)/kSecondsPerDay);
+  if (last_time_ >= 0) {
+    int64_t const elapsed = timestamp-last_time_;
+    // 跨天时只计入当天部分.
+    int64_t today = elapsed;
+    if (day != day_) {
+      daily_time_ = 0;
+      today = std::min(elapsed, (timestamp+kTimeZoneOffset)%kSecondsPerDay);
+    }
+    if (moving_ && elapsed <= kMaxRecordGap) {
+      AddSeconds(elapsed, &continuous_time_);
+      AddSeconds(today, &daily_time_);
+    } else {
+      AddSeconds(elapsed, &parking_time_);
+      if (parking_time_ >= config.min_rest_time) continuous_time_ = 0;
+    }
+  }
+  if (moving) parking_time_ = 0;
+  last_time_ = timestamp;
+  day_ = day;
+  moving_ = moving;
+
+  AlarmBit alarm;
+  alarm.value = 0;
+  uint32_t const speed_limit = config.max_speed*10;
+  if (config.max_speed > 0 && speed > speed_limit) {
+    if (overspeed_since_ < 0) overspeed_since_ = timestamp;
+    if (timestamp-overspeed_since_ >= config.overspeed_duration) {
+      alarm.bit.overspeed = 1;
+    }
+  } else {
+    overspeed_since_ = -1;
+  }
+  if (config.max_speed > 0 && !alarm.bit.overspeed &&
+      config.overspeed_warning_diff > 0 &&
+      static_cast<uint32_t>(speed)+config.overspeed_warning_diff >
+          speed_limit) {
+    alarm.bit.early_warning = 1;
+  }
+  uint32_t const fatigue_time = config.continuous_driving_time;
+  if (fatigue_time > 0) {
+    if (continuous_time_ >= fatigue_time) {
+      alarm.bit.fatigue = 1;
+    } else if (config.fatigue_warning_diff > 0 &&
+               static_cast<uint64_t>(continuous_time_) +
+                   config.fatigue_warning_diff >= fatigue_time) {
+      alarm.bit.early_warning = 1;
+    }
+  }
+  if (config.daily_driving_time > 0 &&
+      daily_time_ >= config.daily_driving_time) {
+    alarm.bit.day_drive_overtime = 1;
+  }
+  StatusBit status_bit;
+  status_bit.value = status;
+  if (config.max_parking_time > 0 && !moving && status_bit.bit.acc &&
+      parking_time_ >= config.max_parking_time) {
+    alarm.bit.stop_driving_overtime = 1;
+  }
+  uint32_t const changed = alarm.value ^ alarm_;
+  alarm_ = alarm.value;
+  return changed;
+}
+
+// 路段行驶时间为从驶入路段的第一条定位到驶离路段的第一条定位的时间.
+bool DrivingAlarmTracker::UpdateSection(
+    int64_t const& timestamp, RouteMatch const* match,
+    RouteInflectionPoint const* point,
+    SectionDrivingTimeAlarm* section_alarm) {
+  if (timestamp <= 0 || timestamp < section_last_time_) return false;
+  section_last_time_ = timestamp;
+  bool const in_section = section_since_ >= 0;
+  if (in_section && match != nullptr &&
+      match->route_id == section_route_id_ &&
+      match->point_index == section_point_index_) {
+    return false;
+  }
+  bool alarmed = false;
+  if (in_section &&
+      (match == nullptr || match->route_id == section_route_id_)) {
+    int64_t const elapsed = timestamp-section_since_;
+    if ((section_max_time_ > 0 && elapsed > section_max_time_) ||
+        (section_min_time_ > 0 && elapsed < section_min_time_)) {
+      alarmed = true;
+      if (section_alarm != nullptr) {
+        section_alarm->segment_id = section_segment_id_;
+        section_alarm->driving_time =
+            static_cast<uint16_t>(std::min<int64_t>(elapsed, UINT16_MAX));
+        section_alarm->result = (elapsed > section_max_time_ &&
+                                 section_max_time_ > 0) ?
+            kSectionDrivingTimeLong : kSectionDrivingTimeShort;
+      }
+    }
+  }
+  if (match == nullptr) {
+    section_since_ = -1;
+    return alarmed;
+  }
+  section_since_ = timestamp;
+  section_route_id_ = match->route_id;
+  section_segment_id_ = match->segment_id;
+  section_point_index_ = match->point_index;
+  section_max_time_ = 0;
+  section_min_time_ = 0;
+  if (point != nullptr && point->segment_attribute.bit.driving_time) {
+    section_max_time_ = point->max_driving_time;
+    section_min_time_ = point->min_driving_time;
+  }
+  return alarmed;
+}
+
+FleetDrivingAlarm::FleetDrivingAlarm() {
+  memset(&config_, 0, sizeof(config_));
+}
+
+void FleetDrivingAlarm::set_config(DrivingAlarmConfig const& config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  config_ = config;
+}
+
+DrivingAlarmConfig FleetDrivingAlarm::config(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return config_;
+}
+
+void FleetDrivingAlarm::RemoveTerminal(std::string const& phone_num) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  terminals_.erase(phone_num);
+}
+
+void FleetDrivingAlarm::ClearTerminals(void) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  terminals_.clear();
+}
+
+size_t FleetDrivingAlarm::terminal_num(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return terminals_.size();
+}
+
+// 整批记录只加锁一次, 门限修改在批次之间生效.
+int FleetDrivingAlarm::Evaluate(LocationRecord const* records,
+                                size_t const& num,
+                                std::vector<DrivingAlarmEvent>* events) {
+  if ((records == nullptr && num > 0) || events == nullptr) return -1;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < num; ++i) {
+    auto const& record = records[i];
+    phone_num_.assign(record.phone_num,
+                      strnlen(record.phone_num, sizeof(record.phone_num)));
+    auto& tracker = terminals_[phone_num_];
+    uint32_t const changed = tracker.Update(config_, record.timestamp,
+                                            record.speed, record.status);
+    if (changed == 0) continue;
+    DrivingAlarmEvent event;
+    event.session = record.session;
+    event.timestamp = record.timestamp;
+    memcpy(event.phone_num, record.phone_num, sizeof(event.phone_num));
+    event.alarm = tracker.alarm();
+    event.changed = changed;
+    event.continuous_driving_time = tracker.continuous_driving_time();
+    event.daily_driving_time = tracker.daily_driving_time();
+    event.speed = record.speed;
+    events->push_back(event);
+  }
+  return 0;
+}
+
+}  // namespace libjt808
@@ -0,0 +1,159 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  fleet_geofence.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 00:41:27
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/fleet_geofence.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "jt808/location_report.h"
+
+
+namespace libjt808 {
+
+constexpr size_t FleetGeofence::kShardNum;
+
+FleetGeofence::FleetGeofence(double const& cell_size)
+    : cell_size_(cell_size),
+      index_(std::make_shared<GeofenceIndex>(cell_size)) {
+}
+
+template<typename Modifier>
+void FleetGeofence::ModifyIndex(Modifier const& modifier) {
+  std::lock_guard<std::mutex> update_lock(update_mutex_);
+  auto new_index = std::make_shared<GeofenceIndex>(*index());
+  modifier(new_index.get());
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  index_ = new_index;
+}
+
+void FleetGeofence::SetAreas(PolygonAreaSet const& areas) {
+  auto new_index = std::make_shared<GeofenceIndex>(cell_size_);
+  new_index->Build(areas);
+  std::lock_guard<std::mutex> update_lock(update_mutex_);
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  index_ = new_index;
+}
+
+void FleetGeofence::UpdateAreas(PolygonAreaSet const& areas) {
+  ModifyIndex([&areas] (GeofenceIndex* index) {
+    for (auto const& item : areas) index->Insert(item.second);
+  });
+}
+
+void FleetGeofence::RemoveAreas(std::vector<uint32_t> const& area_ids) {
+  ModifyIndex([&area_ids] (GeofenceIndex* index) {
+    for (auto const& id : area_ids) index->Remove(id);
+  });
+}
+
+size_t FleetGeofence::area_num(void) const {
+  return index()->size();
+}
+
+void FleetGeofence::RemoveTerminal(std::string const& phone_num) {
+  auto& shard = shards_[std::hash<std::string>()(phone_num) % kShardNum];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.terminals.erase(phone_num);
+}
+
+void FleetGeofence::ClearTerminals(void) {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.terminals.clear();
+  }
+}
+
+size_t FleetGeofence::terminal_num(void) const {
+  size_t num = 0;
+  for (auto const& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    num += shard.terminals.size();
+  }
+  return num;
+}
+
+// 终端首次进入区域时才保存状态, 从未进入过区域的终端不占用内存;
+// 离开区域后保留状态, 避免终端在区域边界附近反复进出时频繁申请释放.
+int FleetGeofence::Evaluate(LocationRecord const* records, size_t const& num,
+                            std::vector<GeofenceEvent>* events) {
+  if ((records == nullptr && num > 0) || events == nullptr) return -1;
+  auto const current = index();
+  // 每个线程复用查询结果和手机号缓存.
+  static thread_local std::vector<uint32_t> inside;
+  static thread_local std::string phone_num;
+  for (size_t i = 0; i < num; ++i) {
+    auto const& record = records[i];
+    current->Query(MakeGeoPoint(record.longitude, record.latitude), &inside);
+    phone_num.assign(record.phone_num,
+                     strnlen(record.phone_num, sizeof(record.phone_num)));
+    auto& shard = shards_[std::hash<std::string>()(phone_num) % kShardNum];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.terminals.find(phone_num);
+    if (it == shard.terminals.end()) {
+      if (inside.empty()) continue;
+      it = shard.terminals.insert(std::make_pair(phone_num, AreaIds())).first;
+    }
+    Transition(*current, record, inside, &it->second, events);
+  }
+  return 0;
+}
+
+void FleetGeofence::Transition(GeofenceIndex const& index,
+                               LocationRecord const& record,
+                               std::vector<uint32_t> const& inside,
+                               AreaIds* state,
+                               std::vector<GeofenceEvent>* events) const {
+  GeofenceEvent event;
+  event.session = record.session;
+  event.timestamp = record.timestamp;
+  memcpy(event.phone_num, record.phone_num, sizeof(event.phone_num));
+  event.latitude = record.latitude;
+  event.longitude = record.longitude;
+  // 之前在区域内而现在不在, 区域已被删除的不产生事件.
+  event.direction = kAccessAreaAlarmOutArea;
+  for (auto const& id : *state) {
+    if (!std::binary_search(inside.begin(), inside.end(), id) &&
+        index.HasArea(id)) {
+      event.area_id = id;
+      events->push_back(event);
+    }
+  }
+  event.direction = kAccessAreaAlarmInArea;
+  for (auto const& id : inside) {
+    if (!std::binary_search(state->begin(), state->end(), id)) {
+      event.area_id = id;
+      events->push_back(event);
+    }
+  }
+  state->assign(inside.begin(), inside.end());
+}
+
+}  // namespace libjt808
@@ -0,0 +1,87 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  frame_assembler.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 11:12:48
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/frame_assembler.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "jt808/protocol_parameter.h"
+
+
+namespace libjt808 {
+
+void FrameAssembler::Append(uint8_t const* data, size_t const& len) {
+  if (data == nullptr || len == 0) return;
+  // 已处理的数据超过一半时整体前移, 避免缓存无限增长.
+  if (read_pos_ > 0 && read_pos_ >= buffer_.size()/2) {
+    buffer_.erase(buffer_.begin(), buffer_.begin()+read_pos_);
+    read_pos_ = 0;
+  }
+  buffer_.insert(buffer_.end(), data, data+len);
+}
+
+bool FrameAssembler::Next(std::vector<uint8_t>* frame) {
+  if (frame == nullptr) return false;
+  while (read_pos_ < buffer_.size()) {
+    auto const begin = buffer_.begin()+read_pos_;
+    // 查找起始标识位, 之前的数据均为无效数据.
+    auto head = std::find(begin, buffer_.end(), PROTOCOL_SIGN);
+    if (head == buffer_.end()) {
+      buffer_.clear();
+      read_pos_ = 0;
+      return false;
+    }
+    read_pos_ = head - buffer_.begin();
+    // 查找结束标识位.
+    auto tail = std::find(head+1, buffer_.end(), PROTOCOL_SIGN);
+    if (tail == buffer_.end()) {
+      // 数据不完整, 超长时丢弃并等待下一个标识位.
+      if (pending() > max_frame_size_) {
+        buffer_.clear();
+        read_pos_ = 0;
+      }
+      return false;
+    }
+    // 连续的两个标识位, 前一个可能是上一帧残留的结束标识位, 以后一个重新同步.
+    if (tail == head+1) {
+      ++read_pos_;
+      continue;
+    }
+    size_t const len = tail - head + 1;
+    read_pos_ += len;
+    if (len > max_frame_size_) continue;
+    frame->assign(head, tail+1);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace libjt808
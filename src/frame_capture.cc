@@ -0,0 +1,299 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  frame_capture.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 05:08:31
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/frame_capture.h"
+
+#include <string.h>
+
+#include <chrono>
+
+#include "jt808/logger.h"
+
+
+namespace libjt808 {
+
+namespace {
+
+constexpr uint32_t kCaptureMagic = 0x43463838;  // "88FC".
+constexpr uint16_t kCaptureVersion = 1;
+// 记录头的最大长度: 类型和3个varint.
+constexpr size_t kMaxRecordHeader = 1+3*10;
+// 缓存达到该大小时立即唤醒后台线程写入, 否则每100ms写入一次.
+constexpr size_t kWriteThreshold = 256*1024;
+// 读取缓存大小.
+constexpr size_t kReadBufferSize = 256*1024;
+
+// 抓包文件头, 固定16字节.
+struct FileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  int64_t start_time_us;  // 开始抓包的时间, 系统时间, 单位微秒(us).
+};
+
+inline int64_t NowUs(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t ZigZagEncode(int64_t const& value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t ZigZagDecode(uint64_t const& value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void WriteVarint(uint64_t value, std::vector<uint8_t>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+// 读取varint, 数据不完整或超过10字节时返回nullptr.
+inline uint8_t const* ReadVarint(uint8_t const* pos, uint8_t const* end,
+                                 uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+    uint8_t const byte = *pos++;
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return pos;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+FrameCaptureWriter::FrameCaptureWriter(size_t const& max_buffer_bytes)
+    : max_buffer_bytes_(max_buffer_bytes), last_time_us_(0),
+      stopping_(false), file_(nullptr) {
+  open_.store(false);
+  records_.store(0);
+  dropped_.store(0);
+}
+
+FrameCaptureWriter::~FrameCaptureWriter() {
+  Close();
+}
+
+int FrameCaptureWriter::Open(std::string const& path) {
+  if (open_.load()) return -1;
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return -1;
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kCaptureMagic;
+  header.version = kCaptureVersion;
+  header.start_time_us = NowUs();
+  if (fwrite(&header, sizeof(header), 1, file) != 1 || fflush(file) != 0) {
+    fclose(file);
+    return -1;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.clear();
+    buffer_.reserve(kWriteThreshold);
+    last_time_us_ = header.start_time_us;
+    stopping_ = false;
+  }
+  file_ = file;
+  writer_thread_ = std::thread(&FrameCaptureWriter::WriterHandler, this);
+  open_.store(true);
+  return 0;
+}
+
+void FrameCaptureWriter::Close(void) {
+  if (!open_.load()) return;
+  open_.store(false);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cond_.notify_one();
+  if (writer_thread_.joinable()) writer_thread_.join();
+  fclose(file_);
+  file_ = nullptr;
+}
+
+void FrameCaptureWriter::WriteAccept(uint64_t const& session) {
+  Append(kFrameCaptureAccept, session, nullptr, 0);
+}
+
+void FrameCaptureWriter::WriteData(uint64_t const& session,
+                                   uint8_t const* data, size_t const& len) {
+  if (data == nullptr || len == 0) return;
+  Append(kFrameCaptureData, session, data, len);
+}
+
+// 时间在加锁后获取, 文件中的记录按时间顺序排列.
+void FrameCaptureWriter::Append(uint8_t const& type, uint64_t const& session,
+                                uint8_t const* data, size_t const& len) {
+  if (!open_.load(std::memory_order_relaxed)) return;
+  if (len > kMaxFrameCaptureData) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) return;
+    if (buffer_.size()+kMaxRecordHeader+len > max_buffer_bytes_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    size_t const size = buffer_.size();
+    int64_t const now = NowUs();
+    buffer_.push_back(type);
+    WriteVarint(ZigZagEncode(now-last_time_us_), &buffer_);
+    WriteVarint(session, &buffer_);
+    WriteVarint(len, &buffer_);
+    if (len > 0) buffer_.insert(buffer_.end(), data, data+len);
+    last_time_us_ = now;
+    notify = (size < kWriteThreshold && buffer_.size() >= kWriteThreshold);
+  }
+  records_.fetch_add(1, std::memory_order_relaxed);
+  if (notify) cond_.notify_one();
+}
+
+// 交换前后台缓存后在锁外写文件, 停止时写完剩余记录后退出.
+void FrameCaptureWriter::WriterHandler(void) {
+  std::vector<uint8_t> writing;
+  writing.reserve(kWriteThreshold);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (1) {
+    if (!stopping_ && buffer_.size() < kWriteThreshold) {
+      cond_.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    bool const stopping = stopping_;
+    writing.swap(buffer_);
+    lock.unlock();
+    if (!writing.empty()) {
+      if (fwrite(writing.data(), 1, writing.size(), file_) != writing.size() ||
+          fflush(file_) != 0) {
+        JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Write capture file failed !!!",
+            __FUNCTION__, __LINE__);
+      }
+      writing.clear();
+    }
+    if (stopping) break;
+    lock.lock();
+  }
+}
+
+FrameCaptureReader::FrameCaptureReader()
+    : file_(nullptr), pos_(0), end_(0), start_time_us_(0), time_us_(0) {
+}
+
+FrameCaptureReader::~FrameCaptureReader() {
+  Close();
+}
+
+int FrameCaptureReader::Open(std::string const& path) {
+  Close();
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return -1;
+  FileHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      header.magic != kCaptureMagic || header.version != kCaptureVersion) {
+    fclose(file);
+    return -1;
+  }
+  file_ = file;
+  buffer_.resize(kReadBufferSize);
+  pos_ = 0;
+  end_ = 0;
+  start_time_us_ = header.start_time_us;
+  time_us_ = header.start_time_us;
+  return 0;
+}
+
+void FrameCaptureReader::Close(void) {
+  if (file_ == nullptr) return;
+  fclose(file_);
+  file_ = nullptr;
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+}
+
+int FrameCaptureReader::Next(FrameCaptureRecord* record) {
+  if (file_ == nullptr || record == nullptr) return -1;
+  size_t const avail = Fill(kMaxRecordHeader);
+  if (avail == 0) return 0;
+  uint8_t const* const start = buffer_.data()+pos_;
+  uint8_t const* const end = start+avail;
+  uint8_t const type = *start;
+  if (type != kFrameCaptureAccept && type != kFrameCaptureData) return -1;
+  uint64_t delta = 0;
+  uint64_t session = 0;
+  uint64_t len = 0;
+  uint8_t const* pos = start+1;
+  if ((pos = ReadVarint(pos, end, &delta)) == nullptr ||
+      (pos = ReadVarint(pos, end, &session)) == nullptr ||
+      (pos = ReadVarint(pos, end, &len)) == nullptr) {
+    // 缓存不足一个最大记录头时已读到文件末尾, 为不完整的记录.
+    return (avail < kMaxRecordHeader) ? 0 : -1;
+  }
+  if (len > kMaxFrameCaptureData) return -1;
+  size_t const header_size = static_cast<size_t>(pos-start);
+  size_t const record_size = header_size+static_cast<size_t>(len);
+  if (Fill(record_size) < record_size) return 0;
+  time_us_ += ZigZagDecode(delta);
+  record->time_us = time_us_;
+  record->session = session;
+  record->type = type;
+  uint8_t const* data = buffer_.data()+pos_+header_size;
+  record->data.assign(data, data+len);
+  pos_ += record_size;
+  return 1;
+}
+
+size_t FrameCaptureReader::Fill(size_t const& need) {
+  if (end_-pos_ >= need) return end_-pos_;
+  if (pos_ > 0) {
+    memmove(buffer_.data(), buffer_.data()+pos_, end_-pos_);
+    end_ -= pos_;
+    pos_ = 0;
+  }
+  if (buffer_.size() < need) buffer_.resize(need);
+  while (end_ < need) {
+    size_t const ret = fread(buffer_.data()+end_, 1, buffer_.size()-end_,
+                             file_);
+    if (ret == 0) break;
+    end_ += ret;
+  }
+  return end_;
+}
+
+}  // namespace libjt808
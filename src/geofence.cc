@@ -0,0 +1,431 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  geofence.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 00:15:06
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/geofence.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+
+#include "jt808/bcd.h"
+
+
+namespace libjt808 {
+
+namespace {
+
+constexpr int64_t kSecondsPerDay = 24*3600;
+// 协议时间为GMT+8.
+constexpr int64_t kTimeZoneOffset = 8*3600;
+
+// 所有索引共用的修改版本计数.
+std::atomic<uint64_t> version_counter(0);
+
+// 解析区域的起止时间, 年月日为0时返回当天的秒数.
+bool ParseAreaTime(std::string const& time, bool const& daily,
+                   int64_t* value) {
+  if (time.size() != 12) return false;
+  if (!daily) return TimeStringToTimestamp(time, value) == 0;
+  int fields[3];
+  for (int i = 0; i < 3; ++i) {
+    int const high = time[6+i*2]-'0';
+    int const low = time[7+i*2]-'0';
+    if (high < 0 || high > 9 || low < 0 || low > 9) return false;
+    fields[i] = high*10+low;
+  }
+  if (fields[0] > 23 || fields[1] > 59 || fields[2] > 59) return false;
+  *value = fields[0]*3600 + fields[1]*60 + fields[2];
+  return true;
+}
+
+}  // namespace
+
+void MakeAreaRule(AreaAttribute const& attribute,
+                  std::string const& start_time,
+                  std::string const& stop_time,
+                  uint16_t const& max_speed,
+                  uint8_t const& overspeed_time,
+                  AreaRule* rule) {
+  if (rule == nullptr) return;
+  rule->attribute = attribute;
+  rule->start_time = 0;
+  rule->stop_time = 0;
+  rule->daily = false;
+  rule->max_speed = attribute.bit.speed_limit ? max_speed : 0;
+  rule->overspeed_time = attribute.bit.speed_limit ? overspeed_time : 0;
+  if (!attribute.bit.by_time) return;
+  rule->daily = start_time.compare(0, 6, "000000") == 0 &&
+                stop_time.compare(0, 6, "000000") == 0;
+  if (!ParseAreaTime(start_time, rule->daily, &rule->start_time) ||
+      !ParseAreaTime(stop_time, rule->daily, &rule->stop_time)) {
+    rule->attribute.bit.by_time = 0;
+  }
+}
+
+bool IsAreaActive(AreaRule const& rule, int64_t const& timestamp) {
+  if (!rule.attribute.bit.by_time) return true;
+  if (!rule.daily) {
+    return timestamp >= rule.start_time && timestamp <= rule.stop_time;
+  }
+  int64_t seconds = (timestamp+kTimeZoneOffset) % kSecondsPerDay;
+  if (seconds < 0) seconds += kSecondsPerDay;
+  if (rule.start_time <= rule.stop_time) {
+    return seconds >= rule.start_time && seconds <= rule.stop_time;
+  }
+  return seconds >= rule.start_time || seconds <= rule.stop_time;
+}
+
+// 逐个顶点转换为定点坐标后按整数判断, 不申请内存.
+bool IsPointInsidePolygon(LocationPoint const& point,
+                          std::vector<LocationPoint> const& vertices) {
+  auto const count = vertices.size();
+  if (count < 3) return false;
+  GeoPoint const check_point = ToGeoPoint(point);
+  bool inside = false;
+  GeoPoint point2 = ToGeoPoint(vertices[count-1]);
+  for (size_t i = 0; i < count; ++i) {
+    GeoPoint const point1 = ToGeoPoint(vertices[i]);
+    if ((point1.latitude > check_point.latitude) !=
+        (point2.latitude > check_point.latitude)) {
+      auto const& lower =
+          (point1.latitude < point2.latitude) ? point1 : point2;
+      auto const& upper =
+          (point1.latitude < point2.latitude) ? point2 : point1;
+      if (Cross(lower, upper, check_point) > 0) inside = !inside;
+    }
+    point2 = point1;
+  }
+  return inside;
+}
+
+constexpr size_t PreparedPolygon::kGroupSize;
+constexpr size_t PreparedPolygon::kFieldNum;
+
+void PreparedPolygon::Reset(std::vector<LocationPoint> const& vertices) {
+  static thread_local std::vector<GeoPoint> points;
+  ToGeoPoints(vertices, &points);
+  Reset(points);
+}
+
+void PreparedPolygon::Reset(std::vector<GeoPoint> const& vertices) {
+  edge_num_ = 0;
+  box_ = GeoBox();
+  edges_.clear();
+  auto const count = vertices.size();
+  if (count < 3) return;
+  GetBoundingBox(vertices, &box_);
+  for (size_t i = 0, j = count-1; i < count; j = i++) {
+    if (vertices[i].latitude != vertices[j].latitude) ++edge_num_;
+  }
+  size_t const group_num = (edge_num_+kGroupSize-1)/kGroupSize;
+  edges_.resize(group_num*kGroupSize*kFieldNum, 0);
+  // 空边的纬度范围为空, 不会与任何射线相交.
+  for (size_t group = 0; group < group_num; ++group) {
+    int32_t* fields = &edges_[group*kGroupSize*kFieldNum];
+    for (size_t k = 0; k < kGroupSize; ++k) {
+      fields[k] = INT32_MAX;
+      fields[kGroupSize+k] = INT32_MIN;
+    }
+  }
+  size_t edge = 0;
+  for (size_t i = 0, j = count-1; i < count; j = i++) {
+    auto const& point1 = vertices[i];
+    auto const& point2 = vertices[j];
+    if (point1.latitude == point2.latitude) continue;
+    auto const& lower = (point1.latitude < point2.latitude) ? point1 : point2;
+    auto const& upper = (point1.latitude < point2.latitude) ? point2 : point1;
+    int32_t* fields = &edges_[edge/kGroupSize*kGroupSize*kFieldNum];
+    size_t const k = edge%kGroupSize;
+    fields[k] = lower.latitude;
+    fields[kGroupSize+k] = upper.latitude;
+    fields[2*kGroupSize+k] = lower.longitude;
+    fields[3*kGroupSize+k] = lower.latitude;
+    fields[4*kGroupSize+k] = upper.longitude-lower.longitude;
+    fields[5*kGroupSize+k] = upper.latitude-lower.latitude;
+    ++edge;
+  }
+}
+
+// 叉积 dx*(py-by)-dy*(px-bx) 大于0时交点在检查点东侧.
+// 各差值不超过32位, 乘积在64位整数中精确计算.
+#if defined(__AVX2__)
+int PreparedPolygon::CountCrossings(GeoPoint const& point) const {
+  __m256i const lon = _mm256_set1_epi64x(point.longitude);
+  __m256i const lat = _mm256_set1_epi64x(point.latitude);
+  __m256i const zero = _mm256_setzero_si256();
+  int crossings = 0;
+  for (size_t i = 0; i < edges_.size(); i += kGroupSize*kFieldNum) {
+    int32_t const* fields = &edges_[i];
+    auto const load = [fields] (size_t const& field) {
+      return _mm256_cvtepi32_epi64(_mm_loadu_si128(
+          reinterpret_cast<__m128i const*>(fields+field*kGroupSize)));
+    };
+    __m256i const min_lat = load(0);
+    __m256i const max_lat = load(1);
+    // min_lat <= lat < max_lat.
+    __m256i mask = _mm256_andnot_si256(_mm256_cmpgt_epi64(min_lat, lat),
+                                       _mm256_cmpgt_epi64(max_lat, lat));
+    // 复杂多边形中大部分边不跨越检查点纬度, 整组跳过叉积计算.
+    if (_mm256_testz_si256(mask, mask)) continue;
+    __m256i const dx = _mm256_sub_epi64(lon, load(2));
+    __m256i const dy = _mm256_sub_epi64(lat, load(3));
+    __m256i const cross = _mm256_sub_epi64(_mm256_mul_epi32(load(4), dy),
+                                           _mm256_mul_epi32(load(5), dx));
+    mask = _mm256_and_si256(mask, _mm256_cmpgt_epi64(cross, zero));
+    crossings += __builtin_popcount(
+        _mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+  }
+  return crossings;
+}
+#else
+int PreparedPolygon::CountCrossings(GeoPoint const& point) const {
+  int crossings = 0;
+  for (size_t i = 0; i < edges_.size(); i += kGroupSize*kFieldNum) {
+    int32_t const* fields = &edges_[i];
+    for (size_t k = 0; k < kGroupSize; ++k) {
+      if (point.latitude >= fields[k] &&
+          point.latitude < fields[kGroupSize+k]) {
+        int64_t const cross =
+            static_cast<int64_t>(fields[4*kGroupSize+k])*
+                (point.latitude-fields[3*kGroupSize+k]) -
+            static_cast<int64_t>(fields[5*kGroupSize+k])*
+                (point.longitude-fields[2*kGroupSize+k]);
+        crossings += (cross > 0);
+      }
+    }
+  }
+  return crossings;
+}
+#endif
+
+bool PreparedPolygon::Contains(GeoPoint const& point) const {
+  if (edge_num_ == 0 || !IsPointInsideBox(point, box_)) return false;
+  return (CountCrossings(point) & 1) == 1;
+}
+
+void PreparedPolygon::ContainsBatch(GeoPoint const* points,
+                                    size_t const& num,
+                                    uint8_t* results) const {
+  if (points == nullptr || results == nullptr) return;
+  for (size_t i = 0; i < num; ++i) {
+    results[i] = Contains(points[i]) ? 1 : 0;
+  }
+}
+
+void PreparedPolygon::ContainsBatch(LocationPoint const* points,
+                                    size_t const& num,
+                                    uint8_t* results) const {
+  if (points == nullptr || results == nullptr) return;
+  for (size_t i = 0; i < num; ++i) {
+    results[i] = Contains(ToGeoPoint(points[i])) ? 1 : 0;
+  }
+}
+
+GeofenceIndex::GeofenceIndex(double const& cell_size)
+    : version_(++version_counter), grid_(DegreeToMicroDegree(cell_size)) {
+}
+
+void GeofenceIndex::Modified(void) {
+  version_ = ++version_counter;
+}
+
+void GeofenceIndex::Build(PolygonAreaSet const& areas) {
+  Clear();
+  entries_.reserve(areas.size());
+  slots_.reserve(areas.size());
+  for (auto const& item : areas) {
+    Insert(item.second);
+  }
+}
+
+GeofenceIndex::Entry* GeofenceIndex::Acquire(uint8_t const& type,
+                                             uint32_t const& area_id) {
+  uint32_t slot = 0;
+  uint64_t const key = AreaKey(type, area_id);
+  auto const& it = slots_.find(key);
+  if (it != slots_.end()) {
+    slot = it->second;
+    grid_.Remove(slot, entries_[slot].box);
+  } else if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+    slots_[key] = slot;
+  } else {
+    slot = static_cast<uint32_t>(entries_.size());
+    entries_.push_back(Entry());
+    slots_[key] = slot;
+  }
+  auto& entry = entries_[slot];
+  entry.type = type;
+  entry.area_id = area_id;
+  return &entry;
+}
+
+int GeofenceIndex::Insert(PolygonArea const& area) {
+  if (area.vertices.size() < 3) {
+    Remove(kAccessAreaAlarmPolygonArea, area.area_id);
+    return -1;
+  }
+  auto* entry = Acquire(kAccessAreaAlarmPolygonArea, area.area_id);
+  entry->polygon.Reset(area.vertices);
+  entry->box = entry->polygon.box();
+  MakeAreaRule(area.area_attribute, area.start_time, area.stop_time,
+               area.max_speed, area.overspeed_time, &entry->rule);
+  grid_.Insert(static_cast<uint32_t>(entry-entries_.data()), entry->box);
+  Modified();
+  return 0;
+}
+
+int GeofenceIndex::Insert(CircularArea const& area) {
+  auto* entry = Acquire(kAccessAreaAlarmCircularArea, area.area_id);
+  entry->polygon = PreparedPolygon();
+  entry->center = ToGeoPoint(area.center);
+  entry->radius = area.radius;
+  entry->box = ExpandBox(GeoBox {entry->center.longitude,
+                                 entry->center.latitude,
+                                 entry->center.longitude,
+                                 entry->center.latitude},
+                         area.radius);
+  MakeAreaRule(area.area_attribute, area.start_time, area.stop_time,
+               area.max_speed, area.overspeed_time, &entry->rule);
+  grid_.Insert(static_cast<uint32_t>(entry-entries_.data()), entry->box);
+  Modified();
+  return 0;
+}
+
+int GeofenceIndex::Insert(RectangleArea const& area) {
+  auto* entry = Acquire(kAccessAreaAlarmRectangleArea, area.area_id);
+  entry->polygon = PreparedPolygon();
+  GeoPoint const upper_left = ToGeoPoint(area.upper_left);
+  GeoPoint const lower_right = ToGeoPoint(area.lower_right);
+  entry->box.min_longitude =
+      std::min(upper_left.longitude, lower_right.longitude);
+  entry->box.max_longitude =
+      std::max(upper_left.longitude, lower_right.longitude);
+  entry->box.min_latitude =
+      std::min(upper_left.latitude, lower_right.latitude);
+  entry->box.max_latitude =
+      std::max(upper_left.latitude, lower_right.latitude);
+  MakeAreaRule(area.area_attribute, area.start_time, area.stop_time,
+               area.max_speed, area.overspeed_time, &entry->rule);
+  grid_.Insert(static_cast<uint32_t>(entry-entries_.data()), entry->box);
+  Modified();
+  return 0;
+}
+
+void GeofenceIndex::Remove(uint8_t const& type, uint32_t const& area_id) {
+  auto const& it = slots_.find(AreaKey(type, area_id));
+  if (it == slots_.end()) return;
+  uint32_t const slot = it->second;
+  grid_.Remove(slot, entries_[slot].box);
+  entries_[slot].polygon = PreparedPolygon();
+  free_slots_.push_back(slot);
+  slots_.erase(it);
+  Modified();
+}
+
+void GeofenceIndex::Clear(uint8_t const& type) {
+  std::vector<uint32_t> area_ids;
+  for (auto const& item : slots_) {
+    auto const& entry = entries_[item.second];
+    if (entry.type == type) area_ids.push_back(entry.area_id);
+  }
+  for (auto const& id : area_ids) Remove(type, id);
+}
+
+void GeofenceIndex::Clear(void) {
+  entries_.clear();
+  free_slots_.clear();
+  slots_.clear();
+  grid_.Clear();
+  Modified();
+}
+
+bool GeofenceIndex::EntryContains(Entry const& entry, GeoPoint const& point) {
+  if (entry.type == kAccessAreaAlarmPolygonArea) {
+    return entry.polygon.Contains(point);
+  }
+  if (!IsPointInsideBox(point, entry.box)) return false;
+  if (entry.type == kAccessAreaAlarmCircularArea) {
+    return IsWithinDistance(entry.center, point, entry.radius);
+  }
+  return true;
+}
+
+int GeofenceIndex::Query(GeoPoint const& point,
+                         std::vector<AreaRef>* areas) const {
+  if (areas == nullptr) return -1;
+  areas->clear();
+  if (slots_.empty()) return 0;
+  grid_.ForEach(point, [this, &point, areas] (uint32_t const& slot) {
+    auto const& entry = entries_[slot];
+    if (EntryContains(entry, point)) {
+      areas->push_back(AreaRef {entry.type, entry.area_id});
+    }
+  });
+  if (areas->size() > 1) std::sort(areas->begin(), areas->end());
+  return 0;
+}
+
+int GeofenceIndex::Query(GeoPoint const& point,
+                         std::vector<uint32_t>* area_ids) const {
+  if (area_ids == nullptr) return -1;
+  area_ids->clear();
+  if (slots_.empty()) return 0;
+  grid_.ForEach(point, [this, &point, area_ids] (uint32_t const& slot) {
+    auto const& entry = entries_[slot];
+    if (entry.type == kAccessAreaAlarmPolygonArea &&
+        entry.polygon.Contains(point)) {
+      area_ids->push_back(entry.area_id);
+    }
+  });
+  if (area_ids->size() > 1) std::sort(area_ids->begin(), area_ids->end());
+  return 0;
+}
+
+int GeofenceIndex::GetRule(uint8_t const& type, uint32_t const& area_id,
+                           AreaRule* rule) const {
+  if (rule == nullptr) return -1;
+  auto const& it = slots_.find(AreaKey(type, area_id));
+  if (it == slots_.end()) return -1;
+  *rule = entries_[it->second].rule;
+  return 0;
+}
+
+bool GeofenceIndex::Contains(uint8_t const& type, uint32_t const& area_id,
+                             GeoPoint const& point) const {
+  auto const& it = slots_.find(AreaKey(type, area_id));
+  if (it == slots_.end()) return false;
+  return EntryContains(entries_[it->second], point);
+}
+
+}  // namespace libjt808
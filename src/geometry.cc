@@ -0,0 +1,192 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  geometry.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 01:26:43
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/geometry.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+
+namespace libjt808 {
+
+namespace {
+
+// 余弦表的纬度步长, 单位为百万分之一度(0.1°).
+constexpr int32_t kCosineStep = 100000;
+constexpr int kCosineTableSize = 90*1000000/kCosineStep+1;
+constexpr double kPI = 3.1415926535897931;
+
+// 纬度0~90°的余弦值, Q16定点数.
+struct CosineTable {
+  CosineTable() {
+    for (int i = 0; i < kCosineTableSize; ++i) {
+      values[i] = static_cast<int32_t>(
+          llround(cos(i*0.1*kPI/180.0)*65536.0));
+    }
+  }
+  int32_t values[kCosineTableSize];
+};
+
+int32_t CosineQ16(int64_t const& latitude) {
+  static CosineTable const table;
+  int64_t index = llabs(latitude)/kCosineStep;
+  if (index >= kCosineTableSize) index = kCosineTableSize-1;
+  return table.values[index];
+}
+
+// 经度差按纬度缩放为等距的百万分之一度.
+inline int64_t ScaleLongitude(int64_t const& delta_longitude,
+                              int32_t const& cosine) {
+  return (delta_longitude*cosine) >> 16;
+}
+
+inline uint32_t ToMeters(double const& micro_degrees) {
+  return static_cast<uint32_t>(micro_degrees*kMetersPerMicroDegree+0.5);
+}
+
+}  // namespace
+
+void ToGeoPoints(std::vector<LocationPoint> const& points,
+                 std::vector<GeoPoint>* out) {
+  if (out == nullptr) return;
+  out->clear();
+  out->reserve(points.size());
+  for (auto const& point : points) {
+    out->push_back(ToGeoPoint(point));
+  }
+}
+
+int GetBoundingBox(std::vector<GeoPoint> const& vertices, GeoBox* box) {
+  if (box == nullptr || vertices.empty()) return -1;
+  box->min_longitude = box->max_longitude = vertices[0].longitude;
+  box->min_latitude = box->max_latitude = vertices[0].latitude;
+  for (auto const& vertex : vertices) {
+    box->min_longitude = std::min(box->min_longitude, vertex.longitude);
+    box->max_longitude = std::max(box->max_longitude, vertex.longitude);
+    box->min_latitude = std::min(box->min_latitude, vertex.latitude);
+    box->max_latitude = std::max(box->max_latitude, vertex.latitude);
+  }
+  return 0;
+}
+
+// 对跨越检查点纬度的边, 由下端点指向上端点, 检查点在边的左侧时
+// 射线与边的交点在检查点东侧.
+bool IsPointInsidePolygon(GeoPoint const& point,
+                          std::vector<GeoPoint> const& vertices) {
+  auto const count = vertices.size();
+  if (count < 3) return false;
+  bool inside = false;
+  for (size_t i = 0, j = count-1; i < count; j = i++) {
+    auto const& point1 = vertices[i];
+    auto const& point2 = vertices[j];
+    if ((point1.latitude > point.latitude) ==
+        (point2.latitude > point.latitude)) {
+      continue;
+    }
+    auto const& lower = (point1.latitude < point2.latitude) ? point1 : point2;
+    auto const& upper = (point1.latitude < point2.latitude) ? point2 : point1;
+    if (Cross(lower, upper, point) > 0) inside = !inside;
+  }
+  return inside;
+}
+
+uint32_t ApproximateDistance(GeoPoint const& from, GeoPoint const& to) {
+  int32_t const cosine = CosineQ16(
+      (static_cast<int64_t>(from.latitude)+to.latitude)/2);
+  int64_t const dx = ScaleLongitude(
+      static_cast<int64_t>(to.longitude)-from.longitude, cosine);
+  int64_t const dy = static_cast<int64_t>(to.latitude)-from.latitude;
+  return ToMeters(sqrt(static_cast<double>(dx*dx+dy*dy)));
+}
+
+bool IsWithinDistance(GeoPoint const& from, GeoPoint const& to,
+                      uint32_t const& meters) {
+  int32_t const cosine = CosineQ16(
+      (static_cast<int64_t>(from.latitude)+to.latitude)/2);
+  int64_t const dx = ScaleLongitude(
+      static_cast<int64_t>(to.longitude)-from.longitude, cosine);
+  int64_t const dy = static_cast<int64_t>(to.latitude)-from.latitude;
+  int64_t const radius =
+      static_cast<int64_t>(meters/kMetersPerMicroDegree+0.5);
+  return dx*dx+dy*dy <= radius*radius;
+}
+
+// 以检查点为原点投影到平面后, 求原点到线段的最近点.
+uint32_t ApproximateSegmentDistance(GeoPoint const& point,
+                                    GeoPoint const& start,
+                                    GeoPoint const& end) {
+  int32_t const cosine = CosineQ16(point.latitude);
+  int64_t const ax = ScaleLongitude(
+      static_cast<int64_t>(start.longitude)-point.longitude, cosine);
+  int64_t const ay = static_cast<int64_t>(start.latitude)-point.latitude;
+  int64_t const bx = ScaleLongitude(
+      static_cast<int64_t>(end.longitude)-point.longitude, cosine);
+  int64_t const by = static_cast<int64_t>(end.latitude)-point.latitude;
+  int64_t const dx = bx-ax;
+  int64_t const dy = by-ay;
+  int64_t const length2 = dx*dx+dy*dy;
+  int64_t const dot = -(ax*dx+ay*dy);  // 原点在线段方向上的投影.
+  if (length2 == 0 || dot <= 0) {
+    return ToMeters(sqrt(static_cast<double>(ax*ax+ay*ay)));
+  }
+  if (dot >= length2) {
+    return ToMeters(sqrt(static_cast<double>(bx*bx+by*by)));
+  }
+  double const t = static_cast<double>(dot)/length2;
+  double const x = ax+t*dx;
+  double const y = ay+t*dy;
+  return ToMeters(sqrt(x*x+y*y));
+}
+
+GeoBox ExpandBox(GeoBox const& box, uint32_t const& meters) {
+  constexpr int64_t kMaxLatitude = 90000000;
+  constexpr int64_t kMaxLongitudeDelta = 360000000;
+  int64_t const delta_latitude =
+      static_cast<int64_t>(meters/kMetersPerMicroDegree)+1;
+  int64_t const min_latitude =
+      std::max(box.min_latitude-delta_latitude, -kMaxLatitude);
+  int64_t const max_latitude =
+      std::min(box.max_latitude+delta_latitude, kMaxLatitude);
+  int32_t const cosine = std::max(
+      CosineQ16(std::max(llabs(min_latitude), llabs(max_latitude))), 1);
+  int64_t const delta_longitude =
+      std::min((delta_latitude << 16)/cosine+1, kMaxLongitudeDelta);
+  GeoBox expanded;
+  expanded.min_longitude =
+      static_cast<int32_t>(box.min_longitude-delta_longitude);
+  expanded.max_longitude =
+      static_cast<int32_t>(box.max_longitude+delta_longitude);
+  expanded.min_latitude = static_cast<int32_t>(min_latitude);
+  expanded.max_latitude = static_cast<int32_t>(max_latitude);
+  return expanded;
+}
+
+}  // namespace libjt808
@@ -0,0 +1,680 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_archive.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 04:26:53
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/location_archive.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#endif
+#include <string.h>
+
+#include <algorithm>
+
+
+namespace libjt808 {
+
+namespace {
+
+constexpr uint32_t kArchiveMagic = 0x414C3838;  // "88LA".
+constexpr uint32_t kArchiveVersion = 1;
+constexpr uint32_t kBlockMagic = 0x424C3838;  // "88LB".
+
+// 列序号.
+enum ArchiveColumn {
+  kColumnTime = 0,
+  kColumnLongitude,
+  kColumnLatitude,
+  kColumnAltitude,
+  kColumnSpeed,
+  kColumnBearing,
+  kColumnAlarm,
+  kColumnStatus,
+  kColumnNum
+};
+// 差值编码的列数, 之后为位图编码的列.
+constexpr int kDeltaColumnNum = kColumnAlarm;
+// 经纬度随车辆匀速行驶近似线性变化, 存放差值的差值.
+inline bool IsSecondOrder(int const& column) {
+  return column == kColumnLongitude || column == kColumnLatitude;
+}
+
+// 归档文件头, 固定64字节.
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint8_t reserved[56];
+};
+
+// 数据块头, 固定96字节, 之后依次存放各列数据.
+struct BlockHeader {
+  uint32_t magic;
+  uint32_t num;  // 记录条数.
+  uint32_t size;  // 块头之后的数据字节数.
+  uint32_t reserved1;
+  int64_t start_time;  // 最早的定位时间.
+  int64_t stop_time;  // 最晚的定位时间.
+  char phone_num[20];
+  uint8_t reserved2[12];
+  uint32_t column_size[kColumnNum];
+};
+
+inline uint64_t ZigZagEncode(int64_t const& value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t ZigZagDecode(uint64_t const& value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void WriteVarint(uint64_t value, std::vector<uint8_t>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+// 读取varint, 数据不完整或超过10字节时返回nullptr.
+inline uint8_t const* ReadVarint(uint8_t const* pos, uint8_t const* end,
+                                 uint64_t* value) {
+  if (pos < end && *pos < 0x80) {
+    *value = *pos;
+    return pos+1;
+  }
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+    uint8_t const byte = *pos++;
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return pos;
+    }
+  }
+  return nullptr;
+}
+
+// 解码差值列, 依次以解码值调用setter.
+template<int kOrder, typename Setter>
+bool DecodeDeltaColumn(uint8_t const* pos, uint8_t const* end,
+                       uint32_t const& num, Setter&& setter) {
+  int64_t value = 0;
+  int64_t delta = 0;
+  for (uint32_t i = 0; i < num; ++i) {
+    uint64_t encoded = 0;
+    pos = ReadVarint(pos, end, &encoded);
+    if (pos == nullptr) return false;
+    if (kOrder == 2) {
+      delta += ZigZagDecode(encoded);
+      value += delta;
+    } else {
+      value += ZigZagDecode(encoded);
+    }
+    setter(i, value);
+  }
+  return pos == end;
+}
+
+// 解码位图列, 位图中为1的记录依次取一个新值, 其余沿用前一条记录的值.
+template<typename Setter>
+bool DecodeWordColumn(uint8_t const* pos, uint8_t const* end,
+                      uint32_t const& num, Setter&& setter) {
+  size_t const bitmap_size = (num+7)/8;
+  if (static_cast<size_t>(end-pos) < bitmap_size) return false;
+  uint8_t const* values = pos+bitmap_size;
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < num; ++i) {
+    if ((pos[i >> 3] >> (i & 7)) & 0x1) {
+      if (end-values < 4) return false;
+      memcpy(&value, values, 4);
+      values += 4;
+    }
+    setter(i, value);
+  }
+  return values == end;
+}
+
+}  // namespace
+
+// 正在编码的数据块, 各列随记录追加增量编码.
+struct LocationArchiveWriter::Block {
+  char phone_num[20];
+  uint32_t num;
+  // 第一条记录加入的时间, 用于判断aging_blocks_中的项是否仍有效.
+  std::chrono::steady_clock::time_point since;
+  int64_t start_time;
+  int64_t stop_time;
+  int64_t last[kDeltaColumnNum];  // 差值列的前一个值.
+  int64_t last_delta[kDeltaColumnNum];  // 二阶差值列的前一个差值.
+  uint32_t last_word[2];  // 报警标志和状态的前一个值.
+  std::vector<uint8_t> columns[kDeltaColumnNum];
+  std::vector<uint8_t> bitmaps[2];
+  std::vector<uint8_t> words[2];
+
+  void Reset(void) {
+    num = 0;
+    start_time = 0;
+    stop_time = 0;
+    memset(last, 0, sizeof(last));
+    memset(last_delta, 0, sizeof(last_delta));
+    memset(last_word, 0, sizeof(last_word));
+    for (auto& column : columns) column.clear();
+    for (int i = 0; i < 2; ++i) {
+      bitmaps[i].clear();
+      words[i].clear();
+    }
+  }
+
+  void Append(LocationRecord const& record) {
+    if (num == 0) {
+      start_time = record.timestamp;
+      stop_time = record.timestamp;
+    } else {
+      start_time = std::min(start_time, record.timestamp);
+      stop_time = std::max(stop_time, record.timestamp);
+    }
+    int64_t const values[kDeltaColumnNum] = {
+        record.timestamp, record.longitude, record.latitude,
+        record.altitude, record.speed, record.bearing};
+    for (int i = 0; i < kDeltaColumnNum; ++i) {
+      int64_t const delta = values[i]-last[i];
+      if (IsSecondOrder(i)) {
+        WriteVarint(ZigZagEncode(delta-last_delta[i]), &columns[i]);
+        last_delta[i] = delta;
+      } else {
+        WriteVarint(ZigZagEncode(delta), &columns[i]);
+      }
+      last[i] = values[i];
+    }
+    uint32_t const words_value[2] = {record.alarm, record.status};
+    for (int i = 0; i < 2; ++i) {
+      if ((num & 7) == 0) bitmaps[i].push_back(0);
+      if (words_value[i] != last_word[i]) {
+        bitmaps[i].back() |= static_cast<uint8_t>(1 << (num & 7));
+        uint8_t bytes[4];
+        memcpy(bytes, &words_value[i], 4);
+        words[i].insert(words[i].end(), bytes, bytes+4);
+        last_word[i] = words_value[i];
+      }
+    }
+    ++num;
+  }
+};
+
+LocationArchiveWriter::LocationArchiveWriter()
+    : file_(nullptr), block_records_(1024), max_block_age_(60000),
+      block_num_(0), bytes_written_(0) {
+}
+
+LocationArchiveWriter::~LocationArchiveWriter() {
+  Close();
+}
+
+// 已有文件从头检查数据块, 截断末尾不完整的数据块.
+int LocationArchiveWriter::Open(std::string const& path,
+                                uint32_t const& block_records,
+                                int const& max_block_age_ms) {
+  static_assert(sizeof(FileHeader) == 64, "archive header must be 64 bytes");
+  static_assert(sizeof(BlockHeader) == 96, "block header must be 96 bytes");
+  if (block_records == 0 || max_block_age_ms <= 0) return -1;
+  Close();
+  std::lock_guard<std::mutex> lock(mutex_);
+  FILE* file = fopen(path.c_str(), "r+b");
+  if (file == nullptr) file = fopen(path.c_str(), "w+b");
+  if (file == nullptr) return -1;
+  FileHeader file_header;
+  long end = 0;
+  if (fread(&file_header, sizeof(file_header), 1, file) != 1) {
+    // 新文件.
+    memset(&file_header, 0, sizeof(file_header));
+    file_header.magic = kArchiveMagic;
+    file_header.version = kArchiveVersion;
+    if (fseek(file, 0, SEEK_SET) != 0 ||
+        fwrite(&file_header, sizeof(file_header), 1, file) != 1) {
+      fclose(file);
+      return -1;
+    }
+    end = sizeof(file_header);
+  } else if (file_header.magic != kArchiveMagic ||
+             file_header.version != kArchiveVersion) {
+    fclose(file);
+    return -1;
+  } else {
+    fseek(file, 0, SEEK_END);
+    long const file_size = ftell(file);
+    end = sizeof(file_header);
+    BlockHeader header;
+    while (fseek(file, end, SEEK_SET) == 0 &&
+           fread(&header, sizeof(header), 1, file) == 1 &&
+           header.magic == kBlockMagic &&
+           static_cast<uint64_t>(end)+sizeof(header)+header.size <=
+               static_cast<uint64_t>(file_size)) {
+      end += static_cast<long>(sizeof(header)+header.size);
+    }
+    if (end != file_size) {
+      fflush(file);
+#if defined(__linux__)
+      if (ftruncate(fileno(file), end) != 0) {
+#elif defined(_WIN32)
+      if (_chsize_s(_fileno(file), end) != 0) {
+#else
+      if (true) {
+#endif
+        fclose(file);
+        return -1;
+      }
+    }
+  }
+  if (fseek(file, end, SEEK_SET) != 0) {
+    fclose(file);
+    return -1;
+  }
+  file_ = file;
+  block_records_ = block_records;
+  max_block_age_ = std::chrono::milliseconds(max_block_age_ms);
+  block_num_ = 0;
+  bytes_written_ = 0;
+  return 0;
+}
+
+void LocationArchiveWriter::Close(void) {
+  Flush();
+  std::lock_guard<std::mutex> lock(mutex_);
+  blocks_.clear();
+  aging_blocks_.clear();
+  if (file_ == nullptr) return;
+  fclose(file_);
+  file_ = nullptr;
+}
+
+bool LocationArchiveWriter::is_open(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_ != nullptr;
+}
+
+int LocationArchiveWriter::Append(LocationRecord const* records,
+                                  size_t const& num) {
+  if (records == nullptr && num > 0) return -1;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == nullptr) return -1;
+  auto const now = std::chrono::steady_clock::now();
+  int ret = 0;
+  for (size_t i = 0; i < num; ++i) {
+    auto const& record = records[i];
+    phone_num_.assign(record.phone_num,
+                      strnlen(record.phone_num, sizeof(record.phone_num)));
+    auto& block = blocks_[phone_num_];
+    if (block == nullptr) {
+      block.reset(new Block());
+      block->Reset();
+      memcpy(block->phone_num, record.phone_num, sizeof(block->phone_num));
+    }
+    if (block->num == 0) {
+      block->since = now;
+      aging_blocks_.push_back(AgingBlock {now, block.get()});
+    }
+    block->Append(record);
+    if (block->num >= block_records_ && WriteBlock(block.get()) != 0) {
+      ret = -1;
+    }
+  }
+  if (WriteAgedBlocks(now) != 0) ret = -1;
+  return ret;
+}
+
+int LocationArchiveWriter::Append(std::string const& phone_num,
+                                  LocationBasicInformation const& info) {
+  LocationRecord record;
+  memset(&record, 0, sizeof(record));
+  FillLocationRecord(info, phone_num, &record);
+  return Append(&record, 1);
+}
+
+int LocationArchiveWriter::Flush(void) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == nullptr) return -1;
+  int ret = 0;
+  for (auto& item : blocks_) {
+    if (item.second->num > 0 && WriteBlock(item.second.get()) != 0) {
+      ret = -1;
+    }
+  }
+  aging_blocks_.clear();
+  if (fflush(file_) != 0) ret = -1;
+  return ret;
+}
+
+uint64_t LocationArchiveWriter::block_num(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return block_num_;
+}
+
+uint64_t LocationArchiveWriter::bytes_written(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_written_;
+}
+
+// 数据块按开始缓存的顺序加入队列, 只需检查队首; 已写出的数据块项直接丢弃.
+// 写出后立即刷新文件缓存, 使这些记录在进程异常退出时不丢失.
+int LocationArchiveWriter::WriteAgedBlocks(
+    std::chrono::steady_clock::time_point const& now) {
+  int ret = 0;
+  bool written = false;
+  while (!aging_blocks_.empty() &&
+         now-aging_blocks_.front().since >= max_block_age_) {
+    auto const item = aging_blocks_.front();
+    aging_blocks_.pop_front();
+    auto* block = item.block;
+    if (block->num == 0 || block->since != item.since) continue;
+    if (WriteBlock(block) != 0) ret = -1;
+    written = true;
+  }
+  if (written && fflush(file_) != 0) ret = -1;
+  return ret;
+}
+
+// 块头和各列拼接后一次写入.
+int LocationArchiveWriter::WriteBlock(Block* block) {
+  BlockHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kBlockMagic;
+  header.num = block->num;
+  header.start_time = block->start_time;
+  header.stop_time = block->stop_time;
+  memcpy(header.phone_num, block->phone_num, sizeof(header.phone_num));
+  for (int i = 0; i < kDeltaColumnNum; ++i) {
+    header.column_size[i] = static_cast<uint32_t>(block->columns[i].size());
+  }
+  for (int i = 0; i < 2; ++i) {
+    header.column_size[kDeltaColumnNum+i] = static_cast<uint32_t>(
+        block->bitmaps[i].size()+block->words[i].size());
+  }
+  for (auto const& size : header.column_size) header.size += size;
+  auto const* header_bytes = reinterpret_cast<uint8_t const*>(&header);
+  buffer_.assign(header_bytes, header_bytes+sizeof(header));
+  for (auto const& column : block->columns) {
+    buffer_.insert(buffer_.end(), column.begin(), column.end());
+  }
+  for (int i = 0; i < 2; ++i) {
+    buffer_.insert(buffer_.end(), block->bitmaps[i].begin(),
+                   block->bitmaps[i].end());
+    buffer_.insert(buffer_.end(), block->words[i].begin(),
+                   block->words[i].end());
+  }
+  block->Reset();
+  if (fwrite(buffer_.data(), buffer_.size(), 1, file_) != 1) return -1;
+  ++block_num_;
+  bytes_written_ += buffer_.size();
+  return 0;
+}
+
+LocationArchiveReader::LocationArchiveReader()
+    : data_(nullptr), map_size_(0), record_num_(0) {
+#if defined(__linux__)
+  fd_ = -1;
+#elif defined(_WIN32)
+  file_ = nullptr;
+  mapping_ = nullptr;
+#endif
+}
+
+LocationArchiveReader::~LocationArchiveReader() {
+  Close();
+}
+
+// 只读映射归档文件, 从头检查数据块建立索引.
+int LocationArchiveReader::Open(std::string const& path) {
+  Close();
+  void* addr = nullptr;
+  size_t map_size = 0;
+#if defined(__linux__)
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    close(fd);
+    return -1;
+  }
+  map_size = static_cast<size_t>(st.st_size);
+  addr = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+  madvise(addr, map_size, MADV_SEQUENTIAL);
+  fd_ = fd;
+#elif defined(_WIN32)
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return -1;
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) ||
+      static_cast<size_t>(file_size.QuadPart) < sizeof(FileHeader)) {
+    CloseHandle(file);
+    return -1;
+  }
+  map_size = static_cast<size_t>(file_size.QuadPart);
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+                                      nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return -1;
+  }
+  addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, map_size);
+  if (addr == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return -1;
+  }
+  file_ = file;
+  mapping_ = mapping;
+#else
+  return -1;
+#endif
+  data_ = static_cast<uint8_t const*>(addr);
+  map_size_ = map_size;
+  FileHeader file_header;
+  memcpy(&file_header, data_, sizeof(file_header));
+  if (file_header.magic != kArchiveMagic ||
+      file_header.version != kArchiveVersion) {
+    Close();
+    return -1;
+  }
+  size_t offset = sizeof(FileHeader);
+  BlockHeader header;
+  while (map_size_-offset >= sizeof(header)) {
+    memcpy(&header, data_+offset, sizeof(header));
+    if (header.magic != kBlockMagic ||
+        header.size > map_size_-offset-sizeof(header)) {
+      break;
+    }
+    std::string const phone_num(
+        header.phone_num, strnlen(header.phone_num, sizeof(header.phone_num)));
+    terminals_[phone_num].push_back(static_cast<uint32_t>(blocks_.size()));
+    blocks_.push_back(BlockInfo {offset, header.num, header.start_time,
+                                 header.stop_time});
+    record_num_ += header.num;
+    offset += sizeof(header)+header.size;
+  }
+  return 0;
+}
+
+void LocationArchiveReader::Close(void) {
+  if (data_ != nullptr) {
+#if defined(__linux__)
+    munmap(const_cast<uint8_t*>(data_), map_size_);
+    close(fd_);
+    fd_ = -1;
+#elif defined(_WIN32)
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#endif
+  }
+  data_ = nullptr;
+  map_size_ = 0;
+  blocks_.clear();
+  terminals_.clear();
+  record_num_ = 0;
+}
+
+// 先逐列解码整个数据块, 数据块不完全在时间范围内时再剔除范围外的记录.
+int64_t LocationArchiveReader::DecodeBlock(
+    BlockInfo const& block, int64_t const& start_time,
+    int64_t const& stop_time, std::vector<LocationRecord>* records) const {
+  BlockHeader header;
+  memcpy(&header, data_+block.offset, sizeof(header));
+  uint64_t column_total = 0;
+  for (auto const& size : header.column_size) column_total += size;
+  // 每条记录在每个差值列中至少占1字节.
+  if (column_total != header.size || header.num > header.size) return -1;
+  records->resize(header.num);
+  LocationRecord* const out = records->data();
+  LocationRecord prototype;
+  memset(&prototype, 0, sizeof(prototype));
+  memcpy(prototype.phone_num, header.phone_num, sizeof(prototype.phone_num));
+  for (uint32_t i = 0; i < header.num; ++i) out[i] = prototype;
+  uint8_t const* pos = data_+block.offset+sizeof(header);
+  uint8_t const* column_end[kColumnNum];
+  uint8_t const* column_begin[kColumnNum];
+  for (int i = 0; i < kColumnNum; ++i) {
+    column_begin[i] = pos;
+    pos += header.column_size[i];
+    column_end[i] = pos;
+  }
+  uint32_t const num = header.num;
+  bool ok =
+      DecodeDeltaColumn<1>(column_begin[kColumnTime], column_end[kColumnTime],
+          num, [out] (uint32_t const& i, int64_t const& value) {
+            out[i].timestamp = value;
+          }) &&
+      DecodeDeltaColumn<2>(column_begin[kColumnLongitude],
+          column_end[kColumnLongitude],
+          num, [out] (uint32_t const& i, int64_t const& value) {
+            out[i].longitude = static_cast<uint32_t>(value);
+          }) &&
+      DecodeDeltaColumn<2>(column_begin[kColumnLatitude],
+          column_end[kColumnLatitude],
+          num, [out] (uint32_t const& i, int64_t const& value) {
+            out[i].latitude = static_cast<uint32_t>(value);
+          }) &&
+      DecodeDeltaColumn<1>(column_begin[kColumnAltitude],
+          column_end[kColumnAltitude],
+          num, [out] (uint32_t const& i, int64_t const& value) {
+            out[i].altitude = static_cast<uint16_t>(value);
+          }) &&
+      DecodeDeltaColumn<1>(column_begin[kColumnSpeed],
+          column_end[kColumnSpeed],
+          num, [out] (uint32_t const& i, int64_t const& value) {
+            out[i].speed = static_cast<uint16_t>(value);
+          }) &&
+      DecodeDeltaColumn<1>(column_begin[kColumnBearing],
+          column_end[kColumnBearing],
+          num, [out] (uint32_t const& i, int64_t const& value) {
+            out[i].bearing = static_cast<uint16_t>(value);
+          }) &&
+      DecodeWordColumn(column_begin[kColumnAlarm], column_end[kColumnAlarm],
+          num, [out] (uint32_t const& i, uint32_t const& value) {
+            out[i].alarm = value;
+          }) &&
+      DecodeWordColumn(column_begin[kColumnStatus], column_end[kColumnStatus],
+          num, [out] (uint32_t const& i, uint32_t const& value) {
+            out[i].status = value;
+          });
+  if (!ok) {
+    records->clear();
+    return -1;
+  }
+  if (block.start_time < start_time || block.stop_time > stop_time) {
+    auto const& end = std::remove_if(records->begin(), records->end(),
+        [&start_time, &stop_time] (LocationRecord const& record) {
+          return record.timestamp < start_time ||
+                 record.timestamp > stop_time;
+        });
+    records->erase(end, records->end());
+  }
+  return static_cast<int64_t>(records->size());
+}
+
+int64_t LocationArchiveReader::Scan(std::string const& phone_num,
+                                    int64_t const& start_time,
+                                    int64_t const& stop_time,
+                                    Visitor const& visitor) const {
+  if (data_ == nullptr || start_time > stop_time) return 0;
+  // 每个线程复用解码缓存.
+  static thread_local std::vector<LocationRecord> records;
+  int64_t total = 0;
+  auto const visit = [&] (BlockInfo const& block) {
+    if (block.stop_time < start_time || block.start_time > stop_time) {
+      return true;
+    }
+    int64_t const num = DecodeBlock(block, start_time, stop_time, &records);
+    if (num < 0) return false;
+    if (num > 0 && visitor) visitor(records.data(), records.size());
+    total += num;
+    return true;
+  };
+  if (phone_num.empty()) {
+    for (auto const& block : blocks_) {
+      if (!visit(block)) return -1;
+    }
+    return total;
+  }
+  auto const& it = terminals_.find(phone_num);
+  if (it == terminals_.end()) return 0;
+  for (auto const& index : it->second) {
+    if (!visit(blocks_[index])) return -1;
+  }
+  return total;
+}
+
+int LocationArchiveReader::Read(std::string const& phone_num,
+                                int64_t const& start_time,
+                                int64_t const& stop_time,
+                                std::vector<LocationRecord>* records) const {
+  if (records == nullptr) return -1;
+  records->clear();
+  int64_t const num = Scan(phone_num, start_time, stop_time,
+      [records] (LocationRecord const* items, size_t const& num) {
+        records->insert(records->end(), items, items+num);
+      });
+  return (num < 0) ? -1 : 0;
+}
+
+}  // namespace libjt808
@@ -0,0 +1,287 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_journal.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 14:05:27
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/location_journal.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+#include <string.h>
+
+
+namespace libjt808 {
+
+namespace {
+
+constexpr uint32_t kJournalMagic = 0x4A383038;  // "J808".
+constexpr uint32_t kJournalVersion = 1;
+constexpr size_t kRecordLengthSize = 2;  // 记录槽中记录长度占用的字节数.
+
+}  // namespace
+
+// 日志文件头, 固定64字节.
+// head和tail为单调递增的读写序号, 第seq条记录位于第(seq % capacity)个记录槽.
+struct LocationJournal::Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;
+  uint32_t slot_size;
+  uint64_t head;  // 最旧记录的序号.
+  uint64_t tail;  // 下一条写入记录的序号.
+  uint8_t reserved[32];
+};
+
+LocationJournal::LocationJournal()
+    : header_(nullptr), slots_(nullptr), map_size_(0), overwritten_(0) {
+#if defined(__linux__)
+  fd_ = -1;
+#elif defined(_WIN32)
+  file_ = nullptr;
+  mapping_ = nullptr;
+#endif
+}
+
+LocationJournal::~LocationJournal() {
+  Close();
+}
+
+// 打开日志文件并映射到内存.
+int LocationJournal::Open(std::string const& path, uint32_t const& capacity,
+                          uint32_t const& slot_size) {
+  static_assert(sizeof(Header) == 64, "journal header must be 64 bytes");
+  if (capacity == 0 || slot_size <= kRecordLengthSize) return -1;
+  Close();
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t const map_size = sizeof(Header) +
+                          static_cast<size_t>(capacity)*slot_size;
+  void* addr = nullptr;
+  bool resized = false;
+#if defined(__linux__)
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return -1;
+  }
+  if (static_cast<size_t>(st.st_size) != map_size) {
+    // 文件大小与配置不一致, 丢弃原有内容.
+    if (ftruncate(fd, 0) != 0 ||
+        ftruncate(fd, static_cast<off_t>(map_size)) != 0) {
+      close(fd);
+      return -1;
+    }
+    resized = true;
+  }
+  addr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+  fd_ = fd;
+#elif defined(_WIN32)
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return -1;
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return -1;
+  }
+  if (static_cast<size_t>(file_size.QuadPart) != map_size) {
+    // 文件大小与配置不一致, 丢弃原有内容.
+    LARGE_INTEGER new_size;
+    new_size.QuadPart = static_cast<LONGLONG>(map_size);
+    if (!SetFilePointerEx(file, new_size, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(file)) {
+      CloseHandle(file);
+      return -1;
+    }
+    resized = true;
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0,
+                                      nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return -1;
+  }
+  addr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, map_size);
+  if (addr == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return -1;
+  }
+  file_ = file;
+  mapping_ = mapping;
+#else
+  return -1;
+#endif
+  header_ = static_cast<Header*>(addr);
+  slots_ = static_cast<uint8_t*>(addr) + sizeof(Header);
+  map_size_ = map_size;
+  overwritten_ = 0;
+  if (resized || header_->magic != kJournalMagic ||
+      header_->version != kJournalVersion ||
+      header_->capacity != capacity || header_->slot_size != slot_size) {
+    memset(header_, 0, sizeof(Header));
+    header_->magic = kJournalMagic;
+    header_->version = kJournalVersion;
+    header_->capacity = capacity;
+    header_->slot_size = slot_size;
+  } else if (header_->tail < header_->head ||
+             header_->tail - header_->head > capacity) {
+    // 文件头已损坏, 丢弃所有记录.
+    header_->head = header_->tail;
+  }
+  return 0;
+}
+
+// 同步并关闭日志文件.
+void LocationJournal::Close(void) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr) return;
+#if defined(__linux__)
+  msync(header_, map_size_, MS_SYNC);
+  munmap(header_, map_size_);
+  close(fd_);
+  fd_ = -1;
+#elif defined(_WIN32)
+  FlushViewOfFile(header_, map_size_);
+  UnmapViewOfFile(header_);
+  CloseHandle(static_cast<HANDLE>(mapping_));
+  CloseHandle(static_cast<HANDLE>(file_));
+  mapping_ = nullptr;
+  file_ = nullptr;
+#endif
+  header_ = nullptr;
+  slots_ = nullptr;
+  map_size_ = 0;
+}
+
+bool LocationJournal::is_open(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return header_ != nullptr;
+}
+
+// 追加一条记录.
+// 先写入记录槽再更新写序号, 进程异常退出时不会读到写了一半的记录.
+int LocationJournal::Append(std::vector<uint8_t> const& record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr || record.empty() ||
+      record.size() > header_->slot_size - kRecordLengthSize ||
+      record.size() > 0xFFFF) {
+    return -1;
+  }
+  if (header_->tail - header_->head >= header_->capacity) {
+    ++header_->head;  // 覆盖最旧的记录.
+    ++overwritten_;
+  }
+  uint8_t* slot = Slot(header_->tail);
+  uint16_t const len = static_cast<uint16_t>(record.size());
+  memcpy(slot, &len, kRecordLengthSize);
+  memcpy(slot + kRecordLengthSize, record.data(), record.size());
+  ++header_->tail;
+  return 0;
+}
+
+// 读取记录但不删除.
+size_t LocationJournal::Peek(size_t const& offset, size_t const& max_num,
+                             size_t const& max_bytes,
+                             std::vector<std::vector<uint8_t>>* records) const {
+  if (records == nullptr) return 0;
+  records->clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr) return 0;
+  size_t bytes = 0;
+  for (uint64_t seq = header_->head + offset;
+       seq < header_->tail && records->size() < max_num; ++seq) {
+    uint8_t const* slot = Slot(seq);
+    uint16_t len = 0;
+    memcpy(&len, slot, kRecordLengthSize);
+    if (len == 0 || len > header_->slot_size - kRecordLengthSize) {
+      records->emplace_back();  // 损坏的记录以空记录返回.
+      continue;
+    }
+    if (bytes + kRecordLengthSize + len > max_bytes) break;
+    bytes += kRecordLengthSize + len;
+    records->emplace_back(slot + kRecordLengthSize,
+                          slot + kRecordLengthSize + len);
+  }
+  return records->size();
+}
+
+// 删除最旧的num条记录.
+void LocationJournal::Pop(size_t const& num) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr) return;
+  uint64_t const cnt = header_->tail - header_->head;
+  header_->head += (num < cnt) ? num : cnt;
+}
+
+// 将日志内容异步刷入磁盘.
+int LocationJournal::Sync(void) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr) return -1;
+#if defined(__linux__)
+  return msync(header_, map_size_, MS_ASYNC);
+#elif defined(_WIN32)
+  return FlushViewOfFile(header_, map_size_) ? 0 : -1;
+#else
+  return -1;
+#endif
+}
+
+size_t LocationJournal::size(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr) return 0;
+  return static_cast<size_t>(header_->tail - header_->head);
+}
+
+size_t LocationJournal::capacity(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr) return 0;
+  return header_->capacity;
+}
+
+uint64_t LocationJournal::overwritten(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return overwritten_;
+}
+
+uint8_t* LocationJournal::Slot(uint64_t const& seq) const {
+  return slots_ + (seq % header_->capacity) * header_->slot_size;
+}
+
+}  // namespace libjt808
@@ -31,6 +31,8 @@
 
 #include <string.h>
 
+#include "jt808/bcd.h"
+#include "jt808/scratch_buffer.h"
 #include "jt808/util.h"
 
 
@@ -52,7 +54,7 @@ int SetOverSpeedAlarmBody(uint8_t const& location_type,
 }
 
 // 获得超速报警报警附加信息消息体.
-int GetOverSpeedAlarmBody(std::vector<uint8_t> const& out,
+int GetOverSpeedAlarmBody(LocationExtensionValue const& out,
                           uint8_t* location_type,
                           uint32_t* area_route_id) {
   if (location_type == nullptr || area_route_id == nullptr) return -1;
@@ -83,7 +85,7 @@ int SetAccessAreaAlarmBody(uint8_t const& location_type,
 }
 
 // 获得进出区域/路线报警附加信息消息体.
-int GetAccessAreaAlarmBody(std::vector<uint8_t> const& out,
+int GetAccessAreaAlarmBody(LocationExtensionValue const& out,
                            uint8_t* location_type,
                            uint32_t* area_route_id,
                            uint8_t* direction) {
@@ -99,4 +101,294 @@ int GetAccessAreaAlarmBody(std::vector<uint8_t> const& out,
   return 0;
 }
 
+// 设置路段行驶时间不足/过长报警附加信息消息体.
+int SetDrivingTimeAlarmBody(uint32_t const& segment_id,
+                            uint16_t const& driving_time,
+                            uint8_t const& result,
+                            std::vector<uint8_t>* out) {
+  if (out == nullptr) return -1;
+  out->clear();
+  U32ToU8Array u32converter;
+  u32converter.u32val = libjt808::EndianSwap32(segment_id);
+  for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
+  out->push_back(static_cast<uint8_t>(driving_time >> 8));
+  out->push_back(static_cast<uint8_t>(driving_time));
+  out->push_back(result);
+  return 0;
+}
+
+// 获得路段行驶时间不足/过长报警附加信息消息体.
+int GetDrivingTimeAlarmBody(LocationExtensionValue const& out,
+                            uint32_t* segment_id,
+                            uint16_t* driving_time,
+                            uint8_t* result) {
+  if (segment_id == nullptr ||
+      driving_time == nullptr ||
+      result == nullptr ||
+      out.size() != 7) return -1;
+  U32ToU8Array u32converter;
+  memcpy(u32converter.u8array, &(out[0]), 4);
+  *segment_id = EndianSwap32(u32converter.u32val);
+  *driving_time = static_cast<uint16_t>(out[4] << 8 | out[5]);
+  *result = out[6];
+  return 0;
+}
+
+// 封装位置信息汇报消息体.
+int PackageLocationReportBody(LocationBasicInformation const& basic_info,
+                              LocationExtensions const& extension_info,
+                              std::vector<uint8_t>* out) {
+  if (out == nullptr) return -1;
+  int msg_len = 28;
+  U32ToU8Array u32converter;
+  // 报警标志.
+  u32converter.u32val = EndianSwap32(basic_info.alarm.value);
+  for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
+  // 状态.
+  u32converter.u32val = EndianSwap32(basic_info.status.value);
+  for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
+  // 纬度.
+  u32converter.u32val = EndianSwap32(basic_info.latitude);
+  for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
+  // 经度.
+  u32converter.u32val = EndianSwap32(basic_info.longitude);
+  for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
+  U16ToU8Array u16converter;
+  // 海拔高程.
+  u16converter.u16val = EndianSwap16(basic_info.altitude);
+  for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
+  // 速度.
+  u16converter.u16val = EndianSwap16(basic_info.speed);
+  for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
+  // 方向.
+  u16converter.u16val = EndianSwap16(basic_info.bearing);
+  for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
+  // UTC时间(BCD-8421码), 未设置时间字符串时由时间戳生成.
+  if (!basic_info.time.empty()) {
+    ScratchBuffer bcd;
+    StringToBcd(basic_info.time, bcd.get());
+    out->insert(out->end(), bcd->begin(), bcd->end());
+  } else {
+    uint8_t bcd[6] = {0};
+    TimestampToBcdTime(basic_info.timestamp, bcd);
+    out->insert(out->end(), bcd, bcd+6);
+  }
+  ScratchBuffer scratch;
+  auto& extension_custom = *scratch;
+  // 位置附加信息项.
+  for (auto const& item : extension_info) {
+    if (item.first <= kCustomInformationLength) {
+      out->push_back(item.first);
+      if (item.first == kCustomInformationLength) continue;
+      out->push_back(item.second.size());
+      msg_len += 2 + item.second.size();
+      out->insert(out->end(), item.second.begin(), item.second.end());
+    } else if (item.first > kCustomInformationLength) {
+      extension_custom.push_back(item.first);
+      extension_custom.push_back(item.second.size());
+      extension_custom.insert(extension_custom.end(),
+                              item.second.begin(), item.second.end());
+    }
+  }
+  auto const& length = extension_custom.size();
+  if (length >= 256) {
+    out->push_back(2);
+    out->push_back(length%65536/256);
+    out->push_back(length%256);
+    msg_len += 4;
+  } else if (length > 0) {
+    out->push_back(1);
+    out->push_back(length%256);
+    msg_len += 3;
+  } else if (extension_info.find(kCustomInformationLength) !=
+             extension_info.end()) {  // 没有后续自定义信息.
+    out->pop_back();
+  }
+  for (auto const& uch : extension_custom) out->push_back(uch);
+  msg_len += length;
+  return msg_len;
+}
+
+// 解析位置基本信息.
+int ParseLocationBasicInformation(uint8_t const* in, size_t const& len,
+                                  LocationBasicInformation* basic_info,
+                                  bool const& time_string) {
+  if (in == nullptr || basic_info == nullptr || len < 28) return -1;
+  U32ToU8Array u32converter;
+  // 报警标志.
+  memcpy(u32converter.u8array, &(in[0]), 4);
+  basic_info->alarm.value = EndianSwap32(u32converter.u32val);
+  // 状态.
+  memcpy(u32converter.u8array, &(in[4]), 4);
+  basic_info->status.value = EndianSwap32(u32converter.u32val);
+  // 纬度.
+  memcpy(u32converter.u8array, &(in[8]), 4);
+  basic_info->latitude = EndianSwap32(u32converter.u32val);
+  // 经度.
+  memcpy(u32converter.u8array, &(in[12]), 4);
+  basic_info->longitude = EndianSwap32(u32converter.u32val);
+  U16ToU8Array u16converter;
+  // 海拔高程.
+  memcpy(u16converter.u8array, &(in[16]), 2);
+  basic_info->altitude = EndianSwap16(u16converter.u16val);
+  // 速度.
+  memcpy(u16converter.u8array, &(in[18]), 2);
+  basic_info->speed = EndianSwap16(u16converter.u16val);
+  // 方向.
+  memcpy(u16converter.u8array, &(in[20]), 2);
+  basic_info->bearing = EndianSwap16(u16converter.u16val);
+  // UTC时间(BCD-8421码).
+  if (BcdTimeToTimestamp(&(in[22]), &basic_info->timestamp) != 0) {
+    basic_info->timestamp = 0;
+  }
+  if (time_string) {
+    ScratchBuffer bcd;
+    bcd->assign(in+22, in+28);
+    BcdToStringFillZero(*bcd, &basic_info->time);
+  } else {
+    basic_info->time.clear();
+  }
+  return 0;
+}
+
+// 解析位置信息汇报消息体.
+int ParseLocationReportBody(uint8_t const* in, size_t const& len,
+                            LocationBasicInformation* basic_info,
+                            LocationExtensions* extension_info,
+                            bool const& time_string) {
+  if (extension_info == nullptr ||
+      ParseLocationBasicInformation(in, len, basic_info, time_string) != 0) {
+    return -1;
+  }
+  // 位置附加信息项.
+  size_t pos = 28;
+  while (pos+2 <= len) {  // 附加信息长度至少为1.
+    size_t const item_len = in[pos+1];
+    if (pos+2+item_len > len) return -1;  // 附加信息长度超出范围.
+    (*extension_info)[in[pos]].assign(in+pos+2, in+pos+2+item_len);
+    pos += 2 + item_len;
+  }
+  return 0;
+}
+
+void LocationExtensionView::Reset(void) {
+  body_ = nullptr;
+  len_ = 0;
+  num_ = 0;
+  memset(offsets_, 0, sizeof(offsets_));
+}
+
+// 只遍历一次消息体记录各附加信息项的偏移.
+int LocationExtensionView::Init(uint8_t const* body, size_t const& len) {
+  Reset();
+  if (body == nullptr || len < 28 || len > 0xFFFF) return -1;
+  size_t pos = 28;
+  while (pos+2 <= len) {
+    size_t const item_len = body[pos+1];
+    if (pos+2+item_len > len) {  // 附加信息长度超出范围.
+      Reset();
+      return -1;
+    }
+    offsets_[body[pos]] = static_cast<uint16_t>(pos);
+    ++num_;
+    pos += 2 + item_len;
+  }
+  body_ = body;
+  len_ = len;
+  return 0;
+}
+
+bool LocationExtensionView::Find(uint8_t const& id, uint8_t const** data,
+                                 size_t* len) const {
+  auto const& pos = offsets_[id];
+  if (pos == 0) return false;
+  if (data != nullptr) *data = body_+pos+2;
+  if (len != nullptr) *len = body_[pos+1];
+  return true;
+}
+
+void LocationExtensionView::ToExtensions(
+    LocationExtensions* extensions) const {
+  if (extensions == nullptr) return;
+  ForEach([extensions] (uint8_t const& id, uint8_t const* data,
+                        size_t const& len) {
+    (*extensions)[id].assign(data, data+len);
+  });
+}
+
+bool LocationExtensionView::GetU8(uint8_t const& id, uint8_t* value) const {
+  uint8_t const* data;
+  size_t len;
+  if (value == nullptr || !Find(id, &data, &len) || len != 1) return false;
+  *value = data[0];
+  return true;
+}
+
+bool LocationExtensionView::GetU16(uint8_t const& id, uint16_t* value) const {
+  uint8_t const* data;
+  size_t len;
+  if (value == nullptr || !Find(id, &data, &len) || len != 2) return false;
+  *value = static_cast<uint16_t>(data[0] << 8 | data[1]);
+  return true;
+}
+
+bool LocationExtensionView::GetU32(uint8_t const& id, uint32_t* value) const {
+  uint8_t const* data;
+  size_t len;
+  if (value == nullptr || !Find(id, &data, &len) || len != 4) return false;
+  *value = static_cast<uint32_t>(data[0]) << 24 | data[1] << 16 |
+           data[2] << 8 | data[3];
+  return true;
+}
+
+bool LocationExtensionView::GetOverSpeedAlarm(uint8_t* location_type,
+                                              uint32_t* area_route_id) const {
+  uint8_t const* data;
+  size_t len;
+  if (location_type == nullptr || area_route_id == nullptr ||
+      !Find(kOverSpeedAlarm, &data, &len) || (len != 1 && len != 5)) {
+    return false;
+  }
+  *location_type = data[0];
+  *area_route_id = 0;
+  if (len == 5) {
+    *area_route_id = static_cast<uint32_t>(data[1]) << 24 | data[2] << 16 |
+                     data[3] << 8 | data[4];
+  }
+  return true;
+}
+
+bool LocationExtensionView::GetAccessAreaAlarm(uint8_t* location_type,
+                                               uint32_t* area_route_id,
+                                               uint8_t* direction) const {
+  uint8_t const* data;
+  size_t len;
+  if (location_type == nullptr || area_route_id == nullptr ||
+      direction == nullptr || !Find(kAccessAreaAlarm, &data, &len) ||
+      len != 6) {
+    return false;
+  }
+  *location_type = data[0];
+  *area_route_id = static_cast<uint32_t>(data[1]) << 24 | data[2] << 16 |
+                   data[3] << 8 | data[4];
+  *direction = data[5];
+  return true;
+}
+
+bool LocationExtensionView::GetDrivingTimeAlarm(uint32_t* route_id,
+                                                uint16_t* driving_time,
+                                                uint8_t* result) const {
+  uint8_t const* data;
+  size_t len;
+  if (route_id == nullptr || driving_time == nullptr || result == nullptr ||
+      !Find(kDrivingTimeAlarm, &data, &len) || len != 7) {
+    return false;
+  }
+  *route_id = static_cast<uint32_t>(data[0]) << 24 | data[1] << 16 |
+              data[2] << 8 | data[3];
+  *driving_time = static_cast<uint16_t>(data[4] << 8 | data[5]);
+  *result = data[6];
+  return true;
+}
+
 }  // namespace libjt808
@@ -0,0 +1,136 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_stream.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 20:31:08
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/location_stream.h"
+
+#include <string.h>
+
+#include <chrono>
+
+
+namespace libjt808 {
+
+void FillLocationRecord(LocationBasicInformation const& info,
+                        std::string const& phone_num,
+                        LocationRecord* record) {
+  if (record == nullptr) return;
+  memset(record->phone_num, 0, sizeof(record->phone_num));
+  memcpy(record->phone_num, phone_num.data(),
+         (phone_num.size() < sizeof(record->phone_num)) ?
+             phone_num.size() : sizeof(record->phone_num));
+  record->timestamp = info.timestamp;
+  record->alarm = info.alarm.value;
+  record->status = info.status.value;
+  record->latitude = info.latitude;
+  record->longitude = info.longitude;
+  record->altitude = info.altitude;
+  record->speed = info.speed;
+  record->bearing = info.bearing;
+  record->batch = 0;
+  record->reserved = 0;
+}
+
+LocationStream::LocationStream(size_t const& capacity)
+    : queue_(capacity), max_records_(256), max_delay_ms_(100) {
+  running_.store(false);
+  waiting_.store(false);
+  dropped_.store(0);
+}
+
+LocationStream::~LocationStream() {
+  Stop();
+}
+
+int LocationStream::Start(BatchCallback const& callback) {
+  if (!callback || running_.load()) return -1;
+  callback_ = callback;
+  running_.store(true);
+  consumer_thread_ = std::thread(&LocationStream::ConsumerHandler, this);
+  return 0;
+}
+
+void LocationStream::Stop(void) {
+  if (!running_.load()) return;
+  running_.store(false);
+  {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    wait_cond_.notify_one();
+  }
+  if (consumer_thread_.joinable()) consumer_thread_.join();
+}
+
+bool LocationStream::Push(LocationRecord const& record) {
+  if (!running_.load(std::memory_order_relaxed)) return false;
+  if (!queue_.TryPush(record)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (waiting_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    wait_cond_.notify_one();
+  }
+  return true;
+}
+
+// 取满一批或首条记录等待超时后回调.
+// 队列为空时等待新记录, 只有消费线程等待时生产者才需要加锁唤醒.
+void LocationStream::ConsumerHandler(void) {
+  std::vector<LocationRecord> batch(max_records_);
+  size_t num = 0;
+  auto deadline = std::chrono::steady_clock::now();
+  while (1) {
+    bool const running = running_.load();
+    while (num < max_records_ && queue_.TryPop(&batch[num])) {
+      if (num == 0) {
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(max_delay_ms_);
+      }
+      ++num;
+    }
+    if (num > 0 && (num >= max_records_ || !running ||
+                    std::chrono::steady_clock::now() >= deadline)) {
+      callback_(batch.data(), num);
+      num = 0;
+      continue;
+    }
+    if (!running) break;
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    waiting_.store(true, std::memory_order_release);
+    if (queue_.empty_approx() && running_.load()) {
+      if (num > 0) {
+        wait_cond_.wait_until(lock, deadline);
+      } else {
+        wait_cond_.wait_for(lock, std::chrono::milliseconds(100));
+      }
+    }
+    waiting_.store(false, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace libjt808
@@ -0,0 +1,262 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  logger.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 19:05:12
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/logger.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <chrono>
+
+
+namespace libjt808 {
+
+namespace {
+
+int64_t SystemTimeUs(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t SteadyTimeUs(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+char const kLevelChars[] = {'D', 'I', 'W', 'E'};
+
+}  // namespace
+
+constexpr size_t Logger::kMaxLineLength;
+
+Logger::Logger(size_t const& capacity) : queue_(capacity) {
+  level_.store(kLogInfo);
+  dropped_.store(0);
+  pushed_.store(0);
+  written_.store(0);
+  output_is_running_.store(false);
+  output_is_waiting_.store(false);
+}
+
+Logger::~Logger() {
+  if (output_is_running_) {
+    output_is_running_.store(false);
+    wait_cond_.notify_one();
+    if (output_thread_.joinable()) output_thread_.join();
+  }
+}
+
+// 全局日志在首次使用时构造, 进程退出时输出剩余日志.
+Logger& Logger::Instance(void) {
+  static Logger logger;
+  return logger;
+}
+
+void Logger::SetSink(LogSink const& sink) {
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  sink_ = sink;
+}
+
+void Logger::Log(LogLevel const& level, char const* fmt, ...) {
+  if (!IsEnabled(level) || level >= kLogOff || fmt == nullptr) return;
+  Record record;
+  record.level = level;
+  record.time_us = SystemTimeUs();
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(record.text, sizeof(record.text), fmt, args);
+  va_end(args);
+  if (len < 0) return;
+  if (len >= static_cast<int>(sizeof(record.text))) {
+    len = sizeof(record.text)-1;
+  }
+  // 去掉结尾换行符, 由输出线程统一添加.
+  while (len > 0 &&
+         (record.text[len-1] == '\n' || record.text[len-1] == '\r')) {
+    --len;
+  }
+  record.len = static_cast<uint16_t>(len);
+  Push(&record);
+}
+
+void Logger::Write(LogLevel const& level, std::string const& text) {
+  if (!IsEnabled(level) || level >= kLogOff) return;
+  Record record;
+  record.level = level;
+  record.time_us = SystemTimeUs();
+  size_t begin = 0;
+  while (begin < text.size()) {
+    size_t end = text.find('\n', begin);
+    if (end == std::string::npos) end = text.size();
+    size_t len = end-begin;
+    if (len > 0 && text[end-1] == '\r') --len;
+    if (len >= sizeof(record.text)) len = sizeof(record.text)-1;
+    memcpy(record.text, text.data()+begin, len);
+    record.len = static_cast<uint16_t>(len);
+    Push(&record);
+    begin = end+1;
+  }
+}
+
+void Logger::Push(Record* record) {
+  std::call_once(start_flag_, [this] {
+    output_is_running_.store(true);
+    output_thread_ = std::thread(&Logger::OutputHandler, this);
+  });
+  if (!queue_.TryPush(std::move(*record))) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  pushed_.fetch_add(1, std::memory_order_release);
+  if (output_is_waiting_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    wait_cond_.notify_one();
+  }
+}
+
+void Logger::Flush(void) {
+  if (!output_is_running_) return;
+  auto const target = pushed_.load(std::memory_order_acquire);
+  while (written_.load(std::memory_order_acquire) < target &&
+         output_is_running_) {
+    {
+      std::lock_guard<std::mutex> lock(wait_mutex_);
+      wait_cond_.notify_one();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+// 后台输出线程, 队列为空时等待新日志, 退出前输出剩余日志.
+void Logger::OutputHandler(void) {
+  Record record;
+  uint64_t reported_dropped = 0;
+  while (1) {
+    bool const running = output_is_running_.load();
+    size_t num = 0;
+    while (queue_.TryPop(&record)) {
+      Output(record);
+      written_.fetch_add(1, std::memory_order_release);
+      ++num;
+    }
+    auto const dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_dropped) {
+      record.level = kLogWarning;
+      record.time_us = SystemTimeUs();
+      record.len = snprintf(record.text, sizeof(record.text),
+          "%lu log messages dropped",
+          static_cast<unsigned long>(dropped-reported_dropped));
+      Output(record);
+      reported_dropped = dropped;
+      ++num;
+    }
+    if (num > 0) {
+      std::lock_guard<std::mutex> lock(sink_mutex_);
+      if (!sink_) fflush(stdout);
+      continue;
+    }
+    if (!running) break;
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    output_is_waiting_.store(true, std::memory_order_release);
+    if (queue_.empty_approx() && output_is_running_) {
+      wait_cond_.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    output_is_waiting_.store(false, std::memory_order_relaxed);
+  }
+}
+
+// 添加时间和级别前缀后输出, 格式: "2026-10-18 19:05:12.345678 E text".
+void Logger::Output(Record const& record) {
+  time_t const sec = static_cast<time_t>(record.time_us/1000000);
+  struct tm tm_time;
+#if defined(__linux__)
+  localtime_r(&sec, &tm_time);
+#elif defined(_WIN32)
+  localtime_s(&tm_time, &sec);
+#endif
+  char line[kMaxLineLength+64];
+  size_t len = strftime(line, sizeof(line), "%Y-%m-%d %H:%M:%S", &tm_time);
+  len += snprintf(line+len, sizeof(line)-len, ".%06d %c ",
+                  static_cast<int>(record.time_us%1000000),
+                  kLevelChars[record.level]);
+  memcpy(line+len, record.text, record.len);
+  len += record.len;
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  if (sink_) {
+    sink_(record.level, line, len);
+  } else {
+    line[len++] = '\n';
+    fwrite(line, 1, len, stdout);
+  }
+}
+
+void StringAppendF(std::string* out, char const* fmt, ...) {
+  if (out == nullptr || fmt == nullptr) return;
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (len < 0) return;
+  if (len < static_cast<int>(sizeof(buf))) {
+    out->append(buf, len);
+    return;
+  }
+  // 超出栈上缓冲区时直接格式化到字符串末尾.
+  auto const old_size = out->size();
+  out->resize(old_size+len+1);
+  va_start(args, fmt);
+  vsnprintf(&(*out)[old_size], len+1, fmt, args);
+  va_end(args);
+  out->resize(old_size+len);
+}
+
+LogRateLimiter::LogRateLimiter(int const& interval_ms)
+    : interval_us_(static_cast<int64_t>(interval_ms)*1000) {
+  next_us_.store(0);
+  suppressed_.store(0);
+}
+
+bool LogRateLimiter::Allow(uint64_t* suppressed) {
+  auto const now = SteadyTimeUs();
+  auto next = next_us_.load(std::memory_order_relaxed);
+  if (now < next ||
+      !next_us_.compare_exchange_strong(next, now+interval_us_,
+                                        std::memory_order_relaxed)) {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  auto const num = suppressed_.exchange(0, std::memory_order_relaxed);
+  if (suppressed != nullptr) *suppressed = num;
+  return true;
+}
+
+}  // namespace libjt808
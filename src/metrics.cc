@@ -0,0 +1,376 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  metrics.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 18:26:51
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/metrics.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+#include "jt808/logger.h"
+#include "jt808/parser.h"
+
+
+namespace libjt808 {
+
+namespace {
+
+// 消息ID分槽: 0x0000-0x0FFF, 0x8000-0x8FFF各占0x1000个槽, 其它ID共用最后一个槽.
+constexpr size_t kMsgIdSlotNum = 0x2000 + 1;
+constexpr size_t kMsgIdOtherSlot = 0x2000;
+
+inline size_t MsgIdSlot(uint16_t const& msg_id) {
+  if (msg_id & 0x7000) return kMsgIdOtherSlot;
+  return ((msg_id >> 3) & 0x1000) | (msg_id & 0x0FFF);
+}
+
+inline uint16_t SlotMsgId(size_t const& slot) {
+  return (slot & 0x1000) ? (0x8000 | (slot & 0x0FFF)) : slot;
+}
+
+// 分片只由所属线程写入, 用relaxed的读和写代替原子自增, 避免总线锁.
+inline void Add(std::atomic<uint64_t>* counter, uint64_t const& value) {
+  counter->store(counter->load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+}
+
+inline uint64_t Load(std::atomic<uint64_t> const& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+enum HistogramIndex {
+  kHistogramHandshake = 0,
+  kHistogramDispatch,
+  kHistogramAck,
+  kHistogramCallbackWait,
+  kHistogramNum,
+};
+
+// 单线程写入的直方图.
+struct ShardHistogram {
+  std::atomic<uint64_t> counts[LatencyHistogram::kBucketNum];
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> max;
+
+  void Record(uint64_t const& value) {
+    Add(&counts[LatencyHistogram::BucketIndex(value)], 1);
+    Add(&sum, value);
+    if (value > Load(max)) max.store(value, std::memory_order_relaxed);
+  }
+  void MergeTo(LatencyHistogram* hist) const {
+    for (size_t i = 0; i < LatencyHistogram::kBucketNum; ++i) {
+      hist->AddBucket(i, Load(counts[i]));
+    }
+    hist->AddSummary(Load(sum), Load(max));
+  }
+};
+
+// 线程局部缓存, 记录当前线程最近使用的注册表及其分片.
+struct LocalCache {
+  uint64_t id;
+  void* shard;
+};
+
+thread_local LocalCache local_cache = {0, nullptr};
+
+std::atomic<uint64_t> next_metrics_id(1);
+
+char const* const kParseFailureNames[kMetricsParseFailureNum] = {
+  "checksum", "unknown_id", "short_frame", "other",
+};
+
+void AppendSummary(std::string* out, char const* name, char const* help,
+                   LatencyHistogram const& hist) {
+  StringAppendF(out, "# HELP %s %s\n# TYPE %s summary\n", name, help, name);
+  double const quantiles[] = {0.5, 0.9, 0.99, 0.999};
+  for (auto const& q : quantiles) {
+    StringAppendF(out, "%s{quantile=\"%g\"} %lu\n", name, q,
+                  static_cast<unsigned long>(hist.Percentile(q*100)));
+  }
+  StringAppendF(out, "%s_sum %lu\n%s_count %lu\n",
+                name, static_cast<unsigned long>(hist.sum()),
+                name, static_cast<unsigned long>(hist.count()));
+}
+
+void AppendFrames(std::string* out, char const* name, char const* help,
+                  std::map<uint16_t, uint64_t> const& frames,
+                  uint64_t const& other) {
+  StringAppendF(out, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+  for (auto const& item : frames) {
+    StringAppendF(out, "%s{msg_id=\"0x%04X\"} %lu\n", name, item.first,
+                  static_cast<unsigned long>(item.second));
+  }
+  if (other > 0) {
+    StringAppendF(out, "%s{msg_id=\"other\"} %lu\n", name,
+                  static_cast<unsigned long>(other));
+  }
+}
+
+}  // namespace
+
+// 线程分片.
+struct Metrics::Shard {
+  std::atomic<uint64_t> frames_in[kMsgIdSlotNum];
+  std::atomic<uint64_t> frames_out[kMsgIdSlotNum];
+  std::atomic<uint64_t> parse_failures[kMetricsParseFailureNum];
+  std::atomic<uint64_t> bytes_in;
+  std::atomic<uint64_t> bytes_out;
+  std::atomic<uint64_t> callbacks_dropped;
+  ShardHistogram histograms[kHistogramNum];
+};
+
+Metrics::Metrics() : id_(next_metrics_id.fetch_add(1)) {
+  active_sessions_.store(0);
+  exporter_running_.store(false);
+}
+
+Metrics::~Metrics() {
+  StopExporter();
+}
+
+inline Metrics::Shard* Metrics::LocalShard(void) {
+  if (local_cache.id == id_) return static_cast<Shard*>(local_cache.shard);
+  return AttachShard();
+}
+
+// 查找或分配当前线程的分片, 并更新线程局部缓存.
+Metrics::Shard* Metrics::AttachShard(void) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& shard = shards_[std::this_thread::get_id()];
+  if (shard == nullptr) shard.reset(new Shard());  // 值初始化, 计数清零.
+  local_cache.id = id_;
+  local_cache.shard = shard.get();
+  return shard.get();
+}
+
+void Metrics::AddFrameIn(uint16_t const& msg_id) {
+  Add(&LocalShard()->frames_in[MsgIdSlot(msg_id)], 1);
+}
+
+void Metrics::AddFrameOut(uint16_t const& msg_id) {
+  Add(&LocalShard()->frames_out[MsgIdSlot(msg_id)], 1);
+}
+
+void Metrics::AddBytesIn(size_t const& bytes) {
+  Add(&LocalShard()->bytes_in, bytes);
+}
+
+void Metrics::AddBytesOut(size_t const& bytes) {
+  Add(&LocalShard()->bytes_out, bytes);
+}
+
+void Metrics::AddParseFailure(int const& error) {
+  int reason = kMetricsParseOther;
+  if (error == kParseErrorChecksum) {
+    reason = kMetricsParseChecksum;
+  } else if (error == kParseErrorUnknownId) {
+    reason = kMetricsParseUnknownId;
+  } else if (error == kParseErrorShortFrame) {
+    reason = kMetricsParseShortFrame;
+  }
+  Add(&LocalShard()->parse_failures[reason], 1);
+}
+
+void Metrics::SetActiveSessions(int64_t const& num) {
+  active_sessions_.store(num, std::memory_order_relaxed);
+}
+
+void Metrics::RecordHandshakeDuration(uint64_t const& us) {
+  LocalShard()->histograms[kHistogramHandshake].Record(us);
+}
+
+void Metrics::RecordDispatchLatency(uint64_t const& us) {
+  LocalShard()->histograms[kHistogramDispatch].Record(us);
+}
+
+void Metrics::RecordAckLatency(uint64_t const& us) {
+  LocalShard()->histograms[kHistogramAck].Record(us);
+}
+
+void Metrics::AddCallbackDropped(void) {
+  Add(&LocalShard()->callbacks_dropped, 1);
+}
+
+void Metrics::RecordCallbackQueueWait(uint64_t const& us) {
+  LocalShard()->histograms[kHistogramCallbackWait].Record(us);
+}
+
+// 合并所有分片.
+void Metrics::Snapshot(MetricsSnapshot* snapshot) const {
+  if (snapshot == nullptr) return;
+  snapshot->frames_in.clear();
+  snapshot->frames_out.clear();
+  snapshot->frames_in_other = 0;
+  snapshot->frames_out_other = 0;
+  memset(snapshot->parse_failures, 0, sizeof(snapshot->parse_failures));
+  snapshot->bytes_in = 0;
+  snapshot->bytes_out = 0;
+  snapshot->callbacks_dropped = 0;
+  snapshot->handshake_duration_us.Reset();
+  snapshot->dispatch_latency_us.Reset();
+  snapshot->ack_latency_us.Reset();
+  snapshot->callback_queue_wait_us.Reset();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto const& item : shards_) {
+    Shard const& shard = *item.second;
+    for (size_t slot = 0; slot < kMsgIdOtherSlot; ++slot) {
+      uint64_t const in = Load(shard.frames_in[slot]);
+      uint64_t const out = Load(shard.frames_out[slot]);
+      if (in > 0) snapshot->frames_in[SlotMsgId(slot)] += in;
+      if (out > 0) snapshot->frames_out[SlotMsgId(slot)] += out;
+    }
+    snapshot->frames_in_other += Load(shard.frames_in[kMsgIdOtherSlot]);
+    snapshot->frames_out_other += Load(shard.frames_out[kMsgIdOtherSlot]);
+    for (int i = 0; i < kMetricsParseFailureNum; ++i) {
+      snapshot->parse_failures[i] += Load(shard.parse_failures[i]);
+    }
+    snapshot->bytes_in += Load(shard.bytes_in);
+    snapshot->bytes_out += Load(shard.bytes_out);
+    snapshot->callbacks_dropped += Load(shard.callbacks_dropped);
+    shard.histograms[kHistogramHandshake].MergeTo(
+        &snapshot->handshake_duration_us);
+    shard.histograms[kHistogramDispatch].MergeTo(
+        &snapshot->dispatch_latency_us);
+    shard.histograms[kHistogramAck].MergeTo(&snapshot->ack_latency_us);
+    shard.histograms[kHistogramCallbackWait].MergeTo(
+        &snapshot->callback_queue_wait_us);
+  }
+  snapshot->active_sessions = active_sessions_.load();
+}
+
+std::string Metrics::PrometheusText(void) const {
+  MetricsSnapshot snapshot;
+  Snapshot(&snapshot);
+  std::string out;
+  AppendFrames(&out, "jt808_frames_in_total",
+               "Frames received by message id.",
+               snapshot.frames_in, snapshot.frames_in_other);
+  AppendFrames(&out, "jt808_frames_out_total",
+               "Frames sent by message id.",
+               snapshot.frames_out, snapshot.frames_out_other);
+  StringAppendF(&out, "# HELP jt808_parse_failures_total Frames failed to "
+                "parse by reason.\n# TYPE jt808_parse_failures_total counter\n");
+  for (int i = 0; i < kMetricsParseFailureNum; ++i) {
+    StringAppendF(&out, "jt808_parse_failures_total{reason=\"%s\"} %lu\n",
+                  kParseFailureNames[i],
+                  static_cast<unsigned long>(snapshot.parse_failures[i]));
+  }
+  StringAppendF(&out, "# HELP jt808_bytes_in_total Bytes received.\n"
+                "# TYPE jt808_bytes_in_total counter\n"
+                "jt808_bytes_in_total %lu\n",
+                static_cast<unsigned long>(snapshot.bytes_in));
+  StringAppendF(&out, "# HELP jt808_bytes_out_total Bytes sent.\n"
+                "# TYPE jt808_bytes_out_total counter\n"
+                "jt808_bytes_out_total %lu\n",
+                static_cast<unsigned long>(snapshot.bytes_out));
+  StringAppendF(&out, "# HELP jt808_active_sessions Authenticated sessions.\n"
+                "# TYPE jt808_active_sessions gauge\n"
+                "jt808_active_sessions %ld\n",
+                static_cast<long>(snapshot.active_sessions));
+  AppendSummary(&out, "jt808_handshake_duration_microseconds",
+                "Time from accept to successful authentication.",
+                snapshot.handshake_duration_us);
+  AppendSummary(&out, "jt808_dispatch_latency_microseconds",
+                "Time from receiving a frame to finishing its handling.",
+                snapshot.dispatch_latency_us);
+  AppendSummary(&out, "jt808_ack_latency_microseconds",
+                "Time from sending a command to the terminal response.",
+                snapshot.ack_latency_us);
+  AppendSummary(&out, "jt808_callback_queue_wait_microseconds",
+                "Time application callbacks wait in the worker queue.",
+                snapshot.callback_queue_wait_us);
+  StringAppendF(&out, "# HELP jt808_callbacks_dropped_total Application "
+                "callbacks dropped because the worker queue was full.\n"
+                "# TYPE jt808_callbacks_dropped_total counter\n"
+                "jt808_callbacks_dropped_total %lu\n",
+                static_cast<unsigned long>(snapshot.callbacks_dropped));
+  return out;
+}
+
+int Metrics::StartExporter(std::string const& path) {
+#if defined(__linux__)
+  if (exporter_running_.load()) return -1;
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) return -1;
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, 8) != 0) {
+    close(fd);
+    return -1;
+  }
+  exporter_path_ = path;
+  exporter_running_.store(true);
+  exporter_thread_ = std::thread(&Metrics::ExporterHandler, this, fd);
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+void Metrics::StopExporter(void) {
+  exporter_running_.store(false);
+  if (exporter_thread_.joinable()) exporter_thread_.join();
+}
+
+// 指标输出线程处理函数.
+void Metrics::ExporterHandler(int const& listen_fd) {
+#if defined(__linux__)
+  while (exporter_running_) {
+    struct pollfd pfd;
+    pfd.fd = listen_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 200) <= 0) continue;
+    int const fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) continue;
+    std::string const text = PrometheusText();
+    size_t offset = 0;
+    while (offset < text.size()) {
+      ssize_t const ret = send(fd, text.data()+offset, text.size()-offset,
+                               MSG_NOSIGNAL);
+      if (ret <= 0) break;
+      offset += static_cast<size_t>(ret);
+    }
+    close(fd);
+  }
+  close(listen_fd);
+  unlink(exporter_path_.c_str());
+#endif
+}
+
+}  // namespace libjt808
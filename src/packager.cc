@@ -30,6 +30,7 @@
 #include "jt808/packager.h"
 
 #include "jt808/bcd.h"
+#include "jt808/scratch_buffer.h"
 #include "jt808/util.h"
 
 
@@ -51,9 +52,9 @@ int JT808FrameHeadPackage(MsgHead const& msg_head,
   u16converter.u16val =  EndianSwap16(msg_head.msgbody_attr.u16val);
   for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
   // 终端手机号(BCD码).
-  std::vector<uint8_t> phone_num_bcd;
-  if (StringToBcd(msg_head.phone_num, &phone_num_bcd) != 0) return -1;
-  for (auto& u8val : phone_num_bcd) out->push_back(u8val);
+  ScratchBuffer phone_num_bcd;
+  if (StringToBcd(msg_head.phone_num, phone_num_bcd.get()) != 0) return -1;
+  out->insert(out->end(), phone_num_bcd->begin(), phone_num_bcd->end());
   // 消息流水号.
   u16converter.u16val = EndianSwap16(msg_head.msg_flow_num);
   for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
@@ -83,16 +84,83 @@ int JT808MsgBodyLengthFix(MsgHead const& msg_head,
 }
 
 // JT808协议转义.
+// 转义前的数据换到线程私有缓冲区, out和缓冲区的容量都可被复用.
 int JT808MsgEscape(std::vector<uint8_t>* out) {
   *(out->begin()) = 0x00;
   *(out->end()-1) = 0x00;
-  auto in = std::move(*out);
-  if (Escape(in, out) < 0) return -1;
+  ScratchBuffer in;
+  in->swap(*out);
+  if (Escape(*in, out) < 0) return -1;
   *(out->begin()) = PROTOCOL_SIGN;
   *(out->end()-1) = PROTOCOL_SIGN;
   return 0;
 }
 
+// 写入大端序的WORD.
+void PackageU16(uint16_t const& value, std::vector<uint8_t>* out) {
+  U16ToU8Array u16converter;
+  u16converter.u16val = EndianSwap16(value);
+  for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
+}
+
+// 写入大端序的DWORD.
+void PackageU32(uint32_t const& value, std::vector<uint8_t>* out) {
+  U32ToU8Array u32converter;
+  u32converter.u32val = EndianSwap32(value);
+  for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
+}
+
+// 经纬度(度)四舍五入为百万分之一度.
+uint32_t ToMicroDegree(double const& degree) {
+  return static_cast<uint32_t>(degree*1e6 + 0.5);
+}
+
+// 写入起始时间和结束时间, 均为BCD[6].
+// Returns:
+//     成功返回写入的字节数, 时间格式错误返回-1.
+int PackageTimeRange(std::string const& start_time,
+                     std::string const& stop_time,
+                     std::vector<uint8_t>* out) {
+  std::vector<uint8_t> bcd;
+  if (start_time.size() != 12 || StringToBcd(start_time, &bcd) != 0) {
+    return -1;
+  }
+  out->insert(out->end(), bcd.begin(), bcd.end());
+  if (stop_time.size() != 12 || StringToBcd(stop_time, &bcd) != 0) {
+    return -1;
+  }
+  out->insert(out->end(), bcd.begin(), bcd.end());
+  return 12;
+}
+
+// 写入圆形和矩形区域项中的起止时间和限速,
+// 在区域属性中相关标志位为1时才有这些字段.
+// Returns:
+//     成功返回写入的字节数, 失败返回-1.
+template<typename Area>
+int PackageAreaLimits(Area const& area, std::vector<uint8_t>* out) {
+  int len = 0;
+  if (area.area_attribute.bit.by_time) {
+    if (PackageTimeRange(area.start_time, area.stop_time, out) < 0) return -1;
+    len += 12;
+  }
+  if (area.area_attribute.bit.speed_limit) {
+    PackageU16(area.max_speed, out);
+    out->push_back(area.overspeed_time);
+    len += 3;
+  }
+  return len;
+}
+
+// 写入删除区域或路线的ID列表, 列表为空表示删除全部.
+int PackageIdList(std::vector<uint32_t> const& ids,
+                  std::vector<uint8_t>* out) {
+  if (ids.size() > 0xFF) return -1;
+  out->push_back(static_cast<uint8_t>(ids.size()));
+  for (auto const& id : ids) PackageU32(id, out);
+  return 1+ids.size()*4;
+}
+
 }  // namespace
 
 // 命令封装器初始化.
@@ -398,67 +466,8 @@ int JT808FramePackagerInit(Packager* packager) {
   packager->insert(std::pair<uint16_t, PackageHandler>(kLocationReport,
       [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
         if (out == nullptr) return -1;
-        int msg_len = 28;
-        auto& basic_info = para.location_info;
-        auto& extension_info = para.location_extension;
-        U32ToU8Array u32converter;
-        // 报警标志.
-        u32converter.u32val = EndianSwap32(basic_info.alarm.value);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        // 状态.
-        u32converter.u32val = EndianSwap32(basic_info.status.value);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        // 纬度.
-        u32converter.u32val = EndianSwap32(basic_info.latitude);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        // 经度.
-        u32converter.u32val = EndianSwap32(basic_info.longitude);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        U16ToU8Array u16converter;
-        // 海拔高程.
-        u16converter.u16val = EndianSwap16(basic_info.altitude);
-        for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
-        // 速度.
-        u16converter.u16val = EndianSwap16(basic_info.speed);
-        for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
-        // 方向.
-        u16converter.u16val = EndianSwap16(basic_info.bearing);
-        for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
-        std::vector<uint8_t> bcd;
-        // UTC时间(BCD-8421码).
-        StringToBcd(basic_info.time, &bcd);
-        for (auto const& uch : bcd)  out->push_back(uch);
-        std::vector<uint8_t> extension_custom;
-        // 位置附加信息项.
-        for (auto const& item : extension_info) {
-          if (item.first <= kCustomInformationLength) {
-            out->push_back(item.first);
-            if (item.first == kCustomInformationLength) continue;
-            out->push_back(item.second.size());
-            msg_len += 2 + item.second.size();
-            for (auto const& uch : item.second) out->push_back(uch);
-          } else if (item.first > kCustomInformationLength) {
-            extension_custom.push_back(item.first);
-            extension_custom.push_back(item.second.size());
-            for (auto const& uch : item.second) extension_custom.push_back(uch);
-          }
-        }
-        auto const& length = extension_custom.size();
-        if (length >= 256) {
-          out->push_back(2);
-          out->push_back(length%65536/256);
-          out->push_back(length%256);
-          msg_len += 4;
-        } else if (length > 0) {
-          out->push_back(1);
-          out->push_back(length%256);
-          msg_len += 3;
-        } else {  // 没有后续自定义信息.
-          out->pop_back();
-        }
-        for (auto const& uch : extension_custom) out->push_back(uch);
-        msg_len += length;
-        return msg_len;
+        return PackageLocationReportBody(para.location_info,
+                                         para.location_extension, out);
       }
   ));
   // 0x8201, 位置信息查询.
@@ -474,70 +483,39 @@ int JT808FramePackagerInit(Packager* packager) {
       kGetLocationInformationResponse,
       [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
         if (out == nullptr) return -1;
-        int msg_len = 30;
+        int msg_len = 2;
         U16ToU8Array u16converter;
         // 应答消息流水号.
         u16converter.u16val = EndianSwap16(para.parse.msg_head.msg_flow_num);
         for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
         // 以下为位置信息汇报内容.
-        auto& basic_info = para.location_info;
-        auto& extension_info = para.location_extension;
-        U32ToU8Array u32converter;
-        // 报警标志.
-        u32converter.u32val = EndianSwap32(basic_info.alarm.value);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        // 状态.
-        u32converter.u32val = EndianSwap32(basic_info.status.value);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        // 纬度.
-        u32converter.u32val = EndianSwap32(basic_info.latitude);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        // 经度.
-        u32converter.u32val = EndianSwap32(basic_info.longitude);
-        for (int i = 0; i < 4; ++i) out->push_back(u32converter.u8array[i]);
-        // 海拔高程.
-        u16converter.u16val = EndianSwap16(basic_info.altitude);
-        for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
-        // 速度.
-        u16converter.u16val = EndianSwap16(basic_info.speed);
-        for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
-        // 方向.
-        u16converter.u16val = EndianSwap16(basic_info.bearing);
+        int ret = PackageLocationReportBody(para.location_info,
+                                            para.location_extension, out);
+        if (ret < 0) return -1;
+        return msg_len + ret;
+      }
+  ));
+  // 0x0704, 定位数据批量上传.
+  packager->insert(std::pair<uint16_t, PackageHandler>(kLocationBatchUpload,
+      [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
+        if (out == nullptr) return -1;
+        auto const& batch = para.location_batch;
+        if (batch.items.empty() || batch.items.size() > 0xFFFF) return -1;
+        int msg_len = 3;
+        U16ToU8Array u16converter;
+        // 数据项个数.
+        u16converter.u16val = EndianSwap16(batch.items.size());
         for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
-        std::vector<uint8_t> bcd;
-        // UTC时间(BCD-8421码).
-        StringToBcd(basic_info.time, &bcd);
-        for (auto const& uch : bcd)  out->push_back(uch);
-        std::vector<uint8_t> extension_custom;
-        // 位置附加信息项.
-        for (auto const& item : extension_info) {
-          if (item.first <= kCustomInformationLength) {
-            out->push_back(item.first);
-            if (item.first == kCustomInformationLength) continue;
-            out->push_back(item.second.size());
-            msg_len += 2 + item.second.size();
-            for (auto const& uch : item.second) out->push_back(uch);
-          } else if (item.first > kCustomInformationLength) {
-            extension_custom.push_back(item.first);
-            extension_custom.push_back(item.second.size());
-            for (auto const& uch : item.second) extension_custom.push_back(uch);
-          }
-        }
-        auto const& length = extension_custom.size();
-        if (length >= 256) {
-          out->push_back(2);
-          out->push_back(length%65536/256);
-          out->push_back(length%256);
-          msg_len += 4;
-        } else if (length > 0) {
-          out->push_back(1);
-          out->push_back(length%256);
-          msg_len += 3;
-        } else {  // 没有后续自定义信息.
-          out->pop_back();
+        // 位置数据类型.
+        out->push_back(batch.type);
+        // 位置汇报数据项, 长度(WORD)+位置汇报数据体.
+        for (auto const& item : batch.items) {
+          if (item.size() < 28 || item.size() > 0xFFFF) return -1;
+          u16converter.u16val = EndianSwap16(item.size());
+          for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[i]);
+          out->insert(out->end(), item.begin(), item.end());
+          msg_len += 2 + item.size();
         }
-        for (auto const& uch : extension_custom) out->push_back(uch);
-        msg_len += length;
         return msg_len;
       }
   ));
@@ -560,6 +538,81 @@ int JT808FramePackagerInit(Packager* packager) {
         return msg_len;
       }
   ));
+  // 0x8600, 设置圆形区域.
+  packager->insert(std::pair<uint16_t, PackageHandler>(kSetCircularArea,
+      [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
+        if (out == nullptr) return -1;
+        auto const& setting = para.circular_area_setting;
+        if (setting.areas.size() > 0xFF) return -1;
+        int msg_len = 2;
+        // 设置属性.
+        out->push_back(setting.setting_type);
+        // 区域总数.
+        out->push_back(static_cast<uint8_t>(setting.areas.size()));
+        for (auto const& item : setting.areas) {
+          auto const& area = item.second;
+          // 区域ID.
+          PackageU32(area.area_id, out);
+          // 区域属性.
+          PackageU16(area.area_attribute.value, out);
+          // 中心点纬度, 经度.
+          PackageU32(ToMicroDegree(area.center.latitude), out);
+          PackageU32(ToMicroDegree(area.center.longitude), out);
+          // 半径.
+          PackageU32(area.radius, out);
+          // 起止时间和限速.
+          int const len = PackageAreaLimits(area, out);
+          if (len < 0) return -1;
+          msg_len += 18 + len;
+        }
+        return msg_len;
+      }
+  ));
+  // 0x8601, 删除圆形区域.
+  packager->insert(std::pair<uint16_t, PackageHandler>(kDeleteCircularArea,
+      [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
+        if (out == nullptr) return -1;
+        return PackageIdList(para.circular_area_id, out);
+      }
+  ));
+  // 0x8602, 设置矩形区域.
+  packager->insert(std::pair<uint16_t, PackageHandler>(kSetRectangleArea,
+      [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
+        if (out == nullptr) return -1;
+        auto const& setting = para.rectangle_area_setting;
+        if (setting.areas.size() > 0xFF) return -1;
+        int msg_len = 2;
+        // 设置属性.
+        out->push_back(setting.setting_type);
+        // 区域总数.
+        out->push_back(static_cast<uint8_t>(setting.areas.size()));
+        for (auto const& item : setting.areas) {
+          auto const& area = item.second;
+          // 区域ID.
+          PackageU32(area.area_id, out);
+          // 区域属性.
+          PackageU16(area.area_attribute.value, out);
+          // 左上点纬度, 经度.
+          PackageU32(ToMicroDegree(area.upper_left.latitude), out);
+          PackageU32(ToMicroDegree(area.upper_left.longitude), out);
+          // 右下点纬度, 经度.
+          PackageU32(ToMicroDegree(area.lower_right.latitude), out);
+          PackageU32(ToMicroDegree(area.lower_right.longitude), out);
+          // 起止时间和限速.
+          int const len = PackageAreaLimits(area, out);
+          if (len < 0) return -1;
+          msg_len += 22 + len;
+        }
+        return msg_len;
+      }
+  ));
+  // 0x8603, 删除矩形区域.
+  packager->insert(std::pair<uint16_t, PackageHandler>(kDeleteRectangleArea,
+      [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
+        if (out == nullptr) return -1;
+        return PackageIdList(para.rectangle_area_id, out);
+      }
+  ));
   // 0x8604, 设置多边形区域.
   packager->insert(std::pair<uint16_t, PackageHandler>(kSetPolygonArea,
       [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
@@ -574,24 +627,10 @@ int JT808FramePackagerInit(Packager* packager) {
         // 区域属性.
         u16converter.u16val = polygon_area.area_attribute.value;
         for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[1-i]);
-        // 起始时间, 在区域属性中相关标志位为1时才启用.
-        if (polygon_area.area_attribute.bit.by_time) {
-          std::vector<uint8_t> bcd;
-          StringToBcd(polygon_area.start_time, &bcd);
-          for (auto const& uch : bcd)  out->push_back(uch);
-          msg_len += polygon_area.start_time.size();
-          StringToBcd(polygon_area.stop_time, &bcd);
-          for (auto const& uch : bcd)  out->push_back(uch);
-          msg_len += polygon_area.stop_time.size();
-        }
-        // 限速, 在区域属性中相关标志位为1时才启用.
-        if (polygon_area.area_attribute.bit.speed_limit) {
-          u16converter.u16val = polygon_area.max_speed;
-          for (int i = 0; i < 2; ++i)
-            out->push_back(u16converter.u8array[1-i]);
-          out->push_back(polygon_area.overspeed_time);
-          msg_len += 3;
-        }
+        // 起止时间和限速.
+        int const len = PackageAreaLimits(polygon_area, out);
+        if (len < 0) return -1;
+        msg_len += len;
         // 顶点个数.
         u16converter.u16val = polygon_area.vertices.size();
         for (int i = 0; i < 2; ++i) out->push_back(u16converter.u8array[1-i]);
@@ -630,6 +669,62 @@ int JT808FramePackagerInit(Packager* packager) {
         return msg_len;
       }
   ));
+  // 0x8606, 设置路线.
+  packager->insert(std::pair<uint16_t, PackageHandler>(kSetRoute,
+      [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
+        if (out == nullptr) return -1;
+        auto const& route = para.route;
+        if (route.points.size() > 0xFFFF) return -1;
+        int msg_len = 8;
+        // 路线ID.
+        PackageU32(route.route_id, out);
+        // 路线属性.
+        PackageU16(route.route_attribute.value, out);
+        // 起止时间, 在路线属性中相关标志位为1时才启用.
+        if (route.route_attribute.bit.by_time) {
+          if (PackageTimeRange(route.start_time, route.stop_time, out) < 0) {
+            return -1;
+          }
+          msg_len += 12;
+        }
+        // 路线总拐点数.
+        PackageU16(route.points.size(), out);
+        for (auto const& point : route.points) {
+          // 拐点ID.
+          PackageU32(point.point_id, out);
+          // 路段ID.
+          PackageU32(point.segment_id, out);
+          // 拐点纬度, 经度.
+          PackageU32(ToMicroDegree(point.point.latitude), out);
+          PackageU32(ToMicroDegree(point.point.longitude), out);
+          // 路段宽度.
+          out->push_back(point.width);
+          // 路段属性.
+          out->push_back(point.segment_attribute.value);
+          msg_len += 18;
+          // 路段行驶时间阈值, 在路段属性中相关标志位为1时才启用.
+          if (point.segment_attribute.bit.driving_time) {
+            PackageU16(point.max_driving_time, out);
+            PackageU16(point.min_driving_time, out);
+            msg_len += 4;
+          }
+          // 路段限速, 在路段属性中相关标志位为1时才启用.
+          if (point.segment_attribute.bit.speed_limit) {
+            PackageU16(point.max_speed, out);
+            out->push_back(point.overspeed_time);
+            msg_len += 3;
+          }
+        }
+        return msg_len;
+      }
+  ));
+  // 0x8607, 删除路线.
+  packager->insert(std::pair<uint16_t, PackageHandler>(kDeleteRoute,
+      [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
+        if (out == nullptr) return -1;
+        return PackageIdList(para.route_id, out);
+      }
+  ));
   // 0x0801, 多媒体数据上传.
   packager->insert(std::pair<uint16_t, PackageHandler>(kMultimediaDataUpload,
       [] (ProtocolParameter const& para, std::vector<uint8_t>* out) {
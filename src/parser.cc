@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "jt808/bcd.h"
+#include "jt808/scratch_buffer.h"
 #include "jt808/util.h"
 
 
@@ -48,9 +49,9 @@ int JT808FrameHeadParse(std::vector<uint8_t> const& in,
   // 消息体属性.
   msg_head->msgbody_attr.u16val = in[3]*256 + in[4];
   // 终端手机号.
-  std::vector<uint8_t> phone_num_bcd;
-  phone_num_bcd.assign(in.begin()+5,in.begin()+11);
-  if (BcdToString(phone_num_bcd, &(msg_head->phone_num)) != 0) return -1;
+  ScratchBuffer phone_num_bcd;
+  phone_num_bcd->assign(in.begin()+5,in.begin()+11);
+  if (BcdToString(*phone_num_bcd, &(msg_head->phone_num)) != 0) return -1;
   // 消息流水号.
   msg_head->msg_flow_num =in[11]*256 + in[12];
   // 出现封包.
@@ -65,6 +66,88 @@ int JT808FrameHeadParse(std::vector<uint8_t> const& in,
   return 0;
 }
 
+// 解析位置信息汇报消息体, 按lazy_location_extension选择是否生成附加信息项,
+// 按numeric_location_time选择是否生成时间字符串.
+int ParseLocationReport(uint8_t const* in, size_t const& len,
+                        ProtocolParameter* para) {
+  bool const time_string = !para->numeric_location_time;
+  if (para->lazy_location_extension) {
+    para->parse.location_report_body.assign(in, in+len);
+    return ParseLocationBasicInformation(in, len, &para->parse.location_info,
+                                         time_string);
+  }
+  return ParseLocationReportBody(in, len, &para->parse.location_info,
+                                 &para->parse.location_extension,
+                                 time_string);
+}
+
+// 读取大端序的WORD.
+uint16_t ReadU16(uint8_t const* in) {
+  U16ToU8Array u16converter;
+  memcpy(u16converter.u8array, in, 2);
+  return EndianSwap16(u16converter.u16val);
+}
+
+// 读取大端序的DWORD.
+uint32_t ReadU32(uint8_t const* in) {
+  U32ToU8Array u32converter;
+  memcpy(u32converter.u8array, in, 4);
+  return EndianSwap32(u32converter.u32val);
+}
+
+// 解析起始时间和结束时间, 均为BCD[6].
+int ParseTimeRange(std::vector<uint8_t> const& in, size_t const& end,
+                   size_t* pos, std::string* start_time,
+                   std::string* stop_time) {
+  if (*pos+12 > end) return -1;
+  std::vector<uint8_t> bcd(in.begin()+*pos, in.begin()+*pos+6);
+  BcdToStringFillZero(bcd, start_time);
+  bcd.assign(in.begin()+*pos+6, in.begin()+*pos+12);
+  BcdToStringFillZero(bcd, stop_time);
+  *pos += 12;
+  return 0;
+}
+
+// 解析圆形和矩形区域项中的起止时间和限速,
+// 在区域属性中相关标志位为1时才有这些字段.
+template<typename Area>
+int ParseAreaLimits(std::vector<uint8_t> const& in, size_t const& end,
+                    size_t* pos, Area* area) {
+  area->start_time.clear();
+  area->stop_time.clear();
+  area->max_speed = 0;
+  area->overspeed_time = 0;
+  if (area->area_attribute.bit.by_time &&
+      ParseTimeRange(in, end, pos, &area->start_time,
+                     &area->stop_time) != 0) {
+    return -1;
+  }
+  if (area->area_attribute.bit.speed_limit) {
+    if (*pos+3 > end) return -1;
+    area->max_speed = ReadU16(&in[*pos]);
+    area->overspeed_time = in[*pos+2];
+    *pos += 3;
+  }
+  return 0;
+}
+
+// 解析删除区域或路线的ID列表, 个数为0表示删除全部.
+int ParseIdList(std::vector<uint8_t> const& in, ProtocolParameter const& para,
+                std::vector<uint32_t>* ids) {
+  auto const& msg_len = para.parse.msg_head.msgbody_attr.bit.msglen;
+  size_t pos = MSGBODY_NOPACKET_POS;
+  if (para.parse.msg_head.msgbody_attr.bit.packet == 1)
+    pos = MSGBODY_PACKET_POS;
+  if (msg_len < 1 || pos+msg_len > in.size()) return -1;
+  uint8_t const cnt = in[pos];
+  if (cnt*4+1 != msg_len) return -1;
+  ids->clear();
+  for (uint8_t i = 0; i < cnt; ++i) {
+    ids->push_back(ReadU32(&in[pos+1+i*4]));
+  }
+  return 0;
+}
+
 }  // namespace
 
 // 命令解析器初始化.
@@ -383,47 +466,7 @@ int JT808FrameParserInit(Parser* parser) {
         uint16_t pos = MSGBODY_NOPACKET_POS;
         if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
           pos = MSGBODY_PACKET_POS;
-        auto& basic_info = para->parse.location_info;
-        auto& extension_info = para->parse.location_extension;
-        U32ToU8Array u32converter;
-        // 报警标志.
-        memcpy(u32converter.u8array, &(in[pos]), 4);
-        basic_info.alarm.value = EndianSwap32(u32converter.u32val);
-        // 状态.
-        memcpy(u32converter.u8array, &(in[pos+4]), 4);
-        basic_info.status.value = EndianSwap32(u32converter.u32val);
-        // 纬度.
-        memcpy(u32converter.u8array, &(in[pos+8]), 4);
-        basic_info.latitude = EndianSwap32(u32converter.u32val);
-        // 经度.
-        memcpy(u32converter.u8array, &(in[pos+12]), 4);
-        basic_info.longitude = EndianSwap32(u32converter.u32val);
-        U16ToU8Array u16converter;
-        // 海拔高程.
-        memcpy(u16converter.u8array, &(in[pos+16]), 2);
-        basic_info.altitude = EndianSwap16(u16converter.u16val);
-        // 速度.
-        memcpy(u16converter.u8array, &(in[pos+18]), 2);
-        basic_info.speed = EndianSwap16(u16converter.u16val);
-        // 方向.
-        memcpy(u16converter.u8array, &(in[pos+20]), 2);
-        basic_info.bearing = EndianSwap16(u16converter.u16val);
-        // UTC时间(BCD-8421码).
-        std::vector<uint8_t> bcd;
-        bcd.assign(in.begin()+pos+22, in.begin()+pos+28);
-        BcdToStringFillZero(bcd, &basic_info.time);
-        if (msg_len > 28) {  // 位置附加信息项.
-          uint8_t end = msg_len + pos;
-          pos += 28;
-          std::vector<uint8_t> item_content;
-          while (pos <= end-2) {  // 附加信息长度至少为1.
-            if (pos+1+in[pos+1] > end) return -1;  // 附加信息长度超出范围.
-            item_content.assign(in.begin()+pos+2, in.begin()+pos+2+in[pos+1]);
-            extension_info[in[pos]] = item_content;
-            pos += 2 + in[pos+1];
-          }
-        }
-        return 0;
+        return ParseLocationReport(&(in[pos]), msg_len, para);
       }
   ));
   // 0x8201, 位置信息查询.
@@ -445,48 +488,38 @@ int JT808FrameParserInit(Parser* parser) {
         if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
           pos = MSGBODY_PACKET_POS;
         // 应答流水号.
-        para->parse.respone_flow_num = in[pos]*256+in[pos];
+        para->parse.respone_flow_num = in[pos]*256 + in[pos+1];
         pos += 2;
         // 以下为位置信息汇报内容.
-        auto& basic_info = para->parse.location_info;
-        auto& extension_info = para->parse.location_extension;
-        U32ToU8Array u32converter;
-        // 报警标志.
-        memcpy(u32converter.u8array, &(in[pos]), 4);
-        basic_info.alarm.value = EndianSwap32(u32converter.u32val);
-        // 状态.
-        memcpy(u32converter.u8array, &(in[pos+4]), 4);
-        basic_info.status.value = EndianSwap32(u32converter.u32val);
-        // 纬度.
-        memcpy(u32converter.u8array, &(in[pos+8]), 4);
-        basic_info.latitude = EndianSwap32(u32converter.u32val);
-        // 经度.
-        memcpy(u32converter.u8array, &(in[pos+12]), 4);
-        basic_info.longitude = EndianSwap32(u32converter.u32val);
-        U16ToU8Array u16converter;
-        // 海拔高程.
-        memcpy(u16converter.u8array, &(in[pos+16]), 2);
-        basic_info.altitude = EndianSwap16(u16converter.u16val);
-        // 速度.
-        memcpy(u16converter.u8array, &(in[pos+18]), 2);
-        basic_info.speed = EndianSwap16(u16converter.u16val);
-        // 方向.
-        memcpy(u16converter.u8array, &(in[pos+20]), 2);
-        basic_info.bearing = EndianSwap16(u16converter.u16val);
-        // UTC时间(BCD-8421码).
-        std::vector<uint8_t> bcd;
-        bcd.assign(in.begin()+pos+22, in.begin()+pos+28);
-        BcdToStringFillZero(bcd, &basic_info.time);
-        if (msg_len > 28) {  // 位置附加信息项.
-          uint8_t end = msg_len + pos;
-          pos += 28;
-          std::vector<uint8_t> item_content;
-          while (pos <= end-2) { // 附加信息长度至少为1.
-            if (pos+1+in[pos+1] > end) return -1;  // 附加信息长度超出范围.
-            item_content.assign(in.begin()+pos+2, in.begin()+pos+2+in[pos+1]);
-            extension_info[in[pos]] = item_content;
-            pos += 2 + in[pos+1];
-          }
+        return ParseLocationReport(&(in[pos]), msg_len-2, para);
+      }
+  ));
+  // 0x0704, 定位数据批量上传.
+  parser->insert(std::pair<uint16_t, ParseHandler>(kLocationBatchUpload,
+      [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+        if (para == nullptr) return -1;
+        auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
+        if (msg_len < 3) return -1;
+        uint16_t pos = MSGBODY_NOPACKET_POS;
+        if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
+          pos = MSGBODY_PACKET_POS;
+        if (pos+msg_len > in.size()) return -1;
+        size_t const end = pos + msg_len;
+        auto& batch = para->parse.location_batch;
+        batch.items.clear();
+        // 数据项个数.
+        uint16_t cnt = in[pos]*256 + in[pos+1];
+        // 位置数据类型.
+        batch.type = in[pos+2];
+        pos += 3;
+        // 位置汇报数据项.
+        for (uint16_t i = 0; i < cnt; ++i) {
+          if (pos+2u > end) return -1;
+          size_t const item_len = in[pos]*256 + in[pos+1];
+          pos += 2;
+          if (item_len < 28 || pos+item_len > end) return -1;
+          batch.items.emplace_back(in.begin()+pos, in.begin()+pos+item_len);
+          pos += item_len;
         }
         return 0;
       }
@@ -511,86 +544,217 @@ int JT808FrameParserInit(Parser* parser) {
         return 0;
       }
   ));
-  // 0x08604, 设置多边形区域.
+  // 0x8600, 设置圆形区域.
+  parser->insert(std::pair<uint16_t, ParseHandler>(kSetCircularArea,
+      [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+        if (para == nullptr) return -1;
+        auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
+        if (msg_len < 2) return -1;
+        size_t pos = MSGBODY_NOPACKET_POS;
+        if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
+          pos = MSGBODY_PACKET_POS;
+        if (pos+msg_len > in.size()) return -1;
+        size_t const end = pos + msg_len;
+        auto& setting = para->parse.circular_area_setting;
+        setting.areas.clear();
+        // 设置属性.
+        setting.setting_type = in[pos];
+        // 区域总数.
+        uint8_t const cnt = in[pos+1];
+        pos += 2;
+        CircularArea area {};
+        for (uint8_t i = 0; i < cnt; ++i) {
+          if (pos+18 > end) return -1;
+          // 区域ID.
+          area.area_id = ReadU32(&in[pos]);
+          // 区域属性.
+          area.area_attribute.value = ReadU16(&in[pos+4]);
+          // 中心点纬度.
+          area.center.latitude = ReadU32(&in[pos+6]) * 1e-6;
+          // 中心点经度.
+          area.center.longitude = ReadU32(&in[pos+10]) * 1e-6;
+          // 半径.
+          area.radius = ReadU32(&in[pos+14]);
+          pos += 18;
+          // 起止时间和限速.
+          if (ParseAreaLimits(in, end, &pos, &area) != 0) return -1;
+          setting.areas[area.area_id] = area;
+        }
+        return (pos == end) ? 0 : -1;
+      }
+  ));
+  // 0x8601, 删除圆形区域.
+  parser->insert(std::pair<uint16_t, ParseHandler>(kDeleteCircularArea,
+      [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+        if (para == nullptr) return -1;
+        return ParseIdList(in, *para, &para->parse.circular_area_id);
+      }
+  ));
+  // 0x8602, 设置矩形区域.
+  parser->insert(std::pair<uint16_t, ParseHandler>(kSetRectangleArea,
+      [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+        if (para == nullptr) return -1;
+        auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
+        if (msg_len < 2) return -1;
+        size_t pos = MSGBODY_NOPACKET_POS;
+        if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
+          pos = MSGBODY_PACKET_POS;
+        if (pos+msg_len > in.size()) return -1;
+        size_t const end = pos + msg_len;
+        auto& setting = para->parse.rectangle_area_setting;
+        setting.areas.clear();
+        // 设置属性.
+        setting.setting_type = in[pos];
+        // 区域总数.
+        uint8_t const cnt = in[pos+1];
+        pos += 2;
+        RectangleArea area {};
+        for (uint8_t i = 0; i < cnt; ++i) {
+          if (pos+22 > end) return -1;
+          // 区域ID.
+          area.area_id = ReadU32(&in[pos]);
+          // 区域属性.
+          area.area_attribute.value = ReadU16(&in[pos+4]);
+          // 左上点纬度, 经度.
+          area.upper_left.latitude = ReadU32(&in[pos+6]) * 1e-6;
+          area.upper_left.longitude = ReadU32(&in[pos+10]) * 1e-6;
+          // 右下点纬度, 经度.
+          area.lower_right.latitude = ReadU32(&in[pos+14]) * 1e-6;
+          area.lower_right.longitude = ReadU32(&in[pos+18]) * 1e-6;
+          pos += 22;
+          // 起止时间和限速.
+          if (ParseAreaLimits(in, end, &pos, &area) != 0) return -1;
+          setting.areas[area.area_id] = area;
+        }
+        return (pos == end) ? 0 : -1;
+      }
+  ));
+  // 0x8603, 删除矩形区域.
+  parser->insert(std::pair<uint16_t, ParseHandler>(kDeleteRectangleArea,
+      [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+        if (para == nullptr) return -1;
+        return ParseIdList(in, *para, &para->parse.rectangle_area_id);
+      }
+  ));
+  // 0x8604, 设置多边形区域.
   parser->insert(std::pair<uint16_t, ParseHandler>(kSetPolygonArea,
       [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
         if (para == nullptr) return -1;
         auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
-        if (msg_len < 28) return -1;
-        uint16_t pos = MSGBODY_NOPACKET_POS;
+        if (msg_len < 8) return -1;
+        size_t pos = MSGBODY_NOPACKET_POS;
         if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
           pos = MSGBODY_PACKET_POS;
-        uint16_t end = pos + msg_len;
+        if (pos+msg_len > in.size()) return -1;
+        size_t const end = pos + msg_len;
         auto& polygon_area = para->parse.polygon_area;
-        U16ToU8Array u16converter;
-        U32ToU8Array u32converter;
         // 区域ID.
-        memcpy(u32converter.u8array, &(in[pos]), 4);
-        polygon_area.area_id = EndianSwap32(u32converter.u32val);
-        pos += 4;
+        polygon_area.area_id = ReadU32(&in[pos]);
         // 区域属性.
-        memcpy(u16converter.u8array, &(in[pos]), 2);
-        polygon_area.area_attribute.value = EndianSwap16(u16converter.u16val);
-        pos += 2;
-        // 起始时间, 在区域属性中相关标志位为1时才启用.
-        if (polygon_area.area_attribute.bit.by_time) {
-          std::vector<uint8_t> bcd;
-          bcd.assign(in.begin()+pos, in.begin()+pos);
-          BcdToStringFillZero(bcd, &polygon_area.start_time);
-          pos += 6;
-          bcd.assign(in.begin()+pos, in.begin()+pos);
-          BcdToStringFillZero(bcd, &polygon_area.stop_time);
-          pos += 6;
-        }
-        // 限速, 在区域属性中相关标志位为1时才启用.
-        if (polygon_area.area_attribute.bit.speed_limit) {
-          memcpy(u16converter.u8array, &(in[pos]), 2);
-          polygon_area.max_speed = EndianSwap16(u16converter.u16val);
-          pos += 2;
-          polygon_area.overspeed_time = in[pos];
-          ++pos;
-        }
+        polygon_area.area_attribute.value = ReadU16(&in[pos+4]);
+        pos += 6;
+        // 起止时间和限速.
+        if (ParseAreaLimits(in, end, &pos, &polygon_area) != 0) return -1;
         // 顶点数.
-        memcpy(u16converter.u8array, &(in[pos]), 2);
-        uint16_t cnt = EndianSwap16(u16converter.u16val);
+        if (pos+2 > end) return -1;
+        uint16_t const cnt = ReadU16(&in[pos]);
         pos += 2;
         // 检查后续内容长度.
-        if (end-pos != cnt*8) return -1;
+        if (end-pos != static_cast<size_t>(cnt)*8) return -1;
         LocationPoint location_point {};
         polygon_area.vertices.clear();
+        polygon_area.vertices.reserve(cnt);
         // 所有顶点经纬度.
         while (pos < end) {
-          memcpy(u32converter.u8array, &(in[pos]), 4);
-          location_point.latitude = EndianSwap32(u32converter.u32val) * 1e-6;
-          pos += 4;
-          memcpy(u32converter.u8array, &(in[pos]), 4);
-          location_point.longitude = EndianSwap32(u32converter.u32val) * 1e-6;
-          pos += 4;
+          location_point.latitude = ReadU32(&in[pos]) * 1e-6;
+          location_point.longitude = ReadU32(&in[pos+4]) * 1e-6;
+          pos += 8;
           polygon_area.vertices.push_back(location_point);
         }
         return 0;
       }
   ));
-  // 0x08605, 删除多边形区域.
+  // 0x8605, 删除多边形区域.
   parser->insert(std::pair<uint16_t, ParseHandler>(kDeletePolygonArea,
+      [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+        if (para == nullptr) return -1;
+        return ParseIdList(in, *para, &para->parse.polygon_area_id);
+      }
+  ));
+  // 0x8606, 设置路线.
+  parser->insert(std::pair<uint16_t, ParseHandler>(kSetRoute,
       [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
         if (para == nullptr) return -1;
         auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
-        uint16_t pos = MSGBODY_NOPACKET_POS;
+        if (msg_len < 8) return -1;
+        size_t pos = MSGBODY_NOPACKET_POS;
         if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
           pos = MSGBODY_PACKET_POS;
-        // 删除区域个数.
-        uint8_t cnt = in[pos];
-        if (cnt*4+1 != msg_len) return -1;
-        auto& polygon_area_id = para->parse.polygon_area_id;
-        polygon_area_id.clear();
-        U32ToU8Array u32converter;
-        // 需要删除的所有区域ID.
-        for (uint8_t i = 0; i < cnt; ++i) {
-          memcpy(u32converter.u8array, &(in[pos+1+i*4]), 4);
-          polygon_area_id.push_back(EndianSwap32(u32converter.u32val));
+        if (pos+msg_len > in.size()) return -1;
+        size_t const end = pos + msg_len;
+        auto& route = para->parse.route;
+        // 路线ID.
+        route.route_id = ReadU32(&in[pos]);
+        // 路线属性.
+        route.route_attribute.value = ReadU16(&in[pos+4]);
+        pos += 6;
+        // 起止时间, 在路线属性中相关标志位为1时才启用.
+        route.start_time.clear();
+        route.stop_time.clear();
+        if (route.route_attribute.bit.by_time &&
+            ParseTimeRange(in, end, &pos, &route.start_time,
+                           &route.stop_time) != 0) {
+          return -1;
         }
-        return 0;
+        // 路线总拐点数.
+        if (pos+2 > end) return -1;
+        uint16_t const cnt = ReadU16(&in[pos]);
+        pos += 2;
+        route.points.clear();
+        route.points.reserve(cnt);
+        RouteInflectionPoint point {};
+        for (uint16_t i = 0; i < cnt; ++i) {
+          if (pos+18 > end) return -1;
+          // 拐点ID.
+          point.point_id = ReadU32(&in[pos]);
+          // 路段ID.
+          point.segment_id = ReadU32(&in[pos+4]);
+          // 拐点纬度, 经度.
+          point.point.latitude = ReadU32(&in[pos+8]) * 1e-6;
+          point.point.longitude = ReadU32(&in[pos+12]) * 1e-6;
+          // 路段宽度.
+          point.width = in[pos+16];
+          // 路段属性.
+          point.segment_attribute.value = in[pos+17];
+          pos += 18;
+          // 路段行驶时间阈值, 在路段属性中相关标志位为1时才启用.
+          point.max_driving_time = 0;
+          point.min_driving_time = 0;
+          if (point.segment_attribute.bit.driving_time) {
+            if (pos+4 > end) return -1;
+            point.max_driving_time = ReadU16(&in[pos]);
+            point.min_driving_time = ReadU16(&in[pos+2]);
+            pos += 4;
+          }
+          // 路段限速, 在路段属性中相关标志位为1时才启用.
+          point.max_speed = 0;
+          point.overspeed_time = 0;
+          if (point.segment_attribute.bit.speed_limit) {
+            if (pos+3 > end) return -1;
+            point.max_speed = ReadU16(&in[pos]);
+            point.overspeed_time = in[pos+2];
+            pos += 3;
+          }
+          route.points.push_back(point);
+        }
+        return (pos == end) ? 0 : -1;
+      }
+  ));
+  // 0x8607, 删除路线.
+  parser->insert(std::pair<uint16_t, ParseHandler>(kDeleteRoute,
+      [] (std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+        if (para == nullptr) return -1;
+        return ParseIdList(in, *para, &para->parse.route_id);
       }
   ));
   // 0x0801, 多媒体数据上传.
@@ -689,17 +853,27 @@ int JT808FrameParse(Parser const& parser,
                     std::vector<uint8_t> const& in,
                     ProtocolParameter* para) {
   if (para == nullptr) return -1;
-  std::vector<uint8_t> out;
+  // 逆转义结果只在本帧解析期间使用, 借用线程私有缓冲区.
+  ScratchBuffer scratch;
+  auto& out = *scratch;
   // 逆转义.
   if (ReverseEscape(in, &out) < 0) return -1;
+  // 标识位, 消息头和校验码共15字节.
+  if (out.size() < 15) return kParseErrorShortFrame;
   // 异或校验检查.
-  if (BccCheckSum(&(out[1]), out.size()-3) != *(out.end()-2)) return -1;
+  if (BccCheckSum(&(out[1]), out.size()-3) != *(out.end()-2)) {
+    return kParseErrorChecksum;
+  }
   // 解析消息头.
   if (JT808FrameHeadParse(out, &para->parse.msg_head) != 0) return -1;
   para->msg_head.phone_num = para->parse.msg_head.phone_num;
+  // 消息体长度超出实际数据长度.
+  if (out.size() < 15u + para->parse.msg_head.msgbody_attr.bit.msglen) {
+    return kParseErrorShortFrame;
+  }
   // 解析消息内容.
   auto it = parser.find(para->parse.msg_head.msg_id);
-  if (it == parser.end()) return -1;
+  if (it == parser.end()) return kParseErrorUnknownId;
   return it->second(out, para);
 }
 
@@ -0,0 +1,193 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  route_index.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 02:14:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/route_index.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+
+namespace libjt808 {
+
+RouteIndex::RouteIndex(double const& cell_size)
+    : grid_(DegreeToMicroDegree(cell_size)) {
+}
+
+void RouteIndex::Build(RouteSet const& routes) {
+  Clear();
+  routes_.reserve(routes.size());
+  for (auto const& item : routes) {
+    Insert(item.second);
+  }
+}
+
+int RouteIndex::Insert(Route const& route) {
+  Remove(route.route_id);
+  auto const& points = route.points;
+  if (points.size() < 2) return -1;
+  auto& slots = routes_[route.route_id];
+  slots.reserve(points.size()-1);
+  for (size_t i = 0; i+1 < points.size(); ++i) {
+    uint32_t slot = 0;
+    if (!free_slots_.empty()) {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+    } else {
+      slot = static_cast<uint32_t>(segments_.size());
+      segments_.push_back(Segment());
+    }
+    auto& segment = segments_[slot];
+    segment.route_id = route.route_id;
+    segment.segment_id = points[i].segment_id;
+    segment.point_index = static_cast<uint32_t>(i);
+    segment.width = points[i].width;
+    segment.start = ToGeoPoint(points[i].point);
+    segment.end = ToGeoPoint(points[i+1].point);
+    LinkSegment(slot);
+    slots.push_back(slot);
+  }
+  return 0;
+}
+
+void RouteIndex::Remove(uint32_t const& route_id) {
+  auto const& it = routes_.find(route_id);
+  if (it == routes_.end()) return;
+  for (auto const& slot : it->second) {
+    UnlinkSegment(slot);
+    free_slots_.push_back(slot);
+  }
+  routes_.erase(it);
+}
+
+void RouteIndex::Clear(void) {
+  segments_.clear();
+  free_slots_.clear();
+  routes_.clear();
+  grid_.Clear();
+}
+
+// 切分后每小段的跨度不超过一个网格, 斜向的长路段只占用其经过的网格,
+// 而不是整个外接矩形覆盖的网格. 端点由整数运算得到, 加入和移除时结果相同.
+// 距离四舍五入到米, 扩展距离多留1米.
+template<typename Visitor>
+void RouteIndex::ForEachSegmentBox(Segment const& segment,
+                                   Visitor&& visitor) const {
+  int64_t const dx =
+      static_cast<int64_t>(segment.end.longitude)-segment.start.longitude;
+  int64_t const dy =
+      static_cast<int64_t>(segment.end.latitude)-segment.start.latitude;
+  int64_t const span = std::max(llabs(dx), llabs(dy));
+  int64_t const pieces =
+      std::max<int64_t>(1, (span+grid_.cell_size()-1)/grid_.cell_size());
+  uint32_t const margin = (segment.width+1)/2+1;
+  GeoPoint from = segment.start;
+  for (int64_t k = 1; k <= pieces; ++k) {
+    GeoPoint const to {
+        static_cast<int32_t>(segment.start.longitude+dx*k/pieces),
+        static_cast<int32_t>(segment.start.latitude+dy*k/pieces)};
+    GeoBox const box {std::min(from.longitude, to.longitude),
+                      std::min(from.latitude, to.latitude),
+                      std::max(from.longitude, to.longitude),
+                      std::max(from.latitude, to.latitude)};
+    visitor(ExpandBox(box, margin));
+    from = to;
+  }
+}
+
+void RouteIndex::LinkSegment(uint32_t const& slot) {
+  ForEachSegmentBox(segments_[slot], [this, &slot] (GeoBox const& box) {
+    grid_.Insert(slot, box);
+  });
+}
+
+void RouteIndex::UnlinkSegment(uint32_t const& slot) {
+  ForEachSegmentBox(segments_[slot], [this, &slot] (GeoBox const& box) {
+    grid_.Remove(slot, box);
+  });
+}
+
+void RouteIndex::MatchSegment(Segment const& segment, GeoPoint const& point,
+                              RouteMatch* match) const {
+  uint32_t const distance =
+      ApproximateSegmentDistance(point, segment.start, segment.end);
+  if (static_cast<uint64_t>(distance)*2 > segment.width) return;
+  if (match->distance <= distance &&
+      (match->distance < distance ||
+       match->point_index <= segment.point_index)) {
+    return;
+  }
+  match->route_id = segment.route_id;
+  match->segment_id = segment.segment_id;
+  match->point_index = segment.point_index;
+  match->distance = distance;
+}
+
+int RouteIndex::Query(GeoPoint const& point,
+                      std::vector<RouteMatch>* matches) const {
+  if (matches == nullptr) return -1;
+  matches->clear();
+  if (routes_.empty()) return 0;
+  // 同一路线只保留距离最近的路段, 距离相同时取序号小的路段.
+  grid_.ForEach(point, [this, &point, matches] (uint32_t const& slot) {
+    auto const& segment = segments_[slot];
+    auto it = std::find_if(matches->begin(), matches->end(),
+        [&segment] (RouteMatch const& match) {
+          return match.route_id == segment.route_id;
+        });
+    if (it != matches->end()) {
+      MatchSegment(segment, point, &*it);
+      return;
+    }
+    RouteMatch match {segment.route_id, 0, 0, UINT32_MAX};
+    MatchSegment(segment, point, &match);
+    if (match.distance != UINT32_MAX) matches->push_back(match);
+  });
+  std::sort(matches->begin(), matches->end(),
+            [] (RouteMatch const& lhs, RouteMatch const& rhs) {
+              return lhs.route_id < rhs.route_id;
+            });
+  return 0;
+}
+
+bool RouteIndex::Match(uint32_t const& route_id, GeoPoint const& point,
+                       RouteMatch* match) const {
+  if (!HasRoute(route_id)) return false;
+  RouteMatch nearest {route_id, 0, 0, UINT32_MAX};
+  grid_.ForEach(point, [this, &route_id, &point, &nearest]
+                       (uint32_t const& slot) {
+    auto const& segment = segments_[slot];
+    if (segment.route_id == route_id) MatchSegment(segment, point, &nearest);
+  });
+  if (nearest.distance == UINT32_MAX) return false;
+  if (match != nullptr) *match = nearest;
+  return true;
+}
+
+}  // namespace libjt808
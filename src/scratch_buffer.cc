@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  scratch_buffer.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 09:26:41
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/scratch_buffer.h"
+
+
+namespace libjt808 {
+
+namespace {
+
+struct ThreadScratch {
+  std::vector<uint8_t> buffers[ScratchBuffer::kMaxDepth];
+  size_t depth = 0;
+};
+
+ThreadScratch& LocalScratch(void) {
+  static thread_local ThreadScratch scratch;
+  return scratch;
+}
+
+}  // namespace
+
+constexpr size_t ScratchBuffer::kMaxDepth;
+constexpr size_t ScratchBuffer::kMaxRetainedCapacity;
+
+ScratchBuffer::ScratchBuffer() : buffer_(&fallback_), borrowed_(false) {
+  auto& scratch = LocalScratch();
+  if (scratch.depth < kMaxDepth) {
+    buffer_ = &scratch.buffers[scratch.depth++];
+    borrowed_ = true;
+  }
+}
+
+ScratchBuffer::~ScratchBuffer() {
+  if (!borrowed_) return;
+  if (buffer_->capacity() > kMaxRetainedCapacity) {
+    std::vector<uint8_t>().swap(*buffer_);
+  } else {
+    buffer_->clear();
+  }
+  --LocalScratch().depth;
+}
+
+}  // namespace libjt808
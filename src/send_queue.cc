@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  send_queue.cc
+// @Version :  1.0
+// @Time    :  2026/10/18 09:52:37
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/send_queue.h"
+
+#include <utility>
+
+
+namespace libjt808 {
+
+PrioritySendQueue::PrioritySendQueue(size_t const& alarm_capacity,
+                                     size_t const& response_capacity,
+                                     size_t const& routine_capacity)
+    : alarm_(alarm_capacity),
+      response_(response_capacity),
+      routine_(routine_capacity) {
+  queues_[kSendPriorityAlarm] = &alarm_;
+  queues_[kSendPriorityResponse] = &response_;
+  queues_[kSendPriorityRoutine] = &routine_;
+  dropped_.store(0);
+}
+
+// 入队失败说明队列已满, 丢弃最旧的一条后重试.
+bool PrioritySendQueue::Push(SendPriority const& priority,
+                             std::vector<uint8_t>&& msg) {
+  if (priority >= kSendPriorityNum) return false;
+  auto queue = queues_[priority];
+  bool no_drop = true;
+  std::vector<uint8_t> oldest;
+  while (!queue->TryPush(std::move(msg))) {
+    if (queue->TryPop(&oldest)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      no_drop = false;
+    }
+  }
+  return no_drop;
+}
+
+bool PrioritySendQueue::Pop(std::vector<uint8_t>* msg) {
+  if (msg == nullptr) return false;
+  for (int i = 0; i < kSendPriorityNum; ++i) {
+    if (queues_[i]->TryPop(msg)) return true;
+  }
+  return false;
+}
+
+bool PrioritySendQueue::Pop(SendPriority const& priority,
+                            std::vector<uint8_t>* msg) {
+  if (msg == nullptr || priority >= kSendPriorityNum) return false;
+  return queues_[priority]->TryPop(msg);
+}
+
+void PrioritySendQueue::Clear(void) {
+  std::vector<uint8_t> msg;
+  while (Pop(&msg)) {}
+}
+
+bool PrioritySendQueue::empty(void) const {
+  for (int i = 0; i < kSendPriorityNum; ++i) {
+    if (!queues_[i]->empty_approx()) return false;
+  }
+  return true;
+}
+
+size_t PrioritySendQueue::size(SendPriority const& priority) const {
+  if (priority >= kSendPriorityNum) return 0;
+  return queues_[priority]->size_approx();
+}
+
+}  // namespace libjt808
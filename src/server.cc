@@ -44,6 +44,10 @@
 #include <chrono>
 #include <fstream>
 
+#include "jt808/bcd.h"
+#include "jt808/frame_assembler.h"
+#include "jt808/logger.h"
+#include "jt808/scratch_buffer.h"
 #include "jt808/socket_util.h"
 
 
@@ -51,62 +55,106 @@ namespace libjt808 {
 
 namespace {
 
+// 单个终端连接待写入socket的数据上限, 超过时断开连接.
+constexpr size_t kMaxOutboundBytes = 1 << 20;
+
+// 当前线程作为主服务线程所属的服务端, 其他线程为空.
+thread_local JT808Server const* current_service_server = nullptr;
+
+// 距离tp经过的时间, 单位微秒(us).
+inline uint64_t ElapsedUs(std::chrono::steady_clock::time_point const& tp) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now()-tp).count();
+}
+
 // 显示位置上报信息.
 void PrintLocationReportInfo(ProtocolParameter const& para) {
   auto const& basic_info = para.parse.location_info;
-  auto const& extension_info = para.parse.location_extension;
-  printf("Location Report:\n");
-  printf("  inout area alarm bit: %d\n", basic_info.alarm.bit.in_out_area);
-  printf("  psoition status: %d\n", basic_info.status.bit.positioning);
-  printf("  latitude: %.6lf\n", basic_info.latitude*1e-6);
-  printf("  longitude: %.6lf\n", basic_info.longitude*1e-6);
-  printf("  atitude: %d\n", basic_info.altitude);
-  printf("  speed: %f\n", basic_info.speed/10.0f);
-  printf("  bearing: %d\n", basic_info.bearing);
-  printf("  time: %s\n", basic_info.time.c_str());
-  printf("  location extension:\n");
-  for (auto const& item : extension_info) {
-    printf("    id:%02X, len: %02X, value:",
-           item.first, static_cast<uint8_t>(item.second.size()));
-    for (auto const& uch: item.second) printf(" %02X", uch);
-    printf("\n");
-  }
-  auto it = extension_info.find(libjt808::kAccessAreaAlarm);
-  if (it != extension_info.end()) {
+  LocationExtensionView extension_info;
+  extension_info.Init(para.parse.location_report_body);
+  std::string str;
+  str.reserve(512);
+  StringAppendF(&str, "Location Report:\n");
+  StringAppendF(&str, "  inout area alarm bit: %d\n",
+                basic_info.alarm.bit.in_out_area);
+  StringAppendF(&str, "  psoition status: %d\n",
+                basic_info.status.bit.positioning);
+  StringAppendF(&str, "  latitude: %.6lf\n", basic_info.latitude*1e-6);
+  StringAppendF(&str, "  longitude: %.6lf\n", basic_info.longitude*1e-6);
+  StringAppendF(&str, "  atitude: %d\n", basic_info.altitude);
+  StringAppendF(&str, "  speed: %f\n", basic_info.speed/10.0f);
+  StringAppendF(&str, "  bearing: %d\n", basic_info.bearing);
+  std::string time;
+  TimestampToTimeString(basic_info.timestamp, &time);
+  StringAppendF(&str, "  time: %s\n", time.c_str());
+  StringAppendF(&str, "  location extension:\n");
+  extension_info.ForEach([&str] (uint8_t const& id, uint8_t const* data,
+                                 size_t const& len) {
+    StringAppendF(&str, "    id:%02X, len: %02X, value:",
+                  id, static_cast<uint8_t>(len));
+    for (size_t i = 0; i < len; ++i) StringAppendF(&str, " %02X", data[i]);
+    str.push_back('\n');
+  });
+  if (extension_info.Has(kAccessAreaAlarm)) {
     uint8_t location_type;
     uint32_t area_toute_id;
     uint8_t direrion;
-    printf("  in or out area and route informartion:\n");
-    if (libjt808::GetAccessAreaAlarmBody(it->second,
-        &location_type, &area_toute_id, &direrion) == 0) {
-      printf("    location type: %d\n", location_type);
-      printf("    id: %04X\n", area_toute_id);
-      printf("    direction: %d\n", direrion);
+    StringAppendF(&str, "  in or out area and route informartion:\n");
+    if (extension_info.GetAccessAreaAlarm(
+            &location_type, &area_toute_id, &direrion)) {
+      StringAppendF(&str, "    location type: %d\n", location_type);
+      StringAppendF(&str, "    id: %04X\n", area_toute_id);
+      StringAppendF(&str, "    direction: %d\n", direrion);
+    }
+  }
+  Logger::Instance().Write(kLogInfo, str);
+}
+
+// 显示定位数据批量上传信息.
+void PrintLocationBatchInfo(ProtocolParameter const& para) {
+  auto const& batch = para.parse.location_batch;
+  std::string str;
+  StringAppendF(&str, "Location Batch Upload: type: %d, items: %d\n",
+                batch.type, static_cast<int>(batch.items.size()));
+  LocationBasicInformation basic_info;
+  std::string time;
+  for (auto const& item : batch.items) {
+    if (ParseLocationBasicInformation(item.data(), item.size(),
+                                      &basic_info, false) != 0) {
+      StringAppendF(&str, "  invalid item\n");
+      continue;
     }
+    TimestampToTimeString(basic_info.timestamp, &time);
+    StringAppendF(&str,
+                  "  time: %s, latitude: %.6lf, longitude: %.6lf, speed: %f\n",
+                  time.c_str(), basic_info.latitude*1e-6,
+                  basic_info.longitude*1e-6, basic_info.speed/10.0f);
   }
+  Logger::Instance().Write(kLogInfo, str);
 }
 
 // 显示终端参数.
 void PrintTerminalParameter(ProtocolParameter const& para) {
   std::string str;
-  printf("Terminal Parameters:\n");
+  StringAppendF(&str, "Terminal Parameters:\n");
   if (!para.terminal_parameter_ids.empty()) {
     for (auto const& id : para.terminal_parameter_ids) {
       auto const& it = para.parse.terminal_parameters.find(id);
       if (it !=  para.parse.terminal_parameters.end()) {
-        printf("  ID:%08X, Length:%d, Value:",
-               it->first, static_cast<int>(it->second.size()));
-        for (auto const& uch : it->second) printf(" %02X", uch);
-        printf("\n");
+        StringAppendF(&str, "  ID:%08X, Length:%d, Value:",
+                      it->first, static_cast<int>(it->second.size()));
+        for (auto const& uch : it->second) StringAppendF(&str, " %02X", uch);
+        str.push_back('\n');
       }
     }
   } else {
     for (auto const& item : para.parse.terminal_parameters) {
-      printf("  ID:%08X, Value:", item.first);
-      for (auto const& uch : item.second) printf(" %02X", uch);
-      printf("\n");
+      StringAppendF(&str, "  ID:%08X, Value:", item.first);
+      for (auto const& uch : item.second) StringAppendF(&str, " %02X", uch);
+      str.push_back('\n');
     }
   }
+  Logger::Instance().Write(kLogInfo, str);
 }
 
 }  // namespace
@@ -117,9 +165,20 @@ void JT808Server::Init(void) {
   port_ = 8888;
   // 最大socket连接.
   max_connection_num_ = 10;
-  // 初始化命令解析器和命令封装器.
-  JT808FrameParserInit(&parser_);
-  JT808FramePackagerInit(&packager_);
+  message_dump_ = false;
+  callback_thread_num_ = 2;
+  media_total_size_ = 0;
+  media_packet_max_size_ = 0;
+  replaying_ = false;
+  command_timeout_ms_ = 10000;
+  command_retransmissions_ = 3;
+  pending_command_num_.store(0);
+  command_accepting_ = false;
+  next_command_check_ = std::chrono::steady_clock::time_point::max();
+  // 使用进程内共享的命令解析器和命令封装器,
+  // 保留Init()之前已经重写或新增的命令.
+  parser_.merge(DefaultParser());
+  packager_.merge(DefaultPackager());
   // 线程运行状态初始化.
   waiting_is_running_.store(false);
   service_is_running_.store(false);
@@ -135,9 +194,12 @@ int JT808Server::InitServer(void) {
   addr.sin_addr.s_addr = inet_addr(ip_.c_str());
   listen_= socket(AF_INET, SOCK_STREAM, 0);
   if (listen_ == -1) {
-    printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Create socket failed!!!", __FUNCTION__, __LINE__);
     return -1;
   }
+  // 允许服务重启后立即重新绑定仍有TIME_WAIT连接的端口.
+  int reuse = 1;
+  setsockopt(listen_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
 #elif defined(_WIN32)
   WSADATA ws_data;
   if (WSAStartup(MAKEWORD(2,2), &ws_data) != 0) {
@@ -145,7 +207,7 @@ int JT808Server::InitServer(void) {
   }
   listen_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
   if (listen_ == INVALID_SOCKET) {
-    printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Create socket failed!!!", __FUNCTION__, __LINE__);
     WSACleanup();
     return -1;
   }
@@ -153,7 +215,7 @@ int JT808Server::InitServer(void) {
 #endif
   if (Bind(listen_, reinterpret_cast<struct sockaddr *>(&addr),
               sizeof(addr)) == -1) {
-    printf("%s[%d]: Connect to remote server failed!!!\n",
+    JT808_LOG_ERROR("%s[%d]: Connect to remote server failed!!!",
            __FUNCTION__, __LINE__);
     Close(listen_);
 #if defined(_WIN32)
@@ -168,22 +230,79 @@ int JT808Server::InitServer(void) {
 // 开启等待客户端连接和与客户端通信线程.
 void JT808Server::Run(void) {
   if (!is_ready_) return;
+  StartWorkers();
   service_thread_ = std::thread(&JT808Server::ServiceHandler, this);
   service_thread_.detach();
   waiting_thread_ = std::thread(&JT808Server::WaitHandler, this);
   waiting_thread_.detach();
 }
 
+// 启动应用回调工作线程和位置记录事件流消费线程.
+void JT808Server::StartWorkers(void) {
+  callback_executor_.set_metrics(&metrics_);
+  callback_executor_.Start(callback_thread_num_);
+  if (geofence_event_callback_ || driving_alarm_event_callback_ ||
+      location_archive_.is_open()) {
+    // 区域和驾驶行为判断、归档在事件流消费线程中进行,
+    // 同一终端的位置记录按接收顺序处理.
+    auto const location_callback = location_batch_callback_;
+    auto const location_archive =
+        location_archive_.is_open() ? &location_archive_ : nullptr;
+    auto const geofence_callback = geofence_event_callback_;
+    auto const driving_callback = driving_alarm_event_callback_;
+    auto const fleet_geofence = &fleet_geofence_;
+    auto const driving_alarm = &driving_alarm_;
+    auto const geofence_events =
+        std::make_shared<std::vector<GeofenceEvent>>();
+    auto const driving_events =
+        std::make_shared<std::vector<DrivingAlarmEvent>>();
+    location_stream_.Start([=] (LocationRecord const* records,
+                                size_t const& num) {
+      if (geofence_callback) {
+        geofence_events->clear();
+        fleet_geofence->Evaluate(records, num, geofence_events.get());
+        if (!geofence_events->empty()) {
+          geofence_callback(geofence_events->data(), geofence_events->size());
+        }
+      }
+      if (driving_callback) {
+        driving_events->clear();
+        driving_alarm->Evaluate(records, num, driving_events.get());
+        if (!driving_events->empty()) {
+          driving_callback(driving_events->data(), driving_events->size());
+        }
+      }
+      if (location_archive != nullptr) location_archive->Append(records, num);
+      if (location_callback) location_callback(records, num);
+    });
+  } else if (location_batch_callback_) {
+    location_stream_.Start(location_batch_callback_);
+  }
+}
+
+// 执行完已提交的应用回调和事件流中剩余的位置记录后停止.
+void JT808Server::StopWorkers(void) {
+  callback_executor_.Stop();
+  location_stream_.Stop();
+}
+
 // 停止服务线程, 关闭连接并清空套接字.
 void JT808Server::Stop(void) {
   if (listen_ > 0) {
     service_is_running_.store(false);
     waiting_is_running_.store(false);
     std::this_thread::sleep_for(std::chrono::seconds(3));
+    std::unique_lock<std::mutex> lock(clients_mutex_);
     for (auto& socket : clients_) {
       Close(socket.first);
     }
     clients_.erase(clients_.begin(), clients_.end());
+    phone_clients_.clear();
+    assemblers_.clear();
+    handshake_leftover_clients_.clear();
+    outbounds_.clear();
+    metrics_.SetActiveSessions(0);
+    lock.unlock();
     Close(listen_);
     listen_ = 0;
 #if defined(_WIN32)
@@ -191,6 +310,71 @@ void JT808Server::Stop(void) {
 #endif
     is_ready_.store(false);
   }
+  StopWorkers();
+  location_archive_.Close();
+  frame_capture_.Close();
+}
+
+void JT808Server::OnLocationReported(LocationBatchCallback const& callback,
+                                     size_t const& max_records,
+                                     int const& max_delay_ms) {
+  location_batch_callback_ = callback;
+  location_stream_.set_batch(max_records, max_delay_ms);
+}
+
+// 按接收顺序回放抓包记录, 每个会话使用独立的帧切分器和协议参数,
+// 与主服务线程相同地逐帧解析和处理.
+int64_t JT808Server::ReplayCapture(std::string const& path,
+                                   double const& speed) {
+  if (service_is_running_ || waiting_is_running_) return -1;
+  FrameCaptureReader reader;
+  if (reader.Open(path) != 0) return -1;
+  replaying_ = true;
+  StartWorkers();
+  std::map<uint64_t, ProtocolParameter> sessions;
+  std::map<uint64_t, FrameAssembler> assemblers;
+  FrameCaptureRecord record;
+  std::vector<uint8_t> msg;
+  int64_t frame_num = 0;
+  int64_t first_time_us = -1;
+  auto const start_tp = std::chrono::steady_clock::now();
+  int ret = -1;
+  while ((ret = reader.Next(&record)) == 1) {
+    if (speed > 0) {
+      if (first_time_us < 0) first_time_us = record.time_us;
+      auto const offset = static_cast<int64_t>(
+          (record.time_us-first_time_us)/speed);
+      if (offset > 0) {
+        std::this_thread::sleep_until(
+            start_tp+std::chrono::microseconds(offset));
+      }
+    }
+    if (record.type == kFrameCaptureAccept) {  // 连接复用了会话标识.
+      sessions.erase(record.session);
+      assemblers.erase(record.session);
+      continue;
+    }
+    auto it = sessions.find(record.session);
+    if (it == sessions.end()) {
+      ProtocolParameter para{};
+      para.lazy_location_extension = true;
+      para.numeric_location_time = true;
+      it = sessions.insert(std::make_pair(record.session, para)).first;
+    }
+    auto const fd = static_cast<decltype(socket(0, 0, 0))>(record.session);
+    auto const recv_tp = std::chrono::steady_clock::now();
+    metrics_.AddBytesIn(record.data.size());
+    auto& assembler = assemblers[record.session];
+    assembler.Append(record.data.data(), record.data.size());
+    while (assembler.Next(&msg)) {
+      ++frame_num;
+      DispatchFrame(fd, msg, recv_tp, &it->second);
+    }
+  }
+  StopWorkers();
+  replaying_ = false;
+  location_archive_.Flush();
+  return (ret < 0) ? -1 : frame_num;
 }
 
 int JT808Server::UpgradeRequest(decltype(socket(0, 0, 0)) const& socket,
@@ -198,73 +382,105 @@ int JT808Server::UpgradeRequest(decltype(socket(0, 0, 0)) const& socket,
                                 std::vector<uint8_t> const& manufacturer_id,
                                 std::string const& version_id,
                                 char const* path) {
+  std::unique_lock<std::mutex> lock(clients_mutex_);
+  auto const& it = clients_.find(socket);
+  if (it == clients_.end()) return -1;
+  auto const phone = it->second.msg_head.phone_num;
+  lock.unlock();
+  return UpgradeRequestByPhoneNumber(phone, upgrade_type, manufacturer_id,
+                                     version_id, path);
+}
+
+// 等待升级结果的线程不能是回调结果的线程.
+int JT808Server::UpgradeRequestByPhoneNumber(
+    std::string const& phone,
+    int const& upgrade_type,
+    std::vector<uint8_t> const& manufacturer_id,
+    std::string const& version_id,
+    char const* path) {
+  if (callback_executor_.InWorkerThread() || current_service_server == this) {
+    JT808_LOG_ERROR("%s[%d]: Blocking upgrade in callback thread !!!",
+        __FUNCTION__, __LINE__);
+    return -1;
+  }
+  auto promise = std::make_shared<std::promise<int>>();
+  auto future = promise->get_future();
+  if (UpgradeRequestByPhoneNumber(phone, upgrade_type, manufacturer_id,
+                                  version_id, path,
+                                  [promise] (CommandResult const& result) {
+                                    promise->set_value(
+                                        result.result == kSuccess ? 0 : -1);
+                                  }) != 0) {
+    return -1;
+  }
+  return future.get();
+}
+
+// 升级包按顺序下发, 上一包收到成功应答后再发送下一包.
+int JT808Server::UpgradeRequestByPhoneNumber(
+    std::string const& phone,
+    int const& upgrade_type,
+    std::vector<uint8_t> const& manufacturer_id,
+    std::string const& version_id,
+    char const* path,
+    CommandCallback const& callback) {
   std::ifstream ifs;
   ifs.open(path, std::ios::in|std::ios::binary);
   if (!ifs.is_open()) {
-    printf("%s[%d]: Updrade file open failed !!!\n", __FUNCTION__, __LINE__);
+    JT808_LOG_ERROR("%s[%d]: Updrade file open failed !!!",
+        __FUNCTION__, __LINE__);
     return -1;
   }
+  auto state = std::make_shared<UpgradeState>();
   ifs.seekg(0, std::ios::end);
   size_t length = ifs.tellg();
   ifs.seekg(0, std::ios::beg);
-  std::unique_ptr<char[]> buffer(
-      new char[length], std::default_delete<char[]>());
-  ifs.read(buffer.get(), length);
+  state->data.resize(length);
+  ifs.read(reinterpret_cast<char*>(state->data.data()), length);
   ifs.close();
-  is_upgrading_clients_.insert(std::make_pair(socket, 0));
-  auto& para = clients_[socket];
+  auto& para = state->para;
   para.upgrade_info.manufacturer_id.assign(
       manufacturer_id.begin(), manufacturer_id.end());
   para.upgrade_info.upgrade_type = upgrade_type;
   para.upgrade_info.version_id = version_id;
-  uint16_t max_content = 1023-9-para.upgrade_info.version_id.size();
-  if (length > max_content) {  // 需要分包处理.
+  state->phone_num = phone;
+  // 消息体最长1023字节, 升级类型、制造商ID、版本号长度和升级数据包长度
+  // 共11字节.
+  state->max_content = 1023-11-para.upgrade_info.version_id.size();
+  state->total_packet = 1;
+  if (length > state->max_content) {  // 需要分包处理.
+    state->total_packet = static_cast<uint16_t>(
+        ceil(length*1.0/state->max_content));
     para.msg_head.msgbody_attr.bit.packet = 1;  // 进行分包.
-    para.msg_head.total_packet =
-        static_cast<uint16_t>(ceil(length*1.0/max_content));
-    para.msg_head.packet_seq = 1;
-    size_t len = 0;
-    for (size_t i = 0; i < length; i += max_content) {
-      len = length-i;
-      if (len > max_content) len = max_content;
-      para.upgrade_info.upgrade_data.assign(
-          buffer.get()+i, buffer.get()+i+len);
-      if (PackagingAndSendMessage(socket, kTerminalUpgrade, &para) < 0) {
-        is_upgrading_clients_.erase(socket);
-        return -1;
-      }
-      if (ReceiveAndParseMessage(socket, 5, &para) < 0) {
-        is_upgrading_clients_.erase(socket);
-        return -1;
-      }
-      if (para.parse.msg_head.msg_id != kTerminalGeneralResponse ||
-          para.parse.respone_msg_id != kTerminalUpgrade ||
-          para.parse.respone_result != kSuccess) {
-        is_upgrading_clients_.erase(socket);
-        return -1;   
-      }
-      ++para.msg_head.packet_seq;
-    }
-    para.msg_head.msgbody_attr.bit.packet = 0;
-    para.msg_head.total_packet = 1;
-  } else {
-    para.upgrade_info.upgrade_data.assign(buffer.get(), buffer.get()+length);
-    if (PackagingAndSendMessage(socket, kTerminalUpgrade, &para) < 0) {
-      is_upgrading_clients_.erase(socket);
-      return -1;
-    }
-    if (ReceiveAndParseMessage(socket, 5, &para) < 0) {
-      is_upgrading_clients_.erase(socket);
-      return -1;
-    }
-    if (para.parse.respone_msg_id != kTerminalUpgrade ||
-        para.parse.respone_result != kSuccess) {
-      is_upgrading_clients_.erase(socket);
-      return -1;
-    }
+    para.msg_head.total_packet = state->total_packet;
   }
-  is_upgrading_clients_.erase(socket);
-  return 0;
+  state->packet_seq = 1;
+  state->callback = callback;
+  return SendUpgradePacket(state);
+}
+
+// 在上一包的结果回调中调用, 不阻塞回调线程.
+int JT808Server::SendUpgradePacket(std::shared_ptr<UpgradeState> const& state) {
+  auto& para = state->para;
+  size_t const offset = (state->packet_seq-1)*state->max_content;
+  size_t const len = std::min<size_t>(state->data.size()-offset,
+                                      state->max_content);
+  para.msg_head.packet_seq = state->packet_seq;
+  para.upgrade_info.upgrade_data.assign(
+      state->data.begin()+offset, state->data.begin()+offset+len);
+  return SendCommand(state->phone_num, kTerminalUpgrade, para,
+      [this, state] (CommandResult const& result) {
+        if (result.result == kSuccess &&
+            state->packet_seq < state->total_packet) {
+          ++state->packet_seq;
+          if (SendUpgradePacket(state) == 0) return;
+          CommandResult stopped = result;
+          stopped.result = kCommandDisconnected;
+          if (state->callback) state->callback(stopped);
+          return;
+        }
+        if (state->callback) state->callback(result);
+      });
 }
 
 // 根据提供的消息ID以及调用前此函数前对参数的设定, 生成对应的JT808格式消息,
@@ -273,37 +489,435 @@ int JT808Server::PackagingAndSendMessage(
     decltype(socket(0, 0, 0)) const& socket,
     uint32_t const& msg_id,
     ProtocolParameter* para) {
-  std::vector<uint8_t> msg;
+  ScratchBuffer scratch;
+  auto& msg = *scratch;
   para->msg_head.msg_id = msg_id;  // 设置消息ID.
-  if (JT808FramePackage(packager_, *para, &msg) < 0) {
-    printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+  if (JT808FramePackage(packager_.get(), *para, &msg) < 0) {
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Package message failed !!!",
+        __FUNCTION__, __LINE__);
     return -1;
   }
+  auto const flow_num = para->msg_head.msg_flow_num;
   ++para->msg_head.msg_flow_num;  // 每正确生成一条命令, 消息流水号增加1.
-  if (Send(socket, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
-    printf("%s[%d]: Send message failed !!!\n", __FUNCTION__, __LINE__);
+  // 已鉴权的连接为非阻塞模式, 由主服务线程整帧写入.
+  if (!replaying_ && current_service_server == this) {
+    if (QueueFrame(socket, msg, msg_id, flow_num, false) < 0) {
+      JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Send message failed !!!",
+          __FUNCTION__, __LINE__);
+      return -2;
+    }
+    return 0;
+  }
+  // 回放抓包文件时只封装不发送.
+  // 鉴权过程和回放时只发送应答消息, 无需记录等待应答.
+  if (!replaying_ &&
+      Send(socket, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Send message failed !!!",
+        __FUNCTION__, __LINE__);
     return -2;
   }
+  metrics_.AddFrameOut(msg_id);
+  metrics_.AddBytesOut(msg.size());
+  return 0;
+}
+
+// 把位置信息汇报或定位数据批量上传解码为位置记录写入事件流.
+void JT808Server::PushLocationRecords(decltype(socket(0, 0, 0)) const& socket,
+                                      ProtocolParameter const& para) {
+  if (!location_stream_.is_running()) return;
+  LocationRecord record;
+  record.receive_time_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+  record.session = static_cast<uint64_t>(socket);
+  auto const& phone_num = para.parse.msg_head.phone_num;
+  if (para.parse.msg_head.msg_id == kLocationReport) {
+    FillLocationRecord(para.parse.location_info, phone_num, &record);
+    location_stream_.Push(record);
+    return;
+  }
+  LocationBasicInformation basic_info;
+  for (auto const& item : para.parse.location_batch.items) {
+    if (ParseLocationBasicInformation(item.data(), item.size(),
+                                      &basic_info, false) != 0) {
+      continue;
+    }
+    FillLocationRecord(basic_info, phone_num, &record);
+    record.batch = 1;
+    location_stream_.Push(record);
+  }
+}
+
+// 多媒体数据移交给回调工作线程, 同一终端的数据按接收顺序回调.
+void JT808Server::DispatchMultimediaData(
+    decltype(socket(0, 0, 0)) const& socket,
+    MultiMediaDataUpload* media) {
+  if (!multimedia_data_upload_callback_) return;
+  auto data = std::make_shared<MultiMediaDataUpload>(std::move(*media));
+  auto const callback = multimedia_data_upload_callback_;
+  callback_executor_.Submit(static_cast<uint64_t>(socket),
+                            [callback, data] (void) { callback(*data); });
+}
+
+int JT808Server::QueueFrame(decltype(socket(0, 0, 0)) const& socket,
+                            std::vector<uint8_t> const& frame,
+                            uint16_t const& msg_id, uint16_t const& flow_num,
+                            bool const& command) {
+  auto& outbound = outbounds_[socket];
+  if (outbound.bytes+frame.size() > kMaxOutboundBytes) {
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Outbound buffer overflow !!!",
+        __FUNCTION__, __LINE__);
+    return -1;
+  }
+  OutboundFrame item;
+  item.data = frame;
+  item.msg_id = msg_id;
+  item.flow_num = flow_num;
+  item.command = command;
+  outbound.frames.push_back(std::move(item));
+  outbound.bytes += frame.size();
+  return FlushOutbound(socket);
+}
+
+// 首个消息帧未完整写入时不会开始写入下一帧, 保证消息帧的完整性.
+int JT808Server::FlushOutbound(decltype(socket(0, 0, 0)) const& socket) {
+  auto const& it = outbounds_.find(socket);
+  if (it == outbounds_.end()) return 0;
+  auto& outbound = it->second;
+  while (!outbound.frames.empty()) {
+    auto& frame = outbound.frames.front();
+    int const ret = Send(
+        socket, reinterpret_cast<char*>(frame.data.data())+outbound.offset,
+        static_cast<int>(frame.data.size()-outbound.offset), 0);
+    if (ret > 0) {
+      outbound.offset += ret;
+      if (outbound.offset < frame.data.size()) continue;
+      OnFrameSent(socket, frame, &outbound);
+      outbound.bytes -= frame.data.size();
+      outbound.offset = 0;
+      outbound.frames.pop_front();
+      continue;
+    }
+    if (ret < 0) {
+#if defined(__linux__)
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+#elif defined(_WIN32)
+      auto wsa_errno = WSAGetLastError();
+      if (wsa_errno == WSAEINTR) continue;
+      if (wsa_errno == WSAEWOULDBLOCK) return 0;
+#endif
+    }
+    return -1;
+  }
   return 0;
 }
 
+// 下发命令完整写入后才开始等待应答, 重传的消息不重复记录应答延时.
+void JT808Server::OnFrameSent(decltype(socket(0, 0, 0)) const& socket,
+                              OutboundFrame const& frame, Outbound* outbound) {
+  metrics_.AddFrameOut(frame.msg_id);
+  metrics_.AddBytesOut(frame.data.size());
+  if (!frame.command) {
+    AddPendingAck(frame.msg_id, frame.flow_num, outbound);
+    return;
+  }
+  auto const& it = pending_commands_.find(
+      std::make_pair(socket, frame.flow_num));
+  if (it == pending_commands_.end() || it->second.sent) return;
+  auto& command = it->second;
+  if (command.retransmissions == 0) {
+    AddPendingAck(frame.msg_id, frame.flow_num, outbound);
+  }
+  command.sent = true;
+  // 第n次重传后的超时时间为T×(n+1).
+  command.deadline = std::chrono::steady_clock::now()+
+      std::chrono::milliseconds(static_cast<int64_t>(command_timeout_ms_) *
+                                (command.retransmissions+1));
+  next_command_check_ = std::min(next_command_check_, command.deadline);
+}
+
+// 应答类命令和多媒体数据上传应答无需终端应答, 不作记录.
+// 记录位置被未超时的记录占用时放弃本次记录, 只覆盖超过应答超时和重传总时间
+// 仍未应答的记录.
+void JT808Server::AddPendingAck(uint16_t const& msg_id,
+                                uint16_t const& flow_num,
+                                Outbound* outbound) {
+  if ((msg_id & 0x8000) == 0 || msg_id == kMultimediaDataUploadResponse) {
+    return;
+  }
+  auto const end = kResponseCommand +
+                   sizeof(kResponseCommand)/sizeof(kResponseCommand[0]);
+  if (std::find(kResponseCommand, end, msg_id) != end) return;
+  auto const now = std::chrono::steady_clock::now();
+  auto& ack = outbound->acks[flow_num % outbound->acks.size()];
+  if (ack.valid && ack.flow_num != flow_num &&
+      now-ack.send_tp < std::chrono::milliseconds(
+          static_cast<int64_t>(command_timeout_ms_) *
+          (command_retransmissions_+1))) {
+    return;
+  }
+  ack.valid = true;
+  ack.flow_num = flow_num;
+  ack.send_tp = now;
+}
+
+void JT808Server::MatchPendingAck(decltype(socket(0, 0, 0)) const& socket,
+                                  ProtocolParameter const& para) {
+  if (para.parse.msg_head.msg_id != kTerminalGeneralResponse) return;
+  auto const& it = outbounds_.find(socket);
+  if (it == outbounds_.end()) return;
+  auto const& flow_num = para.parse.respone_flow_num;
+  auto& ack = it->second.acks[flow_num % it->second.acks.size()];
+  if (!ack.valid || ack.flow_num != flow_num) return;
+  metrics_.RecordAckLatency(ElapsedUs(ack.send_tp));
+  ack.valid = false;
+}
+
+int JT808Server::SendCommand(std::string const& phone,
+                             uint16_t const& msg_id,
+                             ProtocolParameter const& para,
+                             CommandCallback const& callback) {
+  CommandRequest request;
+  request.phone_num = phone;
+  request.msg_id = msg_id;
+  request.para.reset(new ProtocolParameter(para));
+  request.callback = callback;
+  std::lock_guard<std::mutex> lock(command_mutex_);
+  if (!command_accepting_) return -1;
+  pending_command_num_.fetch_add(1, std::memory_order_relaxed);
+  command_queue_.push_back(std::move(request));
+  return 0;
+}
+
+std::future<CommandResult> JT808Server::SendCommand(
+    std::string const& phone,
+    uint16_t const& msg_id,
+    ProtocolParameter const& para) {
+  auto promise = std::make_shared<std::promise<CommandResult>>();
+  auto future = promise->get_future();
+  if (SendCommand(phone, msg_id, para,
+                  [promise] (CommandResult const& result) {
+                    promise->set_value(result);
+                  }) != 0) {
+    CommandResult result;
+    result.result = kCommandDisconnected;
+    result.msg_id = msg_id;
+    result.flow_num = 0;
+    result.retransmissions = 0;
+    promise->set_value(result);
+  }
+  return future;
+}
+
+// 关闭连接前, 该连接上等待应答的命令全部结束.
+void JT808Server::RemoveClient(decltype(socket(0, 0, 0)) const& socket) {
+  Close(socket);
+  outbounds_.erase(socket);
+  auto const& it = clients_.find(socket);
+  if (it == clients_.end()) return;
+  auto const& phone_it = phone_clients_.find(it->second.msg_head.phone_num);
+  if (phone_it != phone_clients_.end() && phone_it->second == socket) {
+    phone_clients_.erase(phone_it);
+  }
+  clients_.erase(it);
+  assemblers_.erase(socket);
+  auto command = pending_commands_.lower_bound(std::make_pair(socket, 0));
+  while (command != pending_commands_.end() &&
+         command->first.first == socket) {
+    FinishCommand(socket, command->first.second, &command->second,
+                  kCommandDisconnected, nullptr);
+    command = pending_commands_.erase(command);
+  }
+}
+
+// 新命令使用终端连接的消息流水号封装后立即发送.
+// 超时检查只在最早的截止时间到达后遍历一次等待应答的命令.
+void JT808Server::ProcessCommands(void) {
+  {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    command_batch_.swap(command_queue_);
+  }
+  auto const now = std::chrono::steady_clock::now();
+  // 消息在应答超时和重传的总时间内仍未写入socket时视为超时.
+  auto const send_timeout = std::chrono::milliseconds(
+      static_cast<int64_t>(command_timeout_ms_) *
+      (command_retransmissions_+1));
+  for (auto& request : command_batch_) {
+    PendingCommand command;
+    command.msg_id = request.msg_id;
+    command.retransmissions = 0;
+    command.sent = false;
+    command.callback = std::move(request.callback);
+    auto const& phone_it = phone_clients_.find(request.phone_num);
+    if (phone_it == phone_clients_.end()) {
+      FinishCommand(0, 0, &command, kCommandDisconnected, nullptr);
+      continue;
+    }
+    auto const fd = phone_it->second;
+    auto& session = clients_[fd];
+    auto& para = *request.para;
+    para.msg_head.msg_id = request.msg_id;
+    para.msg_head.phone_num = session.msg_head.phone_num;
+    para.msg_head.msg_flow_num = session.msg_head.msg_flow_num;
+    auto const flow_num = para.msg_head.msg_flow_num;
+    if (JT808FramePackage(packager_.get(), para, &command.frame) < 0) {
+      FinishCommand(fd, flow_num, &command, kCommandPackageFailed, nullptr);
+      continue;
+    }
+    ++session.msg_head.msg_flow_num;
+    auto const key = std::make_pair(fd, flow_num);
+    // 流水号回绕后仍未应答的命令视为超时.
+    auto const& old = pending_commands_.find(key);
+    if (old != pending_commands_.end()) {
+      FinishCommand(fd, flow_num, &old->second, kCommandTimeout, nullptr);
+      pending_commands_.erase(old);
+    }
+    // 消息完整写入socket后才开始等待应答, 此前的截止时间为等待写入的时间.
+    command.deadline = now+send_timeout;
+    next_command_check_ = std::min(next_command_check_, command.deadline);
+    auto const& inserted =
+        pending_commands_.insert(std::make_pair(key, std::move(command))).first;
+    if (QueueFrame(fd, inserted->second.frame, request.msg_id, flow_num,
+                   true) < 0) {
+      JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Disconnect !!!",
+          __FUNCTION__, __LINE__);
+      RemoveClient(fd);
+    }
+  }
+  command_batch_.clear();
+  if (pending_commands_.empty() || now < next_command_check_) return;
+  auto next = std::chrono::steady_clock::time_point::max();
+  std::vector<decltype(socket(0, 0, 0))> broken;
+  for (auto it = pending_commands_.begin(); it != pending_commands_.end();) {
+    auto& command = it->second;
+    if (command.deadline <= now) {
+      if (!command.sent ||
+          command.retransmissions >= command_retransmissions_) {
+        FinishCommand(it->first.first, it->first.second, &command,
+                      kCommandTimeout, nullptr);
+        it = pending_commands_.erase(it);
+        continue;
+      }
+      // 重传的消息完整写入后, 由OnFrameSent()重新设置应答截止时间.
+      ++command.retransmissions;
+      command.sent = false;
+      command.deadline = now+send_timeout;
+      if (QueueFrame(it->first.first, command.frame, command.msg_id,
+                     it->first.second, true) < 0) {
+        broken.push_back(it->first.first);
+      }
+    }
+    next = std::min(next, command.deadline);
+    ++it;
+  }
+  next_command_check_ = next;
+  for (auto const& fd : broken) {
+    if (clients_.find(fd) != clients_.end()) RemoveClient(fd);
+  }
+}
+
+// 终端通用应答需同时匹配应答消息ID.
+void JT808Server::MatchCommand(decltype(socket(0, 0, 0)) const& socket,
+                               ProtocolParameter const& para) {
+  auto const& msg_id = para.parse.msg_head.msg_id;
+  if (msg_id != kTerminalGeneralResponse &&
+      msg_id != kGetTerminalParametersResponse &&
+      msg_id != kGetLocationInformationResponse) {
+    return;
+  }
+  auto const flow_num = para.parse.respone_flow_num;
+  auto const& it = pending_commands_.find(std::make_pair(socket, flow_num));
+  if (it == pending_commands_.end()) return;
+  int result = kSuccess;
+  if (msg_id == kTerminalGeneralResponse) {
+    if (para.parse.respone_msg_id != it->second.msg_id) return;
+    result = para.parse.respone_result;
+  }
+  FinishCommand(socket, flow_num, &it->second, result,
+                std::make_shared<ProtocolParameter const>(para));
+  pending_commands_.erase(it);
+}
+
+void JT808Server::AbortCommands(void) {
+  {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    command_accepting_ = false;
+    command_batch_.swap(command_queue_);
+  }
+  for (auto& request : command_batch_) {
+    PendingCommand command;
+    command.msg_id = request.msg_id;
+    command.retransmissions = 0;
+    command.callback = std::move(request.callback);
+    FinishCommand(0, 0, &command, kCommandDisconnected, nullptr);
+  }
+  command_batch_.clear();
+  for (auto& item : pending_commands_) {
+    FinishCommand(item.first.first, item.first.second, &item.second,
+                  kCommandDisconnected, nullptr);
+  }
+  pending_commands_.clear();
+}
+
+void JT808Server::FinishCommand(
+    decltype(socket(0, 0, 0)) const& socket,
+    uint16_t const& flow_num,
+    PendingCommand* command,
+    int const& result,
+    std::shared_ptr<ProtocolParameter const> const& response) {
+  pending_command_num_.fetch_sub(1, std::memory_order_relaxed);
+  if (!command->callback) return;
+  CommandResult command_result;
+  command_result.result = result;
+  command_result.msg_id = command->msg_id;
+  command_result.flow_num = flow_num;
+  command_result.retransmissions = command->retransmissions;
+  command_result.response = response;
+  auto const callback = std::move(command->callback);
+  FinishedCommand finished;
+  finished.session = static_cast<uint64_t>(socket);
+  finished.task = [callback, command_result] (void) {
+    callback(command_result);
+  };
+  finished_commands_.push_back(std::move(finished));
+}
+
+// 结果回调不受工作线程队列容量限制, 既不阻塞主服务线程也不丢弃.
+// 没有工作线程或已停止时在当前线程执行, 此时不持有clients_mutex_.
+void JT808Server::DeliverCommandResults(
+    std::vector<FinishedCommand>* commands) {
+  for (auto& command : *commands) {
+    if (callback_executor_.Post(command.session, command.task) != 0) {
+      command.task();
+    }
+  }
+  commands->clear();
+}
+
 // 阻塞地从socket连接中接收一次数据, 然后按照JT808协议进行解析.
 int JT808Server::ReceiveAndParseMessage(
     decltype(socket(0, 0, 0)) const& socket,
     int const& timeout,
+    FrameAssembler* assembler,
     ProtocolParameter* para) {
+  if (assembler == nullptr || para == nullptr) return -1;
   std::vector<uint8_t> msg;
   int ret = -1;
   int timeout_ms = timeout*1000;  // 超时时间, ms.
   auto tp = std::chrono::steady_clock::now();
   std::unique_ptr<char[]> buffer(
       new char[4096], std::default_delete<char[]>());
-  while (1) {
+  // 抓包记录接收到的全部数据, 与回放时相同地经过帧切分.
+  while (!assembler->Next(&msg)) {
     if ((ret = Recv(socket, buffer.get(), 4096, 0)) > 0) {
-      msg.assign(buffer.get(), buffer.get()+ret);
-      break;
+      metrics_.AddBytesIn(ret);
+      frame_capture_.WriteData(static_cast<uint64_t>(socket),
+                               reinterpret_cast<uint8_t*>(buffer.get()), ret);
+      assembler->Append(reinterpret_cast<uint8_t*>(buffer.get()), ret);
     } else if (ret == 0) {
-      printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
+      JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Disconnect !!!",
+          __FUNCTION__, __LINE__);
       return -2;
     } else {
       // TODO(mengyuming@hotmail.com): 其它连接错误需处理.
@@ -311,16 +925,19 @@ int JT808Server::ReceiveAndParseMessage(
     // 检测超时退出.
     if (std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::steady_clock::now()-tp).count() >= timeout_ms) {
-      break;
+      return -2;
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (ret <= 0) std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
-  if (msg.empty()) return -2;
   // 解析消息.
-  if (JT808FrameParse(parser_, msg, para) == -1) {
-    printf("%s[%d]: Parse message failed !!!\n", __FUNCTION__, __LINE__);
+  if ((ret = JT808FrameParse(parser_.get(), msg, para)) < 0) {
+    JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Parse message failed !!!",
+        __FUNCTION__, __LINE__);
+    metrics_.AddParseFailure(ret);
     return -1;
   }
+  // 鉴权过程中没有等待应答的下发消息, 不匹配应答.
+  metrics_.AddFrameIn(para->parse.msg_head.msg_id);
   return 0;
 }
 
@@ -340,11 +957,18 @@ void JT808Server::WaitHandler(void) {
     auto socket = Accept(listen_,
         reinterpret_cast<struct sockaddr *>(&addr), &len);
     if (socket <= 0) {
-      printf("%s[%d]: Invalid socket!!!\n", __FUNCTION__, __LINE__);
+      JT808_LOG_ERROR("%s[%d]: Invalid socket!!!", __FUNCTION__, __LINE__);
       break;
     }
+    auto const accept_tp = std::chrono::steady_clock::now();
+    frame_capture_.WriteAccept(static_cast<uint64_t>(socket));
+    FrameAssembler assembler;
     ProtocolParameter para{};
-    if (ReceiveAndParseMessage(socket, 3, &para) < 0 ||
+    // 位置附加信息只在显示时按需读取, 解析时不生成.
+    para.lazy_location_extension = true;
+    // 定位时间只保留时间戳, 显示时再格式化.
+    para.numeric_location_time = true;
+    if (ReceiveAndParseMessage(socket, 3, &assembler, &para) < 0 ||
         para.parse.msg_head.msg_id != kTerminalRegister) {
       Close(socket);
       continue;
@@ -359,7 +983,7 @@ void JT808Server::WaitHandler(void) {
       continue;
     }
     // 等待返回鉴权码.
-    if (ReceiveAndParseMessage(socket, 3, &para) < 0) {
+    if (ReceiveAndParseMessage(socket, 3, &assembler, &para) < 0) {
       Close(socket);
       continue;
     }
@@ -382,130 +1006,181 @@ void JT808Server::WaitHandler(void) {
 #elif defined(_WIN32)
     unsigned long ul = 1;
     if (ioctlsocket(socket, FIONBIO, (unsigned long *)&ul) == SOCKET_ERROR) {
-      printf("%s[%d]: Set socket nonblock failed!!!\n", __FUNCTION__, __LINE__);
+      JT808_LOG_ERROR("%s[%d]: Set socket nonblock failed!!!",
+          __FUNCTION__, __LINE__);
       Close(socket);
       continue;
     }
 #endif
+    metrics_.RecordHandshakeDuration(ElapsedUs(accept_tp));
+    std::lock_guard<std::mutex> lock(clients_mutex_);
     clients_.insert(std::make_pair(socket, para));
+    phone_clients_[para.msg_head.phone_num] = socket;
+    // 鉴权消息之后紧接着发送的数据已在切分器中, 由主服务线程继续处理.
+    if (assembler.pending() > 0) handshake_leftover_clients_.push_back(socket);
+    assemblers_[socket] = std::move(assembler);
+    metrics_.SetActiveSessions(clients_.size());
   }
   waiting_is_running_.store(false);
   Stop();
 }
 
-// 主服务线程, 监听已连接的客户端线程处理函数.
+// 解析并处理一帧消息.
 // 暂时支持位置上报信息显示和查询终端参数应答的内容进行显示.
 // 对所有非应答类命令暂时都以平台通用应答进行回应, 应答结果均为0.
+int JT808Server::DispatchFrame(
+    decltype(socket(0, 0, 0)) const& socket,
+    std::vector<uint8_t> const& frame,
+    std::chrono::steady_clock::time_point const& recv_tp,
+    ProtocolParameter* para) {
+  int ret = -1;
+  if ((ret = JT808FrameParse(parser_.get(), frame, para)) < 0) {
+    metrics_.AddParseFailure(ret);
+    return 0;
+  }
+  para->respone_result = kSuccess;
+  auto const& msg_id = para->parse.msg_head.msg_id;
+  metrics_.AddFrameIn(msg_id);
+  MatchPendingAck(socket, *para);
+  if (!pending_commands_.empty()) MatchCommand(socket, *para);
+  if (msg_id == kLocationReport) {
+    if (message_dump_) PrintLocationReportInfo(*para);
+    PushLocationRecords(socket, *para);
+  } else if (msg_id == kLocationBatchUpload) {
+    if (message_dump_) PrintLocationBatchInfo(*para);
+    PushLocationRecords(socket, *para);
+  } else if (msg_id == kGetTerminalParametersResponse) {
+    if (message_dump_) PrintTerminalParameter(*para);
+  } else if (msg_id == kMultimediaDataUpload) {  // 多媒体数据上传.
+    // TODO(mengyuming@hotmail.com): 未做分包完整性校验.
+    auto& media = para->parse.multimedia_upload;
+    auto const& msg_head = para->parse.msg_head;
+    auto const& packet_size = media.media_data.size();
+    // 检查分包.
+    if (msg_head.msgbody_attr.bit.packet == 1) {  // 分包.
+      // 分配空间.
+      if (msg_head.packet_seq == 1) {  // 第一包.
+        int max_len = (1023-36)*msg_head.total_packet;
+        media_buffer_.reset(new char[max_len]);
+        // 子包最大的数据长度.
+        media_packet_max_size_ = packet_size;
+        media_total_size_ = 0;
+      }
+      memcpy(&(media_buffer_[media_packet_max_size_*(msg_head.packet_seq-1)]),
+          media.media_data.data(), packet_size);
+      media_total_size_ += packet_size;
+      para->respone_result = kSuccess;
+      if (PackagingAndSendMessage(socket, kPlatformGeneralResponse,
+                                  para) < 0) {
+        media_buffer_.reset();
+        return -1;
+      }
+      // 等待所有数据传输完成.
+      if (msg_head.packet_seq == msg_head.total_packet) {
+        media.media_data.clear();
+        media.media_data.assign(media_buffer_.get(),
+            media_buffer_.get()+media_total_size_);
+        DispatchMultimediaData(socket, &media);
+        media.media_data.clear();
+        media.loaction_report_body.clear();
+        media_buffer_.reset();
+        // 暂时直接返回成功.
+        auto& resp = para->multimedia_upload_response;
+        resp.media_id = media.media_id;
+        resp.reload_packet_ids.clear();
+        if (PackagingAndSendMessage(socket, kMultimediaDataUploadResponse,
+                                    para) < 0) {
+          return -1;
+        }
+      }
+    } else {  // 未分包.
+      DispatchMultimediaData(socket, &media);
+      media.media_data.clear();
+      media.loaction_report_body.clear();
+      para->multimedia_upload_response.media_id = media.media_id;
+      if (PackagingAndSendMessage(socket, kMultimediaDataUploadResponse,
+                                  para) < 0) {
+        return -1;
+      }
+    }
+  }
+  // 对于非应答类命令默认使用平台通用应答.
+  auto const end = kResponseCommand +
+                   sizeof(kResponseCommand)/sizeof(kResponseCommand[0]);
+  if (std::find(kResponseCommand, end, msg_id) == end) {
+    if (PackagingAndSendMessage(socket, kPlatformGeneralResponse, para) < 0) {
+      return -1;
+    }
+  }
+  metrics_.RecordDispatchLatency(ElapsedUs(recv_tp));
+  return 0;
+}
+
+// 主服务线程, 监听已连接的客户端线程处理函数.
 // 客户端连接断开时移除相关的套接字和终端参数.
 void JT808Server::ServiceHandler(void) {
+  current_service_server = this;
   service_is_running_.store(true);
   int ret = -1;
   bool alive = false;
   std::unique_ptr<char[]> buffer(
     new char[4096], std::default_delete<char[]>());
   std::vector<uint8_t> msg;
-  std::vector<uint16_t> response_cmd = {kResponseCommand,
-      kResponseCommand+sizeof(kResponseCommand)/sizeof(kResponseCommand[0])};
-  std::unique_ptr<char[]> data_buffer;
-  int total_size = 0;
-  int packet_max_size = 0;
+  std::vector<FinishedCommand> finished;
+  {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    command_accepting_ = true;
+  }
   while(service_is_running_) {
+    std::unique_lock<std::mutex> lock(clients_mutex_);
+    // 下发命令和终端数据都在本线程处理, 终端连接不再有其他读取方.
+    ProcessCommands();
+    // 处理鉴权时随鉴权消息一起接收到的后续消息帧.
+    for (auto const& fd : handshake_leftover_clients_) {
+      auto it = clients_.find(fd);
+      if (it == clients_.end()) continue;
+      auto const recv_tp = std::chrono::steady_clock::now();
+      auto& assembler = assemblers_[fd];
+      while (assembler.Next(&msg)) {
+        if (DispatchFrame(fd, msg, recv_tp, &it->second) < 0) {
+          JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Disconnect !!!",
+              __FUNCTION__, __LINE__);
+          RemoveClient(fd);
+          break;
+        }
+      }
+      alive = true;
+    }
+    handshake_leftover_clients_.clear();
     for (auto& socket : clients_) {
-      // 升级请求时不在此处作处理.
-      if (is_upgrading_clients_.find(socket.first) !=
-          is_upgrading_clients_.end()) {
-        std::this_thread::sleep_for(std::chrono:: milliseconds(1));
-        continue;
+      auto const fd = socket.first;
+      // socket可写时继续写入未发送完的消息.
+      if (FlushOutbound(fd) < 0) {
+        JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Disconnect !!!",
+            __FUNCTION__, __LINE__);
+        RemoveClient(fd);
+        if (!alive) alive = true;
+        break;  // 删除连接时不再继续遍历, 而是重新开始遍历.
       }
-      if ((ret = Recv(socket.first, buffer.get(), 4096, 0)) > 0) {
+      if ((ret = Recv(fd, buffer.get(), 4096, 0)) > 0) {
         if (!alive) alive = true;
-        msg.assign(buffer.get(), buffer.get() + ret);
-        // printf("Recv[%d]: ", ret);
-        // for (auto const& ch : msg) printf("%02X ", ch);
-        // printf("\n");
-        if (JT808FrameParse(parser_, msg, &socket.second) == 0) {
-          socket.second.respone_result = kSuccess;
-          auto const& msg_id = socket.second.parse.msg_head.msg_id;
-          if (msg_id == kLocationReport) {
-            PrintLocationReportInfo(socket.second);
-          } else if (msg_id == kGetTerminalParametersResponse) {
-            PrintTerminalParameter(socket.second);
-          } else if (msg_id == kMultimediaDataUpload) {  // 多媒体数据上传.
-            // TODO(mengyuming@hotmail.com): 未做分包完整性校验.
-            auto& media = socket.second.parse.multimedia_upload;
-            auto const& msg_head =  socket.second.parse.msg_head;
-            auto const& packet_size = media.media_data.size();
-            // 检查分包.
-            if (msg_head.msgbody_attr.bit.packet == 1) {  // 分包.
-              // 分配空间.
-              if (msg_head.packet_seq == 1) {  // 第一包.
-                int max_len = (1023-36)*msg_head.total_packet;
-                  data_buffer = std::move(std::unique_ptr<char[]>(
-                      new char[max_len], std::default_delete<char[]>()));
-                // 子包最大的数据长度.
-                packet_max_size = packet_size;
-                total_size = 0;
-              }
-              memcpy(&(data_buffer[packet_max_size*(msg_head.packet_seq-1)]),
-                  media.media_data.data(), packet_size);
-              total_size += packet_size;
-              socket.second.respone_result = kSuccess;
-              if (PackagingAndSendMessage(socket.first,
-                    kPlatformGeneralResponse, &socket.second) < 0) {
-                printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                data_buffer.reset();
-                Close(socket.first);
-                clients_.erase(socket.first);
-                break;  // 删除连接时不再继续遍历, 而是重新开始遍历.
-              }
-              // 等待所有数据传输完成.
-              if (msg_head.packet_seq == msg_head.total_packet) {
-                media.media_data.clear();
-                media.media_data.assign(data_buffer.get(),
-                    data_buffer.get()+total_size);
-                multimedia_data_upload_callback_(media);
-                media.media_data.clear();
-                media.loaction_report_body.clear();
-                data_buffer.reset();
-                std::this_thread::sleep_for(std::chrono:: milliseconds(100));
-                // 暂时直接返回成功.
-                auto& resp = socket.second.multimedia_upload_response;
-                resp.media_id = media.media_id;
-                resp.reload_packet_ids.clear();
-                if (PackagingAndSendMessage(socket.first,
-                    kMultimediaDataUploadResponse, &socket.second) < 0) {
-                  printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                  Close(socket.first);
-                  clients_.erase(socket.first);
-                  break;  // 删除连接时不再继续遍历, 而是重新开始遍历.
-                }
-              }
-            } else {  // 未分包.
-              multimedia_data_upload_callback_(media);
-              media.media_data.clear();
-              media.loaction_report_body.clear();
-              socket.second.multimedia_upload_response.media_id = media.media_id;
-              if (PackagingAndSendMessage(socket.first,
-                  kMultimediaDataUploadResponse, &socket.second) < 0) {
-                printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                Close(socket.first);
-                clients_.erase(socket.first);
-                break;  // 删除连接时不再继续遍历, 而是重新开始遍历.
-              }
-            }
-          }
-          // 对于非应答类命令默认使用平台通用应答.
-          if (find(response_cmd.begin(), response_cmd.end(), msg_id) ==
-                  response_cmd.end()) {
-            if (PackagingAndSendMessage(socket.first,
-                    kPlatformGeneralResponse, &socket.second) < 0) {
-              printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-              Close(socket.first);
-              clients_.erase(socket.first);
-              break;  // 删除连接时不再继续遍历, 而是重新开始遍历.
-            }
+        auto const recv_tp = std::chrono::steady_clock::now();
+        metrics_.AddBytesIn(ret);
+        frame_capture_.WriteData(static_cast<uint64_t>(fd),
+                                 reinterpret_cast<uint8_t*>(buffer.get()), ret);
+        // 一次接收的数据可能包含多帧或不完整的帧, 按标识位切分后逐帧处理.
+        auto& assembler = assemblers_[fd];
+        assembler.Append(reinterpret_cast<uint8_t*>(buffer.get()), ret);
+        while (assembler.Next(&msg)) {
+          if (DispatchFrame(fd, msg, recv_tp, &socket.second) < 0) {
+            JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Disconnect !!!",
+                __FUNCTION__, __LINE__);
+            RemoveClient(fd);
+            break;  // 删除连接时不再继续遍历, 而是重新开始遍历.
           }
         }
+        // 处理过程中连接已断开, 重新开始遍历.
+        if (clients_.find(fd) == clients_.end()) break;
         continue;
       } else if (ret <= 0) {
         if (ret < 0) {
@@ -519,19 +1194,29 @@ void JT808Server::ServiceHandler(void) {
           if (wsa_errno == WSAEINTR || wsa_errno == WSAEWOULDBLOCK) continue;
 #endif
         }
-        printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-        Close(socket.first);
-        clients_.erase(socket.first);
+        JT808_LOG_ERROR_EVERY_MS(1000, "%s[%d]: Disconnect !!!",
+            __FUNCTION__, __LINE__);
+        RemoveClient(fd);
         if (!alive) alive = true;
         break;  // 删除连接时不再继续遍历, 而是重新开始遍历.
       }
     }
+    metrics_.SetActiveSessions(clients_.size());
+    finished.swap(finished_commands_);
+    lock.unlock();
+    DeliverCommandResults(&finished);
     if (!alive) {
       std::this_thread::sleep_for(std::chrono:: milliseconds(10));
     }
     alive = false;
   }
   service_is_running_.store(false);
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    AbortCommands();
+    finished.swap(finished_commands_);
+  }
+  DeliverCommandResults(&finished);
   Stop();
 }
 
@@ -39,6 +39,7 @@ int Escape(std::vector<uint8_t> const& in,
            std::vector<uint8_t>* out) {
   if (out == nullptr) return -1;
   out->clear();
+  out->reserve(in.size()+in.size()/8);
   for (auto& u8val: in) {
     if (u8val == PROTOCOL_SIGN) {
       out->push_back(PROTOCOL_ESCAPE);
@@ -58,6 +59,7 @@ int ReverseEscape(std::vector<uint8_t> const& in,
                   std::vector<uint8_t>* out) {
   if (out == nullptr) return -1;
   out->clear();
+  out->reserve(in.size());
   for (size_t i = 0; i < in.size(); ++i) {
     if ((in[i] == PROTOCOL_ESCAPE) && (in[i+1] == PROTOCOL_ESCAPE_SIGN)) {
       out->push_back(PROTOCOL_SIGN);